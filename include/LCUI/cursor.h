@@ -31,6 +31,8 @@
 #ifndef LCUI_CURSOR_H
 #define LCUI_CURSOR_H
 
+#include <LCUI/surface.h>
+
 LCUI_BEGIN_HEADER
 
 /* 初始化游标数据 */
@@ -67,6 +69,23 @@ LCUI_API void LCUICursor_GetPos(LCUI_Pos *pos);
 
 LCUI_API int LCUICursor_Paint(LCUI_PaintContext paint);
 
+/**
+ * 检测游标是否需要重绘
+ * 在游标的位置、图形或可见性有变化，或者重绘区域与游标重叠时需要重绘
+ * @param[in] rects 本次需要重绘的区域列表
+ */
+LCUI_API LCUI_BOOL LCUICursor_IsDirty(LinkedList *rects);
+
+/** 擦除 surface 上的游标，恢复被它覆盖的内容 */
+LCUI_API void LCUICursor_Erase(LCUI_Surface surface);
+
+/**
+ * 在 surface 上绘制游标
+ * 绘制前会保存被游标覆盖的内容，以便在游标移开后直接恢复，不必重绘部件
+ * @return 是否绘制了游标
+ */
+LCUI_API LCUI_BOOL LCUICursor_Draw(LCUI_Surface surface);
+
 LCUI_END_HEADER
 
 #endif
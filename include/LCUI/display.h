@@ -145,6 +145,45 @@ LCUI_API int LCUIDisplay_BindEvent(int event_id, LCUI_EventFunc func, void *arg,
 /** 初始化图形输出模块 */
 LCUI_API int LCUI_InitDisplay(LCUI_DisplayDriver driver);
 
+/**
+ * 创建无头（离屏）显示驱动
+ * 它将 surface 的内容渲染到内存中，不需要真实的屏幕，适用于在没有显示设备的
+ * 机器上进行测试和性能分析。设置环境变量 LCUI_DISPLAY_DRIVER=headless 即可让
+ * LCUI_Init() 使用它，或者在调用 LCUI_Init() 之前手动初始化：
+ *
+ *   LCUI_InitBase();
+ *   LCUI_InitApp(NULL);
+ *   LCUI_InitDisplay(LCUI_CreateHeadlessDisplayDriver());
+ *   LCUI_Init();
+ */
+LCUI_API LCUI_DisplayDriver LCUI_CreateHeadlessDisplayDriver(void);
+
+LCUI_API void LCUI_DestroyHeadlessDisplayDriver(LCUI_DisplayDriver driver);
+
+/**
+ * 获取 surface 的帧缓存
+ * @param[in] surface 目标 surface，若为 NULL，则使用根部件所属的 surface
+ */
+LCUI_API LCUI_Graph *LCUIHeadlessDisplay_GetCanvas(LCUI_Surface surface);
+
+/**
+ * 连续运行指定数量的帧，不进行帧率限制，也不会休眠
+ * @return 已呈现的帧数
+ */
+LCUI_API size_t LCUIHeadlessDisplay_StepFrames(int frames);
+
+/** 将 surface 的内容写入至 png 文件 */
+LCUI_API int LCUIHeadlessDisplay_WritePNG(LCUI_Surface surface,
+					  const char *filename);
+
+/**
+ * 计算 surface 中某一区域的像素校验值
+ * @param[in] surface 目标 surface，若为 NULL，则使用根部件所属的 surface
+ * @param[in] rect 区域，若为 NULL，则计算整个 surface
+ */
+LCUI_API uint32_t LCUIHeadlessDisplay_GetChecksum(LCUI_Surface surface,
+						  const LCUI_Rect *rect);
+
 /** 停用图形输出模块 */
 LCUI_API int LCUI_FreeDisplay(void);
 
@@ -33,6 +33,16 @@
 
 LCUI_BEGIN_HEADER
 
+/**
+ * 初始化圆角遮罩缓存
+ * 初始化后，圆角的遮罩只在第一次绘制时计算，之后半径和边框线宽度相同的圆
+ * 角都直接使用缓存的遮罩。
+ */
+LCUI_API void Border_InitCache(void);
+
+/** 释放圆角遮罩缓存 */
+LCUI_API void Border_FreeCache(void);
+
 LCUI_API int Border_CropContent(const LCUI_Border *border, const LCUI_Rect *box,
 				LCUI_PaintContext paint);
 
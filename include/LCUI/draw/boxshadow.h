@@ -37,6 +37,16 @@ LCUI_API void BoxShadow_GetCanvasRect(const LCUI_BoxShadow *shadow,
 				      const LCUI_Rect *box_rect,
 				      LCUI_Rect *canvas_rect);
 
+/**
+ * 初始化阴影缓存
+ * 初始化后，阴影会先绘制成九宫格并缓存起来，之后绘制形状和颜色相同的阴影
+ * 时只需拉伸缓存的九宫格。
+ */
+LCUI_API void BoxShadow_InitCache(void);
+
+/** 释放阴影缓存 */
+LCUI_API void BoxShadow_FreeCache(void);
+
 LCUI_API int BoxShadow_Paint(const LCUI_BoxShadow *shadow, const LCUI_Rect *box,
 			     int centent_width, int content_height,
 			     LCUI_PaintContext paint);
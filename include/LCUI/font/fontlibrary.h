@@ -31,8 +31,19 @@
 #ifndef LCUI_FONT_LIBRARY_H
 #define LCUI_FONT_LIBRARY_H
 
+#include <LCUI/util/rbtree.h>
+#include <LCUI/util/event.h>
+
 LCUI_BEGIN_HEADER
 
+/** 用于异步渲染字形位图的线程数量 */
+#define LCUI_FONT_RENDER_THREADS 4
+
+/** 字体模块的事件类型 */
+typedef enum LCUI_FontEventType {
+	LCUI_FONT_EVENT_BITMAPS_READY	/**< 异步渲染的字形位图已加入缓存 */
+} LCUI_FontEventType;
+
 typedef enum LCUI_FontStyle {
 	FONT_STYLE_NORMAL,
 	FONT_STYLE_ITALIC,
@@ -67,6 +78,15 @@ typedef struct LCUI_FontBitmap_ {
 	LCUI_Pos advance;	/**< XY轴的跨距 */
 } LCUI_FontBitmap;
 
+/** 字形度量数据，排版只需要这些数据，不需要渲染字形位图 */
+typedef struct LCUI_FontMetrics_ {
+	int top;		/**< 与顶边框的距离 */
+	int left;		/**< 与左边框的距离 */
+	int width;		/**< 字形包围盒的宽度 */
+	int rows;		/**< 字形包围盒的高度 */
+	LCUI_Pos advance;	/**< XY轴的跨距 */
+} LCUI_FontMetrics;
+
 typedef struct LCUI_FontEngine LCUI_FontEngine;
 
 typedef struct LCUI_FontRec_ {
@@ -84,6 +104,16 @@ struct LCUI_FontEngine {
 	int(*open)(const char*, LCUI_Font**);
 	int(*render)(LCUI_FontBitmap*, wchar_t, int, LCUI_Font);
 	void(*close)(void*);
+	/**
+	 * 在指定的渲染线程中渲染字形，最后一个参数为线程序号，取值范围为
+	 * [0, LCUI_FONT_RENDER_THREADS)，为 NULL 时表示该引擎不支持并行渲染
+	 */
+	int(*render_in_thread)(LCUI_FontBitmap*, wchar_t, int, LCUI_Font, int);
+	/**
+	 * 只载入字形的度量数据，不渲染位图，为 NULL 时表示该引擎不支持，
+	 * 度量数据将从渲染出的字形位图中获取
+	 */
+	int(*get_metrics)(LCUI_FontMetrics*, wchar_t, int, LCUI_Font);
 };
 
 /**
@@ -114,6 +144,9 @@ int LCUIFont_InitFreeType(LCUI_FontEngine *engine);
 
 int LCUIFont_ExitFreeType(void);
 
+/** 如果字体索引有改动，则将其保存到索引文件中 */
+void LCUIFont_SaveFreeTypeIndex(void);
+
 #endif
 
 /** 获取内置的 Inconsolata 字体位图 */
@@ -221,6 +254,69 @@ LCUI_API LCUI_FontBitmap* LCUIFont_AddBitmap(wchar_t ch, int font_id,
 LCUI_API int LCUIFont_GetBitmap(wchar_t ch, int font_id, int size,
 				const LCUI_FontBitmap **bmp);
 
+/**
+ * 获取字形的度量数据
+ * 度量数据有单独的缓存，获取它不会渲染和缓存字形位图，适用于只需要测量
+ * 尺寸的文本排版。
+ * @param[in] ch 字符码
+ * @param[in] font_id 使用的字体ID
+ * @param[in] size 字体大小（单位为像素）
+ * @param[out] metrics 输出的度量数据的引用，请勿释放它
+ * @returns 获取成功则返回 0，该字体中没有此字符则返回负数，此时输出的是
+ *  该字体中缺省字形的度量数据
+ */
+LCUI_API int LCUIFont_GetMetrics(wchar_t ch, int font_id, int size,
+				 const LCUI_FontMetrics **metrics);
+
+/**
+ * 请求获取字体位图，若缓存中没有，则交给渲染线程异步渲染
+ * 在未启用异步渲染时，此函数的行为与 LCUIFont_GetBitmap() 一致。
+ * @param[in] ch 字符码
+ * @param[in] font_id 使用的字体ID
+ * @param[in] size 字体大小（单位为像素）
+ * @param[out] bmp 输出的字体位图的引用，正在渲染时输出的是一个只有估算跨
+ *  距的占位位图
+ * @returns 已缓存则返回 0，正在渲染则返回 1，该字体中没有此字符则返回负数
+ */
+LCUI_API int LCUIFont_RequestBitmap(wchar_t ch, int font_id, int size,
+				    const LCUI_FontBitmap **bmp);
+
+/**
+ * 预先渲染文本中的字符
+ * 适用于提前渲染即将显示的文本，例如：程序启动时的常用字、列表中将要滚动
+ * 到可见区域的内容，字形位图会在渲染线程中生成，不会阻塞当前线程。
+ * @returns 新加入渲染队列的字符数量
+ */
+LCUI_API size_t LCUIFont_PrefetchBitmaps(const wchar_t *text, int font_id,
+					 int size);
+
+/** 将排队中的字形位图渲染请求分批提交给渲染线程 */
+LCUI_API void LCUIFont_FlushBitmapRequests(void);
+
+/**
+ * 将已渲染完的字形位图加入缓存，并触发 LCUI_FONT_EVENT_BITMAPS_READY 事件
+ * 需要在主线程中调用，LCUI_RunFrame() 会在每一帧中调用它。
+ * @returns 已处理的字形位图数量
+ */
+LCUI_API size_t LCUIFont_ProcessBitmapRequests(void);
+
+/** 等待所有字形位图渲染完成，并将它们加入缓存 */
+LCUI_API size_t LCUIFont_WaitBitmapRequests(void);
+
+/**
+ * 设置是否启用异步渲染
+ * 文本图层按字形的度量数据排版，启用后，在绘制时遇到未缓存的字形不再阻塞
+ * 等待渲染，而是先跳过它，待字形位图渲染完后再重绘。默认不启用。
+ */
+LCUI_API void LCUIFont_EnableAsyncRender(LCUI_BOOL enable);
+
+/** 绑定字体模块的事件 */
+LCUI_API int LCUIFont_BindEvent(int event_id, LCUI_EventFunc func,
+				void *data, void (*destroy_data)(void *));
+
+/** 解除绑定字体模块的事件 */
+LCUI_API int LCUIFont_UnbindEvent(int handler_id);
+
 /** 载入字体至数据库中 */
 LCUI_API int LCUIFont_LoadFile(const char *filepath);
 
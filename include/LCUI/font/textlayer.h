@@ -31,12 +31,15 @@
 #ifndef LCUI_TEXTLAYER_H
 #define LCUI_TEXTLAYER_H
 
+#include <LCUI/thread.h>
+
 LCUI_BEGIN_HEADER
 
 typedef struct LCUI_TextCharRec_ {
-	wchar_t code;                  /**< 字符码 */
-	LCUI_TextStyle style;          /**< 该字符使用的样式数据 */
-	const LCUI_FontBitmap *bitmap; /**< 字体位图数据(只读) */
+	wchar_t code;                    /**< 字符码 */
+	LCUI_TextStyle style;            /**< 该字符使用的样式数据 */
+	const LCUI_FontMetrics *metrics; /**< 字形度量数据(只读)，用于排版 */
+	const LCUI_FontBitmap *bitmap;   /**< 字体位图数据(只读)，绘制时才载入 */
 } LCUI_TextCharRec, *LCUI_TextChar;
 
 /** End Of Line character */
@@ -49,12 +52,13 @@ typedef enum LCUI_EOLChar {
 
 /* 文本行 */
 typedef struct TextRowRec_ {
-	int width;             /**< 宽度 */
-	int height;            /**< 高度 */
-	int text_height;       /**< 当前行中最大字体的高度 */
-	int length;            /**< 该行文本长度 */
-	LCUI_TextChar *string; /**< 该行文本的数据 */
-	LCUI_EOLChar eol;      /**< 行尾结束类型 */
+	int width;                /**< 宽度 */
+	int height;               /**< 高度 */
+	int text_height;          /**< 当前行中最大字体的高度 */
+	int length;               /**< 该行文本长度 */
+	int capacity;             /**< 文本数据的容量 */
+	LCUI_TextCharRec *string; /**< 该行文本的数据，字符连续存放 */
+	LCUI_EOLChar eol;         /**< 行尾结束类型 */
 } LCUI_TextRowRec, *LCUI_TextRow;
 
 /* 文本行列表 */
@@ -102,6 +106,8 @@ typedef struct LCUI_TextLayerRec_ {
 	LCUI_BOOL enable_mulitiline;   /**< 是否启用多行文本模式 */
 	LCUI_BOOL enable_autowrap;     /**< 是否启用自动换行模式 */
 	LCUI_BOOL enable_style_tag;    /**< 是否使用文本样式标签 */
+	LCUI_BOOL bitmaps_pending;     /**< 是否有字形位图正在异步渲染 */
+	LCUI_Mutex mutex;              /**< 绘制时载入字形位图用的互斥锁 */
 	LinkedList dirty_rects;               /**< 脏矩形记录 */
 	LinkedList text_styles;               /**< 样式缓存 */
 	LCUI_TextStyleRec text_default_style; /**< 文本全局样式 */
@@ -195,7 +201,10 @@ LCUI_API int TextLayer_SetText(LCUI_TextLayer layer, const char *utf8_text);
 LCUI_API size_t TextLayer_GetTextW(LCUI_TextLayer layer, size_t start_pos,
 				   size_t max_len, wchar_t *wstr_buff);
 
-/** 计算并获取文本的宽度 */
+/**
+ * 计算并获取文本的宽度
+ * 宽度为最宽的一行中各个字符的跨距之和，空格等没有字形位图的字符也会计入
+ */
 LCUI_API int TextLayer_GetWidth(LCUI_TextLayer layer);
 
 /** 计算并获取文本的高度 */
@@ -227,9 +236,15 @@ LCUI_API void TextLayer_SetWordBreak(LCUI_TextLayer layer,
 /** 设置是否使用样式标签 */
 LCUI_API void TextLayer_EnableStyleTag(LCUI_TextLayer layer, LCUI_BOOL is_true);
 
-/** 重新载入各个文字的字体位图 */
+/** 重新载入各个文字的字形度量数据，字体位图会在绘制时重新载入 */
 LCUI_API void TextLayer_ReloadCharBitmap(LCUI_TextLayer layer);
 
+/**
+ * 在异步渲染的字形位图就绪后，标记需要重绘文本
+ * @returns 如果有正在等待的字形位图则返回 TRUE
+ */
+LCUI_API LCUI_BOOL TextLayer_ReloadPendingBitmaps(LCUI_TextLayer layer);
+
 /** 更新数据 */
 LCUI_API void TextLayer_Update(LCUI_TextLayer layer, LinkedList *rects);
 
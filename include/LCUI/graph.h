@@ -195,6 +195,31 @@ LCUI_API void PixelsFormat(const uchar_t *in_pixels, int in_color_type,
 			   uchar_t *out_pixels, int out_color_type,
 			   size_t pixel_count);
 
+/**
+ * 像素行转换函数，将一行 ARGB 像素转换为其它格式
+ * x 和 y 是这一行的第一个像素在目标图像中的坐标，用于计算抖动阈值
+ */
+typedef void (*LCUI_PixelRowConverter)(uchar_t *dst, const LCUI_ARGB *src,
+				       int width, int x, int y);
+
+/** 转换时使用有序抖动，以减少低色深格式中的色带 */
+#define LCUI_PIXEL_CONVERT_DITHER 1
+
+/**
+ * 获取像素行转换函数
+ * @param[in] color_type 目标格式，支持 ARGB8888、RGB888、RGB565 和 INDEX8
+ * @param[in] flags 转换选项，目前只有 RGB565 支持抖动，其它格式会忽略它
+ * @returns 不支持的格式返回 NULL
+ */
+LCUI_API LCUI_PixelRowConverter LCUI_GetPixelRowConverter(int color_type,
+							  int flags);
+
+/**
+ * 获取 INDEX8 格式的调色板颜色
+ * 索引的高 2 位是红色，中间 4 位是绿色，低 2 位是蓝色。
+ */
+LCUI_API LCUI_Color LCUI_GetIndex8Color(uchar_t index);
+
 /** 改变色彩类型 */
 LCUI_API int Graph_SetColorType(LCUI_Graph *graph, int color_type);
 
@@ -234,6 +259,28 @@ LCUI_API int Graph_SetGreenBits(LCUI_Graph *graph, uchar_t *g, size_t size);
 
 LCUI_API int Graph_SetBlueBits(LCUI_Graph *graph, uchar_t *b, size_t size);
 
+/** Filters used by Graph_Resample() */
+typedef enum LCUI_GraphResampleFilter {
+	LCUI_RESAMPLE_NEAREST,	/**< nearest neighbor, no filtering */
+	LCUI_RESAMPLE_BILINEAR,	/**< triangle filter, area-aware when shrinking */
+	LCUI_RESAMPLE_BOX,	/**< box filter, averages the covered area */
+	LCUI_RESAMPLE_LANCZOS3	/**< three-lobed Lanczos windowed sinc */
+} LCUI_GraphResampleFilter;
+
+/**
+ * 缩放图像
+ * 使用可分离的两趟滤波（先水平后垂直）进行重采样，滤波权重按行和列预先计算
+ * @param[in] graph 源图像
+ * @param[out] buff 用于存放缩放结果的图像
+ * @param[in] filter 滤波器
+ * @param[in] keep_scale 是否保持宽高比
+ * @param[in] width 目标宽度，若小于等于0，则按高度等比例计算
+ * @param[in] height 目标高度，若小于等于0，则按宽度等比例计算
+ */
+LCUI_API int Graph_Resample(const LCUI_Graph *graph, LCUI_Graph *buff,
+			    LCUI_GraphResampleFilter filter,
+			    LCUI_BOOL keep_scale, int width, int height);
+
 LCUI_API int Graph_Zoom(const LCUI_Graph *graph, LCUI_Graph *buff,
 			LCUI_BOOL keep_scale, int width, int height);
 
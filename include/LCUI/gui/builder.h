@@ -47,6 +47,33 @@ LCUI_API LCUI_Widget LCUIBuilder_LoadString(const char *str, int size);
  */
 LCUI_API LCUI_Widget LCUIBuilder_LoadFile(const char *filepath);
 
+/**
+ * 将界面配置文件编译为二进制格式
+ * 编译结果中记录了创建部件的全部操作，部件类型、id、类名和属性名都已经解析
+ * 好了，被引用的 xml 文件会被一起编译进去。部件原型需要在编译前注册好。
+ * @param[in] filepath 界面配置文件路径
+ * @param[in] output_filepath 输出文件路径
+ * @return 成功返回 0，失败返回 -1
+ */
+LCUI_API int LCUIBuilder_CompileFile(const char *filepath,
+				     const char *output_filepath);
+
+/**
+ * 从预编译的二进制数据中载入图形界面
+ * 字符串会被直接引用，所以数据需要按 4 字节对齐，且在函数返回前保持有效
+ * @param[in] data 由 LCUIBuilder_CompileFile() 生成的数据
+ * @param[in] size 数据的字节数
+ * @return 正常载入会返回一个部件，数据无效则返回 NULL
+ */
+LCUI_API LCUI_Widget LCUIBuilder_LoadBinary(const void *data, size_t size);
+
+/**
+ * 将预编译的界面文件映射到内存中并载入
+ * @param[in] filepath 文件路径
+ * @return 正常载入会返回一个部件，出现错误则返回 NULL
+ */
+LCUI_API LCUI_Widget LCUIBuilder_LoadBinaryFile(const char *filepath);
+
 LCUI_END_HEADER
 
 #endif
@@ -93,6 +93,8 @@ typedef struct LCUI_CSSParserCommentContextRec_ LCUI_CSSParserCommentContextRec;
 typedef struct LCUI_CSSParserCommentContextRec_ *LCUI_CSSParserCommentContext;
 typedef struct LCUI_CSSParserRuleContextRec_ LCUI_CSSParserRuleContextRec;
 typedef struct LCUI_CSSParserRuleContextRec_ *LCUI_CSSParserRuleContext;
+typedef struct LCUI_CSSCacheWriterRec_ LCUI_CSSCacheWriterRec;
+typedef struct LCUI_CSSCacheWriterRec_ *LCUI_CSSCacheWriter;
 typedef int (*LCUI_CSSParserFunction)(LCUI_CSSParserContext ctx);
 
 struct LCUI_CSSParserRec_ {
@@ -154,6 +156,8 @@ struct LCUI_CSSParserContextRec_ {
 	LCUI_CSSParserRuleContextRec rule;
 	LCUI_CSSParserStyleContextRec style;
 	LCUI_CSSParserCommentContextRec comment;
+
+	LCUI_CSSCacheWriter cache; /**< 用于记录解析结果的缓存 */
 };
 
 LCUI_API int LCUI_GetStyleValue(const char *str);
@@ -176,6 +180,16 @@ LCUI_API int LCUI_LoadCSSFile(const char *filepath);
 /** 从字符串中载入CSS样式数据，并导入至样式库中 */
 LCUI_API size_t LCUI_LoadCSSString(const char *str, const char *space);
 
+/**
+ * 设置样式缓存的存放目录
+ * 设置后，LCUI_LoadCSSFile() 和 LCUI_LoadCSSString() 会把解析结果保存为二进制
+ * 缓存，下次载入相同的样式时直接从缓存中导入样式表，不再解析 CSS 代码。样式
+ * 文件或字符串的内容有变化时缓存会失效，此时会重新解析并更新缓存。内置组件的
+ * 样式在 LCUI_Init() 中载入，如果也需要缓存，应在此之前调用。
+ * @param[in] dir 目录路径，为 NULL 时不使用缓存
+ */
+LCUI_API void LCUI_SetCSSCacheDir(const char *dir);
+
 LCUI_API LCUI_CSSParserContext CSSParser_Begin(size_t buffer_size,
 					       const char *space);
 
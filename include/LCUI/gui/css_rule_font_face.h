@@ -41,6 +41,11 @@ typedef struct LCUI_CSSFontFaceRec_ {
 LCUI_API void CSSRuleParser_OnFontFace(LCUI_CSSParserContext ctx,
 				       void(*func)(const LCUI_CSSFontFace));
 
+/** 与 CSSRuleParser_OnFontFace() 相同，但回调函数会收到解析器上下文 */
+LCUI_API void CSSRuleParser_OnFontFaceEx(LCUI_CSSParserContext ctx,
+					 void(*func)(LCUI_CSSParserContext,
+						     const LCUI_CSSFontFace));
+
 LCUI_API int CSSParser_InitFontFaceRuleParser(LCUI_CSSParserContext ctx);
 
 LCUI_API void CSSParser_FreeFontFaceRuleParser(LCUI_CSSParserContext ctx);
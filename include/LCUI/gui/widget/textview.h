@@ -38,6 +38,10 @@ LCUI_API int TextView_SetTextW(LCUI_Widget w, const wchar_t *text);
 
 LCUI_API int TextView_SetText(LCUI_Widget w, const char *utf8_text);
 
+/** 获取与标签关联的文本内容 */
+LCUI_API size_t TextView_GetTextW(LCUI_Widget w, size_t start,
+				  size_t max_len, wchar_t *buf);
+
 LCUI_API void TextView_SetLineHeight(LCUI_Widget w, int height);
 
 LCUI_API void TextView_SetTextAlign(LCUI_Widget w, int align);
@@ -112,6 +112,27 @@ typedef struct LCUI_WidgetTaskBoxRec_ {
 	LCUI_BOOL states[LCUI_WTASK_TOTAL_NUM];	/**< 各个任务的状态标记 */
 } LCUI_WidgetTaskBoxRec;
 
+/** 部件内容尺寸的计算参数，包括可用尺寸和部件自身的盒子参数 */
+typedef struct LCUI_WidgetContentSizeKeyRec_ {
+	float width, height;
+	float min_width, max_width;
+	float min_height, max_height;
+	LCUI_Rect2F padding;
+	float border_top, border_right, border_bottom, border_left;
+	int box_sizing;
+} LCUI_WidgetContentSizeKeyRec;
+
+/**
+ * 部件内容尺寸的缓存
+ * 在子部件的尺寸、位置或排列发生变化时失效，失效会向上传递给祖先部件，直到遇到
+ * 尺寸不受子部件影响的重新布局边界。
+ */
+typedef struct LCUI_WidgetContentSizeCacheRec_ {
+	LCUI_BOOL valid;
+	LCUI_WidgetContentSizeKeyRec key;
+	float width, height;
+} LCUI_WidgetContentSizeCacheRec;
+
 /** 部件状态 */
 typedef enum LCUI_WidgetState {
 	LCUI_WSTATE_CREATED = 0,
@@ -125,6 +146,7 @@ typedef enum LCUI_WidgetState {
 typedef struct LCUI_WidgetRec_* LCUI_Widget;
 typedef struct LCUI_WidgetPrototypeRec_ *LCUI_WidgetPrototype;
 typedef struct LCUI_WidgetTaskContextRec_ *LCUI_WidgetTaskContext;
+typedef struct LCUI_WidgetHitIndexRec_ *LCUI_WidgetHitIndex;
 typedef const struct LCUI_WidgetPrototypeRec_ *LCUI_WidgetPrototypeC;
 
 typedef void(*LCUI_WidgetFunction)(LCUI_Widget);
@@ -253,6 +275,7 @@ typedef struct LCUI_WidgetRec_ {
 	LCUI_Rect2F		padding;		/**< 内边距框 */
 	LCUI_Rect2F		margin;			/**< 外边距框 */
 	LCUI_WidgetBoxModelRec	box;			/**< 部件的各个区域信息 */
+	LCUI_WidgetContentSizeCacheRec content_size;	/**< 内容尺寸的缓存 */
 	LCUI_StyleSheet		style;			/**< 当前完整样式表 */
 	LCUI_StyleList		custom_style;		/**< 自定义样式表 */
 	LCUI_CachedStyleSheet	inherited_style;	/**< 通过继承得到的样式表 */
@@ -260,6 +283,9 @@ typedef struct LCUI_WidgetRec_ {
 	LCUI_Widget		parent;			/**< 父部件 */
 	LinkedList		children;		/**< 子部件 */
 	LinkedList		children_show;		/**< 子部件的堆叠顺序记录，由顶到底 */
+	LCUI_Widget		*children_array;	/**< 子部件数组，与 children 的顺序一致 */
+	size_t			children_capacity;	/**< 子部件数组的容量 */
+	LCUI_WidgetHitIndex	hit_index;		/**< 子部件的命中测试索引 */
 	LCUI_WidgetData		data;			/**< 私有数据 */
 	Dict			*attributes;		/**< 属性记录 */
 	LCUI_WidgetPrototypeC	proto;			/**< 原型 */
@@ -317,6 +343,16 @@ LCUI_API LCUI_BOOL Widget_HasStaticWidthParent(LCUI_Widget widget);
 /** 如果部件具有自适应内容的宽度 */
 LCUI_API LCUI_BOOL Widget_HasFitContentWidth(LCUI_Widget w);
 
+/**
+ * 部件是否为重新布局边界
+ * 边界部件的宽高都是确定的，不受子部件影响，子部件的变化不需要让它和它的祖先部
+ * 件重新计算尺寸。
+ */
+LCUI_API LCUI_BOOL Widget_IsRelayoutBoundary(LCUI_Widget w);
+
+/** 让部件及其祖先部件的内容尺寸缓存失效，直到遇到重新布局边界 */
+LCUI_API void Widget_InvalidateContentSize(LCUI_Widget w);
+
 /** 获取根级部件 */
 LCUI_API LCUI_Widget LCUIWidget_GetRoot(void);
 
@@ -415,8 +451,12 @@ LCUI_API void Widget_UpdateDisplay(LCUI_Widget w);
 /** 设置部件为顶级部件 */
 LCUI_API int Widget_Top(LCUI_Widget w);
 
+/** 对子部件的显示列表进行完整的排序 */
 LCUI_API void Widget_SortChildrenShow(LCUI_Widget w);
 
+/** 更新部件在父部件的显示列表中的位置 */
+LCUI_API void Widget_UpdateShowOrder(LCUI_Widget w);
+
 /** 刷新堆叠顺序 */
 LCUI_API void Widget_UpdateZIndex(LCUI_Widget w);
 
@@ -488,6 +528,15 @@ LCUI_API void Widget_ComputeLimitSize(LCUI_Widget w);
 
 LCUI_API size_t LCUIWidget_ClearTrash(void);
 
+/**
+ * 为部件的附属数据分配内存
+ * 分配的内存已被清零，小块内存来自按大小分级的内存池，需要用
+ * LCUIWidget_FreeMemory() 释放
+ */
+LCUI_API void *LCUIWidget_AllocMemory(size_t size);
+
+LCUI_API void LCUIWidget_FreeMemory(void *ptr);
+
 LCUI_API void LCUIWidget_InitBase(void);
 
 LCUI_API void LCUIWidget_FreeRoot(void);
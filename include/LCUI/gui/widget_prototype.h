@@ -49,6 +49,9 @@ LCUI_API LCUI_BOOL Widget_CheckType(LCUI_Widget w, const char *type);
 LCUI_API LCUI_BOOL Widget_CheckPrototype(LCUI_Widget w,
 					 LCUI_WidgetPrototypeC proto);
 
+/** 判断部件原型是否有自定义的内容尺寸计算函数 */
+LCUI_API LCUI_BOOL Widget_HasCustomResizer(LCUI_Widget w);
+
 LCUI_API void *Widget_GetData(LCUI_Widget widget, LCUI_WidgetPrototype proto);
 
 LCUI_API void *Widget_AddData(LCUI_Widget widget,
@@ -54,6 +54,8 @@ LCUI_API void Widget_AddTaskByStyle(LCUI_Widget w, int key);
 /** 直接更新当前部件的样式 */
 LCUI_API void Widget_ExecUpdateStyle(LCUI_Widget w, LCUI_BOOL is_update_all);
 
+LCUI_API void Widget_InitStyleSheets(LCUI_Widget w);
+
 LCUI_API void Widget_DestroyStyleSheets(LCUI_Widget w);
 
 /** 获取选择器结点 */
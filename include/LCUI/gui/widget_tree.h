@@ -33,6 +33,15 @@
 
 LCUI_BEGIN_HEADER
 
+/** 子部件命中测试的迭代器 */
+typedef struct LCUI_WidgetHitIteratorRec_ {
+	float x, y;
+	LinkedListNode *node;
+	LCUI_Widget *items;
+	size_t length;
+	size_t i;
+} LCUI_WidgetHitIteratorRec, *LCUI_WidgetHitIterator;
+
 /** 将部件与子部件列表断开链接 */
 LCUI_API int Widget_Unlink(LCUI_Widget widget);
 
@@ -61,6 +70,22 @@ LCUI_API LCUI_Widget Widget_GetChild(LCUI_Widget w, size_t index);
 LCUI_API size_t Widget_Each(LCUI_Widget w,
 			    void (*callback)(LCUI_Widget, void *), void *arg);
 
+/**
+ * 获取边框盒包含指定坐标的第一个子部件
+ * 子部件按堆叠顺序由顶到底返回，可见性和状态需要由调用者检查。子部件较多时会使用
+ * 网格索引，只检查坐标所在格子中的子部件。
+ */
+LCUI_API LCUI_Widget Widget_GetFirstChildAt(LCUI_Widget w, float x, float y,
+					    LCUI_WidgetHitIterator iter);
+
+/** 获取边框盒包含迭代器坐标的下一个子部件 */
+LCUI_API LCUI_Widget Widget_GetNextChildAt(LCUI_WidgetHitIterator iter);
+
+/** 标记子部件的命中测试索引需要重建，在子部件的位置、尺寸和堆叠顺序变化时调用 */
+LCUI_API void Widget_InvalidateHitIndex(LCUI_Widget w);
+
+LCUI_API void Widget_DestroyHitIndex(LCUI_Widget w);
+
 /** 获取当前点命中的最上层可见部件 */
 LCUI_API LCUI_Widget Widget_At(LCUI_Widget widget, int x, int y);
 
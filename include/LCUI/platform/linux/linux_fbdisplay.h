@@ -35,4 +35,13 @@ LCUI_API LCUI_DisplayDriver LCUI_CreateLinuxFBDisplayDriver(void);
 
 LCUI_API void LCUI_DestroyLinuxFBDisplayDriver(LCUI_DisplayDriver driver);
 
+typedef int (*LCUI_FrameBufferIoctl)(int fd, unsigned long request, void *arg);
+
+/**
+ * 设置访问帧缓冲设备时使用的 ioctl() 函数
+ * 用于在没有真实设备的环境中，以普通文件模拟帧缓冲设备，设置为 NULL 时
+ * 使用系统的 ioctl()。需要在创建驱动之前设置。
+ */
+LCUI_API void LCUI_SetLinuxFBDeviceIoctl(LCUI_FrameBufferIoctl func);
+
 #endif
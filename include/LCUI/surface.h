@@ -77,6 +77,7 @@ LCUI_API void Surface_Update(LCUI_Surface surface);
 
 /**
  * 准备绘制 Surface 中的内容
+ * 绘制区域中已有的内容会被保留
  * @param[in] surface	目标 surface
  * @param[in] rect	需进行绘制的区域，若为NULL，则绘制整个 surface
  * @return		返回绘制上下文句柄
@@ -355,6 +355,7 @@ typedef struct LCUI_BackgroundSize {
 
 typedef struct LCUI_BackgroundStyle {
 	LCUI_Graph image; /**< 背景图 */
+	unsigned image_generation; /**< 背景图的版本号，每次设置背景图时更新 */
 	LCUI_Color color; /**< 背景色 */
 	struct {
 		LCUI_BOOL x, y;
@@ -388,6 +389,8 @@ typedef void (*FuncPtr)(void *);
 
 typedef struct LCUI_WidgetTasksRec_ {
 	clock_t time;
+	int64_t style_time;  /**< 计算样式的耗时，单位为微秒 */
+	int64_t layout_time; /**< 计算布局、尺寸和位置的耗时，单位为微秒 */
 	size_t update_count;
 	size_t refresh_count;
 	size_t layout_count;
@@ -406,6 +409,8 @@ typedef struct LCUI_FrameProfileRec_ {
 	size_t render_count;
 	clock_t render_time;
 	clock_t present_time;
+	int64_t render_wall_time;  /**< 渲染的实际耗时，单位为微秒 */
+	int64_t present_wall_time; /**< 呈现的实际耗时，单位为微秒 */
 
 	LCUI_WidgetTasksProfileRec widget_tasks;
 } LCUI_FrameProfileRec, *LCUI_FrameProfile;
@@ -47,6 +47,12 @@ typedef struct LCUI_EventTriggerRec_ {
 	RBTree handlers;		/**< 事件处理器记录 */
 } LCUI_EventTriggerRec, *LCUI_EventTrigger;
 
+/** 初始化事件触发器，用于内存由调用者自己管理的触发器 */
+LCUI_API void EventTrigger_Init(LCUI_EventTrigger trigger);
+
+/** 清除事件触发器的数据，但不释放它占用的内存 */
+LCUI_API void EventTrigger_Clear(LCUI_EventTrigger trigger);
+
 /** 构建一个事件触发器 */
 LCUI_API LCUI_EventTrigger EventTrigger(void);
 
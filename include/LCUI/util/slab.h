@@ -0,0 +1,72 @@
+﻿/*
+ * slab.h -- slab allocator for small objects
+ *
+ * Copyright (c) 2019, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LCUI_UTIL_SLAB_H
+#define LCUI_UTIL_SLAB_H
+
+/**
+ * 固定大小对象的分配器
+ * 对象按页批量分配，释放后留在页内的空闲链表中供下次复用，页内的对象全部
+ * 释放后才会把这一页还给系统。分配器不是线程安全的，需要调用者自己加锁。
+ */
+typedef struct slab slab_t;
+
+/** 按对象大小分级的分配器，每一级由一个 slab 负责 */
+typedef struct slab_pool slab_pool_t;
+
+LCUI_API slab_t *slab_create(size_t object_size);
+
+LCUI_API void *slab_alloc(slab_t *slab);
+
+/**
+ * 释放对象
+ * 可用于 slab_alloc() 和 slab_pool_alloc() 分配的对象
+ */
+LCUI_API void slab_free(void *ptr);
+
+/** 获取正在使用的对象数量 */
+LCUI_API size_t slab_count(slab_t *slab);
+
+LCUI_API void slab_destroy(slab_t *slab);
+
+LCUI_API slab_pool_t *slab_pool_create(void);
+
+/**
+ * 从内存池中分配一块内存
+ * 超出最大分级的内存，以及 pool 为 NULL 时，直接使用 malloc() 分配
+ */
+LCUI_API void *slab_pool_alloc(slab_pool_t *pool, size_t size);
+
+/** 获取内存池中正在使用的对象数量，不包括直接用 malloc() 分配的内存 */
+LCUI_API size_t slab_pool_count(slab_pool_t *pool);
+
+LCUI_API void slab_pool_destroy(slab_pool_t *pool);
+
+#endif
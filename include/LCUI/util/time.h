@@ -39,6 +39,9 @@ LCUI_API int64_t LCUI_GetTime(void);
 
 LCUI_API int64_t LCUI_GetTimeDelta(int64_t start);
 
+/** 获取单调递增的时间，单位为微秒，用于测量耗时 */
+LCUI_API int64_t LCUI_GetTimeUs(void);
+
 LCUI_API void LCUI_Sleep(unsigned int s);
 
 LCUI_API void LCUI_MSleep(unsigned int ms);
@@ -36,7 +36,11 @@ static struct LCUICursorModule {
 	LCUI_Pos pos;      /* 当前帧的坐标 */
 	LCUI_Pos new_pos;  /* 下一帧将要更新的坐标 */
 	LCUI_BOOL visible; /* 是否可见 */
+	LCUI_BOOL changed; /* 位置、图形或可见性是否有变化 */
+	LCUI_BOOL drawn;   /* 是否已经绘制在 surface 上 */
+	LCUI_Rect rect;    /* 已绘制的区域 */
 	LCUI_Graph graph;  /* 游标的图形 */
+	LCUI_Graph under;  /* 被游标覆盖的内容 */
 } cursor;
 
 static uchar_t cursor_img_rgba[4][12 * 19] = {
@@ -138,6 +142,8 @@ void LCUI_InitCursor(void)
 	LCUI_Graph pic;
 	Graph_Init(&pic);
 	Graph_Init(&cursor.graph);
+	Graph_Init(&cursor.under);
+	cursor.drawn = FALSE;
 	/* 载入自带的游标的图形数据 */
 	LCUICursor_LoadDefualtGraph(&pic);
 	cursor.new_pos.x = LCUIDisplay_GetWidth() / 2;
@@ -151,6 +157,8 @@ void LCUI_InitCursor(void)
 void LCUI_FreeCursor(void)
 {
 	Graph_Free(&cursor.graph);
+	Graph_Free(&cursor.under);
+	cursor.drawn = FALSE;
 }
 
 void LCUICursor_GetRect(LCUI_Rect *rect)
@@ -165,12 +173,7 @@ void LCUICursor_GetRect(LCUI_Rect *rect)
 
 void LCUICursor_Refresh(void)
 {
-	LCUI_Rect rect;
-	if (!cursor.visible) {
-		return;
-	}
-	LCUICursor_GetRect(&rect);
-	LCUIDisplay_InvalidateArea(&rect);
+	cursor.changed = TRUE;
 }
 
 LCUI_BOOL LCUICursor_IsVisible(void)
@@ -186,8 +189,8 @@ void LCUICursor_Show(void)
 
 void LCUICursor_Hide(void)
 {
-	LCUICursor_Refresh();
 	cursor.visible = FALSE;
+	LCUICursor_Refresh();
 }
 
 void LCUICursor_Update(void)
@@ -196,7 +199,6 @@ void LCUICursor_Update(void)
 	    cursor.pos.y == cursor.new_pos.y) {
 		return;
 	}
-	LCUICursor_Refresh();
 	cursor.pos = cursor.new_pos;
 	LCUICursor_Refresh();
 }
@@ -211,7 +213,6 @@ void LCUICursor_SetPos(LCUI_Pos pos)
 int LCUICursor_SetGraph(LCUI_Graph *graph)
 {
 	if (Graph_IsValid(graph)) {
-		LCUICursor_Refresh();
 		if (Graph_IsValid(&cursor.graph)) {
 			Graph_Free(&cursor.graph);
 		}
@@ -238,3 +239,65 @@ int LCUICursor_Paint(LCUI_PaintContext paint)
 	y = cursor.pos.y - paint->rect.y;
 	return Graph_Mix(&paint->canvas, &cursor.graph, x, y, FALSE);
 }
+
+LCUI_BOOL LCUICursor_IsDirty(LinkedList *rects)
+{
+	LinkedListNode *node;
+
+	if (cursor.changed) {
+		return TRUE;
+	}
+	if (!cursor.drawn) {
+		return FALSE;
+	}
+	for (LinkedList_Each(node, rects)) {
+		if (LCUIRect_IsCoverRect(node->data, &cursor.rect)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+void LCUICursor_Erase(LCUI_Surface surface)
+{
+	LCUI_PaintContext paint;
+
+	if (!cursor.drawn) {
+		return;
+	}
+	cursor.drawn = FALSE;
+	paint = Surface_BeginPaint(surface, &cursor.rect);
+	if (!paint) {
+		return;
+	}
+	Graph_Replace(&paint->canvas, &cursor.under, 0, 0);
+	Surface_EndPaint(surface, paint);
+}
+
+LCUI_BOOL LCUICursor_Draw(LCUI_Surface surface)
+{
+	LCUI_Rect rect;
+	LCUI_PaintContext paint;
+
+	cursor.changed = FALSE;
+	if (!cursor.visible || !Graph_IsValid(&cursor.graph)) {
+		return FALSE;
+	}
+	rect.x = cursor.pos.x;
+	rect.y = cursor.pos.y;
+	rect.width = cursor.graph.width;
+	rect.height = cursor.graph.height;
+	paint = Surface_BeginPaint(surface, &rect);
+	if (!paint) {
+		return FALSE;
+	}
+	/* 先保存游标下面的内容，在游标移开后用它恢复这块区域 */
+	if (paint->rect.width > 0 && paint->rect.height > 0) {
+		Graph_Copy(&cursor.under, &paint->canvas);
+		cursor.rect = paint->rect;
+		cursor.drawn = TRUE;
+		LCUICursor_Paint(paint);
+	}
+	Surface_EndPaint(surface, paint);
+	return cursor.drawn;
+}
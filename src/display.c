@@ -167,6 +167,7 @@ static size_t LCUIDisplay_UpdateFlashRects(SurfaceRecord record)
 		if (!paint) {
 			continue;
 		}
+		Graph_FillRect(&paint->canvas, RGB(255, 255, 255), NULL, TRUE);
 		count += Widget_Render(record->widget, paint);
 		if (flash_rect->paint_time != 0) {
 			Graph_Mix(&paint->canvas, &mask, 0, 0, TRUE);
@@ -268,6 +269,7 @@ static size_t LCUIDisplay_RenderSurface(SurfaceRecord record)
 	int i = 0;
 	size_t count = 0;
 	LCUI_BOOL can_render;
+	LCUI_BOOL paint_cursor = FALSE;
 	LCUI_Rect **rect_array;
 	LCUI_SysEventRec ev;
 	LinkedList rects;
@@ -279,6 +281,14 @@ static size_t LCUIDisplay_RenderSurface(SurfaceRecord record)
 	record->rendered = FALSE;
 	LinkedList_Init(&rects);
 	SurfaceRecord_DumpRects(record, &rects);
+	/* 擦除游标后再重绘部件，以保证游标下保存的内容是最新的 */
+	if (can_render && display.mode != LCUI_DMODE_SEAMLESS) {
+		paint_cursor =
+		    display.show_rect_border || LCUICursor_IsDirty(&rects);
+		if (paint_cursor) {
+			LCUICursor_Erase(record->surface);
+		}
+	}
 
 	rect_array = (LCUI_Rect **)malloc(sizeof(LCUI_Rect *) * rects.length);
 	for (LinkedList_Each(node, &rects)) {
@@ -307,20 +317,24 @@ static size_t LCUIDisplay_RenderSurface(SurfaceRecord record)
 		if (!paint) {
 			continue;
 		}
+		Graph_FillRect(&paint->canvas, RGB(255, 255, 255), NULL, TRUE);
 		DEBUG_MSG("rect: (%d,%d,%d,%d)\n", paint->rect.x, paint->rect.y,
 			  paint->rect.width, paint->rect.height);
 		count += Widget_Render(record->widget, paint);
 		if (display.show_rect_border) {
 			LCUIDisplay_AppendFlashRects(record, &paint->rect);
 		}
-		if (display.mode != LCUI_DMODE_SEAMLESS) {
-			LCUICursor_Paint(paint);
-		}
 		Surface_EndPaint(record->surface, paint);
 	}
 	RectList_Clear(&rects);
 	record->rendered = count > 0;
 	count += LCUIDisplay_UpdateFlashRects(record);
+	if (paint_cursor) {
+		if (LCUICursor_Draw(record->surface)) {
+			count += 1;
+		}
+		record->rendered = TRUE;
+	}
 	return count;
 }
 
@@ -919,6 +933,25 @@ int LCUIDisplay_BindEvent(int event_id, LCUI_EventFunc func, void *arg,
 	return -1;
 }
 
+static LCUI_DisplayDriver LCUIDisplay_CreateDriver(void)
+{
+	const char *name = getenv("LCUI_DISPLAY_DRIVER");
+
+	if (name && strcmp(name, "headless") == 0) {
+		return LCUI_CreateHeadlessDisplayDriver();
+	}
+	return LCUI_CreateDisplayDriver();
+}
+
+static void LCUIDisplay_DestroyDriver(LCUI_DisplayDriver driver)
+{
+	if (strcmp(driver->name, "headless") == 0) {
+		LCUI_DestroyHeadlessDisplayDriver(driver);
+		return;
+	}
+	LCUI_DestroyDisplayDriver(driver);
+}
+
 int LCUI_InitDisplay(LCUI_DisplayDriver driver)
 {
 	LCUI_Widget root;
@@ -934,7 +967,7 @@ int LCUI_InitDisplay(LCUI_DisplayDriver driver)
 	LinkedList_Init(&display.rects);
 	LinkedList_Init(&display.surfaces);
 	if (!display.driver) {
-		display.driver = LCUI_CreateDisplayDriver();
+		display.driver = LCUIDisplay_CreateDriver();
 	}
 	if (!display.driver) {
 		Logger_Warning("[display] init failed\n");
@@ -965,7 +998,8 @@ int LCUI_FreeDisplay(void)
 	RectList_Clear(&display.rects);
 	LCUIDisplay_CleanSurfaces();
 	if (display.driver) {
-		LCUI_DestroyDisplayDriver(display.driver);
+		LCUIDisplay_DestroyDriver(display.driver);
+		display.driver = NULL;
 	}
 	return 0;
 }
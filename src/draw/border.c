@@ -28,736 +28,364 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <math.h>
+/**
+ * 圆角边框的绘制和内容区域的裁剪都基于圆角遮罩。遮罩记录了圆角内每个像素
+ * 被边框外边缘和内边缘包围的比例，它只与圆角半径和两条边框线的宽度有关，计
+ * 算一次后就缓存起来，之后的绘制只需要按遮罩混合像素。
+ */
+
+#include <stdlib.h>
+#include <string.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/graph.h>
+#include <LCUI/thread.h>
 
 #define POW2(X) ((X) * (X))
-#define CIRCLE_R(R) (R - 0.5)
-
-/*  Convert screen Y coordinate to geometric Y coordinate */
-#define ToGeoY(Y, CENTER_Y) ((CENTER_Y)-Y)
-
-/*  Convert screen X coordinate to geometric X coordinate */
-#define ToGeoX(X, CENTER_X) (X - (CENTER_X))
-
-#define SmoothLeftPixel(PX, X) (uchar_t)((PX)->a * (1.0 - (X - 1.0 * (int)X)))
-#define SmoothRightPixel(PX, X) (uchar_t)((PX)->a * (X - 1.0 * (int)X))
-
-#define BorderRenderContext()                             \
-	int x, y;                                         \
-	int right;                                        \
-	double circle_x, circle_y;                        \
-	int outer_xi, inner_xi;                           \
-	double outer_x, split_x, inner_x;                 \
-	double outer_d, inner_d;                          \
-                                                          \
-	const double r = CIRCLE_R(radius);                \
-	const double radius_x = max(0, r - yline->width); \
-	const double radius_y = max(0, r - xline->width); \
-	const int width = max(radius, yline->width);      \
-                                                          \
-	LCUI_Rect rect;                                   \
-	LCUI_ARGB *p;                                     \
-	LCUI_Color color;
 
-static double ellipse_x(double radius_x, double radius_y, double y)
-{
-	double value;
-	if (radius_x == radius_y) {
-		value = radius_x * radius_x - y * y;
-	} else {
-		value = (1.0 - 1.0 * (y * y) / (radius_y * radius_y)) *
-			radius_x * radius_x;
-	}
-	if (value < 0) {
-		value = -value;
-	}
-	return sqrt(value);
-}
+/** 每个像素在每个方向上的采样数，用于计算抗锯齿的覆盖率 */
+#define CORNER_MASK_SAMPLES 4
+
+/** 最多缓存的圆角遮罩数量 */
+#define CORNER_MASK_CACHE_SIZE 64
+
+#define MultiplyAlpha(A, B) (uchar_t)(((A) * (B) + 127) / 255)
+
+/** 圆角遮罩的缓存键 */
+typedef struct CornerMaskKeyRec_ {
+	int radius;
+	int xline_width; /**< 水平边框线的宽度，即上边框或下边框的宽度 */
+	int yline_width; /**< 垂直边框线的宽度，即左边框或右边框的宽度 */
+} CornerMaskKeyRec;
 
 /**
- * FIXME: Improve the rounded border drawing code
- * Merge the four functions of DrawBorder* into one function and make it simple.
+ * 圆角遮罩
+ * 按左上角的方向记录，其它三个角在绘制时翻转坐标。
  */
-
-/** Draw border top left corner */
-static int DrawBorderTopLeft(LCUI_Graph *dst, int bound_left, int bound_top,
-			     const LCUI_BorderLine *xline,
-			     const LCUI_BorderLine *yline, unsigned int radius)
+typedef struct CornerMaskRec_ {
+	CornerMaskKeyRec key;
+	int width;
+	int height;
+	uchar_t *outer; /**< 在边框外边缘以内的覆盖率 */
+	uchar_t *inner; /**< 在边框内边缘以内的覆盖率 */
+	uchar_t *split; /**< 是否使用垂直边框线的颜色 */
+	LinkedListNode node;
+} CornerMaskRec, *CornerMask;
+
+typedef struct BorderCornerRec_ {
+	LCUI_Rect rect;
+	LCUI_BOOL flip_x;
+	LCUI_BOOL flip_y;
+	CornerMaskKeyRec key;
+	const LCUI_BorderLine *xline;
+	const LCUI_BorderLine *yline;
+} BorderCornerRec, *BorderCorner;
+
+static struct CornerMaskCacheModule {
+	LCUI_BOOL active;
+	Dict *masks;
+	DictType type;
+	LinkedList lru;	  /**< 按最近使用的时间排列的遮罩 */
+	LCUI_Mutex mutex; /**< 边框在多个线程中绘制，缓存需要加锁访问 */
+} cache;
+
+static LCUI_BOOL CornerMask_IsInOuter(const CornerMaskKeyRec *key, double x,
+				      double y)
 {
-	BorderRenderContext();
-
-	double cirlce_center_x = bound_left + r;
-	double circle_center_y = bound_top + r;
-	double split_k = 1.0 * yline->width / xline->width;
-	double split_center_x = bound_left + 1.0 * yline->width;
-	double split_center_y = bound_top + 1.0 * xline->width;
-	int inner_ellipse_top = (int)split_center_y;
-
-	/* Get the actual rectagle that can be drawn */
-	Graph_GetValidRect(dst, &rect);
-	dst = Graph_GetQuote(dst);
-	if (!Graph_IsValid(dst)) {
-		return -1;
-	}
-	right = min(rect.width, bound_left + width);
-	for (y = 0; y < rect.height; ++y) {
-		outer_x = 0;
-		split_x = 0;
-		inner_x = width;
-		circle_y = ToGeoY(y, circle_center_y);
-		if (r > 0 && circle_y >= 0) {
-			outer_x = r - ellipse_x(r, r, circle_y);
-			if (radius_y > 0 && y >= inner_ellipse_top) {
-				inner_x =
-				    r - ellipse_x(radius_x, radius_y, circle_y);
-			}
-		}
-		if (xline->width > 0) {
-			split_x = split_center_x -
-				  ToGeoY(y, split_center_y) * split_k;
-		}
-		outer_x = bound_left + outer_x;
-		inner_x = bound_left + inner_x;
-		/* Limit coordinates into the current drawing region */
-		outer_x = max(0, min(right, outer_x));
-		inner_x = max(0, min(right, inner_x));
-		outer_xi = max(0, (int)outer_x - (int)radius / 2);
-		inner_xi = min(right, (int)inner_x + (int)radius / 2);
-		p = Graph_GetPixelPointer(dst, rect.x, rect.y + y);
-		/* Clear the outer pixels */
-		for (x = 0; x < outer_xi; ++x, ++p) {
-			p->alpha = 0;
-		}
-		for (; x < inner_xi; ++x, ++p) {
-			outer_d = -1;
-			inner_d = inner_x - 1.0 * x;
-			circle_x = ToGeoX(x, cirlce_center_x);
-			/* If in the circle */
-			if (r > 0 && circle_y >= 0 && circle_x <= 0) {
-				outer_d =
-				    sqrt(POW2(circle_x) + POW2(circle_y)) - r;
-				/* If the inside is a circle is not an ellipse,
-				 * Use the same anti-aliasing method
-				 */
-				if (radius_x == radius_y && radius_y > 0 &&
-				    y >= inner_ellipse_top) {
-					inner_d = outer_d + r - radius_x;
-				}
-			}
-			if (outer_d >= 1.0) {
-				p->alpha = 0;
-				continue;
-			}
-			if (x < split_x) {
-				color = yline->color;
-			} else {
-				color = xline->color;
-			}
-			if (outer_d >= 0) {
-				/* Fill the border color if the border width is
-				 * valid */
-				if (inner_d - outer_d >= 0.5) {
-					*p = color;
-				}
-				p->a = SmoothLeftPixel(p, outer_d);
-			} else if (inner_d >= 1.0) {
-				LCUI_OverPixel(p, &color);
-			} else if (inner_d >= 0) {
-				color.a = SmoothRightPixel(&color, inner_d);
-				LCUI_OverPixel(p, &color);
-			} else {
-				break;
-			}
-		}
+	double r = key->radius;
+
+	if (x >= r || y >= r) {
+		return TRUE;
 	}
-	return 0;
+	return POW2(x - r) + POW2(y - r) <= POW2(r);
 }
 
-static int DrawBorderTopRight(LCUI_Graph *dst, int bound_left, int bound_top,
-			      const LCUI_BorderLine *xline,
-			      const LCUI_BorderLine *yline, unsigned int radius)
+/** 内边缘是一个与外边缘同心的椭圆，它的半径是圆角半径减去边框线宽度 */
+static LCUI_BOOL CornerMask_IsInInner(const CornerMaskKeyRec *key, double x,
+				      double y)
 {
-	BorderRenderContext();
-
-	double circle_center_y = bound_top + r;
-	double circle_center_x = bound_left + width - 1.0 * radius - 0.5;
-	double split_k = 1.0 * yline->width / xline->width;
-	double split_center_x = bound_left + width - 1.0 * yline->width;
-	double split_center_y = bound_top + 1.0 * xline->width;
-	double inner_ellipse_top = split_center_y;
-
-	/* Get the actual rectagle that can be drawn */
-	Graph_GetValidRect(dst, &rect);
-	dst = Graph_GetQuote(dst);
-	if (!Graph_IsValid(dst)) {
-		return -1;
+	double r = key->radius;
+
+	if (x < key->yline_width || y < key->xline_width) {
+		return FALSE;
 	}
-	right = min(rect.width, bound_left + width);
-	for (y = 0; y < rect.height; ++y) {
-		outer_x = width;
-		split_x = 0;
-		inner_x = -1.0;
-		circle_y = ToGeoY(y, circle_center_y);
-		if (r > 0 && circle_y >= 0) {
-			outer_x = width - radius + ellipse_x(r, r, circle_y);
-			if (radius_y > 0 && y >= inner_ellipse_top) {
-				inner_x =
-				    width - radius - 0.5 +
-				    ellipse_x(radius_x, radius_y, circle_y);
-			}
-		}
-		if (xline->width > 0) {
-			split_x = split_center_x +
-				  ToGeoY(y, split_center_y) * split_k;
-		}
-		outer_x = bound_left + outer_x;
-		inner_x = bound_left + inner_x;
-		/* Limit coordinates into the current drawing region */
-		outer_x = max(0, min(right, outer_x));
-		inner_x = max(-1.0, min(outer_x, inner_x));
-		inner_xi = max(0, (int)inner_x - (int)radius / 2);
-		outer_xi = min(right, (int)outer_x + (int)radius / 2);
-		p = Graph_GetPixelPointer(dst, rect.x + inner_xi, rect.y + y);
-		for (x = inner_xi; x < outer_xi; ++x, ++p) {
-			outer_d = -1.0;
-			inner_d = x - inner_x;
-			circle_x = ToGeoX(x, circle_center_x);
-			if (r > 0 && circle_y >= 0 && circle_x >= 0) {
-				outer_d =
-				    sqrt(POW2(circle_x) + POW2(circle_y)) - r;
-				if (radius_x == radius_y && radius_y > 0 &&
-				    y >= inner_ellipse_top) {
-					inner_d = outer_d + r - radius_x;
-				}
-			}
-			if (outer_d >= 1.0) {
-				break;
-			}
-			if (x < split_x) {
-				color = xline->color;
-			} else {
-				color = yline->color;
-			}
-			if (outer_d >= 0) {
-				if (inner_d - outer_d >= 0.5) {
-					*p = color;
-				}
-				p->a = SmoothLeftPixel(p, outer_d);
-			} else if (inner_d >= 0.5) {
-				LCUI_OverPixel(p, &color);
-			} else if (inner_d >= 0) {
-				color.a = SmoothRightPixel(&color, inner_d);
-				LCUI_OverPixel(p, &color);
-			}
-		}
-		/* Clear the outer pixels */
-		for (; x < right; ++x, ++p) {
-			p->alpha = 0;
-		}
+	if (x >= r || y >= r) {
+		return TRUE;
 	}
-	return 0;
+	return POW2((x - r) / (r - key->yline_width)) +
+		   POW2((y - r) / (r - key->xline_width)) <=
+	       1.0;
 }
 
-static int DrawBorderBottomLeft(LCUI_Graph *dst, int bound_left, int bound_top,
-				const LCUI_BorderLine *xline,
-				const LCUI_BorderLine *yline,
-				unsigned int radius)
+static void CornerMask_Destroy(CornerMask mask)
 {
-	BorderRenderContext();
-
-	int height = max(radius, xline->width);
-	double cirlce_center_x = bound_left + r;
-	double circle_center_y = bound_top + height - 1.0 * radius - 0.5;
-	double split_k = 1.0 * yline->width / xline->width;
-	double split_center_x = bound_left + 1.0 * yline->width;
-	double split_center_y = bound_top + height - 1.0 * xline->width;
-	double inner_ellipse_bottom = circle_center_y + radius_y;
-
-	/* Get the actual rectagle that can be drawn */
-	Graph_GetValidRect(dst, &rect);
-	dst = Graph_GetQuote(dst);
-	if (!Graph_IsValid(dst)) {
-		return -1;
-	}
-	right = min(rect.width, bound_left + width);
-	for (y = 0; y < rect.height; ++y) {
-		outer_x = 0;
-		split_x = 0;
-		inner_x = width;
-		circle_y = ToGeoY(y, circle_center_y);
-		if (r > 0 && circle_y <= 0) {
-			outer_x = r - ellipse_x(r, r, circle_y);
-			if (radius_y > 0 && y <= inner_ellipse_bottom) {
-				inner_x =
-				    r - ellipse_x(radius_x, radius_y, circle_y);
-			}
-		}
-		if (xline->width > 0) {
-			split_x = split_center_x +
-				  ToGeoY(y, split_center_y) * split_k;
-		}
-		outer_x = bound_left + outer_x;
-		inner_x = bound_left + inner_x;
-		/* Limit coordinates into the current drawing region */
-		outer_x = max(0, min(right, outer_x));
-		inner_x = max(0, min(right, inner_x));
-		outer_xi = max(0, (int)outer_x - (int)radius / 2);
-		inner_xi = min(right, (int)inner_x + (int)radius / 2);
-		p = Graph_GetPixelPointer(dst, rect.x, rect.y + y);
-		for (x = 0; x < outer_xi; ++x, ++p) {
-			p->alpha = 0;
-		}
-		for (; x < inner_xi; ++x, ++p) {
-			outer_d = -1;
-			inner_d = inner_x - 1.0 * x;
-			circle_x = ToGeoX(x, cirlce_center_x);
-			if (r > 0 && circle_y <= 0 && circle_x <= 0) {
-				outer_d =
-				    sqrt(POW2(circle_x) + POW2(circle_y)) - r;
-				if (radius_x == radius_y && radius_y > 0 &&
-				    y <= inner_ellipse_bottom) {
-					inner_d = outer_d + r - radius_x;
-				}
-			}
-			if (outer_d >= 1.0) {
-				p->alpha = 0;
-				continue;
-			}
-			if (x < split_x) {
-				color = yline->color;
-			} else {
-				color = xline->color;
-			}
-			if (outer_d >= 0) {
-				if (inner_d - outer_d >= 0.5) {
-					*p = color;
-				}
-				p->a = SmoothLeftPixel(p, outer_d);
-			} else if (inner_d >= 1.0) {
-				LCUI_OverPixel(p, &color);
-			} else if (inner_d >= 0) {
-				color.a = SmoothRightPixel(&color, inner_d);
-				LCUI_OverPixel(p, &color);
-			} else {
-				break;
-			}
-		}
-	}
-	return 0;
+	free(mask->outer);
+	free(mask);
 }
 
-static int DrawBorderBottomRight(LCUI_Graph *dst, int bound_left, int bound_top,
-				 const LCUI_BorderLine *xline,
-				 const LCUI_BorderLine *yline,
-				 unsigned int radius)
+static CornerMask CornerMask_Create(const CornerMaskKeyRec *key)
 {
-	BorderRenderContext();
-
-	int height = max(radius, xline->width);
-	double circle_center_y = bound_top + height - 1.0 * radius - 0.5;
-	double circle_center_x = bound_left + width - 1.0 * radius - 0.5;
-	double split_k = 1.0 * yline->width / xline->width;
-	double split_center_x = bound_left + width - 1.0 * yline->width;
-	double split_center_y = bound_top + height - 1.0 * xline->width;
-	double inner_ellipse_bottom = circle_center_y + radius_y;
-
-	/* Get the actual rectagle that can be drawn */
-	Graph_GetValidRect(dst, &rect);
-	dst = Graph_GetQuote(dst);
-	if (!Graph_IsValid(dst)) {
-		return -1;
-	}
-	right = min(rect.width, bound_left + width);
-	for (y = 0; y < rect.height; ++y) {
-		outer_x = width;
-		split_x = 0;
-		inner_x = -1.0;
-		circle_y = ToGeoY(y, circle_center_y);
-		if (r > 0 && circle_y <= 0) {
-			outer_x = width - r + ellipse_x(r, r, circle_y);
-			if (radius_y > 0 && y <= inner_ellipse_bottom &&
-			    y >= circle_center_y) {
-				inner_x =
-				    width - radius - 0.5 +
-				    ellipse_x(radius_x, radius_y, circle_y);
-			}
-		}
-		if (xline->width > 0) {
-			split_x = split_center_x -
-				  ToGeoY(y, split_center_y) * split_k;
-		}
-		outer_x = bound_left + outer_x;
-		inner_x = bound_left + inner_x;
-		outer_x = max(0, min(right, outer_x));
-		inner_x = max(-1.0, min(outer_x, inner_x));
-		inner_xi = max(0, (int)inner_x - (int)radius / 2);
-		outer_xi = min(right, (int)outer_x + (int)radius / 2);
-		p = Graph_GetPixelPointer(dst, rect.x + inner_xi, rect.y + y);
-		for (x = inner_xi; x < outer_xi; ++x, ++p) {
-			outer_d = -1.0;
-			inner_d = 1.0 * x - inner_x;
-			circle_x = ToGeoX(x, circle_center_x);
-			if (r > 0 && circle_y <= 0 && circle_x >= 0) {
-				outer_d =
-				    sqrt(POW2(circle_x) + POW2(circle_y)) - r;
-				if (radius_x == radius_y && radius_y > 0 &&
-				    y <= inner_ellipse_bottom) {
-					inner_d = outer_d + r - radius_x;
+	int x, y, i, j;
+	int outer, inner;
+	double sx, sy;
+	size_t size, offset;
+	const int samples = CORNER_MASK_SAMPLES * CORNER_MASK_SAMPLES;
+	CornerMask mask = NEW(CornerMaskRec, 1);
+
+	mask->key = *key;
+	mask->width = max(key->radius, key->yline_width);
+	mask->height = max(key->radius, key->xline_width);
+	size = mask->width * mask->height;
+	mask->outer = malloc(size * 3);
+	mask->inner = mask->outer + size;
+	mask->split = mask->inner + size;
+	mask->node.data = mask;
+	for (offset = 0, y = 0; y < mask->height; ++y) {
+		for (x = 0; x < mask->width; ++x, ++offset) {
+			outer = 0;
+			inner = 0;
+			for (j = 0; j < CORNER_MASK_SAMPLES; ++j) {
+				sy = y + (j + 0.5) / CORNER_MASK_SAMPLES;
+				for (i = 0; i < CORNER_MASK_SAMPLES; ++i) {
+					sx = x + (i + 0.5) / CORNER_MASK_SAMPLES;
+					outer += CornerMask_IsInOuter(key, sx, sy);
+					inner += CornerMask_IsInInner(key, sx, sy);
 				}
 			}
-			if (outer_d >= 1.0) {
-				break;
-			}
-			if (x < split_x) {
-				color = xline->color;
-			} else {
-				color = yline->color;
-			}
-			if (outer_d >= 0) {
-				if (inner_d - outer_d >= 0.5) {
-					*p = color;
-				}
-				p->a = SmoothLeftPixel(p, outer_d);
-			} else if (inner_d >= 0.5) {
-				LCUI_OverPixel(p, &color);
-			} else if (inner_d >= 0) {
-				color.a = SmoothRightPixel(&color, inner_d);
-				LCUI_OverPixel(p, &color);
-			}
-		}
-		/* Clear the outer pixels */
-		for (; x < right; ++x, ++p) {
-			p->alpha = 0;
+			mask->outer[offset] = (uchar_t)(outer * 255 / samples);
+			mask->inner[offset] = (uchar_t)(inner * 255 / samples);
+			/* 两条边框线在对角线上分界 */
+			mask->split[offset] = (x + 0.5) * key->xline_width <
+					      (y + 0.5) * key->yline_width;
 		}
 	}
-	return 0;
+	return mask;
 }
 
-/**
- * FIXME: Improve the content cropping code
- * Merge the four functions of CropContent* into one function and make it
- * simple.
- */
+static unsigned int CornerMaskCache_Hash(const void *key)
+{
+	return Dict_GenHashFunction((const unsigned char *)key,
+				    sizeof(CornerMaskKeyRec));
+}
 
-/** Crop the top left corner of the content area */
-static int CropContentTopLeft(LCUI_Graph *dst, int bound_left, int bound_top,
-			      double radius_x, double radius_y)
+static int CornerMaskCache_Compare(void *privdata, const void *key1,
+				   const void *key2)
 {
-	int xi, yi;
-	int outer_xi;
-	double x, y, d;
-	double outer_x;
-	double center_x, center_y;
+	return memcmp(key1, key2, sizeof(CornerMaskKeyRec)) == 0;
+}
 
-	LCUI_Rect rect;
-	LCUI_ARGB *p;
+static void CornerMaskCache_Destroy(void *privdata, void *data)
+{
+	CornerMask_Destroy(data);
+}
 
-	radius_x -= 0.5;
-	radius_y -= 0.5;
-	center_x = bound_left + radius_x;
-	center_y = bound_top + radius_y;
-	Graph_GetValidRect(dst, &rect);
-	dst = Graph_GetQuote(dst);
-	if (!Graph_IsValid(dst)) {
-		return -1;
+/** 获取圆角遮罩，在启用缓存时需要先锁定缓存 */
+static CornerMask CornerMask_Get(const CornerMaskKeyRec *key)
+{
+	CornerMask mask;
+	LinkedListNode *node;
+
+	if (!cache.active) {
+		return CornerMask_Create(key);
 	}
-	for (yi = 0; yi < rect.height; ++yi) {
-		y = ToGeoY(yi, center_y);
-		x = ellipse_x(radius_x + 1.0, radius_y + 1.0, y);
-		outer_xi = (int)(center_x - x);
-		outer_xi = max(0, min(outer_xi, rect.width));
-		p = Graph_GetPixelPointer(dst, rect.x, rect.y + yi);
-		for (xi = 0; xi < outer_xi; ++xi, ++p) {
-			p->alpha = 0;
-		}
-		/* If inner ellipse is circle */
-		if (radius_x == radius_y) {
-			for (; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = sqrt(x * x + y * y) - radius_x;
-				if (d >= 1.0) {
-					p->alpha = 0;
-				} else if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
-				} else {
-					break;
-				}
-			}
-		} else {
-			outer_x =
-			    ToGeoX(ellipse_x(radius_x, radius_y, y), center_x);
-			for (; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = x - outer_x;
-				if (d >= 1.0) {
-					p->alpha = 0;
-				} else if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
-				} else {
-					break;
-				}
-			}
-		}
+	mask = Dict_FetchValue(cache.masks, key);
+	if (mask) {
+		LinkedList_Unlink(&cache.lru, &mask->node);
+		LinkedList_InsertNode(&cache.lru, 0, &mask->node);
+		return mask;
 	}
-	return 0;
+	if (cache.lru.length >= CORNER_MASK_CACHE_SIZE) {
+		node = cache.lru.tail.prev;
+		mask = node->data;
+		LinkedList_Unlink(&cache.lru, node);
+		Dict_Delete(cache.masks, &mask->key);
+	}
+	mask = CornerMask_Create(key);
+	LinkedList_InsertNode(&cache.lru, 0, &mask->node);
+	Dict_Add(cache.masks, &mask->key, mask);
+	return mask;
 }
 
-static int CropContentTopRight(LCUI_Graph *dst, int bound_left, int bound_top,
-			       double radius_x, double radius_y)
+static void CornerMask_Release(CornerMask mask)
 {
-	int xi, yi;
-	int outer_xi;
-	double x, y, d;
-	double outer_x;
-	double center_x, center_y;
-
-	LCUI_Rect rect;
-	LCUI_ARGB *p;
+	if (!cache.active) {
+		CornerMask_Destroy(mask);
+	}
+}
 
-	radius_x -= 0.5;
-	radius_y -= 0.5;
-	center_x = bound_left;
-	center_y = bound_top + radius_y;
-	Graph_GetValidRect(dst, &rect);
-	dst = Graph_GetQuote(dst);
-	if (!Graph_IsValid(dst)) {
-		return -1;
+static void BorderCorner_Init(BorderCorner corner, const LCUI_Rect *box,
+			      const LCUI_BorderLine *xline,
+			      const LCUI_BorderLine *yline, int radius,
+			      LCUI_BOOL flip_x, LCUI_BOOL flip_y)
+{
+	corner->xline = xline;
+	corner->yline = yline;
+	corner->flip_x = flip_x;
+	corner->flip_y = flip_y;
+	corner->key.radius = radius;
+	corner->key.xline_width = xline->width;
+	corner->key.yline_width = yline->width;
+	corner->rect.width = max(radius, yline->width);
+	corner->rect.height = max(radius, xline->width);
+	corner->rect.x = box->x;
+	corner->rect.y = box->y;
+	if (flip_x) {
+		corner->rect.x += box->width - corner->rect.width;
 	}
-	for (yi = 0; yi < rect.height; ++yi) {
-		y = ToGeoY(yi, center_y);
-		x = ellipse_x(max(0, radius_x - 1), max(0, radius_y - 1), y);
-		outer_xi = (int)(center_x + x);
-		outer_xi = max(0, outer_xi);
-		p = Graph_GetPixelPointer(dst, rect.x + outer_xi, rect.y + yi);
-		if (radius_x == radius_y) {
-			for (xi = outer_xi; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = sqrt(x * x + y * y) - radius_x;
-				if (d >= 1.0) {
-					break;
-				}
-				if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
-				}
-			}
-		} else {
-			outer_x =
-			    ToGeoX(ellipse_x(radius_x, radius_y, y), center_x);
-			for (xi = outer_xi; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = x - outer_x;
-				if (d >= 1.0) {
-					break;
-				}
-				if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
-				}
-			}
-		}
-		for (; xi < rect.width; ++xi, ++p) {
-			p->alpha = 0;
-		}
+	if (flip_y) {
+		corner->rect.y += box->height - corner->rect.height;
 	}
-	return 0;
 }
 
-static int CropContentBottomLeft(LCUI_Graph *dst, int bound_left, int bound_top,
-				 double radius_x, double radius_y)
+/** 获取内容区域在圆角内的部分 */
+static void BorderCorner_GetContentRect(BorderCorner corner, LCUI_Rect *rect)
 {
-	int xi, yi;
-	int outer_xi;
-	double x, y, d;
-	double outer_x;
-	double center_x, center_y;
+	*rect = corner->rect;
+	rect->width -= corner->key.yline_width;
+	rect->height -= corner->key.xline_width;
+	if (!corner->flip_x) {
+		rect->x += corner->key.yline_width;
+	}
+	if (!corner->flip_y) {
+		rect->y += corner->key.xline_width;
+	}
+}
 
-	LCUI_Rect rect;
+/**
+ * 绘制圆角
+ * 边框线按它所占的面积混合在背景上，边框外的部分按覆盖率变透明。
+ * 当 crop 为 TRUE 时，只按内边缘裁剪内容区域。
+ */
+static void BorderCorner_Paint(BorderCorner corner, LCUI_PaintContext paint,
+			       LCUI_BOOL crop)
+{
+	int x, y, dx;
+	int outer, ring, offset;
+	LCUI_Rect area, rect;
+	LCUI_Graph canvas, *src;
+	LCUI_Color color;
 	LCUI_ARGB *p;
+	CornerMask mask;
 
-	radius_x -= 0.5;
-	radius_y -= 0.5;
-	center_x = bound_left + radius_x;
-	center_y = bound_top;
-	Graph_GetValidRect(dst, &rect);
-	dst = Graph_GetQuote(dst);
-	if (!Graph_IsValid(dst)) {
-		return -1;
+	if (crop) {
+		BorderCorner_GetContentRect(corner, &area);
+	} else {
+		area = corner->rect;
 	}
-	for (yi = 0; yi < rect.height; ++yi) {
-		y = ToGeoY(yi, center_y);
-		x = ellipse_x(radius_x + 1.0, radius_y + 1.0, y);
-		outer_xi = (int)(center_x - x);
-		outer_xi = max(0, min(outer_xi, rect.width));
-		p = Graph_GetPixelPointer(dst, rect.x, rect.y + yi);
-		for (xi = 0; xi < outer_xi; ++xi, ++p) {
-			p->alpha = 0;
-		}
-		if (radius_x == radius_y) {
-			for (; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = sqrt(x * x + y * y) - radius_x;
-				if (d >= 1.0) {
-					p->alpha = 0;
-				} else if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
-				} else {
-					break;
+	if (area.width <= 0 || area.height <= 0 ||
+	    !LCUIRect_GetOverlayRect(&area, &paint->rect, &area)) {
+		return;
+	}
+	rect.x = area.x - paint->rect.x;
+	rect.y = area.y - paint->rect.y;
+	rect.width = area.width;
+	rect.height = area.height;
+	Graph_Quote(&canvas, &paint->canvas, &rect);
+	Graph_GetValidRect(&canvas, &rect);
+	src = Graph_GetQuote(&canvas);
+	if (!Graph_IsValid(src)) {
+		return;
+	}
+	/* 将区域坐标转换为圆角内的坐标 */
+	area.x -= corner->rect.x;
+	area.y -= corner->rect.y;
+	dx = corner->flip_x ? -1 : 1;
+	if (cache.active) {
+		LCUIMutex_Lock(&cache.mutex);
+	}
+	mask = CornerMask_Get(&corner->key);
+	for (y = 0; y < rect.height; ++y) {
+		p = Graph_GetPixelPointer(src, rect.x, rect.y + y);
+		offset = corner->flip_y ? mask->height - 1 - area.y - y
+					: area.y + y;
+		offset *= mask->width;
+		offset += corner->flip_x ? mask->width - 1 - area.x : area.x;
+		if (crop) {
+			for (x = 0; x < rect.width; ++x, ++p, offset += dx) {
+				if (mask->inner[offset] < 255) {
+					p->a = MultiplyAlpha(
+					    p->a, mask->inner[offset]);
 				}
 			}
-		} else {
-			outer_x =
-			    ToGeoX(ellipse_x(radius_x, radius_y, y), center_x);
-			for (; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = x - outer_x;
-				if (d >= 1.0) {
-					p->alpha = 0;
-				} else if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
+			continue;
+		}
+		for (x = 0; x < rect.width; ++x, ++p, offset += dx) {
+			outer = mask->outer[offset];
+			if (outer == 0) {
+				p->a = 0;
+				continue;
+			}
+			ring = outer - mask->inner[offset];
+			if (ring > 0) {
+				if (mask->split[offset]) {
+					color = corner->yline->color;
 				} else {
-					break;
+					color = corner->xline->color;
 				}
+				color.a = (uchar_t)(color.a * ring / outer);
+				LCUI_OverPixel(p, &color);
+			}
+			if (outer < 255) {
+				p->a = MultiplyAlpha(p->a, outer);
 			}
 		}
 	}
-	return 0;
+	CornerMask_Release(mask);
+	if (cache.active) {
+		LCUIMutex_Unlock(&cache.mutex);
+	}
 }
 
-static int CropContentBottomRight(LCUI_Graph *dst, int bound_left,
-				  int bound_top, double radius_x,
-				  double radius_y)
+static void Border_PaintCorners(const LCUI_Border *border, const LCUI_Rect *box,
+				LCUI_PaintContext paint, LCUI_BOOL crop)
 {
-	int xi, yi;
-	int outer_xi;
-	double x, y, d;
-	double outer_x;
-	double center_x, center_y;
+	BorderCornerRec corner;
+
+	BorderCorner_Init(&corner, box, &border->top, &border->left,
+			  border->top_left_radius, FALSE, FALSE);
+	BorderCorner_Paint(&corner, paint, crop);
+	BorderCorner_Init(&corner, box, &border->top, &border->right,
+			  border->top_right_radius, TRUE, FALSE);
+	BorderCorner_Paint(&corner, paint, crop);
+	BorderCorner_Init(&corner, box, &border->bottom, &border->left,
+			  border->bottom_left_radius, FALSE, TRUE);
+	BorderCorner_Paint(&corner, paint, crop);
+	BorderCorner_Init(&corner, box, &border->bottom, &border->right,
+			  border->bottom_right_radius, TRUE, TRUE);
+	BorderCorner_Paint(&corner, paint, crop);
+}
 
-	LCUI_Rect rect;
-	LCUI_ARGB *p;
+void Border_InitCache(void)
+{
+	cache.type.hashFunction = CornerMaskCache_Hash;
+	cache.type.keyCompare = CornerMaskCache_Compare;
+	cache.type.valDestructor = CornerMaskCache_Destroy;
+	cache.masks = Dict_Create(&cache.type, NULL);
+	LinkedList_Init(&cache.lru);
+	LCUIMutex_Init(&cache.mutex);
+	cache.active = TRUE;
+}
 
-	radius_x -= 0.5;
-	radius_y -= 0.5;
-	center_x = bound_left;
-	center_y = bound_top;
-	Graph_GetValidRect(dst, &rect);
-	dst = Graph_GetQuote(dst);
-	if (!Graph_IsValid(dst)) {
-		return -1;
-	}
-	for (yi = 0; yi < rect.height; ++yi) {
-		y = ToGeoY(yi, center_y);
-		x = ellipse_x(max(0, radius_x - 1), max(0, radius_y - 1), y);
-		outer_xi = (int)(center_x + x);
-		outer_xi = max(0, outer_xi);
-		p = Graph_GetPixelPointer(dst, rect.x + outer_xi, rect.y + yi);
-		if (radius_x == radius_y) {
-			for (xi = outer_xi; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = sqrt(x * x + y * y) - radius_x;
-				if (d >= 1.0) {
-					break;
-				}
-				if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
-				}
-			}
-		} else {
-			outer_x =
-			    ToGeoX(ellipse_x(radius_x, radius_y, y), center_x);
-			for (xi = outer_xi; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = x - outer_x;
-				if (d >= 1.0) {
-					break;
-				}
-				if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
-				}
-			}
-		}
-		for (; xi < rect.width; ++xi, ++p) {
-			p->alpha = 0;
-		}
+void Border_FreeCache(void)
+{
+	if (!cache.active) {
+		return;
 	}
-	return 0;
+	cache.active = FALSE;
+	/* 遮罩都由字典管理，列表中只是引用 */
+	LinkedList_Init(&cache.lru);
+	Dict_Release(cache.masks);
+	LCUIMutex_Destroy(&cache.mutex);
+	cache.masks = NULL;
 }
 
 int Border_CropContent(const LCUI_Border *border, const LCUI_Rect *box,
 		       LCUI_PaintContext paint)
 {
-	LCUI_Graph canvas;
-	LCUI_Rect bound, rect;
-
-	int radius;
-	int bound_top, bound_left;
-
-	radius = border->top_left_radius;
-	bound.x = box->x + border->left.width;
-	bound.y = box->y + border->top.width;
-	bound.width = radius - border->left.width;
-	bound.height = radius - border->top.width;
-	if (bound.width > 0 && bound.height > 0 &&
-	    LCUIRect_GetOverlayRect(&bound, &paint->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= paint->rect.x;
-		rect.y -= paint->rect.y;
-		Graph_Quote(&canvas, &paint->canvas, &rect);
-		CropContentTopLeft(&canvas, bound_left, bound_top, bound.width,
-				   bound.height);
-	}
-
-	radius = border->top_right_radius;
-	bound.x = box->x + box->width - radius;
-	bound.y = box->y + border->top.width;
-	bound.width = radius - border->right.width;
-	bound.height = radius - border->top.width;
-	if (bound.width > 0 && bound.height > 0 &&
-	    LCUIRect_GetOverlayRect(&bound, &paint->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= paint->rect.x;
-		rect.y -= paint->rect.y;
-		Graph_Quote(&canvas, &paint->canvas, &rect);
-		CropContentTopRight(&canvas, bound_left, bound_top, bound.width,
-				    bound.height);
-	}
-
-	radius = border->bottom_left_radius;
-	bound.x = box->x + border->left.width;
-	bound.y = box->y + box->height - radius;
-	bound.width = radius - border->left.width;
-	bound.height = radius - border->bottom.width;
-	if (bound.width > 0 && bound.height > 0 &&
-	    LCUIRect_GetOverlayRect(&bound, &paint->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= paint->rect.x;
-		rect.y -= paint->rect.y;
-		Graph_Quote(&canvas, &paint->canvas, &rect);
-		CropContentBottomLeft(&canvas, bound_left, bound_top,
-				      bound.width, bound.height);
-	}
-
-	radius = border->bottom_right_radius;
-	bound.x = box->x + box->width - radius;
-	bound.y = box->y + box->height - radius;
-	;
-	bound.width = radius - border->right.width;
-	bound.height = radius - border->bottom.width;
-	if (bound.width > 0 && bound.height > 0 &&
-	    LCUIRect_GetOverlayRect(&bound, &paint->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= paint->rect.x;
-		rect.y -= paint->rect.y;
-		Graph_Quote(&canvas, &paint->canvas, &rect);
-		CropContentBottomRight(&canvas, bound_left, bound_top,
-				       bound.width, bound.height);
+	if (!Graph_IsValid(&paint->canvas)) {
+		return -1;
 	}
+	Border_PaintCorners(border, box, paint, TRUE);
 	return 0;
 }
 
@@ -765,9 +393,8 @@ int Border_Paint(const LCUI_Border *border, const LCUI_Rect *box,
 		 LCUI_PaintContext paint)
 {
 	LCUI_Graph canvas;
-	LCUI_Rect bound, rect;
+	LCUI_Rect bound;
 
-	int bound_top, bound_left;
 	int tl_width = max(border->top_left_radius, border->left.width);
 	int tl_height = max(border->top_left_radius, border->top.width);
 	int tr_width = max(border->top_right_radius, border->right.width);
@@ -780,64 +407,7 @@ int Border_Paint(const LCUI_Border *border, const LCUI_Rect *box,
 	if (!Graph_IsValid(&paint->canvas)) {
 		return -1;
 	}
-	/* Draw border top left angle */
-	bound.x = box->x;
-	bound.y = box->y;
-	bound.width = tl_width;
-	bound.height = tl_height;
-	if (LCUIRect_GetOverlayRect(&bound, &paint->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= paint->rect.x;
-		rect.y -= paint->rect.y;
-		Graph_Quote(&canvas, &paint->canvas, &rect);
-		DrawBorderTopLeft(&canvas, bound_left, bound_top, &border->top,
-				  &border->left, border->top_left_radius);
-	}
-	/* Draw border top right angle */
-	bound.y = box->y;
-	bound.width = tr_width;
-	bound.height = tr_height;
-	bound.x = box->x + box->width - bound.width;
-	if (LCUIRect_GetOverlayRect(&bound, &paint->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= paint->rect.x;
-		rect.y -= paint->rect.y;
-		Graph_Quote(&canvas, &paint->canvas, &rect);
-		DrawBorderTopRight(&canvas, bound_left, bound_top, &border->top,
-				   &border->right, border->top_right_radius);
-	}
-	/* Draw border bottom left angle */
-	bound.x = box->x;
-	bound.width = bl_width;
-	bound.height = bl_height;
-	bound.y = box->y + box->height - bound.height;
-	if (LCUIRect_GetOverlayRect(&bound, &paint->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= paint->rect.x;
-		rect.y -= paint->rect.y;
-		Graph_Quote(&canvas, &paint->canvas, &rect);
-		DrawBorderBottomLeft(&canvas, bound_left, bound_top,
-				     &border->bottom, &border->left,
-				     border->bottom_left_radius);
-	}
-	/* Draw border bottom right angle */
-	bound.width = br_width;
-	bound.height = br_height;
-	bound.x = box->x + box->width - bound.width;
-	bound.y = box->y + box->height - bound.height;
-	if (LCUIRect_GetOverlayRect(&bound, &paint->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= paint->rect.x;
-		rect.y -= paint->rect.y;
-		Graph_Quote(&canvas, &paint->canvas, &rect);
-		DrawBorderBottomRight(&canvas, bound_left, bound_top,
-				      &border->bottom, &border->right,
-				      border->bottom_right_radius);
-	}
+	Border_PaintCorners(border, box, paint, FALSE);
 	/* Draw top border line */
 	bound.x = box->x + tl_width;
 	bound.y = box->y;
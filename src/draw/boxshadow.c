@@ -35,9 +35,11 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/graph.h>
+#include <LCUI/thread.h>
 
 #define BLUR_N 1.5
 #define BLUR_WIDTH(sd) (int)(sd->blur * BLUR_N)
@@ -57,6 +59,12 @@
 #define SmoothLeftPixel(PX, X) (uchar_t)((PX)->a * (1.0 - (X - 1.0 * (int)X)))
 #define SmoothRightPixel(PX, X) (uchar_t)((PX)->a * (X - 1.0 * (int)X))
 
+/** 最多缓存的阴影数量 */
+#define BOX_SHADOW_CACHE_SIZE 64
+
+/** 九宫格图像的最大像素数量，超过它的阴影直接绘制，不缓存 */
+#define BOX_SHADOW_CACHE_MAX_PIXELS (512 * 512)
+
 typedef struct BoxShadowRenderingContextRec {
 	int max_radius;
 	const LCUI_BoxShadow *shadow;
@@ -66,6 +74,43 @@ typedef struct BoxShadowRenderingContextRec {
 	LCUI_PaintContext paint;
 } BoxShadowRenderingContextRec, *BoxShadowRenderingContext;
 
+/** 阴影九宫格的缓存键，形状和颜色相同的阴影共用同一份缓存 */
+typedef struct BoxShadowCacheKeyRec_ {
+	LCUI_Color color;
+	int blur;
+	int spread;
+	int top_left_radius;
+	int top_right_radius;
+	int bottom_left_radius;
+	int bottom_right_radius;
+	int width;
+	int height;
+} BoxShadowCacheKeyRec;
+
+/**
+ * 阴影九宫格
+ * 图像由四个角和一像素宽的边组成，绘制时将中间的那一行和一列拉伸到实际尺
+ * 寸。当阴影的尺寸小到不能拆分时，图像就是整个阴影，left 和 top 等于图像
+ * 的宽高，right 和 bottom 为 0。
+ */
+typedef struct BoxShadowCacheRec_ {
+	BoxShadowCacheKeyRec key;
+	int left;		/**< 左边不拉伸的宽度 */
+	int right;		/**< 右边不拉伸的宽度 */
+	int top;		/**< 上边不拉伸的高度 */
+	int bottom;		/**< 下边不拉伸的高度 */
+	LCUI_Graph image;
+	LinkedListNode node;
+} BoxShadowCacheRec, *BoxShadowCache;
+
+static struct BoxShadowCacheModule {
+	LCUI_BOOL active;
+	Dict *caches;
+	DictType type;
+	LinkedList lru;		/**< 按最近使用的时间排列的缓存 */
+	LCUI_Mutex mutex;	/**< 阴影在多个线程中绘制，缓存需要加锁访问 */
+} cache;
+
 typedef struct gradient {
 	int s;
 	double v;
@@ -599,6 +644,282 @@ static void BoxShadow_ClearContentRect(BoxShadowRenderingContext ctx)
 	RectList_Clear(&rects);
 }
 
+/**
+ * 将绘制好的阴影混合到画布上
+ * 内容区域中除了四个圆角外的像素都已被清除，不需要混合。
+ */
+static void BoxShadow_MixCanvas(BoxShadowRenderingContext ctx,
+				LCUI_PaintContext paint)
+{
+	LCUI_Rect rect;
+	LCUI_Rect inner;
+	LCUI_Graph fore;
+	LinkedList rects;
+	LinkedListNode *node;
+	const LCUI_BoxShadow *shadow = ctx->shadow;
+	int left = max(shadow->top_left_radius, shadow->bottom_left_radius);
+	int right = max(shadow->top_right_radius, shadow->bottom_right_radius);
+	int top = max(shadow->top_left_radius, shadow->top_right_radius);
+	int bottom =
+	    max(shadow->bottom_left_radius, shadow->bottom_right_radius);
+
+	inner.x = ctx->content_box.x + left;
+	inner.y = ctx->content_box.y + top;
+	inner.width = ctx->content_box.width - left - right;
+	inner.height = ctx->content_box.height - top - bottom;
+	if (inner.width <= 0 || inner.height <= 0) {
+		Graph_Mix(&paint->canvas, &ctx->paint->canvas, 0, 0,
+			  paint->with_alpha);
+		return;
+	}
+	LinkedList_Init(&rects);
+	RectList_Add(&rects, &paint->rect);
+	RectList_Delete(&rects, &inner);
+	for (LinkedList_Each(node, &rects)) {
+		rect = *(LCUI_Rect *)node->data;
+		rect.x -= paint->rect.x;
+		rect.y -= paint->rect.y;
+		Graph_Quote(&fore, &ctx->paint->canvas, &rect);
+		Graph_Mix(&paint->canvas, &fore, rect.x, rect.y,
+			  paint->with_alpha);
+	}
+	RectList_Clear(&rects);
+}
+
+static void BoxShadow_Render(BoxShadowRenderingContext ctx)
+{
+	BoxShadow_FillRect(ctx);
+	BoxShadow_PaintLeftBlur(ctx);
+	BoxShadow_PaintRightBlur(ctx);
+	BoxShadow_PaintTopBlur(ctx);
+	BoxShadow_PaintBottomBlur(ctx);
+	BoxShadow_PaintTopLeftBlur(ctx);
+	BoxShadow_PaintTopRightBlur(ctx);
+	BoxShadow_PaintBottomLeftBlur(ctx);
+	BoxShadow_PaintBottomRightBlur(ctx);
+}
+
+static unsigned int BoxShadowCache_Hash(const void *key)
+{
+	return Dict_GenHashFunction((const unsigned char *)key,
+				    sizeof(BoxShadowCacheKeyRec));
+}
+
+static int BoxShadowCache_Compare(void *privdata, const void *key1,
+				  const void *key2)
+{
+	return memcmp(key1, key2, sizeof(BoxShadowCacheKeyRec)) == 0;
+}
+
+static void BoxShadowCache_Destroy(void *privdata, void *data)
+{
+	BoxShadowCache c = data;
+
+	Graph_Free(&c->image);
+	free(c);
+}
+
+INLINE int BoxShadow_GetCornerSize(BoxShadowRenderingContext ctx, int radius)
+{
+	return max(0, min(ctx->max_radius, FULL_SHADOW_WIDTH(ctx) + radius));
+}
+
+/**
+ * 计算九宫格的各边尺寸
+ * 四个角和四条边的渐变都在不拉伸的区域内，中间的行和列上的像素只与其中一
+ * 个坐标有关，所以用一像素就能表示。
+ */
+static void BoxShadowCache_Init(BoxShadowCache c, BoxShadowRenderingContext ctx)
+{
+	const LCUI_BoxShadow *shadow = ctx->shadow;
+	int tl = BoxShadow_GetCornerSize(ctx, shadow->top_left_radius);
+	int tr = BoxShadow_GetCornerSize(ctx, shadow->top_right_radius);
+	int bl = BoxShadow_GetCornerSize(ctx, shadow->bottom_left_radius);
+	int br = BoxShadow_GetCornerSize(ctx, shadow->bottom_right_radius);
+	int blur = max(0, BLUR_WIDTH(shadow));
+
+	memset(&c->key, 0, sizeof(c->key));
+	c->key.color = shadow->color;
+	c->key.blur = shadow->blur;
+	c->key.spread = shadow->spread;
+	c->key.top_left_radius = tl;
+	c->key.top_right_radius = tr;
+	c->key.bottom_left_radius = bl;
+	c->key.bottom_right_radius = br;
+	c->left = max(blur, max(tl, bl));
+	c->right = max(blur, max(tr, br));
+	c->top = max(blur, max(tl, tr));
+	c->bottom = max(blur, max(bl, br));
+	if (ctx->shadow_box.width > c->left + c->right + 1) {
+		c->key.width = c->left + c->right + 1;
+	} else {
+		c->key.width = ctx->shadow_box.width;
+		c->left = c->key.width;
+		c->right = 0;
+	}
+	if (ctx->shadow_box.height > c->top + c->bottom + 1) {
+		c->key.height = c->top + c->bottom + 1;
+	} else {
+		c->key.height = ctx->shadow_box.height;
+		c->top = c->key.height;
+		c->bottom = 0;
+	}
+}
+
+/** 用与直接绘制相同的方法绘制九宫格图像 */
+static int BoxShadowCache_Render(BoxShadowCache c,
+				 BoxShadowRenderingContext ctx)
+{
+	LCUI_PaintContextRec paint;
+	BoxShadowRenderingContextRec image_ctx = *ctx;
+
+	Graph_Init(&c->image);
+	c->image.color_type = LCUI_COLOR_TYPE_ARGB;
+	if (Graph_Create(&c->image, c->key.width, c->key.height) != 0) {
+		return -1;
+	}
+	paint.rect.x = 0;
+	paint.rect.y = 0;
+	paint.rect.width = c->key.width;
+	paint.rect.height = c->key.height;
+	paint.with_alpha = TRUE;
+	paint.canvas = c->image;
+	image_ctx.paint = &paint;
+	image_ctx.shadow_box = paint.rect;
+	BoxShadow_Render(&image_ctx);
+	return 0;
+}
+
+static BoxShadowCache BoxShadowCache_Get(BoxShadowRenderingContext ctx)
+{
+	BoxShadowCache c, old;
+	BoxShadowCacheRec key;
+
+	BoxShadowCache_Init(&key, ctx);
+	if (key.key.width * key.key.height > BOX_SHADOW_CACHE_MAX_PIXELS) {
+		return NULL;
+	}
+	c = Dict_FetchValue(cache.caches, &key.key);
+	if (c) {
+		LinkedList_Unlink(&cache.lru, &c->node);
+		LinkedList_InsertNode(&cache.lru, 0, &c->node);
+		return c;
+	}
+	c = NEW(BoxShadowCacheRec, 1);
+	if (!c) {
+		return NULL;
+	}
+	*c = key;
+	if (BoxShadowCache_Render(c, ctx) != 0) {
+		free(c);
+		return NULL;
+	}
+	if (cache.lru.length >= BOX_SHADOW_CACHE_SIZE) {
+		old = cache.lru.tail.prev->data;
+		LinkedList_Unlink(&cache.lru, &old->node);
+		Dict_Delete(cache.caches, &old->key);
+	}
+	c->node.data = c;
+	LinkedList_InsertNode(&cache.lru, 0, &c->node);
+	Dict_Add(cache.caches, &c->key, c);
+	return c;
+}
+
+/**
+ * 复制九宫格中的一行像素
+ * @param[in] x 在阴影中的起始横坐标
+ * @param[in] box_width 阴影的实际宽度
+ */
+static void BoxShadowCache_CopyRow(BoxShadowCache c, LCUI_ARGB *dst,
+				   const LCUI_ARGB *src, int x, int width,
+				   int box_width)
+{
+	int n;
+	int end = x + width;
+	int right = box_width - c->right;
+
+	if (x < c->left) {
+		n = min(end, c->left) - x;
+		memcpy(dst, src + x, sizeof(LCUI_ARGB) * n);
+		dst += n;
+		x += n;
+	}
+	for (; x < end && x < right; ++x, ++dst) {
+		*dst = src[c->left];
+	}
+	if (x < end) {
+		n = end - x;
+		x -= box_width - c->key.width;
+		memcpy(dst, src + x, sizeof(LCUI_ARGB) * n);
+	}
+}
+
+/** 将缓存的九宫格拉伸到阴影的实际尺寸 */
+static LCUI_BOOL BoxShadow_PaintCache(BoxShadowRenderingContext ctx)
+{
+	int y, sy, box_height;
+	LCUI_Rect rect;
+	LCUI_ARGB *dst;
+	BoxShadowCache c;
+
+	if (!cache.active) {
+		return FALSE;
+	}
+	LCUIMutex_Lock(&cache.mutex);
+	c = BoxShadowCache_Get(ctx);
+	if (!c) {
+		LCUIMutex_Unlock(&cache.mutex);
+		return FALSE;
+	}
+	if (!LCUIRect_GetOverlayRect(&ctx->shadow_box, &ctx->paint->rect,
+				     &rect)) {
+		LCUIMutex_Unlock(&cache.mutex);
+		return TRUE;
+	}
+	box_height = ctx->shadow_box.height;
+	for (y = rect.y; y < rect.y + rect.height; ++y) {
+		sy = y - ctx->shadow_box.y;
+		if (sy >= box_height - c->bottom) {
+			sy -= box_height - c->key.height;
+		} else if (sy >= c->top) {
+			sy = c->top;
+		}
+		dst = Graph_GetPixelPointer(&ctx->paint->canvas,
+					    rect.x - ctx->paint->rect.x,
+					    y - ctx->paint->rect.y);
+		BoxShadowCache_CopyRow(
+		    c, dst, Graph_GetPixelPointer(&c->image, 0, sy),
+		    rect.x - ctx->shadow_box.x, rect.width,
+		    ctx->shadow_box.width);
+	}
+	LCUIMutex_Unlock(&cache.mutex);
+	return TRUE;
+}
+
+void BoxShadow_InitCache(void)
+{
+	cache.type.hashFunction = BoxShadowCache_Hash;
+	cache.type.keyCompare = BoxShadowCache_Compare;
+	cache.type.valDestructor = BoxShadowCache_Destroy;
+	cache.caches = Dict_Create(&cache.type, NULL);
+	LinkedList_Init(&cache.lru);
+	LCUIMutex_Init(&cache.mutex);
+	cache.active = TRUE;
+}
+
+void BoxShadow_FreeCache(void)
+{
+	if (!cache.active) {
+		return;
+	}
+	cache.active = FALSE;
+	/* 缓存都由字典管理，列表中只是引用 */
+	LinkedList_Init(&cache.lru);
+	Dict_Release(cache.caches);
+	LCUIMutex_Destroy(&cache.mutex);
+	cache.caches = NULL;
+}
+
 int BoxShadow_Paint(const LCUI_BoxShadow *shadow, const LCUI_Rect *box,
 		    int content_width, int content_height,
 		    LCUI_PaintContext paint)
@@ -637,21 +958,15 @@ int BoxShadow_Paint(const LCUI_BoxShadow *shadow, const LCUI_Rect *box,
 	shadow_paint.canvas.color_type = LCUI_COLOR_TYPE_ARGB;
 	Graph_Create(&ctx.paint->canvas, paint->rect.width, paint->rect.height);
 
-	/* Render box shadow */
-	BoxShadow_FillRect(&ctx);
-	BoxShadow_PaintLeftBlur(&ctx);
-	BoxShadow_PaintRightBlur(&ctx);
-	BoxShadow_PaintTopBlur(&ctx);
-	BoxShadow_PaintBottomBlur(&ctx);
-	BoxShadow_PaintTopLeftBlur(&ctx);
-	BoxShadow_PaintTopRightBlur(&ctx);
-	BoxShadow_PaintBottomLeftBlur(&ctx);
-	BoxShadow_PaintBottomRightBlur(&ctx);
+	/* Render box shadow, reuse the cached nine-patch if possible */
+	if (!BoxShadow_PaintCache(&ctx)) {
+		BoxShadow_Render(&ctx);
+	}
 	/* Clear pixels that overlap the content area */
 	BoxShadow_ClearContentRect(&ctx);
 
 	/* Render the rendered shadow bitmap to the canvas */
-	Graph_Mix(&paint->canvas, &ctx.paint->canvas, 0, 0, paint->with_alpha);
+	BoxShadow_MixCanvas(&ctx, paint);
 	Graph_Free(&ctx.paint->canvas);
 	return 0;
 }
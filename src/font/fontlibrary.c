@@ -37,12 +37,24 @@
 #include <LCUI/types.h>
 #include <LCUI/util.h>
 #include <LCUI/graph.h>
+#include <LCUI/thread.h>
+#include <LCUI/worker.h>
 #include <LCUI/font.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FONT_MIX_WITH_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FONT_MIX_WITH_NEON
+#include <arm_neon.h>
+#endif
+
 /* clang-format off */
 
 #define FONT_CACHE_SIZE		32
 #define FONT_CACHE_MAX_SIZE	1024
+#define FONT_RENDER_BATCH_SIZE	16
 
 /**
  * 库中缓存的字体位图是分组存放的，共有三级分组，分别为：
@@ -82,6 +94,9 @@ static struct LCUI_FontLibraryModule {
 	Dict *font_families;		/**< 字族信息库，以字族名称索引字体信息 */
 	DictType font_families_type;	/**< 字族信息库的字典类型数据 */
 	RBTree bitmap_cache;		/**< 字体位图缓存区 */
+	LCUI_Mutex mutex;		/**< 文本在多个线程中绘制，位图缓存需要加锁访问 */
+	Dict *metrics_cache;		/**< 字形度量数据缓存区 */
+	DictType metrics_cache_type;	/**< 字形度量数据缓存区的字典类型数据 */
 	LCUI_FontCache *font_cache;	/**< 字体信息缓存区 */
 	LCUI_Font default_font;		/**< 默认字体的信息 */
 	LCUI_Font incore_font;		/**< 内置字体的信息 */
@@ -89,6 +104,60 @@ static struct LCUI_FontLibraryModule {
 	LCUI_FontEngine *engine;	/**< 当前选择的字体引擎 */
 } fontlib;
 
+/** 字形度量数据缓存项 */
+typedef struct LCUI_FontMetricsEntryRec_ {
+	wchar_t ch;
+	int font_id;
+	int size;
+	int ret;			/**< 获取度量数据时的返回值 */
+	LCUI_FontMetrics metrics;
+} LCUI_FontMetricsEntryRec, *LCUI_FontMetricsEntry;
+
+/** 字形位图渲染请求的状态 */
+typedef enum LCUI_FontBitmapRequestState {
+	FONT_REQUEST_QUEUED,		/**< 正在排队，尚未交给渲染线程 */
+	FONT_REQUEST_RENDERING,		/**< 正在渲染 */
+	FONT_REQUEST_FAILED		/**< 字体中没有该字符，替换字体后清除 */
+} LCUI_FontBitmapRequestState;
+
+/** 字形位图渲染请求 */
+typedef struct LCUI_FontBitmapRequestRec_ {
+	wchar_t ch;
+	int font_id;
+	int size;
+	int ret;			/**< 渲染函数的返回值 */
+	LCUI_Font font;
+	LCUI_FontBitmap bitmap;
+	LCUI_FontBitmapRequestState state;
+	LinkedListNode node;
+} LCUI_FontBitmapRequestRec, *LCUI_FontBitmapRequest;
+
+/** 交给同一个渲染线程处理的一批请求 */
+typedef struct LCUI_FontBitmapBatchRec_ {
+	int thread;			/**< 渲染线程的序号 */
+	LinkedList requests;
+} LCUI_FontBitmapBatchRec, *LCUI_FontBitmapBatch;
+
+/**
+ * 字形位图渲染器
+ * 请求表、排队列表和占位位图与位图缓存一样由 fontlib.mutex 保护，渲染结果
+ * 列表和计数器由 renderer.mutex 保护，渲染线程只接触交给它的那一批请求。
+ */
+static struct LCUI_FontRendererModule {
+	LCUI_BOOL async;		/**< 文本图层是否使用异步渲染 */
+	LCUI_BOOL active;		/**< 渲染线程是否在运行 */
+	size_t running;			/**< 尚未渲染完的批次数量 */
+	Dict *requests;			/**< 请求表，用于合并重复的请求 */
+	DictType requests_type;		/**< 请求表的字典类型数据 */
+	LinkedList queue;		/**< 排队中的请求 */
+	LinkedList results;		/**< 已渲染完的请求 */
+	RBTree placeholders;		/**< 占位用的字体位图 */
+	LCUI_Mutex mutex;
+	LCUI_Cond cond;
+	LCUI_EventTrigger trigger;
+	LCUI_Worker workers[LCUI_FONT_RENDER_THREADS];
+} renderer;
+
 /* clang-format on */
 
 #define FontBitmap_IsValid(fbmp) \
@@ -261,6 +330,40 @@ static void DestroyTreeNode(void *arg)
 	free(arg);
 }
 
+/** 等待渲染线程处理完所有已提交的请求 */
+static void LCUIFont_WaitRenderer(void)
+{
+	if (!renderer.active) {
+		return;
+	}
+	LCUIMutex_Lock(&renderer.mutex);
+	while (renderer.running > 0) {
+		LCUICond_Wait(&renderer.cond, &renderer.mutex);
+	}
+	LCUIMutex_Unlock(&renderer.mutex);
+}
+
+/** 清除字体的失败请求，替换后的字体可能有这些字符 */
+static void LCUIFont_ClearFailedRequests(int font_id)
+{
+	DictEntry *entry;
+	DictIterator *iter;
+	LCUI_FontBitmapRequest req;
+
+	LCUIMutex_Lock(&fontlib.mutex);
+	iter = Dict_GetSafeIterator(renderer.requests);
+	while ((entry = Dict_Next(iter))) {
+		req = DictEntry_GetVal(entry);
+		/* 排队中的和已渲染完的请求还被列表引用，不能在这里删除 */
+		if (req->font_id == font_id &&
+		    req->state == FONT_REQUEST_FAILED) {
+			Dict_Delete(renderer.requests, req);
+		}
+	}
+	Dict_ReleaseIterator(iter);
+	LCUIMutex_Unlock(&fontlib.mutex);
+}
+
 int LCUIFont_Add(LCUI_Font font)
 {
 	LCUI_Font exists_font;
@@ -282,6 +385,9 @@ int LCUIFont_Add(LCUI_Font font)
 			fontlib.default_font = font;
 		}
 		ClearFontWeight(snode, font->weight);
+		/* 渲染线程可能正在使用旧字体，需等它们处理完 */
+		LCUIFont_WaitRenderer();
+		LCUIFont_ClearFailedRequests(font->id);
 		DeleteFont(exists_font);
 	} else {
 		font->id = ++fontlib.count;
@@ -522,8 +628,9 @@ void LCUIFont_SetDefault(int id)
 	}
 }
 
-LCUI_FontBitmap *LCUIFont_AddBitmap(wchar_t ch, int font_id, int size,
-				    const LCUI_FontBitmap *bmp)
+static LCUI_FontBitmap *LCUIFont_CacheBitmap(wchar_t ch, int font_id,
+					     int size,
+					     const LCUI_FontBitmap *bmp)
 {
 	LCUI_FontBitmap *bmp_cache;
 	RBTree *tree_font, *tree_bmp;
@@ -571,52 +678,491 @@ LCUI_FontBitmap *LCUIFont_AddBitmap(wchar_t ch, int font_id, int size,
 	return bmp_cache;
 }
 
+LCUI_FontBitmap *LCUIFont_AddBitmap(wchar_t ch, int font_id, int size,
+				    const LCUI_FontBitmap *bmp)
+{
+	LCUI_FontBitmap *bmp_cache;
+
+	if (!fontlib.active) {
+		return NULL;
+	}
+	LCUIMutex_Lock(&fontlib.mutex);
+	bmp_cache = LCUIFont_CacheBitmap(ch, font_id, size, bmp);
+	LCUIMutex_Unlock(&fontlib.mutex);
+	return bmp_cache;
+}
+
+static int LCUIFont_GetValidId(int font_id)
+{
+	if (font_id > 0) {
+		return font_id;
+	}
+	if (fontlib.default_font) {
+		return fontlib.default_font->id;
+	}
+	return fontlib.incore_font->id;
+}
+
+static LCUI_FontBitmap *LCUIFont_GetCachedBitmap(wchar_t ch, int font_id,
+						 int size)
+{
+	RBTree *ctx;
+
+	if (!(ctx = SelectChar(ch))) {
+		return NULL;
+	}
+	ctx = SelectFont(ctx, font_id);
+	if (!ctx) {
+		return NULL;
+	}
+	return SelectBitmap(ctx, size);
+}
+
+static int LCUIFont_LoadBitmap(wchar_t ch, int font_id, int size,
+			       const LCUI_FontBitmap **bmp)
+{
+	int ret;
+	LCUI_FontBitmap bmp_cache;
+
+	*bmp = LCUIFont_GetCachedBitmap(ch, font_id, size);
+	if (*bmp) {
+		return 0;
+	}
+	if (ch == 0) {
+		return -1;
+	}
+	FontBitmap_Init(&bmp_cache);
+	ret = LCUIFont_RenderBitmap(&bmp_cache, ch, font_id, size);
+	if (ret == 0) {
+		*bmp = LCUIFont_CacheBitmap(ch, font_id, size, &bmp_cache);
+		return 0;
+	}
+	ret = LCUIFont_LoadBitmap(0, font_id, size, bmp);
+	if (ret != 0) {
+		*bmp = LCUIFont_CacheBitmap(0, font_id, size, &bmp_cache);
+	}
+	return -1;
+}
+
 int LCUIFont_GetBitmap(wchar_t ch, int font_id, int size,
 		       const LCUI_FontBitmap **bmp)
 {
 	int ret;
-	RBTree *ctx;
-	LCUI_FontBitmap bmp_cache;
 
 	*bmp = NULL;
 	if (!fontlib.active) {
 		return -2;
 	}
-	if (font_id <= 0) {
-		if (fontlib.default_font) {
-			font_id = fontlib.default_font->id;
-		} else {
-			font_id = fontlib.incore_font->id;
+	font_id = LCUIFont_GetValidId(font_id);
+	LCUIMutex_Lock(&fontlib.mutex);
+	ret = LCUIFont_LoadBitmap(ch, font_id, size, bmp);
+	LCUIMutex_Unlock(&fontlib.mutex);
+	return ret;
+}
+
+static unsigned int FontMetricsEntry_Hash(const void *key)
+{
+	const LCUI_FontMetricsEntryRec *entry = key;
+	unsigned int hash = 5381;
+
+	hash = hash * 33 + (unsigned int)entry->ch;
+	hash = hash * 33 + (unsigned int)entry->font_id;
+	hash = hash * 33 + (unsigned int)entry->size;
+	return hash;
+}
+
+static int FontMetricsEntry_Compare(void *privdata, const void *key1,
+				    const void *key2)
+{
+	const LCUI_FontMetricsEntryRec *a = key1;
+	const LCUI_FontMetricsEntryRec *b = key2;
+
+	return a->ch == b->ch && a->font_id == b->font_id &&
+	       a->size == b->size;
+}
+
+static void FontMetricsEntry_Destroy(void *privdata, void *data)
+{
+	free(data);
+}
+
+static int LCUIFont_LoadMetrics(LCUI_FontMetrics *metrics, wchar_t ch,
+				int font_id, int size)
+{
+	int ret;
+	LCUI_Font font;
+	const LCUI_FontBitmap *bmp;
+
+	memset(metrics, 0, sizeof(LCUI_FontMetrics));
+	font = LCUIFont_GetById(font_id);
+	if (font && font->engine && font->engine->get_metrics) {
+		return font->engine->get_metrics(metrics, ch, size, font);
+	}
+	/* 字体引擎不支持单独载入度量数据，只能从字形位图中获取 */
+	ret = LCUIFont_GetBitmap(ch, font_id, size, &bmp);
+	if (bmp) {
+		metrics->top = bmp->top;
+		metrics->left = bmp->left;
+		metrics->width = bmp->width;
+		metrics->rows = bmp->rows;
+		metrics->advance = bmp->advance;
+	}
+	return ret;
+}
+
+int LCUIFont_GetMetrics(wchar_t ch, int font_id, int size,
+			const LCUI_FontMetrics **metrics)
+{
+	LCUI_FontMetricsEntry entry;
+	LCUI_FontMetricsEntryRec key;
+
+	*metrics = NULL;
+	if (!fontlib.active) {
+		return -2;
+	}
+	key.ch = ch;
+	key.font_id = LCUIFont_GetValidId(font_id);
+	key.size = size;
+	entry = Dict_FetchValue(fontlib.metrics_cache, &key);
+	if (!entry) {
+		entry = NEW(LCUI_FontMetricsEntryRec, 1);
+		if (!entry) {
+			return -2;
 		}
+		*entry = key;
+		entry->ret = LCUIFont_LoadMetrics(&entry->metrics, ch,
+						  key.font_id, size);
+		Dict_Add(fontlib.metrics_cache, entry, entry);
 	}
-	do {
-		if (!(ctx = SelectChar(ch))) {
-			break;
+	*metrics = &entry->metrics;
+	return entry->ret;
+}
+
+static unsigned int FontBitmapRequest_Hash(const void *key)
+{
+	const LCUI_FontBitmapRequestRec *req = key;
+	unsigned int hash = 5381;
+
+	hash = hash * 33 + (unsigned int)req->ch;
+	hash = hash * 33 + (unsigned int)req->font_id;
+	hash = hash * 33 + (unsigned int)req->size;
+	return hash;
+}
+
+static int FontBitmapRequest_Compare(void *privdata, const void *key1,
+				     const void *key2)
+{
+	const LCUI_FontBitmapRequestRec *a = key1;
+	const LCUI_FontBitmapRequestRec *b = key2;
+
+	return a->ch == b->ch && a->font_id == b->font_id &&
+	       a->size == b->size;
+}
+
+static void FontBitmapRequest_Destroy(void *privdata, void *data)
+{
+	LCUI_FontBitmapRequest req = data;
+
+	FontBitmap_Free(&req->bitmap);
+	free(req);
+}
+
+/**
+ * 获取占位用的字体位图
+ * 在字形渲染完成前，全角字符的跨距按字体大小估算，其它字符按一半估算，
+ * 以减少字形渲染完成后重新排版时的文字抖动。
+ */
+static const LCUI_FontBitmap *LCUIFont_GetPlaceholder(wchar_t ch, int size)
+{
+	int key = size * 2 + (ch >= 0x2E80 ? 1 : 0);
+	LCUI_FontBitmap *bmp = RBTree_GetData(&renderer.placeholders, key);
+
+	if (bmp) {
+		return bmp;
+	}
+	bmp = NEW(LCUI_FontBitmap, 1);
+	if (!bmp) {
+		return NULL;
+	}
+	FontBitmap_Init(bmp);
+	/* 文本图层会跳过没有位图数据的字形，所以给它一个空的位图数据 */
+	bmp->buffer = NEW(uchar_t, 1);
+	bmp->advance.x = (key & 1) ? size : size / 2;
+	bmp->advance.y = size;
+	RBTree_Insert(&renderer.placeholders, key, bmp);
+	return bmp;
+}
+
+/**
+ * 添加字形位图渲染请求
+ * @returns 已缓存则返回 0，正在渲染则返回 1，渲染失败则返回 -1，该字体不支
+ *  持异步渲染则返回 -2
+ */
+static int LCUIFont_AddBitmapRequest(wchar_t ch, int font_id, int size,
+				     const LCUI_FontBitmap **bmp)
+{
+	LCUI_Font font;
+	LCUI_FontBitmapRequest req;
+	LCUI_FontBitmapRequestRec key;
+
+	*bmp = LCUIFont_GetCachedBitmap(ch, font_id, size);
+	if (*bmp) {
+		return 0;
+	}
+	key.ch = ch;
+	key.font_id = font_id;
+	key.size = size;
+	req = Dict_FetchValue(renderer.requests, &key);
+	if (req) {
+		if (req->state == FONT_REQUEST_FAILED) {
+			return -1;
 		}
-		ctx = SelectFont(ctx, font_id);
-		if (!ctx) {
-			break;
+		*bmp = LCUIFont_GetPlaceholder(ch, size);
+		return 1;
+	}
+	font = LCUIFont_GetById(font_id);
+	if (!font || !font->engine || !font->engine->render_in_thread) {
+		return -2;
+	}
+	req = NEW(LCUI_FontBitmapRequestRec, 1);
+	if (!req) {
+		return -2;
+	}
+	*req = key;
+	req->state = FONT_REQUEST_QUEUED;
+	req->node.data = req;
+	FontBitmap_Init(&req->bitmap);
+	Dict_Add(renderer.requests, req, req);
+	LinkedList_AppendNode(&renderer.queue, &req->node);
+	*bmp = LCUIFont_GetPlaceholder(ch, size);
+	return 1;
+}
+
+static LCUI_BOOL LCUIFont_IsRendererActive(void)
+{
+	LCUI_BOOL active;
+
+	LCUIMutex_Lock(&renderer.mutex);
+	active = renderer.active;
+	LCUIMutex_Unlock(&renderer.mutex);
+	return active;
+}
+
+static void LCUIFont_RenderBitmapBatch(void *arg1, void *arg2)
+{
+	LinkedListNode *node;
+	LCUI_FontBitmapRequest req;
+	LCUI_FontBitmapBatch batch = arg1;
+
+	for (LinkedList_Each(node, &batch->requests)) {
+		req = node->data;
+		/* 渲染器停止后，剩下的请求直接放弃 */
+		if (!LCUIFont_IsRendererActive()) {
+			req->ret = -2;
+			continue;
 		}
-		*bmp = SelectBitmap(ctx, size);
-		if (*bmp) {
-			return 0;
+		req->ret = req->font->engine->render_in_thread(
+		    &req->bitmap, req->ch, req->size, req->font, batch->thread);
+	}
+	LCUIMutex_Lock(&renderer.mutex);
+	LinkedList_Concat(&renderer.results, &batch->requests);
+	renderer.running -= 1;
+	LCUICond_Broadcast(&renderer.cond);
+	LCUIMutex_Unlock(&renderer.mutex);
+	free(batch);
+}
+
+static void LCUIFont_StartRenderer(void)
+{
+	int i;
+
+	if (renderer.active) {
+		return;
+	}
+	renderer.active = TRUE;
+	for (i = 0; i < LCUI_FONT_RENDER_THREADS; ++i) {
+		renderer.workers[i] = LCUIWorker_New();
+		LCUIWorker_RunAsync(renderer.workers[i]);
+	}
+}
+
+static void LCUIFont_SubmitBitmapRequests(void)
+{
+	int i, n;
+	LCUI_TaskRec task = { 0 };
+	LinkedListNode *node;
+	LCUI_FontBitmapRequest req;
+	LCUI_FontBitmapBatch batches[LCUI_FONT_RENDER_THREADS];
+
+	if (!fontlib.active || renderer.queue.length < 1) {
+		return;
+	}
+	LCUIFont_StartRenderer();
+	/* 请求较少时只用部分线程，避免每个线程只分到一两个字 */
+	n = (int)((renderer.queue.length + FONT_RENDER_BATCH_SIZE - 1) /
+		  FONT_RENDER_BATCH_SIZE);
+	n = min(n, LCUI_FONT_RENDER_THREADS);
+	for (i = 0; i < n; ++i) {
+		batches[i] = NEW(LCUI_FontBitmapBatchRec, 1);
+		batches[i]->thread = i;
+		LinkedList_Init(&batches[i]->requests);
+	}
+	for (i = 0; renderer.queue.length > 0;) {
+		node = LinkedList_GetNode(&renderer.queue, 0);
+		LinkedList_Unlink(&renderer.queue, node);
+		req = node->data;
+		/* 字体可能在请求排队期间被替换，所以在这里才获取字体 */
+		req->font = LCUIFont_GetById(req->font_id);
+		if (!req->font || !req->font->engine->render_in_thread) {
+			req->ret = -2;
+			LCUIMutex_Lock(&renderer.mutex);
+			LinkedList_AppendNode(&renderer.results, node);
+			LCUIMutex_Unlock(&renderer.mutex);
+			continue;
 		}
-		break;
-	} while (0);
-	if (ch == 0) {
-		return -1;
+		req->state = FONT_REQUEST_RENDERING;
+		LinkedList_AppendNode(&batches[i]->requests, node);
+		i = (i + 1) % n;
+	}
+	task.func = LCUIFont_RenderBitmapBatch;
+	for (i = 0; i < n; ++i) {
+		if (batches[i]->requests.length < 1) {
+			free(batches[i]);
+			continue;
+		}
+		LCUIMutex_Lock(&renderer.mutex);
+		renderer.running += 1;
+		LCUIMutex_Unlock(&renderer.mutex);
+		task.arg[0] = batches[i];
+		LCUIWorker_PostTask(renderer.workers[i], &task);
 	}
-	FontBitmap_Init(&bmp_cache);
-	ret = LCUIFont_RenderBitmap(&bmp_cache, ch, font_id, size);
-	if (ret == 0) {
-		*bmp = LCUIFont_AddBitmap(ch, font_id, size, &bmp_cache);
+}
+
+void LCUIFont_FlushBitmapRequests(void)
+{
+	if (!fontlib.active) {
+		return;
+	}
+	LCUIMutex_Lock(&fontlib.mutex);
+	LCUIFont_SubmitBitmapRequests();
+	LCUIMutex_Unlock(&fontlib.mutex);
+}
+
+size_t LCUIFont_ProcessBitmapRequests(void)
+{
+	size_t count = 0;
+	LinkedList results;
+	LinkedListNode *node;
+	LCUI_FontBitmapRequest req;
+
+	if (!fontlib.active || !renderer.active) {
 		return 0;
 	}
-	ret = LCUIFont_GetBitmap(0, font_id, size, bmp);
-	if (ret != 0) {
-		*bmp = LCUIFont_AddBitmap(0, font_id, size, &bmp_cache);
+	LinkedList_Init(&results);
+	LCUIMutex_Lock(&renderer.mutex);
+	LinkedList_Concat(&results, &renderer.results);
+	LCUIMutex_Unlock(&renderer.mutex);
+	LCUIMutex_Lock(&fontlib.mutex);
+	while (results.length > 0) {
+		node = LinkedList_GetNode(&results, 0);
+		LinkedList_Unlink(&results, node);
+		req = node->data;
+		if (req->ret == 0) {
+			LCUIFont_CacheBitmap(req->ch, req->font_id, req->size,
+					     &req->bitmap);
+			FontBitmap_Init(&req->bitmap);
+			Dict_Delete(renderer.requests, req);
+		} else if (req->ret == -1) {
+			/* 保留失败的请求，以免反复渲染字体中没有的字符 */
+			FontBitmap_Free(&req->bitmap);
+			req->state = FONT_REQUEST_FAILED;
+		} else {
+			/* 其它错误可能只是暂时的，丢弃请求，下次再重新渲染 */
+			Dict_Delete(renderer.requests, req);
+		}
+		++count;
 	}
-	return -1;
+	LCUIMutex_Unlock(&fontlib.mutex);
+	if (count > 0) {
+		EventTrigger_Trigger(renderer.trigger,
+				     LCUI_FONT_EVENT_BITMAPS_READY, NULL);
+	}
+	return count;
+}
+
+size_t LCUIFont_WaitBitmapRequests(void)
+{
+	LCUIFont_FlushBitmapRequests();
+	LCUIFont_WaitRenderer();
+	return LCUIFont_ProcessBitmapRequests();
+}
+
+int LCUIFont_RequestBitmap(wchar_t ch, int font_id, int size,
+			   const LCUI_FontBitmap **bmp)
+{
+	int ret;
+
+	*bmp = NULL;
+	if (!fontlib.active) {
+		return -2;
+	}
+	font_id = LCUIFont_GetValidId(font_id);
+	LCUIMutex_Lock(&fontlib.mutex);
+	ret = -2;
+	if (renderer.async && ch != 0) {
+		ret = LCUIFont_AddBitmapRequest(ch, font_id, size, bmp);
+	}
+	if (ret == -2) {
+		ret = LCUIFont_LoadBitmap(ch, font_id, size, bmp);
+	}
+	LCUIMutex_Unlock(&fontlib.mutex);
+	return ret;
+}
+
+size_t LCUIFont_PrefetchBitmaps(const wchar_t *text, int font_id, int size)
+{
+	size_t count;
+	const wchar_t *p;
+	const LCUI_FontBitmap *bmp;
+
+	if (!fontlib.active || !text) {
+		return 0;
+	}
+	font_id = LCUIFont_GetValidId(font_id);
+	LCUIMutex_Lock(&fontlib.mutex);
+	count = renderer.queue.length;
+	for (p = text; *p; ++p) {
+		if (*p > ' ') {
+			LCUIFont_AddBitmapRequest(*p, font_id, size, &bmp);
+		}
+	}
+	count = renderer.queue.length - count;
+	LCUIFont_SubmitBitmapRequests();
+	LCUIMutex_Unlock(&fontlib.mutex);
+	return count;
+}
+
+void LCUIFont_EnableAsyncRender(LCUI_BOOL enable)
+{
+	renderer.async = enable;
+}
+
+int LCUIFont_BindEvent(int event_id, LCUI_EventFunc func, void *data,
+		       void (*destroy_data)(void *))
+{
+	if (!renderer.trigger) {
+		return -1;
+	}
+	return EventTrigger_Bind(renderer.trigger, event_id, func, data,
+				 destroy_data);
+}
+
+int LCUIFont_UnbindEvent(int handler_id)
+{
+	if (!renderer.trigger) {
+		return -1;
+	}
+	return EventTrigger_Unbind2(renderer.trigger, handler_id);
 }
 
 static int LCUIFont_LoadFileEx(LCUI_FontEngine *engine, const char *file)
@@ -720,27 +1266,201 @@ int FontBitmap_Print(LCUI_FontBitmap *fontbmp)
 	return 0;
 }
 
+/**
+ * 将一个覆盖度值与文字颜色混合到 ARGB 像素上
+ * 这是 LCUI_OverPixel() 的整数版本，与它的差异仅来自浮点运算的舍入误差。
+ */
+INLINE void FontBitmap_MixPixel(LCUI_ARGB *px, const LCUI_ARGB *color,
+				unsigned coverage)
+{
+	unsigned a, ia, oa;
+
+	a = coverage * color->a / 255;
+	if (a == 0) {
+		return;
+	}
+	if (a == 255) {
+		*px = *color;
+		return;
+	}
+	/* 背景不透明时输出的透明度必然是 255，公式可以化简 */
+	if (px->a == 255) {
+		ia = 255 - a;
+		px->r = (uchar_t)((color->r * a + px->r * ia) / 255);
+		px->g = (uchar_t)((color->g * a + px->g * ia) / 255);
+		px->b = (uchar_t)((color->b * a + px->b * ia) / 255);
+		return;
+	}
+	ia = (255 - a) * px->a;
+	oa = a * 255 + ia;
+	px->r = (uchar_t)((color->r * a * 255 + px->r * ia) / oa);
+	px->g = (uchar_t)((color->g * a * 255 + px->g * ia) / oa);
+	px->b = (uchar_t)((color->b * a * 255 + px->b * ia) / oa);
+	px->a = (uchar_t)(oa / 255);
+}
+
+/*
+ * 以下 SIMD 版本每次处理 4 个像素，仅在这 4 个像素都不透明时使用向量运算，
+ * 否则逐个调用 FontBitmap_MixPixel()。文字颜色在进入循环前就展开成向量，
+ * 其透明度分量被替换为 255，这样输出像素的透明度也能在同一组运算中得出。
+ * 所有中间结果都不超过 255 * 255，可以用 16 位整数存放，除以 255 的运算
+ * 使用 (x + 1 + (x >> 8)) >> 8 代替，在这个范围内结果与整数除法一致。
+ */
+
+#ifdef FONT_MIX_WITH_SSE2
+
+INLINE __m128i Div255_SSE2(__m128i x)
+{
+	x = _mm_add_epi16(x, _mm_add_epi16(_mm_srli_epi16(x, 8),
+					   _mm_set1_epi16(1)));
+	return _mm_srli_epi16(x, 8);
+}
+
+static void FontBitmap_MixRowARGB(LCUI_ARGB *px, const uchar_t *coverage,
+				  int width, const LCUI_ARGB *color)
+{
+	int x;
+	unsigned value;
+	LCUI_ARGB opaque = *color;
+	__m128i zero = _mm_setzero_si128();
+	__m128i max = _mm_set1_epi16(255);
+	__m128i alpha = _mm_set1_epi16(color->a);
+	__m128i alpha_mask = _mm_slli_epi32(_mm_set1_epi32(0xff), 24);
+	__m128i tint, dst, cov, cov_lo, cov_hi, lo, hi;
+
+	opaque.a = 255;
+	tint = _mm_unpacklo_epi8(_mm_set1_epi32(opaque.value), zero);
+	for (x = 0; x + 4 <= width; x += 4, px += 4, coverage += 4) {
+		memcpy(&value, coverage, 4);
+		if (value == 0) {
+			continue;
+		}
+		dst = _mm_loadu_si128((const __m128i *)px);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(
+			_mm_and_si128(dst, alpha_mask), alpha_mask)) != 0xffff) {
+			FontBitmap_MixPixel(px, color, coverage[0]);
+			FontBitmap_MixPixel(px + 1, color, coverage[1]);
+			FontBitmap_MixPixel(px + 2, color, coverage[2]);
+			FontBitmap_MixPixel(px + 3, color, coverage[3]);
+			continue;
+		}
+		/* [c0 c1 c2 c3] => [c0 c0 c0 c0 c1 c1 c1 c1 ...] */
+		cov = _mm_cvtsi32_si128((int)value);
+		cov = _mm_unpacklo_epi8(cov, cov);
+		cov = _mm_unpacklo_epi16(cov, cov);
+		cov_lo = _mm_unpacklo_epi8(cov, zero);
+		cov_hi = _mm_unpackhi_epi8(cov, zero);
+		cov_lo = Div255_SSE2(_mm_mullo_epi16(cov_lo, alpha));
+		cov_hi = Div255_SSE2(_mm_mullo_epi16(cov_hi, alpha));
+		lo = _mm_add_epi16(
+		    _mm_mullo_epi16(tint, cov_lo),
+		    _mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero),
+				    _mm_sub_epi16(max, cov_lo)));
+		hi = _mm_add_epi16(
+		    _mm_mullo_epi16(tint, cov_hi),
+		    _mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero),
+				    _mm_sub_epi16(max, cov_hi)));
+		lo = Div255_SSE2(lo);
+		hi = Div255_SSE2(hi);
+		_mm_storeu_si128((__m128i *)px, _mm_packus_epi16(lo, hi));
+	}
+	for (; x < width; ++x, ++px, ++coverage) {
+		FontBitmap_MixPixel(px, color, *coverage);
+	}
+}
+
+#elif defined(FONT_MIX_WITH_NEON)
+
+INLINE uint16x8_t Div255_NEON(uint16x8_t x)
+{
+	x = vaddq_u16(x, vaddq_u16(vshrq_n_u16(x, 8), vdupq_n_u16(1)));
+	return vshrq_n_u16(x, 8);
+}
+
+static void FontBitmap_MixRowARGB(LCUI_ARGB *px, const uchar_t *coverage,
+				  int width, const LCUI_ARGB *color)
+{
+	int x;
+	uint32_t value;
+	uint32x2_t mask2;
+	uint32x4_t mask;
+	LCUI_ARGB opaque = *color;
+	static const uint8_t index_lo[8] = { 0, 0, 0, 0, 1, 1, 1, 1 };
+	static const uint8_t index_hi[8] = { 2, 2, 2, 2, 3, 3, 3, 3 };
+	uint8x8_t max = vdup_n_u8(255);
+	uint8x8_t alpha = vdup_n_u8(color->a);
+	uint32x4_t alpha_mask = vdupq_n_u32(0xff000000u);
+	uint8x8_t cov, cov_lo, cov_hi;
+	uint8x16_t tint, dst;
+	uint16x8_t lo, hi;
+
+	opaque.a = 255;
+	tint = vreinterpretq_u8_u32(vdupq_n_u32((uint32_t)opaque.value));
+	for (x = 0; x + 4 <= width; x += 4, px += 4, coverage += 4) {
+		memcpy(&value, coverage, 4);
+		if (value == 0) {
+			continue;
+		}
+		dst = vld1q_u8((const uint8_t *)px);
+		mask = vceqq_u32(
+		    vandq_u32(vreinterpretq_u32_u8(dst), alpha_mask),
+		    alpha_mask);
+		mask2 = vand_u32(vget_low_u32(mask), vget_high_u32(mask));
+		if ((vget_lane_u32(mask2, 0) & vget_lane_u32(mask2, 1)) !=
+		    0xffffffffu) {
+			FontBitmap_MixPixel(px, color, coverage[0]);
+			FontBitmap_MixPixel(px + 1, color, coverage[1]);
+			FontBitmap_MixPixel(px + 2, color, coverage[2]);
+			FontBitmap_MixPixel(px + 3, color, coverage[3]);
+			continue;
+		}
+		cov = vreinterpret_u8_u32(vdup_n_u32(value));
+		cov_lo = vtbl1_u8(cov, vld1_u8(index_lo));
+		cov_hi = vtbl1_u8(cov, vld1_u8(index_hi));
+		cov_lo = vmovn_u16(Div255_NEON(vmull_u8(cov_lo, alpha)));
+		cov_hi = vmovn_u16(Div255_NEON(vmull_u8(cov_hi, alpha)));
+		lo = vmull_u8(vget_low_u8(tint), cov_lo);
+		lo = vmlal_u8(lo, vget_low_u8(dst), vsub_u8(max, cov_lo));
+		hi = vmull_u8(vget_high_u8(tint), cov_hi);
+		hi = vmlal_u8(hi, vget_high_u8(dst), vsub_u8(max, cov_hi));
+		dst = vcombine_u8(vmovn_u16(Div255_NEON(lo)),
+				  vmovn_u16(Div255_NEON(hi)));
+		vst1q_u8((uint8_t *)px, dst);
+	}
+	for (; x < width; ++x, ++px, ++coverage) {
+		FontBitmap_MixPixel(px, color, *coverage);
+	}
+}
+
+#else
+
+static void FontBitmap_MixRowARGB(LCUI_ARGB *px, const uchar_t *coverage,
+				  int width, const LCUI_ARGB *color)
+{
+	int x;
+
+	for (x = 0; x < width; ++x, ++px, ++coverage) {
+		FontBitmap_MixPixel(px, color, *coverage);
+	}
+}
+
+#endif
+
 static void FontBitmap_MixARGB(LCUI_Graph *graph, LCUI_Rect *write_rect,
 			       const LCUI_FontBitmap *bmp, LCUI_Color color,
 			       LCUI_Rect *read_rect)
 {
-	int x, y;
-	LCUI_Color c;
-	LCUI_ARGB *px, *px_row_des;
-	uchar_t *byte_ptr, *byte_row_ptr;
+	int y;
+	LCUI_ARGB *px_row_des;
+	uchar_t *byte_row_ptr;
 
 	byte_row_ptr = bmp->buffer + read_rect->y * bmp->width;
 	px_row_des = graph->argb + write_rect->y * graph->width;
 	byte_row_ptr += read_rect->x;
 	px_row_des += write_rect->x;
 	for (y = 0; y < read_rect->height; ++y) {
-		px = px_row_des;
-		byte_ptr = byte_row_ptr;
-		for (x = 0; x < read_rect->width; ++x, ++byte_ptr, ++px) {
-			c = color;
-			c.alpha = (uchar_t)(*byte_ptr * color.alpha / 255.0);
-			LCUI_OverPixel(px, &c);
-		}
+		FontBitmap_MixRowARGB(px_row_des, byte_row_ptr,
+				      read_rect->width, &color);
 		px_row_des += graph->width;
 		byte_row_ptr += bmp->width;
 	}
@@ -840,9 +1560,63 @@ static void LCUIFont_InitBase(void)
 	fontlib.font_families_type.valDestructor = DestroyFontFamilyNode;
 	fontlib.font_families = Dict_Create(&fontlib.font_families_type, NULL);
 	RBTree_OnDestroy(&fontlib.bitmap_cache, DestroyTreeNode);
+	fontlib.metrics_cache_type.hashFunction = FontMetricsEntry_Hash;
+	fontlib.metrics_cache_type.keyCompare = FontMetricsEntry_Compare;
+	fontlib.metrics_cache_type.valDestructor = FontMetricsEntry_Destroy;
+	fontlib.metrics_cache = Dict_Create(&fontlib.metrics_cache_type, NULL);
+	LCUIMutex_Init(&fontlib.mutex);
 	fontlib.active = TRUE;
 }
 
+static void LCUIFont_InitRenderer(void)
+{
+	renderer.active = FALSE;
+	renderer.running = 0;
+	renderer.requests_type.hashFunction = FontBitmapRequest_Hash;
+	renderer.requests_type.keyCompare = FontBitmapRequest_Compare;
+	renderer.requests_type.valDestructor = FontBitmapRequest_Destroy;
+	renderer.requests = Dict_Create(&renderer.requests_type, NULL);
+	renderer.trigger = EventTrigger();
+	LinkedList_Init(&renderer.queue);
+	LinkedList_Init(&renderer.results);
+	RBTree_Init(&renderer.placeholders);
+	RBTree_OnDestroy(&renderer.placeholders, DestroyFontBitmap);
+	LCUIMutex_Init(&renderer.mutex);
+	LCUICond_Init(&renderer.cond);
+}
+
+static void LCUIFont_FreeRenderer(void)
+{
+	int i;
+
+	if (!renderer.trigger) {
+		return;
+	}
+	if (renderer.active) {
+		/* 先让渲染线程放弃剩下的请求，再停止它们 */
+		LCUIMutex_Lock(&renderer.mutex);
+		renderer.active = FALSE;
+		while (renderer.running > 0) {
+			LCUICond_Wait(&renderer.cond, &renderer.mutex);
+		}
+		LCUIMutex_Unlock(&renderer.mutex);
+		for (i = 0; i < LCUI_FONT_RENDER_THREADS; ++i) {
+			LCUIWorker_Destroy(renderer.workers[i]);
+			renderer.workers[i] = NULL;
+		}
+	}
+	/* 请求都由请求表管理，列表中只是引用 */
+	LinkedList_Init(&renderer.queue);
+	LinkedList_Init(&renderer.results);
+	Dict_Release(renderer.requests);
+	RBTree_Destroy(&renderer.placeholders);
+	EventTrigger_Destroy(renderer.trigger);
+	LCUIMutex_Destroy(&renderer.mutex);
+	LCUICond_Destroy(&renderer.cond);
+	renderer.requests = NULL;
+	renderer.trigger = NULL;
+}
+
 static void LCUIFont_InitEngine(void)
 {
 	int fid;
@@ -879,6 +1653,9 @@ static void LCUIFont_FreeBase(void)
 	}
 	Dict_Release(fontlib.font_families);
 	RBTree_Destroy(&fontlib.bitmap_cache);
+	Dict_Release(fontlib.metrics_cache);
+	fontlib.metrics_cache = NULL;
+	LCUIMutex_Destroy(&fontlib.mutex);
 	free(fontlib.font_cache);
 	fontlib.font_cache = NULL;
 }
@@ -989,12 +1766,17 @@ static void LCUIFont_LoadDefaultFonts(void)
 void LCUI_InitFontLibrary(void)
 {
 	LCUIFont_InitBase();
+	LCUIFont_InitRenderer();
 	LCUIFont_InitEngine();
 	LCUIFont_LoadDefaultFonts();
+#ifdef LCUI_FONT_ENGINE_FREETYPE
+	LCUIFont_SaveFreeTypeIndex();
+#endif
 }
 
 void LCUI_FreeFontLibrary(void)
 {
+	LCUIFont_FreeRenderer();
 	LCUIFont_FreeBase();
 	LCUIFont_FreeEngine();
 }
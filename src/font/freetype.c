@@ -32,10 +32,22 @@
 #include <LCUI_Build.h>
 #ifdef LCUI_FONT_ENGINE_FREETYPE
 #include <LCUI/types.h>
-#include <LCUI/util/linkedlist.h>
+#include <LCUI/util.h>
+#include <LCUI/thread.h>
 #include <LCUI/font.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <sys/stat.h>
+
+#ifdef LCUI_BUILD_IN_WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -45,53 +57,502 @@
 
 #define LCUI_FONT_RENDER_MODE	FT_RENDER_MODE_NORMAL
 #define LCUI_FONT_LOAD_FALGS	(FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT)
+#define LCUI_FONT_METRICS_LOAD_FLAGS	FT_LOAD_FORCE_AUTOHINT
+#define FONT_INDEX_HEADER	"# LCUI font index v1"
+#define FONT_INDEX_MAX_LINE	1024
+
+/** 字体文件，由其中的所有字体共享同一份内存映射 */
+typedef struct FontFileRec_ {
+	char *path;
+	size_t size;
+	long mtime;
+	unsigned refs;		/**< 引用该文件的字体数量 */
+	FT_Byte *data;		/**< 映射到内存中的文件内容，在需要时才映射 */
+#ifdef LCUI_BUILD_IN_WIN32
+	HANDLE mapping;
+#endif
+	LinkedListNode node;
+} FontFileRec, *FontFile;
+
+/**
+ * 字体，在首次渲染字形时才创建 FT_Face
+ * FT_Face 不能在多个线程中同时使用，所以每个渲染线程都有各自的 FT_Face
+ */
+typedef struct FontFaceRec_ {
+	int index;
+	FT_Face face;
+	FT_Face thread_faces[LCUI_FONT_RENDER_THREADS];
+	FontFile file;
+} FontFaceRec, *FontFace;
+
+/** 字体索引记录，保存字体文件中各个字体的名称 */
+typedef struct FontIndexEntryRec_ {
+	char *path;
+	size_t size;
+	long mtime;
+	int num_faces;
+	char **names;		/**< 字族名称和样式名称，两两一组 */
+} FontIndexEntryRec, *FontIndexEntry;
 
 static struct {
 	FT_Library library;
+	FT_Library thread_libraries[LCUI_FONT_RENDER_THREADS];
+	LCUI_Mutex mutex;	/**< 用于保护文件映射的互斥锁 */
+	LinkedList files;
+	Dict *index;		/**< 字体索引，以字体文件路径为键 */
+	DictType index_type;
+	LCUI_BOOL index_dirty;	/**< 字体索引是否有未保存的改动 */
+	char *index_path;	/**< 字体索引文件的路径 */
 } freetype;
 
-static int FreeType_Open(const char *filepath, LCUI_Font **outfonts)
+static void FontFile_Unmap(FontFile file)
 {
-	FT_Face face;
-	LCUI_Font font, *fonts;
-	int i, err, num_faces;
+	if (!file->data) {
+		return;
+	}
+#ifdef LCUI_BUILD_IN_WIN32
+	UnmapViewOfFile(file->data);
+	CloseHandle(file->mapping);
+	file->mapping = NULL;
+#else
+	munmap(file->data, file->size);
+#endif
+	file->data = NULL;
+}
+
+static int FontFile_Map(FontFile file)
+{
+#ifdef LCUI_BUILD_IN_WIN32
+	HANDLE handle;
+#else
+	int fd;
+	void *data;
+#endif
 
-	err = FT_New_Face(freetype.library, filepath, -1, &face);
-	if (err) {
-		*outfonts = NULL;
+	if (file->data) {
+		return 0;
+	}
+	if (file->size < 1) {
+		return -1;
+	}
+#ifdef LCUI_BUILD_IN_WIN32
+	handle = CreateFileA(file->path, GENERIC_READ, FILE_SHARE_READ, NULL,
+			     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return -1;
+	}
+	file->mapping =
+	    CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(handle);
+	if (!file->mapping) {
 		return -1;
 	}
+	file->data = MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!file->data) {
+		CloseHandle(file->mapping);
+		file->mapping = NULL;
+		return -1;
+	}
+#else
+	fd = open(file->path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	data = mmap(NULL, file->size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return -1;
+	}
+	file->data = data;
+#endif
+	return 0;
+}
+
+static FontFile FontFile_Open(const char *path)
+{
+	FontFile file;
+	struct stat buf;
+	LinkedListNode *node;
+
+	if (stat(path, &buf) != 0) {
+		return NULL;
+	}
+	for (LinkedList_Each(node, &freetype.files)) {
+		file = node->data;
+		if (strcmp(file->path, path) == 0 &&
+		    file->size == (size_t)buf.st_size &&
+		    file->mtime == (long)buf.st_mtime) {
+			return file;
+		}
+	}
+	file = NEW(FontFileRec, 1);
+	if (!file) {
+		return NULL;
+	}
+	file->path = strdup2(path);
+	file->size = buf.st_size;
+	file->mtime = (long)buf.st_mtime;
+	file->node.data = file;
+	LinkedList_AppendNode(&freetype.files, &file->node);
+	return file;
+}
+
+static void FontFile_Release(FontFile file)
+{
+	if (file->refs > 0) {
+		--file->refs;
+	}
+	if (file->refs > 0) {
+		return;
+	}
+	FontFile_Unmap(file);
+	LinkedList_Unlink(&freetype.files, &file->node);
+	free(file->path);
+	free(file);
+}
+
+static int FontFile_OpenFace(FontFile file, FT_Library library, int index,
+			     FT_Face *face)
+{
+	int ret;
+
+	LCUIMutex_Lock(&freetype.mutex);
+	ret = FontFile_Map(file);
+	LCUIMutex_Unlock(&freetype.mutex);
+	if (ret != 0) {
+		return -1;
+	}
+	return FT_New_Memory_Face(library, file->data, (FT_Long)file->size,
+				  index, face);
+}
+
+static void FontIndexEntry_Delete(void *data)
+{
+	int i;
+	FontIndexEntry entry = data;
+
+	for (i = 0; i < entry->num_faces * 2; ++i) {
+		free(entry->names[i]);
+	}
+	free(entry->names);
+	free(entry->path);
+	free(entry);
+}
+
+static void FontIndexEntry_OnDelete(void *privdata, void *data)
+{
+	FontIndexEntry_Delete(data);
+}
+
+static FontIndexEntry FontIndexEntry_New(FontFile file, int num_faces)
+{
+	FontIndexEntry entry;
+
+	entry = NEW(FontIndexEntryRec, 1);
+	if (!entry) {
+		return NULL;
+	}
+	entry->names = NEW(char *, num_faces * 2 + 1);
+	if (!entry->names) {
+		free(entry);
+		return NULL;
+	}
+	entry->path = strdup2(file->path);
+	entry->size = file->size;
+	entry->mtime = file->mtime;
+	entry->num_faces = num_faces;
+	return entry;
+}
+
+/** 添加索引记录，以记录自身的路径字符串作为键，随记录一起释放 */
+static int FontIndex_Add(FontIndexEntry entry)
+{
+	if (Dict_Add(freetype.index, entry->path, entry) != 0) {
+		FontIndexEntry_Delete(entry);
+		return -1;
+	}
+	return 0;
+}
+
+/** 名称中的制表符和换行符会破坏索引文件的格式，需要替换掉 */
+static char *FontIndex_CopyName(const char *name)
+{
+	char *p, *str;
+
+	str = strdup2(name ? name : "");
+	for (p = str; p && *p; ++p) {
+		if (*p == '\t' || *p == '\r' || *p == '\n') {
+			*p = ' ';
+		}
+	}
+	return str;
+}
+
+static void FontIndex_Load(void)
+{
+	int i = 0;
+	FILE *fp;
+	long mtime;
+	unsigned long size;
+	int num_faces;
+	char *p, line[FONT_INDEX_MAX_LINE];
+	FontIndexEntry entry = NULL;
+	FontFileRec file;
+
+	fp = fopen(freetype.index_path, "r");
+	if (!fp) {
+		return;
+	}
+	if (!fgets(line, sizeof(line), fp) ||
+	    strncmp(line, FONT_INDEX_HEADER, strlen(FONT_INDEX_HEADER)) != 0) {
+		fclose(fp);
+		return;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		p = line + strlen(line);
+		while (p > line && (p[-1] == '\n' || p[-1] == '\r')) {
+			*--p = 0;
+		}
+		if (strncmp(line, "face\t", 5) == 0) {
+			p = strchr(line + 5, '\t');
+			if (!entry || i >= entry->num_faces * 2 || !p) {
+				continue;
+			}
+			*p = 0;
+			entry->names[i++] = strdup2(line + 5);
+			entry->names[i++] = strdup2(p + 1);
+			continue;
+		}
+		if (sscanf(line, "file\t%lu\t%ld\t%d\t", &size, &mtime,
+			   &num_faces) != 3 || num_faces < 1) {
+			entry = NULL;
+			continue;
+		}
+		p = strchr(line + 5, '\t');
+		p = p ? strchr(p + 1, '\t') : NULL;
+		p = p ? strchr(p + 1, '\t') : NULL;
+		if (!p) {
+			entry = NULL;
+			continue;
+		}
+		file.path = p + 1;
+		file.size = size;
+		file.mtime = mtime;
+		entry = FontIndexEntry_New(&file, num_faces);
+		if (entry && FontIndex_Add(entry) != 0) {
+			entry = NULL;
+		}
+		i = 0;
+	}
+	fclose(fp);
+	Logger_Debug("[font] loaded %lu entries from font index: %s\n",
+		     Dict_Size(freetype.index), freetype.index_path);
+}
+
+static void FontIndex_Save(void)
+{
+	int i;
+	FILE *fp;
+	FontIndexEntry entry;
+	DictEntry *item;
+	DictIterator *iter;
+
+	fp = fopen(freetype.index_path, "w");
+	if (!fp) {
+		Logger_Warning("[font] cannot write font index: %s\n",
+			       freetype.index_path);
+		return;
+	}
+	fprintf(fp, "%s\n", FONT_INDEX_HEADER);
+	iter = Dict_GetIterator(freetype.index);
+	while ((item = Dict_Next(iter))) {
+		entry = DictEntry_GetVal(item);
+		fprintf(fp, "file\t%lu\t%ld\t%d\t%s\n",
+			(unsigned long)entry->size, entry->mtime,
+			entry->num_faces, entry->path);
+		for (i = 0; i < entry->num_faces * 2; i += 2) {
+			fprintf(fp, "face\t%s\t%s\n", entry->names[i],
+				entry->names[i + 1]);
+		}
+	}
+	Dict_ReleaseIterator(iter);
+	fclose(fp);
+	freetype.index_dirty = FALSE;
+}
+
+/** 扫描字体文件，记录其中所有字体的名称 */
+static FontIndexEntry FontIndex_Scan(FontFile file)
+{
+	int i, num_faces;
+	FT_Face face;
+	FontIndexEntry entry;
+
+	if (FontFile_OpenFace(file, freetype.library, -1, &face) != 0) {
+		return NULL;
+	}
 	num_faces = face->num_faces;
 	FT_Done_Face(face);
 	if (num_faces < 1) {
-		return 0;
+		return NULL;
+	}
+	entry = FontIndexEntry_New(file, num_faces);
+	if (!entry) {
+		return NULL;
+	}
+	for (i = 0; i < num_faces; ++i) {
+		if (FontFile_OpenFace(file, freetype.library, i, &face) != 0) {
+			/* 空的字族名称表示该字体不可用 */
+			entry->names[i * 2] = strdup2("");
+			entry->names[i * 2 + 1] = strdup2("");
+			continue;
+		}
+		entry->names[i * 2] = FontIndex_CopyName(face->family_name);
+		entry->names[i * 2 + 1] = FontIndex_CopyName(face->style_name);
+		FT_Done_Face(face);
+	}
+	return entry;
+}
+
+/** 获取字体文件的索引记录，如果记录不存在或已过期则重新扫描 */
+static FontIndexEntry FontIndex_Get(FontFile file)
+{
+	int i;
+	FontIndexEntry entry;
+
+	entry = Dict_FetchValue(freetype.index, file->path);
+	if (entry && entry->size == file->size &&
+	    entry->mtime == file->mtime) {
+		for (i = 0; i < entry->num_faces * 2; ++i) {
+			if (!entry->names[i]) {
+				break;
+			}
+		}
+		if (i == entry->num_faces * 2) {
+			return entry;
+		}
+	}
+	if (entry) {
+		Dict_Delete(freetype.index, file->path);
+	}
+	entry = FontIndex_Scan(file);
+	if (!entry || FontIndex_Add(entry) != 0) {
+		return NULL;
+	}
+	/* 扫描大量字体时每次都重写索引文件的开销太大，等到加载完后再统一保存 */
+	freetype.index_dirty = TRUE;
+	return entry;
+}
+
+void LCUIFont_SaveFreeTypeIndex(void)
+{
+	if (freetype.index_dirty && freetype.index_path) {
+		FontIndex_Save();
+	}
+}
+
+static FT_Face FontFace_Open(FontFace ff, FT_Library library, FT_Face *face)
+{
+	if (*face) {
+		return *face;
+	}
+	if (FontFile_OpenFace(ff->file, library, ff->index, face) != 0) {
+		*face = NULL;
+		return NULL;
+	}
+	FT_Select_Charmap(*face, FT_ENCODING_UNICODE);
+	return *face;
+}
+
+static FT_Face FontFace_Get(FontFace ff)
+{
+	return FontFace_Open(ff, freetype.library, &ff->face);
+}
+
+/** 获取供渲染线程使用的 FT_Face，只能在该线程中调用 */
+static FT_Face FontFace_GetForThread(FontFace ff, int thread)
+{
+	FT_Library *library = &freetype.thread_libraries[thread];
+
+	if (!*library && FT_Init_FreeType(library)) {
+		*library = NULL;
+		return NULL;
+	}
+	return FontFace_Open(ff, *library, &ff->thread_faces[thread]);
+}
+
+static int FreeType_Open(const char *filepath, LCUI_Font **outfonts)
+{
+	FontFile file;
+	FontFace ff;
+	FontIndexEntry entry;
+	LCUI_Font font, *fonts;
+	int i, num_fonts = 0;
+
+	*outfonts = NULL;
+	file = FontFile_Open(filepath);
+	if (!file) {
+		return -1;
+	}
+	entry = FontIndex_Get(file);
+	if (!entry) {
+		if (file->refs < 1) {
+			FontFile_Release(file);
+		}
+		return -1;
 	}
-	fonts = malloc(sizeof(LCUI_FontRec*) * num_faces);
+	fonts = malloc(sizeof(LCUI_FontRec *) * entry->num_faces);
 	if (!fonts) {
+		if (file->refs < 1) {
+			FontFile_Release(file);
+		}
 		return -ENOMEM;
 	}
-	for (i = 0; i < num_faces; ++i) {
-		err = FT_New_Face(freetype.library, filepath, i, &face);
-		if (err) {
-			fonts[i] = NULL;
+	for (i = 0; i < entry->num_faces; ++i) {
+		if (!entry->names[i * 2][0]) {
 			continue;
 		}
-		FT_Select_Charmap(face, FT_ENCODING_UNICODE);
-		font = Font(face->family_name, face->style_name);
-		font->data = face;
-		fonts[i] = font;
+		ff = NEW(FontFaceRec, 1);
+		if (!ff) {
+			break;
+		}
+		ff->file = file;
+		ff->index = i;
+		file->refs += 1;
+		font = Font(entry->names[i * 2], entry->names[i * 2 + 1]);
+		font->data = ff;
+		fonts[num_fonts++] = font;
+	}
+	if (num_fonts < 1) {
+		free(fonts);
+		fonts = NULL;
+	}
+	if (file->refs < 1) {
+		FontFile_Release(file);
 	}
 	*outfonts = fonts;
-	return num_faces;
+	return num_fonts;
 }
 
-static void FreeType_Close(void *face)
+static void FreeType_Close(void *data)
 {
-	FT_Done_Face(face);
+	int i;
+	FontFace ff = data;
+
+	if (ff->face) {
+		FT_Done_Face(ff->face);
+	}
+	for (i = 0; i < LCUI_FONT_RENDER_THREADS; ++i) {
+		if (ff->thread_faces[i]) {
+			FT_Done_Face(ff->thread_faces[i]);
+		}
+	}
+	FontFile_Release(ff->file);
+	free(ff);
 }
 
 /** 转换 FT_GlyphSlot 类型数据为 LCUI_FontBitmap */
-static size_t Convert_FTGlyph(LCUI_FontBitmap *bmp, FT_GlyphSlot slot, int mode)
+static size_t Convert_FTGlyph(LCUI_FontBitmap *bmp, FT_Library library,
+			      FT_GlyphSlot slot, int mode)
 {
 	int error;
 	size_t size;
@@ -155,7 +616,7 @@ static size_t Convert_FTGlyph(LCUI_FontBitmap *bmp, FT_GlyphSlot slot, int mode)
 
 		FT_Bitmap_New(&bitmap);
 		/* 转换位图bitmap_glyph->bitmap至bitmap，1个像素占1个字节 */
-		FT_Bitmap_Convert(freetype.library, &bitmap_glyph->bitmap, &bitmap, 1);
+		FT_Bitmap_Convert(library, &bitmap_glyph->bitmap, &bitmap, 1);
 		bit_ptr = bitmap.buffer;
 		byte_ptr = bmp->buffer;
 		for (y = 0; y < bmp->rows; ++y) {
@@ -164,7 +625,7 @@ static size_t Convert_FTGlyph(LCUI_FontBitmap *bmp, FT_GlyphSlot slot, int mode)
 				++byte_ptr, ++bit_ptr;
 			}
 		}
-		FT_Bitmap_Done(freetype.library, &bitmap);
+		FT_Bitmap_Done(library, &bitmap);
 		break;
 	}
 	/* 其它像素模式的位图，暂时先直接填充255，等需要时再完善 */
@@ -176,13 +637,16 @@ static size_t Convert_FTGlyph(LCUI_FontBitmap *bmp, FT_GlyphSlot slot, int mode)
 	return size;
 }
 
-static int FreeType_Render(LCUI_FontBitmap *bmp, wchar_t ch,
-			   int pixel_size, LCUI_Font font)
+static int FreeType_RenderFace(LCUI_FontBitmap *bmp, wchar_t ch,
+			       int pixel_size, FT_Library library,
+			       FT_Face ft_face)
 {
 	int ret = 0;
 	FT_UInt index;
-	FT_Face ft_face = (FT_Face)font->data;
 
+	if (!ft_face) {
+		return -2;
+	}
 	/* 设定字体尺寸 */
 	FT_Set_Pixel_Sizes(ft_face, 0, pixel_size);
 	index = FT_Get_Char_Index(ft_face, ch);
@@ -193,24 +657,98 @@ static int FreeType_Render(LCUI_FontBitmap *bmp, wchar_t ch,
 	if (FT_Load_Glyph(ft_face, index, LCUI_FONT_LOAD_FALGS) != 0) {
 		return -2;
 	}
-	Convert_FTGlyph(bmp, ft_face->glyph, LCUI_FONT_RENDER_MODE);
+	Convert_FTGlyph(bmp, library, ft_face->glyph, LCUI_FONT_RENDER_MODE);
+	return ret;
+}
+
+static int FreeType_Render(LCUI_FontBitmap *bmp, wchar_t ch,
+			   int pixel_size, LCUI_Font font)
+{
+	return FreeType_RenderFace(bmp, ch, pixel_size, freetype.library,
+				   FontFace_Get(font->data));
+}
+
+/** 只载入字形的度量数据，跨距与渲染时的一致，但不会生成位图 */
+static int FreeType_GetMetrics(LCUI_FontMetrics *metrics, wchar_t ch,
+			       int pixel_size, LCUI_Font font)
+{
+	int ret = 0;
+	FT_UInt index;
+	FT_Glyph_Metrics *m;
+	FT_Face ft_face = FontFace_Get(font->data);
+
+	if (!ft_face) {
+		return -2;
+	}
+	FT_Set_Pixel_Sizes(ft_face, 0, pixel_size);
+	index = FT_Get_Char_Index(ft_face, ch);
+	if (index == 0) {
+		ret = -1;
+	}
+	if (FT_Load_Glyph(ft_face, index, LCUI_FONT_METRICS_LOAD_FLAGS) != 0) {
+		return -2;
+	}
+	m = &ft_face->glyph->metrics;
+	metrics->top = m->horiBearingY >> 6;
+	metrics->left = m->horiBearingX >> 6;
+	metrics->width = m->width >> 6;
+	metrics->rows = m->height >> 6;
+	metrics->advance.x = m->horiAdvance >> 6;
+	metrics->advance.y = m->vertAdvance >> 6;
 	return ret;
 }
 
+static int FreeType_RenderInThread(LCUI_FontBitmap *bmp, wchar_t ch,
+				   int pixel_size, LCUI_Font font, int thread)
+{
+	return FreeType_RenderFace(bmp, ch, pixel_size,
+				   freetype.thread_libraries[thread],
+				   FontFace_GetForThread(font->data, thread));
+}
+
 int LCUIFont_InitFreeType(LCUI_FontEngine *engine)
 {
 	if (FT_Init_FreeType(&freetype.library)) {
 		return -1;
 	}
+	memset(freetype.thread_libraries, 0,
+	       sizeof(freetype.thread_libraries));
+	LCUIMutex_Init(&freetype.mutex);
+	LinkedList_Init(&freetype.files);
+	freetype.index_type = DictType_StringKey;
+	freetype.index_type.valDestructor = FontIndexEntry_OnDelete;
+	freetype.index = Dict_Create(&freetype.index_type, NULL);
+	freetype.index_dirty = FALSE;
+	freetype.index_path = NULL;
+	if (getenv("LCUI_FONT_INDEX_FILE")) {
+		freetype.index_path = strdup2(getenv("LCUI_FONT_INDEX_FILE"));
+		FontIndex_Load();
+	}
 	strcpy(engine->name, "FreeType");
 	engine->render = FreeType_Render;
 	engine->open = FreeType_Open;
 	engine->close = FreeType_Close;
+	engine->render_in_thread = FreeType_RenderInThread;
+	engine->get_metrics = FreeType_GetMetrics;
 	return 0;
 }
 
 int LCUIFont_ExitFreeType(void)
 {
+	int i;
+
+	LCUIFont_SaveFreeTypeIndex();
+	Dict_Release(freetype.index);
+	freetype.index = NULL;
+	free(freetype.index_path);
+	freetype.index_path = NULL;
+	for (i = 0; i < LCUI_FONT_RENDER_THREADS; ++i) {
+		if (freetype.thread_libraries[i]) {
+			FT_Done_FreeType(freetype.thread_libraries[i]);
+			freetype.thread_libraries[i] = NULL;
+		}
+	}
+	LCUIMutex_Destroy(&freetype.mutex);
 	FT_Done_FreeType(freetype.library);
 	return 0;
 }
@@ -29,14 +29,14 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <wctype.h>
 #include <LCUI_Build.h>
 #include <LCUI/types.h>
-#include <LCUI/util/math.h>
-#include <LCUI/util/linkedlist.h>
-#include <LCUI/util/rect.h>
+#include <LCUI/util.h>
 #include <LCUI/graph.h>
 #include <LCUI/font.h>
+#include <LCUI/thread.h>
 
 typedef enum { TEXT_ACTION_INSERT, TEXT_ACTION_APPEND } TextAction;
 
@@ -45,6 +45,8 @@ typedef enum { TEXT_ACTION_INSERT, TEXT_ACTION_APPEND } TextAction;
 #define TextLayer_GetRow(layer, n) \
 	(n >= layer->text_rows.length) ? NULL : layer->text_rows.rows[n]
 #define GetDefaultLineHeight(H) iround(H * 1.42857143)
+#define TEXT_ROW_MIN_CAPACITY 8
+#define TEXT_INSERT_BATCH_SIZE 128
 #define ISALPHA(CH) (CH >= 'a' && CH <= 'z') || (CH >= 'A' && CH <= 'Z')
 
 /* 根据对齐方式，计算文本行的起始X轴位置 */
@@ -106,6 +108,7 @@ static void TextRow_Init(LCUI_TextRow txtrow)
 	txtrow->width = 0;
 	txtrow->height = 0;
 	txtrow->length = 0;
+	txtrow->capacity = 0;
 	txtrow->string = NULL;
 	txtrow->eol = LCUI_EOL_NONE;
 	txtrow->text_height = 0;
@@ -113,15 +116,10 @@ static void TextRow_Init(LCUI_TextRow txtrow)
 
 static void TextRow_Destroy(LCUI_TextRow txtrow)
 {
-	int i;
-	for (i = 0; i < txtrow->length; ++i) {
-		if (txtrow->string[i]) {
-			free(txtrow->string[i]);
-		}
-	}
 	txtrow->width = 0;
 	txtrow->height = 0;
 	txtrow->length = 0;
+	txtrow->capacity = 0;
 	txtrow->text_height = 0;
 	if (txtrow->string) {
 		free(txtrow->string);
@@ -176,21 +174,24 @@ static int TextRowList_RemoveRow(LCUI_TextRowList rowlist, int i_row)
 	return 0;
 }
 
-/** 更新文本行的尺寸 */
-static void TextLayer_UpdateRowSize(LCUI_TextLayer layer, LCUI_TextRow txtrow)
+/** 累加字符的尺寸到文本行 */
+static void TextLayer_AddRowSize(LCUI_TextLayer layer, LCUI_TextRow txtrow,
+				 const LCUI_TextCharRec *chars, int n_chars)
 {
 	int i;
-	LCUI_TextChar txtchar;
-	txtrow->width = 0;
-	txtrow->text_height = layer->text_default_style.pixel_size;
-	for (i = 0; i < txtrow->length; ++i) {
-		txtchar = txtrow->string[i];
-		if (!txtchar->bitmap) {
+	const LCUI_TextCharRec *txtchar;
+
+	if (txtrow->text_height < layer->text_default_style.pixel_size) {
+		txtrow->text_height = layer->text_default_style.pixel_size;
+	}
+	for (i = 0; i < n_chars; ++i) {
+		txtchar = &chars[i];
+		if (!txtchar->metrics) {
 			continue;
 		}
-		txtrow->width += txtchar->bitmap->advance.x;
-		if (txtrow->text_height < txtchar->bitmap->advance.y) {
-			txtrow->text_height = txtchar->bitmap->advance.y;
+		txtrow->width += txtchar->metrics->advance.x;
+		if (txtrow->text_height < txtchar->metrics->advance.y) {
+			txtrow->text_height = txtchar->metrics->advance.y;
 		}
 	}
 	if (layer->line_height > -1) {
@@ -200,77 +201,146 @@ static void TextLayer_UpdateRowSize(LCUI_TextLayer layer, LCUI_TextRow txtrow)
 	}
 }
 
-/** 设置文本行的字符串长度 */
+/** 更新文本行的尺寸 */
+static void TextLayer_UpdateRowSize(LCUI_TextLayer layer, LCUI_TextRow txtrow)
+{
+	txtrow->width = 0;
+	txtrow->text_height = 0;
+	TextLayer_AddRowSize(layer, txtrow, txtrow->string, txtrow->length);
+}
+
+/**
+ * 设置文本行的字符串长度
+ * 容量按倍数增长，以减少逐字插入时的内存重分配次数；长度远小于容量时
+ * 会收缩容量，避免删除大段文本后仍然占用过多内存。
+ */
 static int TextRow_SetLength(LCUI_TextRow txtrow, int len)
 {
-	LCUI_TextChar *txtstr;
+	int capacity;
+	LCUI_TextCharRec *txtstr;
+
 	if (len < 0) {
 		len = 0;
 	}
-	txtstr = realloc(txtrow->string, sizeof(LCUI_TextChar) * (len + 1));
-	if (!txtstr) {
-		return -1;
+	capacity = txtrow->capacity;
+	if (len > capacity) {
+		capacity = max(capacity * 2, TEXT_ROW_MIN_CAPACITY);
+		capacity = max(capacity, len);
+	} else if (len < capacity / 4 && capacity > TEXT_ROW_MIN_CAPACITY) {
+		capacity = max(len * 2, TEXT_ROW_MIN_CAPACITY);
+	}
+	if (capacity != txtrow->capacity) {
+		txtstr = realloc(txtrow->string,
+				 sizeof(LCUI_TextCharRec) * capacity);
+		if (!txtstr) {
+			if (len > txtrow->capacity) {
+				return -1;
+			}
+		} else {
+			txtrow->string = txtstr;
+			txtrow->capacity = capacity;
+		}
 	}
-	txtstr[len] = NULL;
-	txtrow->string = txtstr;
 	txtrow->length = len;
 	return 0;
 }
 
-/** 将字符数据直接插入至文本行 */
+/** 将多个字符数据插入至文本行 */
 static int TextRow_Insert(LCUI_TextRow txtrow, int ins_pos,
-			  LCUI_TextChar txtchar)
+			  const LCUI_TextCharRec *chars, int n_chars)
 {
-	int i;
+	int length = txtrow->length;
+
+	if (n_chars <= 0) {
+		return 0;
+	}
 	if (ins_pos < 0) {
-		ins_pos = txtrow->length + 1 + ins_pos;
-		if (ins_pos < 0) {
-			ins_pos = 0;
-		}
-	} else if (ins_pos > txtrow->length) {
-		ins_pos = txtrow->length;
+		ins_pos = 0;
+	} else if (ins_pos > length) {
+		ins_pos = length;
 	}
-	TextRow_SetLength(txtrow, txtrow->length + 1);
-	for (i = txtrow->length - 1; i > ins_pos; --i) {
-		txtrow->string[i] = txtrow->string[i - 1];
+	if (TextRow_SetLength(txtrow, length + n_chars) != 0) {
+		return -1;
 	}
-	txtrow->string[ins_pos] = txtchar;
+	memmove(txtrow->string + ins_pos + n_chars, txtrow->string + ins_pos,
+		sizeof(LCUI_TextCharRec) * (length - ins_pos));
+	memcpy(txtrow->string + ins_pos, chars,
+	       sizeof(LCUI_TextCharRec) * n_chars);
 	return 0;
 }
 
-/** 向文本行插入一个字符数据副本 */
-static int TextRow_InsertCopy(LCUI_TextRow txtrow, int ins_pos,
-			      LCUI_TextChar txtchar)
+/**
+ * 将一批字符插入至文本行
+ * 只累加新字符的尺寸，这样在长文本行中逐字输入时不用每次都遍历整行
+ */
+static void TextLayer_InsertRowChars(LCUI_TextLayer layer, LCUI_TextRow txtrow,
+				     int ins_pos, const LCUI_TextCharRec *chars,
+				     int n_chars)
 {
-	LCUI_TextChar txtchar2;
-	txtchar2 = malloc(sizeof(LCUI_TextCharRec));
-	*txtchar2 = *txtchar;
-	return TextRow_Insert(txtrow, ins_pos, txtchar2);
+	if (TextRow_Insert(txtrow, ins_pos, chars, n_chars) == 0) {
+		TextLayer_AddRowSize(layer, txtrow, chars, n_chars);
+	}
 }
 
-/** 更新字体位图 */
-static void TextChar_UpdateBitmap(LCUI_TextChar ch, LCUI_TextStyle style)
+static int TextChar_GetFont(LCUI_TextChar ch, LCUI_TextStyle style,
+			    const int **font_ids)
 {
-	int i = 0;
-	int size = style->pixel_size;
-	int *font_ids = style->font_ids;
-	if (ch->style) {
-		if (ch->style->has_family) {
-			font_ids = ch->style->font_ids;
-		}
-		if (ch->style->has_pixel_size) {
-			size = ch->style->pixel_size;
+	*font_ids = style->font_ids;
+	if (!ch->style) {
+		return style->pixel_size;
+	}
+	if (ch->style->has_family) {
+		*font_ids = ch->style->font_ids;
+	}
+	if (ch->style->has_pixel_size) {
+		return ch->style->pixel_size;
+	}
+	return style->pixel_size;
+}
+
+/**
+ * 更新字形度量数据
+ * 排版只需要度量数据，字形位图等到绘制时再载入
+ */
+static void TextChar_UpdateMetrics(LCUI_TextChar ch, LCUI_TextStyle style)
+{
+	int i, size;
+	const int *font_ids;
+
+	ch->bitmap = NULL;
+	size = TextChar_GetFont(ch, style, &font_ids);
+	for (i = 0; font_ids && font_ids[i] > 0; ++i) {
+		if (LCUIFont_GetMetrics(ch->code, font_ids[i], size,
+					&ch->metrics) >= 0) {
+			return;
 		}
 	}
-	while (font_ids && font_ids[i] > 0) {
-		int ret = LCUIFont_GetBitmap(ch->code, font_ids[i], size,
-					     &ch->bitmap);
+	LCUIFont_GetMetrics(ch->code, -1, size, &ch->metrics);
+}
+
+/**
+ * 载入字体位图，字体的选择顺序与 TextChar_UpdateMetrics() 一致
+ * @returns 字形位图正在异步渲染则返回 1，否则返回 0
+ */
+static int TextChar_LoadBitmap(LCUI_TextChar ch, LCUI_TextStyle style)
+{
+	int i, ret, size;
+	const int *font_ids;
+	const LCUI_FontBitmap *bmp;
+
+	size = TextChar_GetFont(ch, style, &font_ids);
+	for (i = 0; font_ids && font_ids[i] > 0; ++i) {
+		ret = LCUIFont_RequestBitmap(ch->code, font_ids[i], size, &bmp);
 		if (ret == 0) {
-			return;
+			ch->bitmap = bmp;
+		}
+		/* 占位位图不保存，下次绘制时再重新获取 */
+		if (ret >= 0) {
+			return ret;
 		}
-		++i;
 	}
 	LCUIFont_GetBitmap(ch->code, -1, size, &ch->bitmap);
+	return 0;
 }
 
 /** 新建文本图层 */
@@ -297,6 +367,8 @@ LCUI_TextLayer TextLayer_New(void)
 	layer->enable_autowrap = FALSE;
 	layer->enable_mulitiline = FALSE;
 	layer->enable_style_tag = FALSE;
+	layer->bitmaps_pending = FALSE;
+	LCUIMutex_Init(&layer->mutex);
 	layer->word_break = LCUI_WORD_BREAK_NORMAL;
 	TextStyle_Init(&layer->text_default_style);
 	LinkedList_Init(&layer->text_styles);
@@ -342,6 +414,7 @@ void TextLayer_Destroy(LCUI_TextLayer layer)
 	TextStyle_Destroy(&layer->text_default_style);
 	TextRowList_Destroy(&layer->text_rows);
 	TextLayer_DestroyStyleCache(layer);
+	LCUIMutex_Destroy(&layer->mutex);
 	free(layer);
 }
 
@@ -371,17 +444,17 @@ static int TextLayer_GetRowRect(LCUI_TextLayer layer, int i_row, int start_col,
 		rect->width = txtrow->width;
 	} else {
 		for (i = 0; i < start_col; ++i) {
-			if (!txtrow->string[i]->bitmap) {
+			if (!txtrow->string[i].metrics) {
 				continue;
 			}
-			rect->x += txtrow->string[i]->bitmap->advance.x;
+			rect->x += txtrow->string[i].metrics->advance.x;
 		}
 		rect->width = 0;
 		for (i = start_col; i <= end_col && i < txtrow->length; ++i) {
-			if (!txtrow->string[i]->bitmap) {
+			if (!txtrow->string[i].metrics) {
 				continue;
 			}
-			rect->width += txtrow->string[i]->bitmap->advance.x;
+			rect->width += txtrow->string[i].metrics->advance.x;
 		}
 	}
 	if (rect->width <= 0 || rect->height <= 0) {
@@ -482,13 +555,13 @@ int TextLayer_SetCaretPosByPixelPos(LCUI_TextLayer layer, int x, int y)
 	pixel_pos += TextLayer_GetRowStartX(layer, txtrow);
 	for (i = 0; i < txtrow->length; ++i) {
 		LCUI_TextChar txtchar;
-		txtchar = txtrow->string[i];
-		if (!txtchar->bitmap) {
+		txtchar = &txtrow->string[i];
+		if (!txtchar->metrics) {
 			continue;
 		}
-		pixel_pos += txtchar->bitmap->advance.x;
+		pixel_pos += txtchar->metrics->advance.x;
 		/* 如果在当前字中心点的前面 */
-		if (x <= pixel_pos - txtchar->bitmap->advance.x / 2) {
+		if (x <= pixel_pos - txtchar->metrics->advance.x / 2) {
 			ins_x = i;
 			break;
 		}
@@ -518,11 +591,11 @@ int TextLayer_GetCharPixelPos(LCUI_TextLayer layer, int row, int col,
 	txtrow = layer->text_rows.rows[row];
 	pixel_x = TextLayer_GetRowStartX(layer, txtrow);
 	for (i = 0; i < col; ++i) {
-		LCUI_TextChar txtchar = txtrow->string[i];
-		if (!txtchar || !txtchar->bitmap) {
+		LCUI_TextChar txtchar = &txtrow->string[i];
+		if (!txtchar->metrics) {
 			continue;
 		}
-		pixel_x += txtchar->bitmap->advance.x;
+		pixel_x += txtchar->metrics->advance.x;
 	}
 	pixel_pos->x = pixel_x;
 	pixel_pos->y = pixel_y;
@@ -554,18 +627,14 @@ void TextLayer_ClearText(LCUI_TextLayer layer)
 static void TextLayer_BreakTextRow(LCUI_TextLayer layer, int row, int col,
 				   LCUI_EOLChar eol)
 {
-	int n;
 	LCUI_TextRow txtrow, next;
 	txtrow = TextLayer_GetRow(layer, row);
 	next = TextRowList_InsertNewRow(&layer->text_rows, row + 1);
 	/* 将本行原有的行尾符转移至下一行 */
 	next->eol = txtrow->eol;
 	txtrow->eol = eol;
-	for (n = txtrow->length - 1; n >= col; --n) {
-		TextRow_Insert(next, 0, txtrow->string[n]);
-		txtrow->string[n] = NULL;
-	}
-	txtrow->length = col;
+	TextRow_Insert(next, 0, txtrow->string + col, txtrow->length - col);
+	TextRow_SetLength(txtrow, col);
 	TextLayer_UpdateRowSize(layer, txtrow);
 	TextLayer_UpdateRowSize(layer, next);
 }
@@ -573,7 +642,6 @@ static void TextLayer_BreakTextRow(LCUI_TextLayer layer, int row, int col,
 /** 将指定行与下一行合并 */
 static void TextLayer_MergeRow(LCUI_TextLayer layer, int row)
 {
-	int i, j;
 	LCUI_TextRow txtrow = TextLayer_GetRow(layer, row);
 	LCUI_TextRow next = TextLayer_GetRow(layer, row + 1);
 
@@ -586,12 +654,7 @@ static void TextLayer_MergeRow(LCUI_TextLayer layer, int row)
 			layer->insert_x += txtrow->length;
 		}
 	}
-	i = txtrow->length;
-	TextRow_SetLength(txtrow, txtrow->length + next->length);
-	for (j = 0; j < next->length; ++i, ++j) {
-		txtrow->string[i] = next->string[j];
-		next->string[j] = NULL;
-	}
+	TextRow_Insert(txtrow, txtrow->length, next->string, next->length);
 	txtrow->eol = next->eol;
 	TextLayer_UpdateRowSize(layer, txtrow);
 	TextRowList_RemoveRow(&layer->text_rows, row + 1);
@@ -618,12 +681,12 @@ static void TextLayer_TextRowTypeset(LCUI_TextLayer layer, int row)
 	}
 	txtrow = layer->text_rows.rows[row];
 	for (col = 0; col < txtrow->length; ++col) {
-		txtchar = txtrow->string[col];
-		if (!txtchar->bitmap) {
+		txtchar = &txtrow->string[col];
+		if (!txtchar->metrics) {
 			continue;
 		}
 		/* 累加行宽度 */
-		row_width += txtchar->bitmap->advance.x;
+		row_width += txtchar->metrics->advance.x;
 		/* 如果是当前行的第一个字符，或者行宽度没有超过宽度限制 */
 		if (not_autowrap || col < 1 || row_width <= max_width) {
 			if (ISALPHA(txtchar->code)) {
@@ -706,10 +769,11 @@ static int TextLayer_ProcessText(LCUI_TextLayer layer, const wchar_t *wstr,
 {
 	LCUI_EOLChar eol;
 	LCUI_TextRow txtrow;
-	LCUI_TextCharRec txtchar;
+	LCUI_TextChar txtchar;
+	LCUI_TextCharRec chars[TEXT_INSERT_BATCH_SIZE];
 	LinkedList tmp_tags;
 	const wchar_t *p;
-	int cur_col, cur_row, start_row, ins_x, ins_y;
+	int cur_col, cur_row, start_row, ins_x, ins_y, n_chars = 0;
 	LCUI_BOOL need_typeset, rect_has_added;
 	LCUI_TextStyle style = NULL;
 
@@ -765,6 +829,9 @@ static int TextLayer_ProcessText(LCUI_TextLayer layer, const wchar_t *wstr,
 			} else {
 				eol = LCUI_EOL_LF;
 			}
+			TextLayer_InsertRowChars(layer, txtrow, ins_x - n_chars,
+						 chars, n_chars);
+			n_chars = 0;
 			/* 如果没有记录过文本行的矩形区域 */
 			if (!rect_has_added) {
 				TextLayer_InvalidateRowsRect(layer, ins_y, -1);
@@ -781,15 +848,20 @@ static int TextLayer_ProcessText(LCUI_TextLayer layer, const wchar_t *wstr,
 			txtrow = TextLayer_GetRow(layer, ins_y);
 			continue;
 		}
-		txtchar.style = style;
-		txtchar.code = *p;
-		TextChar_UpdateBitmap(&txtchar, &layer->text_default_style);
-		TextRow_InsertCopy(txtrow, ins_x, &txtchar);
+		/* 先将字符暂存起来，攒够一批后再一起插入，以减少移动字符的次数 */
+		if (n_chars >= TEXT_INSERT_BATCH_SIZE) {
+			TextLayer_InsertRowChars(layer, txtrow, ins_x - n_chars,
+						 chars, n_chars);
+			n_chars = 0;
+		}
+		txtchar = &chars[n_chars++];
+		txtchar->style = style;
+		txtchar->code = *p;
+		TextChar_UpdateMetrics(txtchar, &layer->text_default_style);
 		++layer->length;
 		++ins_x;
 	}
-	/* 更新当前行的尺寸 */
-	TextLayer_UpdateRowSize(layer, txtrow);
+	TextLayer_InsertRowChars(layer, txtrow, ins_x - n_chars, chars, n_chars);
 	layer->width = max(layer->width, txtrow->width);
 	if (action == TEXT_ACTION_INSERT) {
 		layer->insert_x = ins_x;
@@ -889,10 +961,11 @@ size_t TextLayer_GetTextW(LCUI_TextLayer layer, size_t start_pos,
 		}
 		i += layer->text_rows.rows[row]->length;
 	}
-	for (i = 0; row < layer->text_rows.length && i < max_len; ++row) {
+	for (i = 0; row < layer->text_rows.length && i < max_len;
+	     ++row, col = 0) {
 		row_ptr = layer->text_rows.rows[row];
 		for (; col < row_ptr->length && i < max_len; ++col, ++i) {
-			wstr_buff[i] = row_ptr->string[col]->code;
+			wstr_buff[i] = row_ptr->string[col].code;
 		}
 	}
 	wstr_buff[i] = 0;
@@ -909,15 +982,14 @@ int TextLayer_GetWidth(LCUI_TextLayer layer)
 	for (row = 0, max_w = 0; row < layer->text_rows.length; ++row) {
 		txtrow = layer->text_rows.rows[row];
 		for (i = 0, w = 0; i < txtrow->length; ++i) {
-			if (!txtrow->string[i]->bitmap ||
-			    !txtrow->string[i]->bitmap->buffer) {
+			if (!txtrow->string[i].metrics) {
 				continue;
 			}
-			w += txtrow->string[i]->bitmap->advance.x;
+			w += txtrow->string[i].metrics->advance.x;
 			DEBUG_MSG("[%d/%d] %d %c, width: %d/%d\n", i,
-				  txtrow->length, txtrow->string[i]->code,
-				  txtrow->string[i]->code,
-				  txtrow->string[i]->bitmap->advance.x, w);
+				  txtrow->length, txtrow->string[i].code,
+				  txtrow->string[i].code,
+				  txtrow->string[i].metrics->advance.x, w);
 		}
 		if (w > max_w) {
 			max_w = w;
@@ -937,6 +1009,9 @@ int TextLayer_GetHeight(LCUI_TextLayer layer)
 
 int TextLayer_SetFixedSize(LCUI_TextLayer layer, int width, int height)
 {
+	if (layer->fixed_width == width && layer->fixed_height == height) {
+		return 0;
+	}
 	layer->fixed_width = width;
 	layer->fixed_height = height;
 	layer->task.redraw_all = TRUE;
@@ -949,6 +1024,9 @@ int TextLayer_SetFixedSize(LCUI_TextLayer layer, int width, int height)
 
 int TextLayer_SetMaxSize(LCUI_TextLayer layer, int width, int height)
 {
+	if (layer->max_width == width && layer->max_height == height) {
+		return 0;
+	}
 	layer->max_width = width;
 	layer->max_height = height;
 	layer->task.redraw_all = TRUE;
@@ -1046,9 +1124,8 @@ static int TextLayer_TextDeleteEx(LCUI_TextLayer layer, int char_y, int char_x,
 		}
 		TextLayer_InvalidateRowRect(layer, char_y, char_x, -1);
 		TextLayer_AddUpdateTypeset(layer, char_y);
-		for (i = char_x, j = end_x; j < txtrow->length; ++i, ++j) {
-			txtrow->string[i] = txtrow->string[j];
-		}
+		memmove(txtrow->string + char_x, txtrow->string + end_x,
+			sizeof(LCUI_TextCharRec) * (txtrow->length - end_x));
 		/* 如果当前行为空，也不是第一行，并且上一行没有结束符 */
 		if (len <= 0 && end_y > 0 &&
 		    prev_txtrow->eol != LCUI_EOL_NONE) {
@@ -1185,7 +1262,7 @@ static void TextLayer_UpdateTextStyleCache(LCUI_TextLayer layer)
 	}
 }
 
-/** 重新载入各个文字的字体位图 */
+/** 重新载入各个文字的字形度量数据 */
 void TextLayer_ReloadCharBitmap(LCUI_TextLayer layer)
 {
 	int row, col;
@@ -1193,14 +1270,24 @@ void TextLayer_ReloadCharBitmap(LCUI_TextLayer layer)
 	for (row = 0; row < layer->text_rows.length; ++row) {
 		LCUI_TextRow txtrow = layer->text_rows.rows[row];
 		for (col = 0; col < txtrow->length; ++col) {
-			LCUI_TextChar txtchar = txtrow->string[col];
-			TextChar_UpdateBitmap(txtchar,
-					      &layer->text_default_style);
+			TextChar_UpdateMetrics(&txtrow->string[col],
+					       &layer->text_default_style);
 		}
 		TextLayer_UpdateRowSize(layer, txtrow);
 	}
 }
 
+LCUI_BOOL TextLayer_ReloadPendingBitmaps(LCUI_TextLayer layer)
+{
+	if (!layer->bitmaps_pending) {
+		return FALSE;
+	}
+	/* 排版用的是度量数据，不受字形位图影响，只需要重绘 */
+	layer->bitmaps_pending = FALSE;
+	TextLayer_InvalidateRowsRect(layer, 0, -1);
+	return TRUE;
+}
+
 void TextLayer_Update(LCUI_TextLayer layer, LinkedList *rects)
 {
 	if (layer->task.update_bitmap) {
@@ -1272,14 +1359,14 @@ static void TextLayer_DrawTextRow(LCUI_TextLayer layer, LCUI_Rect *area,
 	x = TextLayer_GetRowStartX(layer, txtrow) + layer->offset_x;
 	/* 确定从哪个文字开始绘制 */
 	for (col = 0; col < txtrow->length; ++col) {
-		txtchar = txtrow->string[col];
+		txtchar = &txtrow->string[col];
 		/* 忽略无字体位图的文字 */
-		if (!txtchar->bitmap) {
+		if (!txtchar->metrics) {
 			continue;
 		}
-		x += txtchar->bitmap->advance.x;
+		x += txtchar->metrics->advance.x;
 		if (x > area->x) {
-			x -= txtchar->bitmap->advance.x;
+			x -= txtchar->metrics->advance.x;
 			break;
 		}
 	}
@@ -1290,8 +1377,8 @@ static void TextLayer_DrawTextRow(LCUI_TextLayer layer, LCUI_Rect *area,
 	}
 	/* 遍历该行的文字 */
 	for (; col < txtrow->length; ++col) {
-		txtchar = txtrow->string[col];
-		if (!txtchar->bitmap) {
+		txtchar = &txtrow->string[col];
+		if (!txtchar->metrics) {
 			continue;
 		}
 		/* 计算字体位图的绘制坐标 */
@@ -1302,16 +1389,23 @@ static void TextLayer_DrawTextRow(LCUI_TextLayer layer, LCUI_Rect *area,
 			rect.x = ch_pos.x;
 			rect.y = ch_pos.y;
 			rect.height = txtrow->height;
-			rect.width = txtchar->bitmap->advance.x;
+			rect.width = txtchar->metrics->advance.x;
 			Graph_FillRect(graph, txtchar->style->back_color, &rect,
 				       TRUE);
 		}
-		ch_pos.x += txtchar->bitmap->left;
-		ch_pos.y += baseline;
-		ch_pos.y += (txtrow->height - baseline) / 2;
-		ch_pos.y -= txtchar->bitmap->top;
-		TextLayer_DrawChar(layer, txtchar, graph, ch_pos);
-		x += txtchar->bitmap->advance.x;
+		x += txtchar->metrics->advance.x;
+		/* 字形位图在第一次绘制时才载入 */
+		if (!txtchar->bitmap &&
+		    TextChar_LoadBitmap(txtchar, &layer->text_default_style)) {
+			layer->bitmaps_pending = TRUE;
+		}
+		if (txtchar->bitmap) {
+			ch_pos.x += txtchar->bitmap->left;
+			ch_pos.y += baseline;
+			ch_pos.y += (txtrow->height - baseline) / 2;
+			ch_pos.y -= txtchar->bitmap->top;
+			TextLayer_DrawChar(layer, txtchar, graph, ch_pos);
+		}
 		/* 如果超过绘制区域则不继续绘制该行文本 */
 		if (x > area->x + area->width) {
 			break;
@@ -1340,6 +1434,11 @@ int TextLayer_RenderTo(LCUI_TextLayer layer, LCUI_Rect area, LCUI_Pos layer_pos,
 	if (row >= layer->text_rows.length) {
 		return -1;
 	}
+	/**
+	 * 一个文本层可能被拆分到多个绘制区域中，由多个线程同时绘制，而绘制时
+	 * 会载入字形位图并修改文字和文本层的数据，所以需要加锁
+	 */
+	LCUIMutex_Lock(&layer->mutex);
 	for (; row < layer->text_rows.length; ++row) {
 		txtrow = TextLayer_GetRow(layer, row);
 		TextLayer_DrawTextRow(layer, &area, canvas, layer_pos, txtrow,
@@ -1350,6 +1449,10 @@ int TextLayer_RenderTo(LCUI_TextLayer layer, LCUI_Rect area, LCUI_Pos layer_pos,
 			break;
 		}
 	}
+	if (layer->bitmaps_pending) {
+		LCUIFont_FlushBitmapRequests();
+	}
+	LCUIMutex_Unlock(&layer->mutex);
 	return 0;
 }
 
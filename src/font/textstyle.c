@@ -33,9 +33,7 @@
 #include <errno.h>
 #include <LCUI_Build.h>
 #include <LCUI/types.h>
-#include <LCUI/util/math.h>
-#include <LCUI/util/parse.h>
-#include <LCUI/util/linkedlist.h>
+#include <LCUI/util.h>
 #include <LCUI/font.h>
 
 typedef enum LCUI_TextStyleTagType_ {
@@ -37,6 +37,15 @@
 #include <LCUI/util.h>
 #include <LCUI/graph.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_CONVERT_WITH_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PIXEL_CONVERT_WITH_NEON
+#include <arm_neon.h>
+#endif
+
 void Graph_PrintInfo(LCUI_Graph *graph)
 {
 	printf("address:%p\n", graph);
@@ -177,6 +186,276 @@ void PixelsFormat(const uchar_t *in_pixels, int in_color_type,
 	}
 }
 
+/*------------------------------ Row converters ----------------------------*/
+
+/*
+ * 以下转换函数用于将 ARGB 像素写入显示设备的缓冲区，每次转换一行。主循环
+ * 使用 SSE2 或 NEON 一次处理多个像素，剩下的像素由标量代码处理，两者的结
+ * 果完全一致。RGB565 和 INDEX8 都只截取每个分量的高位，RGB888 的像素按 B、
+ * G、R 的顺序存放。
+ */
+
+/** 4x4 的有序抖动矩阵 */
+static const uchar_t dither_matrix[4][4] = { { 0, 8, 2, 10 },
+					     { 12, 4, 14, 6 },
+					     { 3, 11, 1, 9 },
+					     { 15, 7, 13, 5 } };
+
+INLINE void WriteRGB565(uchar_t *dst, const LCUI_ARGB *px)
+{
+	unsigned value = ((px->r >> 3) << 11) | ((px->g >> 2) << 5) |
+			 (px->b >> 3);
+
+	dst[0] = (uchar_t)(value & 0xff);
+	dst[1] = (uchar_t)(value >> 8);
+}
+
+/**
+ * 给像素加上抖动阈值
+ * 阈值小于量化步长，5 位的分量加上 0 ~ 7，6 位的分量加上 0 ~ 3。
+ */
+INLINE void DitherRGB565(LCUI_ARGB *px, int d)
+{
+	px->r = (uchar_t)min(255, px->r + (d >> 1));
+	px->g = (uchar_t)min(255, px->g + (d >> 2));
+	px->b = (uchar_t)min(255, px->b + (d >> 1));
+}
+
+INLINE uchar_t Index8FromARGB(const LCUI_ARGB *px)
+{
+	return (uchar_t)((px->r & 0xc0) | ((px->g & 0xf0) >> 2) | (px->b >> 6));
+}
+
+#ifdef PIXEL_CONVERT_WITH_SSE2
+
+/** 将 4 个 ARGB 像素转换为 RGB565，结果在每个 32 位整数的低 16 位中 */
+INLINE __m128i PackRGB565_SSE2(__m128i px)
+{
+	__m128i r = _mm_and_si128(_mm_srli_epi32(px, 8), _mm_set1_epi32(0xf800));
+	__m128i g = _mm_and_si128(_mm_srli_epi32(px, 5), _mm_set1_epi32(0x07e0));
+	__m128i b = _mm_and_si128(_mm_srli_epi32(px, 3), _mm_set1_epi32(0x001f));
+
+	px = _mm_or_si128(r, _mm_or_si128(g, b));
+	/* 有符号扩展后才能用 _mm_packs_epi32() 无损地打包成 16 位 */
+	return _mm_srai_epi32(_mm_slli_epi32(px, 16), 16);
+}
+
+INLINE __m128i PackIndex8_SSE2(__m128i px)
+{
+	__m128i r = _mm_and_si128(_mm_srli_epi32(px, 16), _mm_set1_epi32(0xc0));
+	__m128i g = _mm_and_si128(_mm_srli_epi32(px, 10), _mm_set1_epi32(0x3c));
+	__m128i b = _mm_and_si128(_mm_srli_epi32(px, 6), _mm_set1_epi32(0x03));
+
+	return _mm_or_si128(r, _mm_or_si128(g, b));
+}
+
+#endif
+
+static void ConvertRowToRGB565(uchar_t *dst, const LCUI_ARGB *src, int width,
+			       int x, int y)
+{
+	int i = 0;
+#ifdef PIXEL_CONVERT_WITH_SSE2
+	__m128i lo, hi;
+
+	for (; i + 8 <= width; i += 8, dst += 16) {
+		lo = _mm_loadu_si128((const __m128i *)(src + i));
+		hi = _mm_loadu_si128((const __m128i *)(src + i + 4));
+		lo = PackRGB565_SSE2(lo);
+		hi = PackRGB565_SSE2(hi);
+		_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(lo, hi));
+	}
+#elif defined(PIXEL_CONVERT_WITH_NEON)
+	uint8x8x4_t px;
+	uint16x8_t value;
+
+	for (; i + 8 <= width; i += 8, dst += 16) {
+		/* val[0] ~ val[3] 分别是 8 个像素的 B、G、R、A 分量 */
+		px = vld4_u8((const uint8_t *)(src + i));
+		value = vshll_n_u8(px.val[2], 8);
+		value = vsriq_n_u16(value, vshll_n_u8(px.val[1], 8), 5);
+		value = vsriq_n_u16(value, vshll_n_u8(px.val[0], 8), 11);
+		vst1q_u8(dst, vreinterpretq_u8_u16(value));
+	}
+#endif
+	for (; i < width; ++i, dst += 2) {
+		WriteRGB565(dst, src + i);
+	}
+}
+
+static void ConvertRowToRGB565Dither(uchar_t *dst, const LCUI_ARGB *src,
+				     int width, int x, int y)
+{
+	int i = 0;
+	LCUI_ARGB px;
+	const uchar_t *row = dither_matrix[y & 3];
+#ifdef PIXEL_CONVERT_WITH_SSE2
+	int k;
+	uchar_t thresholds[16] = { 0 };
+	__m128i lo, hi, threshold;
+
+	/* 抖动矩阵每 4 列重复一次，每组像素的阈值都相同 */
+	for (k = 0; k < 4; ++k) {
+		thresholds[k * 4] = row[(x + k) & 3] >> 1;
+		thresholds[k * 4 + 1] = row[(x + k) & 3] >> 2;
+		thresholds[k * 4 + 2] = row[(x + k) & 3] >> 1;
+	}
+	threshold = _mm_loadu_si128((const __m128i *)thresholds);
+	for (; i + 8 <= width; i += 8, dst += 16) {
+		lo = _mm_loadu_si128((const __m128i *)(src + i));
+		hi = _mm_loadu_si128((const __m128i *)(src + i + 4));
+		lo = PackRGB565_SSE2(_mm_adds_epu8(lo, threshold));
+		hi = PackRGB565_SSE2(_mm_adds_epu8(hi, threshold));
+		_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(lo, hi));
+	}
+#elif defined(PIXEL_CONVERT_WITH_NEON)
+	int k;
+	uint8_t thresholds[8], thresholds_g[8];
+	uint8x8_t threshold, threshold_g;
+	uint8x8x4_t px8;
+	uint16x8_t value;
+
+	for (k = 0; k < 8; ++k) {
+		thresholds[k] = row[(x + k) & 3] >> 1;
+		thresholds_g[k] = row[(x + k) & 3] >> 2;
+	}
+	threshold = vld1_u8(thresholds);
+	threshold_g = vld1_u8(thresholds_g);
+	for (; i + 8 <= width; i += 8, dst += 16) {
+		px8 = vld4_u8((const uint8_t *)(src + i));
+		px8.val[0] = vqadd_u8(px8.val[0], threshold);
+		px8.val[1] = vqadd_u8(px8.val[1], threshold_g);
+		px8.val[2] = vqadd_u8(px8.val[2], threshold);
+		value = vshll_n_u8(px8.val[2], 8);
+		value = vsriq_n_u16(value, vshll_n_u8(px8.val[1], 8), 5);
+		value = vsriq_n_u16(value, vshll_n_u8(px8.val[0], 8), 11);
+		vst1q_u8(dst, vreinterpretq_u8_u16(value));
+	}
+#endif
+	for (; i < width; ++i, dst += 2) {
+		px = src[i];
+		DitherRGB565(&px, row[(x + i) & 3]);
+		WriteRGB565(dst, &px);
+	}
+}
+
+static void ConvertRowToRGB888(uchar_t *dst, const LCUI_ARGB *src, int width,
+			       int x, int y)
+{
+	int i = 0;
+#ifdef PIXEL_CONVERT_WITH_NEON
+	uint8x8x4_t px;
+	uint8x8x3_t rgb;
+
+	for (; i + 8 <= width; i += 8, dst += 24) {
+		px = vld4_u8((const uint8_t *)(src + i));
+		rgb.val[0] = px.val[0];
+		rgb.val[1] = px.val[1];
+		rgb.val[2] = px.val[2];
+		vst3_u8(dst, rgb);
+	}
+#else
+	uint32_t p[4], out[3];
+
+	/* 每 4 个像素的 12 个字节正好是 3 个 32 位整数 */
+	for (; i + 4 <= width; i += 4, dst += 12) {
+		memcpy(p, src + i, sizeof(p));
+		out[0] = (p[0] & 0xffffff) | (p[1] << 24);
+		out[1] = ((p[1] >> 8) & 0xffff) | (p[2] << 16);
+		out[2] = ((p[2] >> 16) & 0xff) | (p[3] << 8);
+		memcpy(dst, out, sizeof(out));
+	}
+#endif
+	for (; i < width; ++i) {
+		*dst++ = src[i].b;
+		*dst++ = src[i].g;
+		*dst++ = src[i].r;
+	}
+}
+
+static void ConvertRowToARGB8888(uchar_t *dst, const LCUI_ARGB *src, int width,
+				 int x, int y)
+{
+	memcpy(dst, src, sizeof(LCUI_ARGB) * width);
+}
+
+static void ConvertRowToIndex8(uchar_t *dst, const LCUI_ARGB *src, int width,
+			       int x, int y)
+{
+	int i = 0;
+#ifdef PIXEL_CONVERT_WITH_SSE2
+	__m128i a, b, c, d;
+
+	for (; i + 16 <= width; i += 16, dst += 16) {
+		a = PackIndex8_SSE2(_mm_loadu_si128((const __m128i *)(src + i)));
+		b = PackIndex8_SSE2(
+		    _mm_loadu_si128((const __m128i *)(src + i + 4)));
+		c = PackIndex8_SSE2(
+		    _mm_loadu_si128((const __m128i *)(src + i + 8)));
+		d = PackIndex8_SSE2(
+		    _mm_loadu_si128((const __m128i *)(src + i + 12)));
+		a = _mm_packs_epi32(a, b);
+		c = _mm_packs_epi32(c, d);
+		_mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(a, c));
+	}
+#elif defined(PIXEL_CONVERT_WITH_NEON)
+	uint8x8x4_t px;
+	uint8x8_t index;
+
+	for (; i + 8 <= width; i += 8, dst += 8) {
+		px = vld4_u8((const uint8_t *)(src + i));
+		index = vand_u8(px.val[2], vdup_n_u8(0xc0));
+		index = vorr_u8(index, vand_u8(vshr_n_u8(px.val[1], 2),
+					       vdup_n_u8(0x3c)));
+		index = vorr_u8(index, vshr_n_u8(px.val[0], 6));
+		vst1_u8(dst, index);
+	}
+#endif
+	for (; i < width; ++i) {
+		*dst++ = Index8FromARGB(src + i);
+	}
+}
+
+static const struct PixelRowConverterRec_ {
+	int color_type;
+	int flags;
+	LCUI_PixelRowConverter convert;
+} pixel_row_converters[] = {
+	{ LCUI_COLOR_TYPE_ARGB8888, 0, ConvertRowToARGB8888 },
+	{ LCUI_COLOR_TYPE_RGB888, 0, ConvertRowToRGB888 },
+	{ LCUI_COLOR_TYPE_RGB565, 0, ConvertRowToRGB565 },
+	{ LCUI_COLOR_TYPE_RGB565, LCUI_PIXEL_CONVERT_DITHER,
+	  ConvertRowToRGB565Dither },
+	{ LCUI_COLOR_TYPE_INDEX8, 0, ConvertRowToIndex8 }
+};
+
+LCUI_PixelRowConverter LCUI_GetPixelRowConverter(int color_type, int flags)
+{
+	size_t i;
+	size_t n = sizeof(pixel_row_converters) / sizeof(pixel_row_converters[0]);
+
+	for (i = 0; i < n; ++i) {
+		if (pixel_row_converters[i].color_type == color_type &&
+		    pixel_row_converters[i].flags == flags) {
+			return pixel_row_converters[i].convert;
+		}
+	}
+	/* 不支持的选项直接忽略 */
+	for (i = 0; i < n; ++i) {
+		if (pixel_row_converters[i].color_type == color_type) {
+			return pixel_row_converters[i].convert;
+		}
+	}
+	return NULL;
+}
+
+LCUI_Color LCUI_GetIndex8Color(uchar_t index)
+{
+	return RGB((uchar_t)(((index >> 6) & 3) * 85),
+		   (uchar_t)(((index >> 2) & 15) * 17),
+		   (uchar_t)((index & 3) * 85));
+}
+
 static int Graph_RGBToARGB(LCUI_Graph *graph)
 {
 	size_t x, y;
@@ -698,13 +977,6 @@ static int Graph_FillRectARGB(LCUI_Graph *graph, LCUI_Color color,
 	return 0;
 }
 
-static uchar_t Graph_BilinearResamplingCore(uchar_t a, uchar_t b, uchar_t c,
-					    uchar_t d, float dx, float dy)
-{
-	return (uchar_t)(a * (1 - dx) * (1 - dy) + b * (dx) * (1 - dy) +
-			 c * (dy) * (1 - dx) + d * (dx * dy));
-}
-
 /*-------------------------------- End ARGB --------------------------------*/
 
 int Graph_SetColorType(LCUI_Graph *graph, int color_type)
@@ -961,159 +1233,15 @@ int Graph_SetBlueBits(LCUI_Graph *graph, uchar_t *b, size_t size)
 int Graph_Zoom(const LCUI_Graph *graph, LCUI_Graph *buff, LCUI_BOOL keep_scale,
 	       int width, int height)
 {
-	LCUI_Rect rect;
-	int x, y, src_x, src_y;
-	double scale_x = 0.0, scale_y = 0.0;
-	if (!Graph_IsValid(graph) || (width <= 0 && height <= 0)) {
-		return -1;
-	}
-	/* 获取引用的有效区域，以及指向引用的对象的指针 */
-	Graph_GetValidRect(graph, &rect);
-	graph = Graph_GetQuote(graph);
-	if (width > 0) {
-		scale_x = 1.0 * rect.width / width;
-	}
-	if (height > 0) {
-		scale_y = 1.0 * rect.height / height;
-	}
-	if (width <= 0) {
-		scale_x = scale_y;
-		width = (int)(0.5 + 1.0 * graph->width / scale_x);
-	}
-	if (height <= 0) {
-		scale_y = scale_x;
-		height = (int)(0.5 + 1.0 * graph->height / scale_y);
-	}
-	/* 如果保持宽高比 */
-	if (keep_scale) {
-		if (scale_x < scale_y) {
-			scale_y = scale_x;
-		} else {
-			scale_x = scale_y;
-		}
-	}
-	buff->color_type = graph->color_type;
-	if (Graph_Create(buff, width, height) < 0) {
-		return -2;
-	}
-	if (graph->color_type == LCUI_COLOR_TYPE_ARGB) {
-		LCUI_ARGB *px_src, *px_des, *px_row_src;
-		for (y = 0; y < height; ++y) {
-			src_y = (int)(y * scale_y);
-			px_row_src = graph->argb;
-			px_row_src += (src_y + rect.y) * graph->width + rect.x;
-			px_des = buff->argb + y * width;
-			for (x = 0; x < width; ++x) {
-				src_x = (int)(x * scale_x);
-				px_src = px_row_src + src_x;
-				*px_des++ = *px_src;
-			}
-		}
-	} else {
-		uchar_t *byte_src, *byte_des, *byte_row_src;
-		for (y = 0; y < height; ++y) {
-			src_y = (int)(y * scale_y);
-			byte_row_src = graph->bytes;
-			byte_row_src += (src_y + rect.y) * graph->bytes_per_row;
-			byte_row_src += rect.x * graph->bytes_per_pixel;
-			byte_des = buff->bytes + y * buff->bytes_per_row;
-			for (x = 0; x < width; ++x) {
-				src_x = (int)(x * scale_x);
-				src_x *= graph->bytes_per_pixel;
-				byte_src = byte_row_src + src_x;
-				*byte_des++ = *byte_src++;
-				*byte_des++ = *byte_src++;
-				*byte_des++ = *byte_src;
-			}
-		}
-	}
-	return 0;
+	return Graph_Resample(graph, buff, LCUI_RESAMPLE_NEAREST, keep_scale,
+			      width, height);
 }
 
 int Graph_ZoomBilinear(const LCUI_Graph *graph, LCUI_Graph *buff,
 		       LCUI_BOOL keep_scale, int width, int height)
 {
-	LCUI_Rect rect;
-	LCUI_ARGB a, b, c, d, t_color;
-
-	int x, y, i, j;
-	float x_diff, y_diff;
-	double scale_x = 0.0, scale_y = 0.0;
-
-	if (graph->color_type != LCUI_COLOR_TYPE_RGB &&
-	    graph->color_type != LCUI_COLOR_TYPE_ARGB) {
-		/* fall back to nearest scaling */
-		Logger_Debug("[graph] unable to perform bilinear scaling, "
-			     "fallback...\n");
-		return Graph_Zoom(graph, buff, keep_scale, width, height);
-	}
-	if (!Graph_IsValid(graph) || (width <= 0 && height <= 0)) {
-		return -1;
-	}
-	/* 获取引用的有效区域，以及指向引用的对象的指针 */
-	Graph_GetValidRect(graph, &rect);
-	graph = Graph_GetQuote(graph);
-	if (width > 0) {
-		scale_x = 1.0 * rect.width / width;
-	}
-	if (height > 0) {
-		scale_y = 1.0 * rect.height / height;
-	}
-	if (width <= 0) {
-		scale_x = scale_y;
-		width = (int)(0.5 + 1.0 * graph->width / scale_x);
-	}
-	if (height <= 0) {
-		scale_y = scale_x;
-		height = (int)(0.5 + 1.0 * graph->height / scale_y);
-	}
-	/* 如果保持宽高比 */
-	if (keep_scale) {
-		if (scale_x < scale_y) {
-			scale_y = scale_x;
-		} else {
-			scale_x = scale_y;
-		}
-	}
-	buff->color_type = graph->color_type;
-	if (Graph_Create(buff, width, height) < 0) {
-		return -2;
-	}
-	for (i = 0; i < height; i++) {
-		for (j = 0; j < width; j++) {
-			/*
-			 * Qmn = (m, n).
-			 * Qxy1 = (x2 - x) / (x2 - x1) * Q11 + (x - x1) / (x2
-			 * - x1) * Q21
-			 * Qxy2 = (x2 - x) / (x2 - x1) * Q12 + (x - x1) / (x2
-			 * - x1) * Q22
-			 * Qxy = (y2 - y) / (y2 - y1) * Qxy1 + (y - y1) / (y2 -
-			 * y1) * Qxy2
-			 */
-			x = (int)(scale_x * j);
-			y = (int)(scale_y * i);
-			x_diff = (float)((scale_x * j) - x);
-			y_diff = (float)((scale_y * i) - y);
-			Graph_GetPixel(graph, x + rect.x + 0, y + rect.y + 0,
-				       a);
-			Graph_GetPixel(graph, x + rect.x + 1, y + rect.y + 0,
-				       b);
-			Graph_GetPixel(graph, x + rect.x + 0, y + rect.y + 1,
-				       c);
-			Graph_GetPixel(graph, x + rect.x + 1, y + rect.y + 1,
-				       d);
-			t_color.b = Graph_BilinearResamplingCore(
-			    a.b, b.b, c.b, d.b, x_diff, y_diff);
-			t_color.g = Graph_BilinearResamplingCore(
-			    a.g, b.g, c.g, d.g, x_diff, y_diff);
-			t_color.r = Graph_BilinearResamplingCore(
-			    a.r, b.r, c.r, d.r, x_diff, y_diff);
-			t_color.a = Graph_BilinearResamplingCore(
-			    a.a, b.a, c.a, d.a, x_diff, y_diff);
-			Graph_SetPixel(buff, j, i, t_color);
-		}
-	}
-	return 0;
+	return Graph_Resample(graph, buff, LCUI_RESAMPLE_BILINEAR, keep_scale,
+			      width, height);
 }
 
 int Graph_Cut(const LCUI_Graph *graph, LCUI_Rect rect, LCUI_Graph *buff)
@@ -29,6 +29,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <LCUI_Build.h>
 #include "config.h"
@@ -37,14 +38,68 @@
 #include <LCUI/gui/widget.h>
 #include <LCUI/gui/builder.h>
 #include <LCUI/gui/css_parser.h>
+#include <sys/stat.h>
+
+#ifdef LCUI_BUILD_IN_WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 
 #define WARN_TXT "[builder] warning: this module is not enabled before build.\n"
 
+/**
+ * 预编译的界面文件格式
+ * 文件由文件头、部件类型表、指令和字符串数据依次组成，整数都按本机字节序存储。
+ * 指令按照原 xml 文档中的顺序记录部件的创建、属性设置和资源加载操作，每条指令
+ * 由指令类型和固定数量的参数组成，参数是部件类型的索引或字符串在字符串数据中
+ * 的偏移量。字符串以 '\0' 结尾，载入时直接引用映射到内存中的数据。部件的类型、
+ * id、类和属性名在编译时就已经解析好了。
+ */
+#define UI_BINARY_MAGIC "LCUI"
+#define UI_BINARY_VERSION 1
+#define UI_BINARY_BYTE_ORDER 0x01020304
+#define UI_BINARY_NONE 0xffffffff
+
+typedef struct UIBinaryHeaderRec_ {
+	char magic[4];
+	unsigned version;
+	unsigned byte_order;
+	unsigned types_count;  /**< 部件类型数量 */
+	unsigned ops_size;     /**< 指令数据的长度，以 unsigned 为单位 */
+	unsigned strings_size; /**< 字符串数据的字节数 */
+} UIBinaryHeaderRec;
+
+enum UIBinaryOpType {
+	UI_OP_NONE,
+	UI_OP_BEGIN_UI,       /**< 创建根部件 */
+	UI_OP_BEGIN_WIDGET,   /**< 创建部件，参数为部件类型的索引 */
+	UI_OP_END,            /**< 结束当前部件 */
+	UI_OP_SET_ID,         /**< 设置 id */
+	UI_OP_ADD_CLASS,      /**< 添加一个类 */
+	UI_OP_SET_ATTRIBUTE,  /**< 设置属性，参数为属性名和属性值 */
+	UI_OP_SET_TEXT,       /**< 设置文本 */
+	UI_OP_LOAD_CSS,       /**< 载入样式，参数为样式代码和空间 */
+	UI_OP_LOAD_CSS_FILE,  /**< 载入样式文件 */
+	UI_OP_LOAD_FONT_FILE, /**< 载入字体文件 */
+	UI_OP_TOTAL_NUM
+};
+
+/** 各个指令的参数数量 */
+static const unsigned ui_op_args[UI_OP_TOTAL_NUM] = { 0, 0, 1, 0, 1, 1,
+						      2, 1, 2, 1, 1 };
+
 #ifdef USE_LCUI_BUILDER
 #include <libxml/xmlmemory.h>
-#include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 
-#define PropNameIs(PROP, NAME) (xmlStrcasecmp(PROP->name, (xmlChar *)NAME) == 0)
+#define NameIs(NAME, STR) (xmlStrcasecmp(NAME, (xmlChar *)STR) == 0)
+#define IsTextNode(TYPE)                        \
+	((TYPE) == XML_READER_TYPE_TEXT ||      \
+	 (TYPE) == XML_READER_TYPE_WHITESPACE || \
+	 (TYPE) == XML_READER_TYPE_SIGNIFICANT_WHITESPACE)
 
 enum ParserID { ID_ROOT, ID_UI, ID_WIDGET, ID_RESOURCE };
 
@@ -56,8 +111,25 @@ enum ParserBehavior {
 	PB_ENTER    /**< 进入子元素列表 */
 };
 
+/** 界面编译器，将解析结果记录为指令，而不是直接创建部件 */
+typedef struct UIWriterRec_ {
+	Dict *strings;       /**< 字符串到偏移量的映射，用于去重 */
+	char *data;          /**< 字符串数据 */
+	size_t data_len;
+	size_t data_size;
+	unsigned *types;     /**< 部件类型名称的偏移量 */
+	unsigned types_count;
+	unsigned types_size;
+	unsigned *ops;
+	unsigned ops_len;
+	unsigned ops_size;
+	int depth;           /**< 尚未结束的部件的层数 */
+	LCUI_BOOL has_root;
+	LCUI_BOOL ok;
+} UIWriterRec, *UIWriter;
+
 typedef struct XMLParserContextRec_ XMLParserContextRec, *XMLParserContext;
-typedef int (*ParserFuncPtr)(XMLParserContext, xmlNodePtr);
+typedef int (*ParserFuncPtr)(XMLParserContext, xmlTextReaderPtr);
 
 typedef struct Parser {
 	int id;
@@ -73,8 +145,22 @@ struct XMLParserContextRec_ {
 	LCUI_WidgetPrototypeC widget_proto;
 	ParserPtr parent_parser;
 	const char *space;
+	UIWriter writer;  /**< 不为 NULL 时表示正在编译 */
+	LCUI_BOOL nested; /**< 是否为被其它文档引用的文档 */
 };
 
+/**
+ * 流式加载器
+ * 文档是边读取边构建的，不会生成完整的 DOM 树，只需要为当前元素的每一层祖先
+ * 保存一个解析上下文，stack[i] 是深度为 i 的元素的子元素所用的上下文。
+ */
+typedef struct XMLLoaderRec_ {
+	const char *name;
+	xmlTextReaderPtr reader;
+	XMLParserContextRec *stack;
+	int stack_size;
+} XMLLoaderRec, *XMLLoader;
+
 static struct ModuleContext {
 	LCUI_BOOL active;
 	RBTree parsers;
@@ -84,53 +170,228 @@ static struct ModuleContext {
 	code = CODE; \
 	goto exit;
 
-/** 解析 <resource> 元素，根据相关参数载入资源 */
-static int ParseResource(XMLParserContext ctx, xmlNodePtr node)
+static int UIWriter_Compile(UIWriter writer, const char *filepath,
+			    LCUI_BOOL nested);
+
+static void *UIWriter_Grow(UIWriter writer, void *buf, unsigned *size,
+			   unsigned count, size_t item_size)
+{
+	unsigned new_size;
+
+	if (count < *size) {
+		return buf;
+	}
+	new_size = *size > 0 ? *size * 2 : 64;
+	buf = realloc(buf, new_size * item_size);
+	if (!buf) {
+		writer->ok = FALSE;
+		return NULL;
+	}
+	*size = new_size;
+	return buf;
+}
+
+static void UIWriter_Init(UIWriter writer)
+{
+	memset(writer, 0, sizeof(UIWriterRec));
+	writer->strings = Dict_Create(&DictType_StringCopyKey, NULL);
+	writer->ok = TRUE;
+}
+
+static void UIWriter_Destroy(UIWriter writer)
+{
+	Dict_Release(writer->strings);
+	free(writer->data);
+	free(writer->types);
+	free(writer->ops);
+	memset(writer, 0, sizeof(UIWriterRec));
+}
+
+/**
+ * 添加字符串，相同的字符串只保存一份
+ * @returns 字符串在字符串数据中的偏移量
+ */
+static unsigned UIWriter_AddString(UIWriter writer, const char *str)
+{
+	void *value;
+	char *data;
+	unsigned offset;
+	size_t len, size;
+
+	value = Dict_FetchValue(writer->strings, str);
+	if (value) {
+		return (unsigned)((size_t)value - 1);
+	}
+	len = strlen(str) + 1;
+	if (writer->data_len + len > writer->data_size) {
+		size = writer->data_size > 0 ? writer->data_size * 2 : 4096;
+		while (size < writer->data_len + len) {
+			size *= 2;
+		}
+		data = realloc(writer->data, size);
+		if (!data) {
+			writer->ok = FALSE;
+			return UI_BINARY_NONE;
+		}
+		writer->data = data;
+		writer->data_size = size;
+	}
+	offset = (unsigned)writer->data_len;
+	memcpy(writer->data + writer->data_len, str, len);
+	writer->data_len += len;
+	Dict_Add(writer->strings, (void *)str, (void *)((size_t)offset + 1));
+	return offset;
+}
+
+static unsigned UIWriter_AddType(UIWriter writer, const char *type)
+{
+	unsigned i, str;
+	unsigned *types;
+
+	str = UIWriter_AddString(writer, type);
+	for (i = 0; i < writer->types_count; ++i) {
+		if (writer->types[i] == str) {
+			return i;
+		}
+	}
+	types = UIWriter_Grow(writer, writer->types, &writer->types_size,
+			      writer->types_count, sizeof(unsigned));
+	if (!types) {
+		return UI_BINARY_NONE;
+	}
+	writer->types = types;
+	writer->types[writer->types_count] = str;
+	return writer->types_count++;
+}
+
+/** 添加指令，多余的参数会被忽略 */
+static void UIWriter_AddOp(UIWriter writer, unsigned type, unsigned arg1,
+			   unsigned arg2)
+{
+	unsigned i;
+	unsigned *ops;
+	unsigned args[2] = { arg1, arg2 };
+
+	ops = UIWriter_Grow(writer, writer->ops, &writer->ops_size,
+			    writer->ops_len + 2, sizeof(unsigned));
+	if (!ops) {
+		return;
+	}
+	writer->ops = ops;
+	ops[writer->ops_len++] = type;
+	for (i = 0; i < ui_op_args[type]; ++i) {
+		ops[writer->ops_len++] = args[i];
+	}
+}
+
+static void UIWriter_AddStringOp(UIWriter writer, unsigned type,
+				 const char *str)
+{
+	UIWriter_AddOp(writer, type, UIWriter_AddString(writer, str),
+		       UI_BINARY_NONE);
+}
+
+static int UIWriter_Save(UIWriter writer, const char *filepath)
 {
-	xmlAttrPtr prop;
+	FILE *fp;
+	size_t count = 0;
+	UIBinaryHeaderRec header;
+
+	memcpy(header.magic, UI_BINARY_MAGIC, 4);
+	header.version = UI_BINARY_VERSION;
+	header.byte_order = UI_BINARY_BYTE_ORDER;
+	header.types_count = writer->types_count;
+	header.ops_size = writer->ops_len;
+	header.strings_size = (unsigned)writer->data_len;
+	fp = fopen(filepath, "wb");
+	if (!fp) {
+		return -1;
+	}
+	count += fwrite(&header, sizeof(header), 1, fp);
+	count += fwrite(writer->types, sizeof(unsigned), writer->types_count,
+			fp);
+	count += fwrite(writer->ops, sizeof(unsigned), writer->ops_len, fp);
+	count += fwrite(writer->data, 1, writer->data_len, fp);
+	if (fclose(fp) != 0 || count != 1 + writer->types_count +
+					     writer->ops_len + writer->data_len) {
+		remove(filepath);
+		return -1;
+	}
+	return 0;
+}
 
+/** 解析 <resource> 元素，根据相关参数载入资源 */
+static int ParseResource(XMLParserContext ctx, xmlTextReaderPtr reader)
+{
 	int code = PB_NEXT;
-	char *prop_val, *type = NULL, *src = NULL;
+	const xmlChar *name;
+	char *type = NULL, *src = NULL;
 
-	if (node->type != XML_ELEMENT_NODE) {
+	/* 内联样式表是以文本结点的形式传进来的 */
+	if (IsTextNode(xmlTextReaderNodeType(reader))) {
+		name = xmlTextReaderConstValue(reader);
+		if (ctx->writer) {
+			UIWriter_AddOp(
+			    ctx->writer, UI_OP_LOAD_CSS,
+			    UIWriter_AddString(ctx->writer, (char *)name),
+			    ctx->space
+				? UIWriter_AddString(ctx->writer, ctx->space)
+				: UI_BINARY_NONE);
+		} else {
+			LCUI_LoadCSSString((char *)name, ctx->space);
+		}
 		return PB_NEXT;
 	}
-	prop = node->properties;
-	while (prop) {
-		prop_val = (char *)xmlGetProp(node, prop->name);
-		if (PropNameIs(prop, "type")) {
-			type = prop_val;
-		} else if (PropNameIs(prop, "src")) {
-			src = prop_val;
-		} else {
-			xmlFree(prop_val);
+	if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
+		return PB_NEXT;
+	}
+	while (xmlTextReaderMoveToNextAttribute(reader) == 1) {
+		name = xmlTextReaderConstLocalName(reader);
+		if (NameIs(name, "type")) {
+			type = (char *)xmlTextReaderValue(reader);
+		} else if (NameIs(name, "src")) {
+			src = (char *)xmlTextReaderValue(reader);
 		}
-		prop = prop->next;
 	}
-	if (!type && !src) {
-		return PB_WARNING;
+	xmlTextReaderMoveToElement(reader);
+	if (!type) {
+		EXIT(PB_WARNING);
 	}
 	if (strstr(type, "application/font-")) {
-		if (LCUIFont_LoadFile(src) < 1) {
+		if (ctx->writer) {
+			if (!src) {
+				EXIT(PB_WARNING);
+			}
+			UIWriter_AddStringOp(ctx->writer, UI_OP_LOAD_FONT_FILE,
+					     src);
+		} else if (LCUIFont_LoadFile(src) < 1) {
 			EXIT(PB_WARNING);
 		}
 	} else if (strcmp(type, "text/css") == 0) {
 		if (src) {
-			if (LCUI_LoadCSSFile(src) != 0) {
+			if (ctx->writer) {
+				UIWriter_AddStringOp(ctx->writer,
+						     UI_OP_LOAD_CSS_FILE, src);
+			} else if (LCUI_LoadCSSFile(src) != 0) {
 				EXIT(PB_WARNING);
 			}
 		}
-		for (node = node->children; node; node = node->next) {
-			if (node->type != XML_TEXT_NODE) {
-				continue;
-			}
-			LCUI_LoadCSSString((char *)node->content, ctx->space);
-		}
+		EXIT(PB_ENTER);
 	} else if (strcmp(type, "text/xml") == 0) {
 		LCUI_Widget pack;
 		if (!src) {
 			EXIT(PB_WARNING);
 		}
+		/* 编译时直接把被引用的文档中的部件编译到当前位置 */
+		if (ctx->writer) {
+			if (ctx->writer->depth < 1 && !ctx->writer->has_root) {
+				EXIT(PB_WARNING);
+			}
+			if (UIWriter_Compile(ctx->writer, src, TRUE) != 0) {
+				EXIT(PB_WARNING);
+			}
+			EXIT(PB_NEXT);
+		}
 		pack = LCUIBuilder_LoadFile(src);
 		if (!pack) {
 			EXIT(PB_WARNING);
@@ -156,58 +417,129 @@ exit:
 }
 
 /** 解析 <ui> 元素，主要作用是创建一个容纳全部部件的根级部件 */
-static int ParseUI(XMLParserContext ctx, xmlNodePtr node)
+static int ParseUI(XMLParserContext ctx, xmlTextReaderPtr reader)
 {
-	if (node->type != XML_ELEMENT_NODE) {
+	if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
 		return PB_NEXT;
 	}
 	if (ctx->parent_parser && ctx->parent_parser->id != ID_ROOT) {
 		return PB_ERROR;
 	}
+	if (ctx->writer) {
+		/* 被引用的文档的根部件在载入后会被展开，所以不需要记录 */
+		if (!ctx->nested) {
+			if (ctx->writer->has_root) {
+				return PB_ERROR;
+			}
+			UIWriter_AddOp(ctx->writer, UI_OP_BEGIN_UI,
+				       UI_BINARY_NONE, UI_BINARY_NONE);
+			ctx->writer->has_root = TRUE;
+			ctx->writer->depth += 1;
+		}
+		return PB_ENTER;
+	}
 	ctx->widget = LCUIWidget_New(NULL);
 	ctx->root = ctx->widget;
 	return PB_ENTER;
 }
 
+/** 编译 <widget> 元素，类名会被拆分，属性名会被转换为小写 */
+static int CompileWidget(XMLParserContext ctx, xmlTextReaderPtr reader)
+{
+	const xmlChar *name;
+	char *prop_val, *prop_name, *class_name;
+	UIWriter writer = ctx->writer;
+	unsigned type = UI_BINARY_NONE;
+
+	if (ctx->widget_proto) {
+		type = UIWriter_AddType(writer, ctx->widget_proto->name);
+	} else {
+		while (xmlTextReaderMoveToNextAttribute(reader) == 1) {
+			name = xmlTextReaderConstLocalName(reader);
+			if (NameIs(name, "type")) {
+				prop_val = (char *)xmlTextReaderConstValue(reader);
+				type = UIWriter_AddType(writer, prop_val);
+				break;
+			}
+		}
+		xmlTextReaderMoveToElement(reader);
+	}
+	UIWriter_AddOp(writer, UI_OP_BEGIN_WIDGET, type, UI_BINARY_NONE);
+	writer->depth += 1;
+	while (xmlTextReaderMoveToNextAttribute(reader) == 1) {
+		name = xmlTextReaderConstLocalName(reader);
+		prop_val = (char *)xmlTextReaderConstValue(reader);
+		if (NameIs(name, "id")) {
+			UIWriter_AddStringOp(writer, UI_OP_SET_ID, prop_val);
+		} else if (NameIs(name, "class")) {
+			prop_val = strdup2(prop_val);
+			class_name = strtok(prop_val, " ");
+			while (class_name) {
+				UIWriter_AddStringOp(writer, UI_OP_ADD_CLASS,
+						     class_name);
+				class_name = strtok(NULL, " ");
+			}
+			free(prop_val);
+		} else {
+			prop_name = malloc(strsize((const char *)name));
+			strtolower(prop_name, (const char *)name);
+			UIWriter_AddOp(writer, UI_OP_SET_ATTRIBUTE,
+				       UIWriter_AddString(writer, prop_name),
+				       UIWriter_AddString(writer, prop_val));
+			free(prop_name);
+		}
+	}
+	xmlTextReaderMoveToElement(reader);
+	return PB_ENTER;
+}
+
 /** 解析 <widget> 元素数据 */
-static int ParseWidget(XMLParserContext ctx, xmlNodePtr node)
+static int ParseWidget(XMLParserContext ctx, xmlTextReaderPtr reader)
 {
-	xmlAttrPtr prop;
-	char *prop_val = NULL, *prop_name, *type = NULL;
+	int type;
+	const xmlChar *name;
+	char *prop_val, *prop_name;
 	LCUI_Widget w = NULL, parent = ctx->widget;
 
 	if (ctx->parent_parser && ctx->parent_parser->id != ID_UI &&
 	    ctx->parent_parser->id != ID_WIDGET) {
 		return PB_ERROR;
 	}
-	switch (node->type) {
-	case XML_ELEMENT_NODE:
-		break;
-	case XML_TEXT_NODE:
-		Widget_SetText(parent, (char *)node->content);
-		DEBUG_MSG("widget: %s, set text: %s\n", parent->type,
-			  (char *)node->content);
+	type = xmlTextReaderNodeType(reader);
+	if (IsTextNode(type)) {
+		prop_val = (char *)xmlTextReaderConstValue(reader);
+		if (ctx->writer) {
+			UIWriter_AddStringOp(ctx->writer, UI_OP_SET_TEXT,
+					     prop_val);
+			return PB_NEXT;
+		}
+		Widget_SetText(parent, prop_val);
+		DEBUG_MSG("widget: %s, set text: %s\n", parent->type, prop_val);
 		return PB_NEXT;
-	default:
+	}
+	if (type != XML_READER_TYPE_ELEMENT) {
 		return PB_ERROR;
 	}
+	if (ctx->writer) {
+		/* 在 <ui> 之外的部件没有父部件，不需要编译 */
+		if (!ctx->parent_parser) {
+			return PB_ERROR;
+		}
+		return CompileWidget(ctx, reader);
+	}
 	if (ctx->widget_proto) {
 		w = LCUIWidget_NewWithPrototype(ctx->widget_proto);
 	} else {
-		for (prop = node->properties; prop; prop = prop->next) {
-			prop_val = (char *)xmlGetProp(node, prop->name);
-			if (PropNameIs(prop, "type")) {
-				type = prop_val;
+		prop_val = NULL;
+		while (xmlTextReaderMoveToNextAttribute(reader) == 1) {
+			name = xmlTextReaderConstLocalName(reader);
+			if (NameIs(name, "type")) {
+				prop_val = (char *)xmlTextReaderConstValue(reader);
 				break;
 			}
-			if (prop_val) {
-				xmlFree(prop_val);
-			}
-		}
-		w = LCUIWidget_New(type);
-		if (type) {
-			xmlFree(type);
 		}
+		w = LCUIWidget_New(prop_val);
+		xmlTextReaderMoveToElement(reader);
 	}
 	if (!w) {
 		return PB_ERROR;
@@ -215,24 +547,23 @@ static int ParseWidget(XMLParserContext ctx, xmlNodePtr node)
 	DEBUG_MSG("create widget: %s\n", w->type);
 	Widget_Append(parent, w);
 	ctx->widget = w;
-	for (prop = node->properties; prop; prop = prop->next) {
-		prop_val = (char *)xmlGetProp(node, prop->name);
-		if (PropNameIs(prop, "id")) {
+	while (xmlTextReaderMoveToNextAttribute(reader) == 1) {
+		name = xmlTextReaderConstLocalName(reader);
+		prop_val = (char *)xmlTextReaderConstValue(reader);
+		if (NameIs(name, "id")) {
 			DEBUG_MSG("widget: %p, set id: %s\n", w, prop_val);
 			Widget_SetId(w, prop_val);
-		} else if (PropNameIs(prop, "class")) {
+		} else if (NameIs(name, "class")) {
 			DEBUG_MSG("widget: %p, add class: %s\n", w, prop_val);
 			Widget_AddClass(w, prop_val);
 		} else {
-			prop_name = malloc(strsize((const char *)prop->name));
-			strtolower(prop_name, (const char *)prop->name);
+			prop_name = malloc(strsize((const char *)name));
+			strtolower(prop_name, (const char *)name);
 			Widget_SetAttribute(w, prop_name, prop_val);
 			free(prop_name);
 		}
-		if (prop_val) {
-			xmlFree(prop_val);
-		}
 	}
+	xmlTextReaderMoveToElement(reader);
 	return PB_ENTER;
 }
 
@@ -261,63 +592,230 @@ static void LCUIBuilder_Init(void)
 	self.active = TRUE;
 }
 
-/** 解析 xml 文档结点 */
-static void ParseNode(XMLParserContext ctx, xmlNodePtr node)
+static LCUI_BOOL XMLLoader_Reserve(XMLLoader loader, int depth)
+{
+	int size;
+	XMLParserContextRec *stack;
+
+	if (depth < loader->stack_size) {
+		return TRUE;
+	}
+	size = loader->stack_size > 0 ? loader->stack_size * 2 : 16;
+	while (size <= depth) {
+		size *= 2;
+	}
+	stack = realloc(loader->stack, sizeof(XMLParserContextRec) * size);
+	if (!stack) {
+		return FALSE;
+	}
+	loader->stack = stack;
+	loader->stack_size = size;
+	return TRUE;
+}
+
+/** 结束元素，编译时需要记录部件的结束位置 */
+static void XMLLoader_EndNode(XMLParserContext ctx)
+{
+	UIWriter writer = ctx->writer;
+
+	if (!writer || !ctx->parent_parser) {
+		return;
+	}
+	if (ctx->parent_parser->id == ID_WIDGET ||
+	    (ctx->parent_parser->id == ID_UI && !ctx->nested)) {
+		UIWriter_AddOp(writer, UI_OP_END, UI_BINARY_NONE,
+			       UI_BINARY_NONE);
+		writer->depth -= 1;
+	}
+}
+
+/**
+ * 解析当前结点
+ * @returns 是否需要跳过当前结点的子结点
+ */
+static LCUI_BOOL XMLLoader_ParseNode(XMLLoader loader, int depth)
 {
+	int type;
 	ParserPtr p;
+	XMLParserContext ctx;
 	XMLParserContextRec cur_ctx;
-	LCUI_WidgetPrototype proto;
-
-	for (; node; node = node->next) {
-		proto = NULL;
-		if (node->type == XML_COMMENT_NODE) {
-			continue;
-		}
-		if (node->type == XML_ELEMENT_NODE) {
-			p = RBTree_CustomGetData(&self.parsers, node->name);
-			if (!p) {
-				proto =
-				    LCUIWidget_GetPrototype((char *)node->name);
-				/* If there is no suitable parser, but a widget
-				 * prototype with the same name already exists,
-				 * use the widget parser
-				 */
-				if (proto) {
-					p = &parser_list[1];
-				} else {
-					continue;
-				}
-			}
-		} else {
-			p = ctx->parent_parser;
-			if (!p) {
-				continue;
+	LCUI_WidgetPrototype proto = NULL;
+	const xmlChar *name;
+
+	ctx = &loader->stack[depth - 1];
+	type = xmlTextReaderNodeType(loader->reader);
+	name = xmlTextReaderConstLocalName(loader->reader);
+	if (type == XML_READER_TYPE_ELEMENT) {
+		/* <resource> 元素内只有文本内容 */
+		if (ctx->parent_parser && ctx->parent_parser->id == ID_RESOURCE) {
+			return TRUE;
+		}
+		p = RBTree_CustomGetData(&self.parsers, name);
+		if (!p) {
+			proto = LCUIWidget_GetPrototype((const char *)name);
+			/* If there is no suitable parser, but a widget
+			 * prototype with the same name already exists,
+			 * use the widget parser
+			 */
+			if (!proto) {
+				return TRUE;
 			}
+			p = &parser_list[1];
 		}
-		cur_ctx = *ctx;
-		cur_ctx.parent_widget = ctx->widget;
-		cur_ctx.widget_proto = proto;
-		switch (p->parse(&cur_ctx, node)) {
-		case PB_ENTER:
-			cur_ctx.parent_parser = p;
-			ParseNode(&cur_ctx, node->children);
-			break;
-		case PB_NEXT:
+	} else if (IsTextNode(type)) {
+		p = ctx->parent_parser;
+		if (!p) {
+			return FALSE;
+		}
+	} else {
+		return FALSE;
+	}
+	cur_ctx = *ctx;
+	cur_ctx.parent_widget = ctx->widget;
+	cur_ctx.widget_proto = proto;
+	switch (p->parse(&cur_ctx, loader->reader)) {
+	case PB_ENTER:
+		if (type != XML_READER_TYPE_ELEMENT) {
 			break;
-		case PB_WARNING:
-			Logger_Warning("[builder] %s (%d): warning: %s node.\n",
-				       node->doc->name, node->line, node->name);
+		}
+		cur_ctx.parent_parser = p;
+		if (xmlTextReaderIsEmptyElement(loader->reader)) {
+			XMLLoader_EndNode(&cur_ctx);
 			break;
-		case PB_ERROR:
-		default:
-			Logger_Error("[builder] %s (%d): error: %s node.\n",
-				     node->doc->name, node->line, node->name);
+		}
+		if (!XMLLoader_Reserve(loader, depth)) {
+			Logger_Error("[builder] out of memory\n");
+			XMLLoader_EndNode(&cur_ctx);
 			break;
 		}
+		loader->stack[depth] = cur_ctx;
 		if (!ctx->root && cur_ctx.root) {
 			ctx->root = cur_ctx.root;
 		}
+		return FALSE;
+	case PB_NEXT:
+		break;
+	case PB_WARNING:
+		Logger_Warning(
+		    "[builder] %s (%d): warning: %s node.\n", loader->name,
+		    xmlTextReaderGetParserLineNumber(loader->reader), name);
+		break;
+	case PB_ERROR:
+	default:
+		Logger_Error("[builder] %s (%d): error: %s node.\n",
+			     loader->name,
+			     xmlTextReaderGetParserLineNumber(loader->reader),
+			     name);
+		break;
+	}
+	if (!ctx->root && cur_ctx.root) {
+		ctx->root = cur_ctx.root;
+	}
+	return TRUE;
+}
+
+/**
+ * 读取整个文档
+ * @param[in,out] ctx 顶层元素的解析上下文，读取完后会记录创建的根部件
+ * @returns 文档格式有错误时返回 -1
+ */
+static int XMLLoader_Load(XMLLoader loader, XMLParserContext ctx)
+{
+	int ret, type, depth;
+	LCUI_BOOL skip;
+
+	if (!self.active) {
+		LCUIBuilder_Init();
+	}
+	ret = xmlTextReaderRead(loader->reader);
+	while (ret == 1) {
+		skip = FALSE;
+		type = xmlTextReaderNodeType(loader->reader);
+		depth = xmlTextReaderDepth(loader->reader);
+		if (depth > 0) {
+			if (type == XML_READER_TYPE_END_ELEMENT) {
+				XMLLoader_EndNode(&loader->stack[depth]);
+			} else {
+				skip = XMLLoader_ParseNode(loader, depth);
+			}
+		} else if (type == XML_READER_TYPE_ELEMENT) {
+			if (!NameIs(xmlTextReaderConstLocalName(loader->reader),
+				    "lcui-app")) {
+				Logger_Error(
+				    "[builder] error root node name: %s\n",
+				    xmlTextReaderConstLocalName(loader->reader));
+				ret = -1;
+				break;
+			}
+			if (!XMLLoader_Reserve(loader, 0)) {
+				ret = -1;
+				break;
+			}
+			loader->stack[0] = *ctx;
+		}
+		if (skip) {
+			ret = xmlTextReaderNext(loader->reader);
+		} else {
+			ret = xmlTextReaderRead(loader->reader);
+		}
+	}
+	if (loader->stack) {
+		ctx->root = loader->stack[0].root;
+		free(loader->stack);
+		loader->stack = NULL;
+	}
+	if (ret == -1) {
+		Logger_Error("[builder] Failed to parse xml: %s\n",
+			     loader->name);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * 从 xml 读取器中加载界面
+ * 元素在读取到它的开始标签时就会被创建并添加到父部件中，如果之后发现文档格式
+ * 有错误，则销毁已经创建的部件，和之前一次性解析整个文档的行为保持一致。
+ */
+static LCUI_Widget LCUIBuilder_LoadReader(xmlTextReaderPtr reader,
+					  const char *name, const char *space)
+{
+	XMLLoaderRec loader = { 0 };
+	XMLParserContextRec ctx = { 0 };
+
+	loader.name = name;
+	loader.reader = reader;
+	ctx.space = space;
+	if (XMLLoader_Load(&loader, &ctx) != 0) {
+		if (ctx.root) {
+			Widget_Destroy(ctx.root);
+		}
+		return NULL;
+	}
+	return ctx.root;
+}
+
+/** 编译 xml 文件，被引用的文档会被编译到引用它的位置 */
+static int UIWriter_Compile(UIWriter writer, const char *filepath,
+			    LCUI_BOOL nested)
+{
+	int ret;
+	XMLLoaderRec loader = { 0 };
+	XMLParserContextRec ctx = { 0 };
+
+	loader.name = filepath;
+	loader.reader = xmlReaderForFile(filepath, NULL, 0);
+	if (!loader.reader) {
+		Logger_Error("[builder] Failed to parse xml file: %s\n",
+			     filepath);
+		return -1;
 	}
+	ctx.space = filepath;
+	ctx.writer = writer;
+	ctx.nested = nested;
+	ret = XMLLoader_Load(&loader, &ctx);
+	xmlFreeTextReader(loader.reader);
+	return ret;
 }
 #endif
 
@@ -326,30 +824,17 @@ LCUI_Widget LCUIBuilder_LoadString(const char *str, int size)
 #ifndef USE_LCUI_BUILDER
 	Logger_Warning(WARN_TXT);
 #else
-	xmlDocPtr doc;
-	xmlNodePtr cur;
-	XMLParserContextRec ctx;
+	LCUI_Widget root;
+	xmlTextReaderPtr reader;
 
-	memset(&ctx, 0, sizeof(ctx));
-	doc = xmlParseMemory(str, size);
-	if (!doc) {
+	reader = xmlReaderForMemory(str, size, NULL, NULL, 0);
+	if (!reader) {
 		Logger_Error("[builder] Failed to parse xml form memory\n");
-		goto FAILED;
-	}
-	cur = xmlDocGetRootElement(doc);
-	if (xmlStrcasecmp(cur->name, BAD_CAST "lcui-app")) {
-		Logger_Error("[builder] error root node name: %s\n", cur->name);
-		goto FAILED;
-	}
-	if (!self.active) {
-		LCUIBuilder_Init();
+		return NULL;
 	}
-	ParseNode(&ctx, cur->children);
-FAILED:
-	if (doc) {
-		xmlFreeDoc(doc);
-	}
-	return ctx.root;
+	root = LCUIBuilder_LoadReader(reader, "(memory)", NULL);
+	xmlFreeTextReader(reader);
+	return root;
 #endif
 	return NULL;
 }
@@ -359,32 +844,256 @@ LCUI_Widget LCUIBuilder_LoadFile(const char *filepath)
 #ifndef USE_LCUI_BUILDER
 	Logger_Warning(WARN_TXT);
 #else
-	xmlDocPtr doc;
-	xmlNodePtr cur;
-	XMLParserContextRec ctx;
+	LCUI_Widget root;
+	xmlTextReaderPtr reader;
 
-	memset(&ctx, 0, sizeof(ctx));
-	ctx.space = filepath;
-	doc = xmlParseFile(filepath);
-	if (!doc) {
+	reader = xmlReaderForFile(filepath, NULL, 0);
+	if (!reader) {
 		Logger_Error("[builder] Failed to parse xml file: %s\n",
 			     filepath);
-		goto FAILED;
+		return NULL;
 	}
-	cur = xmlDocGetRootElement(doc);
-	if (xmlStrcasecmp(cur->name, BAD_CAST "lcui-app")) {
-		Logger_Error("[builder] error root node name: %s\n", cur->name);
-		goto FAILED;
+	root = LCUIBuilder_LoadReader(reader, filepath, filepath);
+	xmlFreeTextReader(reader);
+	return root;
+#endif
+	return NULL;
+}
+
+int LCUIBuilder_CompileFile(const char *filepath, const char *output_filepath)
+{
+#ifndef USE_LCUI_BUILDER
+	Logger_Warning(WARN_TXT);
+#else
+	int ret = -1;
+	UIWriterRec writer;
+
+	UIWriter_Init(&writer);
+	if (UIWriter_Compile(&writer, filepath, FALSE) == 0 && writer.ok &&
+	    writer.has_root && writer.depth == 0) {
+		ret = UIWriter_Save(&writer, output_filepath);
 	}
-	if (!self.active) {
-		LCUIBuilder_Init();
+	UIWriter_Destroy(&writer);
+	return ret;
+#endif
+	return -1;
+}
+
+/** 检查预编译的界面数据是否完整 */
+static LCUI_BOOL UIBinary_Check(const UIBinaryHeaderRec *header, size_t size)
+{
+	size_t expected;
+	const char *strings;
+
+	if (size < sizeof(UIBinaryHeaderRec) ||
+	    memcmp(header->magic, UI_BINARY_MAGIC, 4) != 0 ||
+	    header->version != UI_BINARY_VERSION ||
+	    header->byte_order != UI_BINARY_BYTE_ORDER) {
+		return FALSE;
 	}
-	ParseNode(&ctx, cur->children);
-FAILED:
-	if (doc) {
-		xmlFreeDoc(doc);
+	expected = sizeof(UIBinaryHeaderRec);
+	expected += sizeof(unsigned) * header->types_count;
+	expected += sizeof(unsigned) * header->ops_size;
+	expected += header->strings_size;
+	if (expected != size) {
+		return FALSE;
 	}
-	return ctx.root;
+	/* 字符串数据必须以 '\0' 结尾，这样才能直接引用其中的字符串 */
+	strings = (const char *)header + size - header->strings_size;
+	return header->strings_size == 0 ||
+	       strings[header->strings_size - 1] == 0;
+}
+
+LCUI_Widget LCUIBuilder_LoadBinary(const void *data, size_t size)
+{
+	unsigned i, j, type, sp = 0;
+	LCUI_BOOL ok = TRUE;
+	LCUI_Widget w, root = NULL;
+	LCUI_Widget *stack = NULL;
+	LCUI_WidgetPrototype *protos = NULL;
+	const UIBinaryHeaderRec *header = data;
+	const unsigned *types, *ops;
+	const char *strings, *args[2];
+
+	if (!UIBinary_Check(header, size)) {
+		Logger_Error("[builder] invalid ui binary data\n");
+		return NULL;
+	}
+	types = (const unsigned *)(header + 1);
+	ops = types + header->types_count;
+	strings = (const char *)(ops + header->ops_size);
+	/* 每种部件类型的原型只需要查找一次 */
+	protos = calloc(header->types_count + 1, sizeof(LCUI_WidgetPrototype));
+	stack = malloc(sizeof(LCUI_Widget) * (header->ops_size + 1));
+	if (!protos || !stack) {
+		ok = FALSE;
+	}
+	for (i = 0; ok && i < header->types_count; ++i) {
+		if (types[i] >= header->strings_size) {
+			ok = FALSE;
+			break;
+		}
+		protos[i] = LCUIWidget_GetPrototype(strings + types[i]);
+	}
+	for (i = 0; ok && i < header->ops_size;) {
+		type = ops[i++];
+		if (type == UI_OP_NONE || type >= UI_OP_TOTAL_NUM ||
+		    i + ui_op_args[type] > header->ops_size) {
+			ok = FALSE;
+			break;
+		}
+		for (j = 0; j < ui_op_args[type]; ++j, ++i) {
+			args[j] = NULL;
+			if (ops[i] < header->strings_size) {
+				args[j] = strings + ops[i];
+			}
+		}
+		w = sp > 0 ? stack[sp - 1] : root;
+		switch (type) {
+		case UI_OP_BEGIN_UI:
+			if (root) {
+				ok = FALSE;
+				break;
+			}
+			root = LCUIWidget_New(NULL);
+			stack[sp++] = root;
+			break;
+		case UI_OP_BEGIN_WIDGET:
+			j = ops[i - 1];
+			if (!w || (j != UI_BINARY_NONE &&
+				   j >= header->types_count)) {
+				ok = FALSE;
+				break;
+			}
+			if (j == UI_BINARY_NONE) {
+				stack[sp] = LCUIWidget_New(NULL);
+			} else if (protos[j]) {
+				stack[sp] = LCUIWidget_NewWithPrototype(protos[j]);
+			} else {
+				stack[sp] = LCUIWidget_New(strings + types[j]);
+			}
+			Widget_Append(w, stack[sp++]);
+			break;
+		case UI_OP_END:
+			if (sp < 1) {
+				ok = FALSE;
+				break;
+			}
+			sp -= 1;
+			break;
+		case UI_OP_SET_ID:
+			if (!w || !args[0]) {
+				ok = FALSE;
+				break;
+			}
+			Widget_SetId(w, args[0]);
+			break;
+		case UI_OP_ADD_CLASS:
+			if (!w || !args[0]) {
+				ok = FALSE;
+				break;
+			}
+			Widget_AddClass(w, args[0]);
+			break;
+		case UI_OP_SET_ATTRIBUTE:
+			if (!w || !args[0] || !args[1]) {
+				ok = FALSE;
+				break;
+			}
+			Widget_SetAttribute(w, args[0], args[1]);
+			break;
+		case UI_OP_SET_TEXT:
+			if (!w || !args[0]) {
+				ok = FALSE;
+				break;
+			}
+			Widget_SetText(w, args[0]);
+			break;
+		case UI_OP_LOAD_CSS:
+			if (!args[0]) {
+				ok = FALSE;
+				break;
+			}
+			LCUI_LoadCSSString(args[0], args[1]);
+			break;
+		case UI_OP_LOAD_CSS_FILE:
+			if (!args[0]) {
+				ok = FALSE;
+				break;
+			}
+			LCUI_LoadCSSFile(args[0]);
+			break;
+		case UI_OP_LOAD_FONT_FILE:
+			if (!args[0]) {
+				ok = FALSE;
+				break;
+			}
+			LCUIFont_LoadFile(args[0]);
+			break;
+		default:
+			break;
+		}
+	}
+	free(protos);
+	free(stack);
+	if (!ok) {
+		Logger_Error("[builder] invalid ui binary data\n");
+		if (root) {
+			Widget_Destroy(root);
+		}
+		return NULL;
+	}
+	return root;
+}
+
+LCUI_Widget LCUIBuilder_LoadBinaryFile(const char *filepath)
+{
+	void *data;
+	struct stat buf;
+	LCUI_Widget root;
+#ifdef LCUI_BUILD_IN_WIN32
+	HANDLE handle, mapping;
+#else
+	int fd;
 #endif
-	return NULL;
+
+	if (stat(filepath, &buf) != 0 || buf.st_size < 1) {
+		Logger_Error("[builder] Failed to open file: %s\n", filepath);
+		return NULL;
+	}
+#ifdef LCUI_BUILD_IN_WIN32
+	handle = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL,
+			     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+	mapping = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(handle);
+	if (!mapping) {
+		return NULL;
+	}
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle(mapping);
+		return NULL;
+	}
+	root = LCUIBuilder_LoadBinary(data, (size_t)buf.st_size);
+	UnmapViewOfFile(data);
+	CloseHandle(mapping);
+#else
+	fd = open(filepath, O_RDONLY);
+	if (fd < 0) {
+		Logger_Error("[builder] Failed to open file: %s\n", filepath);
+		return NULL;
+	}
+	data = mmap(NULL, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		Logger_Error("[builder] Failed to map file: %s\n", filepath);
+		return NULL;
+	}
+	root = LCUIBuilder_LoadBinary(data, (size_t)buf.st_size);
+	munmap(data, buf.st_size);
+#endif
+	return root;
 }
@@ -98,24 +98,149 @@ typedef struct StyleLinkRec_ {
 	Dict *parents;		/**< 父级节点 */
 } StyleLinkRec, *StyleLink;
 
+/**
+ * 整数键哈希表
+ * 使用开放寻址法和线性探测，键直接存放在表项中，添加和查找都不需要为键分配内存。
+ * 这些表只会添加和整体清空，不会删除单个表项，所以不需要删除标记。
+ */
+typedef struct IntMapEntryRec_ {
+	unsigned key;
+	void *value;		/**< 值，为 NULL 时表示该表项是空的 */
+} IntMapEntryRec, *IntMapEntry;
+
+typedef struct IntMapRec_ {
+	size_t length;		/**< 已使用的表项数量 */
+	size_t mask;		/**< 容量减一，容量是 2 的幂 */
+	IntMapEntry entries;
+	void (*destroy_value)(void *);
+} IntMapRec, *IntMap;
+
 static struct {
 	LCUI_BOOL active;
 	LCUI_Mutex mutex;		/**< 互斥锁 */
 	LinkedList groups;		/**< 样式组列表 */
-	Dict *cache;			/**< 样式表缓存，以选择器的 hash 值索引 */
-	Dict *names;			/**< 样式属性名称表，以值的名称索引 */
+	IntMapRec cache;		/**< 样式表缓存，以选择器的 hash 值索引 */
+	IntMapRec names;		/**< 样式属性名称表，以属性的标识索引 */
 	Dict *value_keys;		/**< 样式属性值表，以值的名称索引 */
-	Dict *value_names;		/**< 样式属性值名称表，以值索引 */
-	DictType names_dict;		/**< 样式属性名称表的类型 */
+	IntMapRec value_names;		/**< 样式属性值名称表，以值索引 */
 	DictType value_keys_dict;	/**< 样式属性值表的类型 */
-	DictType value_names_dict;	/**< 样式属性值名称表的类型 */
 	DictType style_link_dict;	/**< 样式链接表的类型 */
 	DictType style_group_dict;	/**< 样式组的类型 */
-	DictType cache_dict;		/**< 样式表缓存的类型 */
 	strpool_t *strpool;		/**< 字符串池 */
 	int count;			/**< 当前记录的属性数量 */
 } library;
 
+#define INTMAP_MIN_SIZE 16
+
+static void IntMap_Init(IntMap map, void (*destroy_value)(void *))
+{
+	map->length = 0;
+	map->mask = 0;
+	map->entries = NULL;
+	map->destroy_value = destroy_value;
+}
+
+static void IntMap_Clear(IntMap map)
+{
+	size_t i;
+
+	if (map->length < 1) {
+		return;
+	}
+	for (i = 0; i <= map->mask; ++i) {
+		if (map->entries[i].value && map->destroy_value) {
+			map->destroy_value(map->entries[i].value);
+		}
+		map->entries[i].value = NULL;
+	}
+	map->length = 0;
+}
+
+static void IntMap_Destroy(IntMap map)
+{
+	IntMap_Clear(map);
+	free(map->entries);
+	map->entries = NULL;
+	map->mask = 0;
+}
+
+static IntMapEntry IntMap_Find(IntMap map, unsigned key)
+{
+	size_t i;
+	IntMapEntry entry;
+
+	if (!map->entries) {
+		return NULL;
+	}
+	i = (key * 2654435761u) & map->mask;
+	for (;; i = (i + 1) & map->mask) {
+		entry = &map->entries[i];
+		if (!entry->value) {
+			return NULL;
+		}
+		if (entry->key == key) {
+			return entry;
+		}
+	}
+}
+
+static void *IntMap_Get(IntMap map, unsigned key)
+{
+	IntMapEntry entry = IntMap_Find(map, key);
+	return entry ? entry->value : NULL;
+}
+
+static void IntMap_Insert(IntMapEntry entries, size_t mask, unsigned key,
+			  void *value)
+{
+	size_t i = (key * 2654435761u) & mask;
+
+	while (entries[i].value) {
+		i = (i + 1) & mask;
+	}
+	entries[i].key = key;
+	entries[i].value = value;
+}
+
+static int IntMap_Grow(IntMap map)
+{
+	size_t i, size;
+	IntMapEntry entries;
+
+	size = map->entries ? (map->mask + 1) * 2 : INTMAP_MIN_SIZE;
+	entries = calloc(size, sizeof(IntMapEntryRec));
+	if (!entries) {
+		return -ENOMEM;
+	}
+	for (i = 0; map->entries && i <= map->mask; ++i) {
+		if (map->entries[i].value) {
+			IntMap_Insert(entries, size - 1, map->entries[i].key,
+				      map->entries[i].value);
+		}
+	}
+	free(map->entries);
+	map->entries = entries;
+	map->mask = size - 1;
+	return 0;
+}
+
+/** 添加键值对，值不能为 NULL，键已存在时返回 -1 */
+static int IntMap_Add(IntMap map, unsigned key, void *value)
+{
+	if (IntMap_Find(map, key)) {
+		return -1;
+	}
+	/* 保持负载因子不超过 0.5，让探测序列足够短 */
+	if (!map->entries || (map->length + 1) * 2 > map->mask + 1) {
+		if (IntMap_Grow(map) != 0) {
+			return -ENOMEM;
+		}
+	}
+	IntMap_Insert(map->entries, map->mask, key, value);
+	map->length += 1;
+	return 0;
+}
+
 /** 样式字符串值与标识码 */
 typedef struct KeyNameGroupRec_ {
 	int key;
@@ -226,19 +351,26 @@ static KeyNameGroupRec style_value_map[] = {
 
 static int LCUI_DirectAddStyleName(int key, const char *name)
 {
-	return Dict_AddCopy(library.names, &key, name);
+	int ret;
+	char *newname = strdup2(name);
+
+	ret = IntMap_Add(&library.names, key, newname);
+	if (ret != 0) {
+		free(newname);
+	}
+	return ret;
 }
 
 int LCUI_SetStyleName(int key, const char *name)
 {
 	char *newname;
-	DictEntry *entry;
+	IntMapEntry entry;
 	LCUIMutex_Lock(&library.mutex);
-	entry = Dict_Find(library.names, &key);
+	entry = IntMap_Find(&library.names, key);
 	if (entry) {
 		newname = strdup2(name);
-		free(entry->v.val);
-		entry->v.val = newname;
+		free(entry->value);
+		entry->value = newname;
 		LCUIMutex_Unlock(&library.mutex);
 		return 0;
 	}
@@ -262,7 +394,7 @@ int LCUI_AddCSSPropertyName(const char *name)
 
 const char *LCUI_GetStyleName(int key)
 {
-	return Dict_FetchValue(library.names, &key);
+	return IntMap_Get(&library.names, key);
 }
 
 static KeyNameGroup CreateKeyNameGroup(int key, const char *name)
@@ -293,8 +425,8 @@ int LCUI_AddStyleValue(int key, const char *name)
 		DestroyKeyNameGroup(group);
 		return -1;
 	}
-	if (Dict_Add(library.value_names, &group->key, group)) {
-		DestroyKeyNameGroup(group);
+	if (IntMap_Add(&library.value_names, group->key, group)) {
+		Dict_Delete(library.value_keys, group->name);
 		return -2;
 	}
 	return 0;
@@ -313,7 +445,7 @@ int LCUI_GetStyleValue(const char *str)
 const char *LCUI_GetStyleValueName(int val)
 {
 	KeyNameGroup group;
-	group = Dict_FetchValue(library.value_names, &val);
+	group = IntMap_Get(&library.value_names, val);
 	if (group) {
 		return group->name;
 	}
@@ -1284,7 +1416,7 @@ int LCUI_PutStyleSheet(LCUI_Selector selector, LCUI_StyleSheet in_ss,
 {
 	LCUI_StyleList list;
 	LCUIMutex_Lock(&library.mutex);
-	Dict_Empty(library.cache);
+	IntMap_Clear(&library.cache);
 	list = LCUI_SelectStyleList(selector, space);
 	if (list) {
 		StyleList_Merge(list, in_ss);
@@ -1568,7 +1700,7 @@ LCUI_CachedStyleSheet LCUI_GetCachedStyleSheet(LCUI_Selector s)
 	LCUI_StyleSheet ss;
 
 	LinkedList_Init(&list);
-	ss = Dict_FetchValue(library.cache, &s->hash);
+	ss = IntMap_Get(&library.cache, s->hash);
 	if (ss) {
 		return ss;
 	}
@@ -1579,7 +1711,7 @@ LCUI_CachedStyleSheet LCUI_GetCachedStyleSheet(LCUI_Selector s)
 		StyleSheet_MergeList(ss, sn->list);
 	}
 	LinkedList_Clear(&list, NULL);
-	Dict_Add(library.cache, &s->hash, ss);
+	IntMap_Add(&library.cache, s->hash, ss);
 	return ss;
 }
 
@@ -1617,62 +1749,14 @@ void LCUI_PrintStyleSheetsBySelector(LCUI_Selector s)
 	Logger_Debug("selector(%u) stylesheets end\n", s->hash);
 }
 
-static void StyleSheetCacheDestructor(void *privdata, void *val)
-{
-	StyleSheet_Delete(val);
-}
-
-static void *DupStyleName(void *privdata, const void *val)
-{
-	return strdup2(val);
-}
-
-static void StyleNameDestructor(void *privdata, void *val)
-{
-	free(val);
-}
-
-static unsigned int IntKeyDict_HashFunction(const void *key)
-{
-	return Dict_IdentityHashFunction(*(unsigned int *)key);
-}
-
-static int IntKeyDict_KeyCompare(void *privdata, const void *key1,
-				 const void *key2)
-{
-	return *(unsigned int *)key1 == *(unsigned int *)key2;
-}
-
-static void IntKeyDict_KeyDestructor(void *privdata, void *key)
-{
-	free(key);
-}
-
-static void *IntKeyDict_KeyDup(void *privdata, const void *key)
-{
-	unsigned int *newkey = malloc(sizeof(unsigned int));
-	*newkey = *(unsigned int *)key;
-	return newkey;
-}
-
 static void InitStylesheetCache(void)
 {
-	DictType *dt = &library.cache_dict;
-
-	dt->valDup = NULL;
-	dt->keyDup = IntKeyDict_KeyDup;
-	dt->keyCompare = IntKeyDict_KeyCompare;
-	dt->hashFunction = IntKeyDict_HashFunction;
-	dt->keyDestructor = IntKeyDict_KeyDestructor;
-	dt->valDestructor = StyleSheetCacheDestructor;
-	dt->keyDestructor = IntKeyDict_KeyDestructor;
-	library.cache = Dict_Create(dt, NULL);
+	IntMap_Init(&library.cache, (FuncPtr)StyleSheet_Delete);
 }
 
 static void DestroyStylesheetCache(void)
 {
-	Dict_Release(library.cache);
-	library.cache = NULL;
+	IntMap_Destroy(&library.cache);
 }
 
 static void StyleLinkDestructor(void *privdata, void *data)
@@ -1688,45 +1772,31 @@ static void InitStyleLinkDict(void)
 
 static void InitStyleNameLibrary(void)
 {
-	DictType *dt = &library.names_dict;
-
-	dt->valDup = DupStyleName;
-	dt->keyDup = IntKeyDict_KeyDup;
-	dt->keyCompare = IntKeyDict_KeyCompare;
-	dt->valDestructor = StyleNameDestructor;
-	dt->hashFunction = IntKeyDict_HashFunction;
-	dt->keyDestructor = IntKeyDict_KeyDestructor;
-	library.names = Dict_Create(dt, NULL);
+	IntMap_Init(&library.names, free);
 }
 
 static void DestroyStyleNameLibrary(void)
 {
-	Dict_Release(library.names);
-	library.names = NULL;
+	IntMap_Destroy(&library.names);
 }
 
 static void InitStyleValueLibrary(void)
 {
 	DictType *keys_dt = &library.value_keys_dict;
-	DictType *names_dt = &library.value_names_dict;
 
-	memset(names_dt, 0, sizeof(DictType));
-	names_dt->keyCompare = IntKeyDict_KeyCompare;
-	names_dt->hashFunction = IntKeyDict_HashFunction;
 	*keys_dt = DictType_StringKey;
 	keys_dt->valDestructor = KeyNameGroupDestructor;
 	/* value_keys 表用于存放 key 和 name 数据 */
 	library.value_keys = Dict_Create(keys_dt, NULL);
 	/* value_names 表仅引用 value_keys 里的数据  */
-	library.value_names = Dict_Create(names_dt, NULL);
+	IntMap_Init(&library.value_names, NULL);
 }
 
 static void DestroyStyleValueLibrary(void)
 {
-	Dict_Release(library.value_names);
+	IntMap_Destroy(&library.value_names);
 	Dict_Release(library.value_keys);
 	library.value_keys = NULL;
-	library.value_names = NULL;
 }
 
 void LCUI_InitCSSLibrary(void)
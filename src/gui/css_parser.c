@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/thread.h>
@@ -49,10 +50,71 @@
 
 #define SetCSSProperty CSSStyleParser_SetCSSProperty
 
+/**
+ * 样式缓存
+ * 缓存文件由文件头、LCUI 版本号、源数据标识和若干条记录组成，整数都按本机字
+ * 节序存储，字符串以长度加内容的形式存储。样式表记录包含选择器列表和有效的样式
+ * 属性，字体记录包含 @font-face 中的字体文件路径。文件头中的标记用于判断源数据
+ * 是否有变化，样式属性名称表的哈希值用于判断属性键值是否仍然对应相同的属性。
+ */
+#define CSS_CACHE_MAGIC "LCSS"
+#define CSS_CACHE_VERSION 1
+#define CSS_CACHE_BYTE_ORDER 0x01020304
+
+enum CSSCacheRecordType { CSS_CACHE_STYLE_SHEET = 1, CSS_CACHE_FONT_FACE };
+
+typedef struct CSSCacheHeaderRec_ {
+	char magic[4];
+	unsigned version;
+	unsigned byte_order;
+	unsigned schema;   /**< 样式属性名称表的哈希值 */
+	unsigned stamp[3]; /**< 源数据的标记，文件为大小和修改时间，字符串为长度和哈希值 */
+} CSSCacheHeaderRec;
+
+struct LCUI_CSSCacheWriterRec_ {
+	LCUI_BOOL ok; /**< 是否所有数据都能缓存 */
+	char *data;
+	size_t length;
+	size_t size;
+};
+
+/**
+ * 字符类别
+ * 每个解析目标都有一个结束标志，没有该标志的字符会被当前目标直接追加到缓存或
+ * 忽略，扫描器据此一次处理一段连续的字符，只把带有结束标志的字符交给解析函数。
+ * 字符串结束符带有全部标志。
+ */
+#define CSS_CHAR_SPACE 0x01         /**< 空白符 */
+#define CSS_CHAR_TARGET_SKIP 0x02   /**< 在规则之间会被忽略的字符 */
+#define CSS_CHAR_SELECTOR_END 0x04  /**< 选择器中需要处理的字符 */
+#define CSS_CHAR_KEY_END 0x08       /**< 属性名中需要处理的字符 */
+#define CSS_CHAR_VALUE_END 0x10     /**< 属性值中需要处理的字符 */
+
+static const unsigned char css_char_flags[256] = {
+	0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x0b, 0x0b, 0x00, 0x00, 0x0b, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x0b, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x1c,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x08, 0x18, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x06, 0x00, 0x1a, 0x00, 0x00,
+	/* 0x80 ~ 0xff 都是普通字符 */
+};
+
 static struct CSSParserModule {
 	int count;
 	DictType dicttype; /**< 解析器表的字典类型数据 */
 	Dict *parsers;     /**< 解析器表，以名称进行索引 */
+	char *cache_dir;   /**< 样式缓存的存放目录 */
 } self;
 
 void CSSStyleParser_SetCSSProperty(LCUI_CSSParserStyleContext ctx, int key,
@@ -690,6 +752,116 @@ static LCUI_CSSPropertyParserRec style_parser_map[] = {
 	{ -1, "background", OnParseBackground }
 };
 
+static void CSSCache_Write(LCUI_CSSCacheWriter cache, const void *data,
+			   size_t len)
+{
+	char *buf;
+	size_t size;
+
+	if (!cache->ok) {
+		return;
+	}
+	if (cache->length + len > cache->size) {
+		size = cache->size > 0 ? cache->size * 2 : 4096;
+		while (size < cache->length + len) {
+			size *= 2;
+		}
+		buf = realloc(cache->data, size);
+		if (!buf) {
+			cache->ok = FALSE;
+			return;
+		}
+		cache->data = buf;
+		cache->size = size;
+	}
+	memcpy(cache->data + cache->length, data, len);
+	cache->length += len;
+}
+
+static void CSSCache_WriteUInt(LCUI_CSSCacheWriter cache, unsigned value)
+{
+	CSSCache_Write(cache, &value, sizeof(value));
+}
+
+static void CSSCache_WriteString(LCUI_CSSCacheWriter cache, const char *str)
+{
+	unsigned len = (unsigned)strlen(str);
+
+	CSSCache_WriteUInt(cache, len);
+	CSSCache_Write(cache, str, len);
+}
+
+/** 记录样式表，选择器以结点全名的形式保存，载入时重新生成 */
+static void CSSCache_WriteStyleSheet(LCUI_CSSCacheWriter cache,
+				     LinkedList *selectors,
+				     LCUI_StyleSheet sheet)
+{
+	int i, j, count;
+	unsigned value;
+	const char *name;
+	char fullname[MAX_SELECTOR_LEN];
+	LCUI_Selector s;
+	LCUI_Style style;
+	LinkedListNode *node;
+
+	CSSCache_WriteUInt(cache, CSS_CACHE_STYLE_SHEET);
+	CSSCache_WriteUInt(cache, (unsigned)selectors->length);
+	for (LinkedList_Each(node, selectors)) {
+		s = node->data;
+		fullname[0] = 0;
+		for (i = 0, j = 0; i < s->length; ++i) {
+			if (!s->nodes[i]->fullname) {
+				cache->ok = FALSE;
+				return;
+			}
+			if (i > 0) {
+				fullname[j++] = ' ';
+			}
+			strncpy(fullname + j, s->nodes[i]->fullname,
+				MAX_SELECTOR_LEN - j - 1);
+			j += (int)strlen(fullname + j);
+			fullname[j] = 0;
+		}
+		CSSCache_WriteString(cache, fullname);
+	}
+	for (count = 0, i = 0; i < sheet->length; ++i) {
+		if (sheet->sheet[i].is_valid) {
+			count += 1;
+		}
+	}
+	CSSCache_WriteUInt(cache, count);
+	for (i = 0; i < sheet->length; ++i) {
+		style = &sheet->sheet[i];
+		if (!style->is_valid) {
+			continue;
+		}
+		CSSCache_WriteUInt(cache, i);
+		CSSCache_WriteUInt(cache, style->type);
+		switch (style->type) {
+		case LCUI_STYPE_STRING:
+			CSSCache_WriteString(cache, style->val_string);
+			break;
+		case LCUI_STYPE_STYLE:
+			name = LCUI_GetStyleValueName(style->val_style);
+			if (!name) {
+				cache->ok = FALSE;
+				return;
+			}
+			CSSCache_WriteString(cache, name);
+			break;
+		case LCUI_STYPE_WSTRING:
+		case LCUI_STYPE_IMAGE:
+			/* 这些值是运行时才有的数据，不能缓存 */
+			cache->ok = FALSE;
+			return;
+		default:
+			memcpy(&value, &style->val_int, sizeof(value));
+			CSSCache_WriteUInt(cache, value);
+			break;
+		}
+	}
+}
+
 static int CSSParser_ParseComment(LCUI_CSSParserContext ctx)
 {
 	if (ctx->comment.is_line_comment) {
@@ -727,6 +899,10 @@ int CSSParser_BeginParseComment(LCUI_CSSParserContext ctx)
 static void CSSParser_EndParseSheet(LCUI_CSSParserContext ctx)
 {
 	LinkedListNode *node;
+	if (ctx->cache) {
+		CSSCache_WriteStyleSheet(ctx->cache, &ctx->style.selectors,
+					 ctx->style.sheet);
+	}
 	/* 将记录的样式表添加至匹配到的选择器中 */
 	for (LinkedList_Each(node, &ctx->style.selectors)) {
 		LCUI_PutStyleSheet(node->data, ctx->style.sheet, ctx->space);
@@ -813,6 +989,8 @@ static int CSSParser_ParseRuleData(LCUI_CSSParserContext ctx)
 static int CSSParser_ParseStyleName(LCUI_CSSParserContext ctx)
 {
 	switch (*ctx->cur) {
+	case '/':
+		return CSSParser_BeginParseComment(ctx);
 	CASE_WHITE_SPACE:
 	case ';':
 		return -1;
@@ -853,6 +1031,12 @@ static int CSSParser_ParseStyleValue(LCUI_CSSParserContext ctx)
 	if (*ctx->cur == ';') {
 		ctx->target = CSS_TARGET_KEY;
 	}
+	/* 去掉属性值末尾的空白符，例如 display: block } */
+	while (ctx->pos > 0 &&
+	       css_char_flags[(unsigned char)ctx->buffer[ctx->pos - 1]] &
+		   CSS_CHAR_SPACE) {
+		--ctx->pos;
+	}
 	CSSParser_EndBuffer(ctx);
 	if (ctx->style.parser) {
 		ctx->style.parser->parse(&ctx->style, ctx->buffer);
@@ -902,12 +1086,12 @@ static void LoadFontFile(void *arg1, void *arg2)
 	LCUIWidget_RefreshTextView();
 }
 
-static void OnParsedFontFace(LCUI_CSSFontFace face)
+static void LoadFontFace(const char *src)
 {
 	static int worker_id = -1;
 	LCUI_TaskRec task = { 0 };
 	task.func = LoadFontFile;
-	task.arg[0] = strdup2(face->src);
+	task.arg[0] = strdup2(src);
 	task.destroy_arg[0] = free;
 	if (worker_id > -1) {
 		LCUI_PostAsyncTaskTo(&task, worker_id);
@@ -916,6 +1100,18 @@ static void OnParsedFontFace(LCUI_CSSFontFace face)
 	}
 }
 
+static void OnParsedFontFace(LCUI_CSSParserContext ctx, LCUI_CSSFontFace face)
+{
+	if (!face->src) {
+		return;
+	}
+	if (ctx->cache) {
+		CSSCache_WriteUInt(ctx->cache, CSS_CACHE_FONT_FACE);
+		CSSCache_WriteString(ctx->cache, face->src);
+	}
+	LoadFontFace(face->src);
+}
+
 static char *getdirname(const char *path)
 {
 	char *dirname;
@@ -949,12 +1145,14 @@ LCUI_CSSParserContext CSSParser_Begin(size_t buffer_size, const char *space)
 		ctx->space = NULL;
 		ctx->style.dirname = NULL;
 	}
+	ctx->pos = 0;
 	ctx->buffer = NEW(char, buffer_size);
 	ctx->buffer_size = buffer_size;
 	ctx->target = CSS_TARGET_NONE;
 	ctx->style.space = ctx->space;
 	ctx->style.style_handler = NULL;
 	ctx->style.style_handler_arg = NULL;
+	ctx->cache = NULL;
 	ctx->parsers[CSS_TARGET_NONE].parse = CSSParser_ParseTarget;
 	ctx->parsers[CSS_TARGET_RULE_NAME].parse = CSSParser_ParseRuleName;
 	ctx->parsers[CSS_TARGET_RULE_DATA].parse = CSSParser_ParseRuleData;
@@ -966,7 +1164,7 @@ LCUI_CSSParserContext CSSParser_Begin(size_t buffer_size, const char *space)
 	LinkedList_Init(&ctx->style.selectors);
 	memset(&ctx->rule, 0, sizeof(ctx->rule));
 	CSSParser_InitFontFaceRuleParser(ctx);
-	CSSRuleParser_OnFontFace(ctx, OnParsedFontFace);
+	CSSRuleParser_OnFontFaceEx(ctx, OnParsedFontFace);
 	return ctx;
 }
 
@@ -984,18 +1182,476 @@ void CSSParser_End(LCUI_CSSParserContext ctx)
 	free(ctx);
 }
 
-/** 载入CSS代码块，用于实现CSS代码的分块载入 */
-static size_t LCUI_LoadCSSBlock(LCUI_CSSParserContext ctx, const char *str)
+static void CSSParser_ReserveBuffer(LCUI_CSSParserContext ctx, size_t len)
+{
+	char *buffer;
+	size_t size = ctx->buffer_size;
+
+	if (ctx->pos + len < size) {
+		return;
+	}
+	while (ctx->pos + len >= size) {
+		size *= 2;
+	}
+	buffer = realloc(ctx->buffer, size);
+	if (buffer) {
+		ctx->buffer = buffer;
+		ctx->buffer_size = size;
+	}
+}
+
+/** 跳过带有指定标志的字符 */
+static void CSSParser_SkipChars(LCUI_CSSParserContext ctx, int flags)
+{
+	const char *cur = ctx->cur;
+
+	while (*cur && (css_char_flags[(unsigned char)*cur] & flags)) {
+		++cur;
+	}
+	ctx->cur = cur;
+}
+
+/** 将不带有结束标志的一段字符追加到缓存中 */
+static void CSSParser_ReadChars(LCUI_CSSParserContext ctx, int end_flags)
+{
+	size_t len;
+	const char *cur = ctx->cur;
+
+	while (!(css_char_flags[(unsigned char)*cur] & end_flags)) {
+		++cur;
+	}
+	len = cur - ctx->cur;
+	if (len < 1) {
+		return;
+	}
+	CSSParser_ReserveBuffer(ctx, len + 1);
+	if (ctx->pos + len < ctx->buffer_size) {
+		memcpy(ctx->buffer + ctx->pos, ctx->cur, len);
+		ctx->pos += (int)len;
+	}
+	ctx->cur = cur;
+}
+
+/**
+ * 定位到注释的结束位置
+ * 进入注释时 ctx->cur 指向注释开头的星号，块注释的结束符不能与这个星号共用，
+ * 否则以斜杠、星号、斜杠开头的注释会被提前结束。
+ */
+static void CSSParser_SkipComment(LCUI_CSSParserContext ctx)
 {
-	size_t size = 0;
+	const char *start = ctx->cur;
+	const char *cur = start;
 
+	if (ctx->comment.is_line_comment) {
+		while (*cur && *cur != '\n') {
+			++cur;
+		}
+		ctx->cur = cur;
+		return;
+	}
+	while (*cur) {
+		if (*cur == '/' && cur - 1 > start && *(cur - 1) == '*') {
+			break;
+		}
+		++cur;
+	}
+	ctx->cur = cur;
+}
+
+/**
+ * 载入CSS代码块
+ * 各个解析目标中会被追加到缓存或忽略的连续字符由扫描器批量处理，其余字符仍然
+ * 逐个交给当前目标的解析函数处理。
+ */
+static size_t LCUI_LoadCSSBlock(LCUI_CSSParserContext ctx, const char *str)
+{
 	ctx->cur = str;
-	while (*ctx->cur && size < ctx->buffer_size) {
+	while (*ctx->cur) {
+		switch (ctx->target) {
+		case CSS_TARGET_NONE:
+			CSSParser_SkipChars(ctx, CSS_CHAR_TARGET_SKIP);
+			break;
+		case CSS_TARGET_SELECTOR:
+			CSSParser_ReadChars(ctx, CSS_CHAR_SELECTOR_END);
+			break;
+		case CSS_TARGET_KEY:
+			CSSParser_SkipChars(ctx, CSS_CHAR_SPACE);
+			CSSParser_ReadChars(ctx, CSS_CHAR_KEY_END);
+			if (css_char_flags[(unsigned char)*ctx->cur] &
+			    CSS_CHAR_SPACE) {
+				continue;
+			}
+			break;
+		case CSS_TARGET_VALUE:
+			if (ctx->pos == 0) {
+				CSSParser_SkipChars(ctx, CSS_CHAR_SPACE);
+			}
+			CSSParser_ReadChars(ctx, CSS_CHAR_VALUE_END);
+			break;
+		case CSS_TARGET_RULE_NAME:
+			if (ctx->pos == 0) {
+				CSSParser_SkipChars(ctx, CSS_CHAR_SPACE);
+			}
+			CSSParser_ReadChars(ctx, CSS_CHAR_SPACE);
+			break;
+		case CSS_TARGET_COMMENT:
+			CSSParser_SkipComment(ctx);
+			break;
+		default:
+			break;
+		}
+		if (!*ctx->cur) {
+			break;
+		}
+		CSSParser_ReserveBuffer(ctx, 2);
 		ctx->parsers[ctx->target].parse(ctx);
 		++ctx->cur;
-		++size;
 	}
-	return size;
+	return ctx->cur - str;
+}
+
+static unsigned CSSCache_HashFNV1a(unsigned hash, const char *str, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i) {
+		hash ^= (unsigned char)str[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static unsigned CSSCache_HashDJB2(unsigned hash, const char *str, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i) {
+		hash = hash * 33 + (unsigned char)str[i];
+	}
+	return hash;
+}
+
+/** 计算样式属性名称表的哈希值，属性增删或顺序变化后缓存中的键值会失效 */
+static unsigned CSSCache_HashSchema(void)
+{
+	int i, total;
+	const char *name;
+	unsigned hash = 2166136261u;
+
+	total = LCUI_GetStyleTotal();
+	for (i = 0; i < total; ++i) {
+		name = LCUI_GetStyleName(i);
+		if (!name) {
+			name = "";
+		}
+		hash = CSSCache_HashFNV1a(hash, name, strlen(name) + 1);
+	}
+	return hash;
+}
+
+static void CSSCache_InitHeader(CSSCacheHeaderRec *header)
+{
+	memset(header, 0, sizeof(CSSCacheHeaderRec));
+	memcpy(header->magic, CSS_CACHE_MAGIC, 4);
+	header->version = CSS_CACHE_VERSION;
+	header->byte_order = CSS_CACHE_BYTE_ORDER;
+	header->schema = CSSCache_HashSchema();
+}
+
+static char *CSSCache_GetPath(char prefix, unsigned h1, unsigned h2)
+{
+	size_t len;
+	char *path;
+
+	len = strlen(self.cache_dir) + 24;
+	path = malloc(sizeof(char) * len);
+	if (!path) {
+		return NULL;
+	}
+	snprintf(path, len, "%s/%c%08x%08x.lcss", self.cache_dir, prefix, h1,
+		 h2);
+	return path;
+}
+
+static LCUI_CSSCacheWriter CSSCache_Begin(CSSCacheHeaderRec *header,
+					  const char *key)
+{
+	LCUI_CSSCacheWriter cache;
+
+	cache = NEW(LCUI_CSSCacheWriterRec, 1);
+	if (!cache) {
+		return NULL;
+	}
+	cache->ok = TRUE;
+	CSSCache_Write(cache, header, sizeof(CSSCacheHeaderRec));
+	CSSCache_WriteString(cache, LCUI_GetVersion());
+	CSSCache_WriteString(cache, key ? key : "");
+	return cache;
+}
+
+/** 保存缓存，先写入临时文件再替换，避免其它进程读到不完整的缓存 */
+static void CSSCache_End(LCUI_CSSCacheWriter cache, const char *path)
+{
+	FILE *fp;
+	char *tmp_path;
+	size_t len = strlen(path) + 5;
+
+	tmp_path = malloc(sizeof(char) * len);
+	if (cache->ok && tmp_path) {
+		snprintf(tmp_path, len, "%s.tmp", path);
+		fp = fopen(tmp_path, "wb");
+		if (fp) {
+			if (fwrite(cache->data, 1, cache->length, fp) ==
+			    cache->length) {
+				fclose(fp);
+				remove(path);
+				rename(tmp_path, path);
+			} else {
+				fclose(fp);
+				remove(tmp_path);
+			}
+		}
+	}
+	free(tmp_path);
+	free(cache->data);
+	free(cache);
+}
+
+typedef struct CSSCacheReaderRec_ {
+	const char *cur;
+	const char *end;
+} CSSCacheReaderRec, *CSSCacheReader;
+
+static LCUI_BOOL CSSCache_ReadUInt(CSSCacheReader reader, unsigned *value)
+{
+	if ((size_t)(reader->end - reader->cur) < sizeof(unsigned)) {
+		return FALSE;
+	}
+	memcpy(value, reader->cur, sizeof(unsigned));
+	reader->cur += sizeof(unsigned);
+	return TRUE;
+}
+
+/** 读取字符串，返回的字符串不以 0 结尾，长度由 len 输出 */
+static const char *CSSCache_ReadString(CSSCacheReader reader, unsigned *len)
+{
+	const char *str;
+
+	if (!CSSCache_ReadUInt(reader, len) ||
+	    (size_t)(reader->end - reader->cur) < *len) {
+		return NULL;
+	}
+	str = reader->cur;
+	reader->cur += *len;
+	return str;
+}
+
+static char *CSSCache_ReadStringCopy(CSSCacheReader reader)
+{
+	char *str;
+	const char *data;
+	unsigned len;
+
+	data = CSSCache_ReadString(reader, &len);
+	if (!data) {
+		return NULL;
+	}
+	str = malloc(sizeof(char) * (len + 1));
+	if (!str) {
+		return NULL;
+	}
+	memcpy(str, data, len);
+	str[len] = 0;
+	return str;
+}
+
+static LCUI_BOOL CSSCache_ReadStyle(CSSCacheReader reader, LCUI_Style style)
+{
+	char *str;
+	unsigned type, value;
+
+	if (!CSSCache_ReadUInt(reader, &type)) {
+		return FALSE;
+	}
+	switch (type) {
+	case LCUI_STYPE_STRING:
+		str = CSSCache_ReadStringCopy(reader);
+		if (!str) {
+			return FALSE;
+		}
+		style->val_string = str;
+		break;
+	case LCUI_STYPE_STYLE:
+		str = CSSCache_ReadStringCopy(reader);
+		if (!str) {
+			return FALSE;
+		}
+		style->val_style = LCUI_GetStyleValue(str);
+		free(str);
+		if (style->val_style < 0) {
+			return FALSE;
+		}
+		break;
+	case LCUI_STYPE_WSTRING:
+	case LCUI_STYPE_IMAGE:
+		return FALSE;
+	default:
+		if (type > LCUI_STYPE_WSTRING ||
+		    !CSSCache_ReadUInt(reader, &value)) {
+			return FALSE;
+		}
+		memcpy(&style->val_int, &value, sizeof(value));
+		break;
+	}
+	style->is_valid = TRUE;
+	style->type = type;
+	return TRUE;
+}
+
+/**
+ * 读取一条样式表记录
+ * @param[in] space 样式表的所属空间
+ * @param[in] apply 是否导入样式库，为 FALSE 时只检查记录是否有效
+ */
+static LCUI_BOOL CSSCache_ReadStyleSheet(CSSCacheReader reader,
+					 LCUI_StyleSheet sheet,
+					 const char *space, LCUI_BOOL apply)
+{
+	unsigned i, n, key;
+	char *str;
+	CSSCacheReaderRec selectors_reader;
+	LCUI_Selector s;
+
+	if (!CSSCache_ReadUInt(reader, &n)) {
+		return FALSE;
+	}
+	selectors_reader.cur = reader->cur;
+	for (i = 0; i < n; ++i) {
+		if (!CSSCache_ReadString(reader, &key)) {
+			return FALSE;
+		}
+	}
+	selectors_reader.end = reader->cur;
+	StyleSheet_Clear(sheet);
+	if (!CSSCache_ReadUInt(reader, &n)) {
+		return FALSE;
+	}
+	for (i = 0; i < n; ++i) {
+		if (!CSSCache_ReadUInt(reader, &key) ||
+		    key >= (unsigned)sheet->length ||
+		    !CSSCache_ReadStyle(reader, &sheet->sheet[key])) {
+			return FALSE;
+		}
+	}
+	if (!apply) {
+		return TRUE;
+	}
+	while (selectors_reader.cur < selectors_reader.end) {
+		str = CSSCache_ReadStringCopy(&selectors_reader);
+		if (!str) {
+			return FALSE;
+		}
+		s = Selector(str);
+		free(str);
+		if (!s) {
+			return FALSE;
+		}
+		LCUI_PutStyleSheet(s, sheet, space);
+		Selector_Delete(s);
+	}
+	return TRUE;
+}
+
+static LCUI_BOOL CSSCache_ReadRecords(CSSCacheReader reader,
+				      LCUI_StyleSheet sheet,
+				      const char *space, LCUI_BOOL apply)
+{
+	char *src;
+	unsigned type;
+
+	while (reader->cur < reader->end) {
+		if (!CSSCache_ReadUInt(reader, &type)) {
+			return FALSE;
+		}
+		if (type == CSS_CACHE_STYLE_SHEET) {
+			if (!CSSCache_ReadStyleSheet(reader, sheet, space,
+						     apply)) {
+				return FALSE;
+			}
+			continue;
+		}
+		if (type != CSS_CACHE_FONT_FACE) {
+			return FALSE;
+		}
+		src = CSSCache_ReadStringCopy(reader);
+		if (!src) {
+			return FALSE;
+		}
+		if (apply) {
+			LoadFontFace(src);
+		}
+		free(src);
+	}
+	return TRUE;
+}
+
+/**
+ * 从缓存文件中导入样式
+ * 先检查一遍全部记录，确认缓存完整且有效后才导入样式库，因此失败时不会导入
+ * 部分样式，调用者可以直接改为解析 CSS 代码。
+ */
+static int CSSCache_Load(const char *path, CSSCacheHeaderRec *header,
+			 const char *key, const char *space)
+{
+	FILE *fp;
+	long size;
+	char *data, *str;
+	LCUI_BOOL ok;
+	const char *body;
+	LCUI_StyleSheet sheet;
+	CSSCacheReaderRec reader;
+
+	fp = fopen(path, "rb");
+	if (!fp) {
+		return -1;
+	}
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (size < (long)sizeof(CSSCacheHeaderRec)) {
+		fclose(fp);
+		return -1;
+	}
+	data = malloc(size);
+	if (!data || fread(data, 1, size, fp) != (size_t)size ||
+	    memcmp(data, header, sizeof(CSSCacheHeaderRec)) != 0) {
+		free(data);
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+	reader.cur = data + sizeof(CSSCacheHeaderRec);
+	reader.end = data + size;
+	str = CSSCache_ReadStringCopy(&reader);
+	ok = str && strcmp(str, LCUI_GetVersion()) == 0;
+	free(str);
+	str = ok ? CSSCache_ReadStringCopy(&reader) : NULL;
+	ok = str && strcmp(str, key ? key : "") == 0;
+	free(str);
+	sheet = ok ? StyleSheet() : NULL;
+	body = reader.cur;
+	if (sheet && CSSCache_ReadRecords(&reader, sheet, space, FALSE)) {
+		reader.cur = body;
+		CSSCache_ReadRecords(&reader, sheet, space, TRUE);
+		ok = TRUE;
+	} else {
+		ok = FALSE;
+	}
+	if (sheet) {
+		StyleSheet_Delete(sheet);
+	}
+	free(data);
+	return ok ? 0 : -1;
 }
 
 LCUI_CSSPropertyParser LCUI_GetCSSPropertyParser(const char *name)
@@ -1003,41 +1659,121 @@ LCUI_CSSPropertyParser LCUI_GetCSSPropertyParser(const char *name)
 	return Dict_FetchValue(self.parsers, name);
 }
 
+/** 读取文件的全部内容，使注释和记录不会被分块截断 */
+static char *ReadTextFile(FILE *fp)
+{
+	size_t n, len = 0, size = 4096;
+	char *buf, *data = malloc(size);
+
+	while (data) {
+		n = fread(data + len, 1, size - len - 1, fp);
+		len += n;
+		if (len + 1 < size) {
+			break;
+		}
+		size *= 2;
+		buf = realloc(data, size);
+		if (!buf) {
+			free(data);
+			return NULL;
+		}
+		data = buf;
+	}
+	if (data) {
+		data[len] = 0;
+	}
+	return data;
+}
+
 int LCUI_LoadCSSFile(const char *filepath)
 {
 	size_t n;
 	FILE *fp;
-	char buff[512];
+	char *data;
+	char *cache_path = NULL;
+	struct stat info;
+	CSSCacheHeaderRec header;
 	LCUI_CSSParserContext ctx;
 
 	fp = fopen(filepath, "r");
 	if (!fp) {
 		return -1;
 	}
+	if (self.cache_dir && stat(filepath, &info) == 0) {
+		CSSCache_InitHeader(&header);
+		header.stamp[0] = (unsigned)info.st_size;
+		header.stamp[1] = (unsigned)info.st_mtime;
+		n = strlen(filepath);
+		cache_path = CSSCache_GetPath(
+		    'f', CSSCache_HashFNV1a(2166136261u, filepath, n),
+		    CSSCache_HashDJB2(5381, filepath, n));
+		if (cache_path &&
+		    CSSCache_Load(cache_path, &header, filepath, filepath) == 0) {
+			free(cache_path);
+			fclose(fp);
+			return 0;
+		}
+	}
+	data = ReadTextFile(fp);
+	if (!data) {
+		free(cache_path);
+		fclose(fp);
+		return -ENOMEM;
+	}
 	ctx = CSSParser_Begin(512, filepath);
-	n = fread(buff, 1, 511, fp);
-	while (n > 0) {
-		buff[n] = 0;
-		LCUI_LoadCSSBlock(ctx, buff);
-		n = fread(buff, 1, 511, fp);
+	if (cache_path) {
+		ctx->cache = CSSCache_Begin(&header, filepath);
+	}
+	LCUI_LoadCSSBlock(ctx, data);
+	free(data);
+	if (ctx->cache) {
+		CSSCache_End(ctx->cache, cache_path);
+		ctx->cache = NULL;
 	}
 	CSSParser_End(ctx);
+	free(cache_path);
 	fclose(fp);
 	return 0;
 }
 
 size_t LCUI_LoadCSSString(const char *str, const char *space)
 {
-	size_t len = 1;
-	const char *cur;
+	size_t len;
+	char *cache_path = NULL;
+	unsigned h1, h2;
+	CSSCacheHeaderRec header;
 	LCUI_CSSParserContext ctx;
 
+	if (self.cache_dir) {
+		len = space ? strlen(space) + 1 : 0;
+		h1 = CSSCache_HashFNV1a(2166136261u, space, len);
+		h2 = CSSCache_HashDJB2(5381, space, len);
+		len = strlen(str);
+		h1 = CSSCache_HashFNV1a(h1, str, len);
+		h2 = CSSCache_HashDJB2(h2, str, len);
+		CSSCache_InitHeader(&header);
+		header.stamp[0] = (unsigned)len;
+		header.stamp[1] = h1;
+		header.stamp[2] = h2;
+		cache_path = CSSCache_GetPath('s', h1, h2);
+		if (cache_path &&
+		    CSSCache_Load(cache_path, &header, space, space) == 0) {
+			free(cache_path);
+			return 0;
+		}
+	}
 	DEBUG_MSG("parse begin\n");
 	ctx = CSSParser_Begin(512, space);
-	for (cur = str; len > 0; cur += len) {
-		len = LCUI_LoadCSSBlock(ctx, cur);
+	if (cache_path) {
+		ctx->cache = CSSCache_Begin(&header, space);
+	}
+	LCUI_LoadCSSBlock(ctx, str);
+	if (ctx->cache) {
+		CSSCache_End(ctx->cache, cache_path);
+		ctx->cache = NULL;
 	}
 	CSSParser_End(ctx);
+	free(cache_path);
 	DEBUG_MSG("parse end\n");
 	return 0;
 }
@@ -1095,6 +1831,14 @@ void LCUI_InitCSSParser(void)
 	}
 }
 
+void LCUI_SetCSSCacheDir(const char *dir)
+{
+	if (self.cache_dir) {
+		free(self.cache_dir);
+	}
+	self.cache_dir = dir ? strdup2(dir) : NULL;
+}
+
 void LCUI_FreeCSSParser(void)
 {
 	Dict_Release(self.parsers);
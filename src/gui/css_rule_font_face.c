@@ -60,6 +60,7 @@ typedef struct FontFaceParserContextRec_ {
 	int key;
 	LCUI_CSSFontFace face;
 	void(*callback)(const LCUI_CSSFontFace);
+	void(*callback_ex)(LCUI_CSSParserContext, const LCUI_CSSFontFace);
 } FontFaceParserContextRec, *FontFaceParserContext;
 
 #define GetParserContext(CTX) (CTX)->rule.parsers[CSS_RULE_FONT_FACE].data
@@ -122,7 +123,9 @@ static int FontFaceParser_ParseTail(LCUI_CSSParserContext ctx)
 {
 	FontFaceParserContext data;
 	data = GetParserContext(ctx);
-	if (data->callback) {
+	if (data->callback_ex) {
+		data->callback_ex(ctx, data->face);
+	} else if (data->callback) {
 		data->callback(data->face);
 	}
 	FontFaceParser_End(ctx);
@@ -280,6 +283,15 @@ void CSSRuleParser_OnFontFace(LCUI_CSSParserContext ctx,
 	data->callback = func;
 }
 
+void CSSRuleParser_OnFontFaceEx(LCUI_CSSParserContext ctx,
+				void(*func)(LCUI_CSSParserContext,
+					    const LCUI_CSSFontFace))
+{
+	FontFaceParserContext data;
+	data = GetParserContext(ctx);
+	data->callback_ex = func;
+}
+
 int CSSParser_InitFontFaceRuleParser(LCUI_CSSParserContext ctx)
 {
 	LCUI_CSSRuleParser parser;
@@ -43,6 +43,7 @@
 
 #define GetData(W) Widget_GetData(W, self.prototype)
 #define ComputeActual LCUIMetrics_ComputeActual
+#define TEXT_MEASURE_CACHE_SIZE 4
 
 enum TaskType {
 	TASK_SET_TEXT,
@@ -56,8 +57,29 @@ enum TaskType {
 	TASK_TOTAL
 };
 
+/** 文本尺寸的测量条件 */
+typedef struct TextMeasureKeyRec_ {
+	unsigned content_version; /**< 文本内容的版本号 */
+	unsigned style_version;   /**< 影响排版的文本样式的版本号 */
+	float scale;
+	float width, height;   /**< 传给 autosize() 的宽高 */
+	int fixed_width;       /**< 排版时文本层的固定宽度 */
+	int max_width;         /**< 排版时文本层的最大宽度 */
+	LCUI_BOOL fit_content; /**< 是否按内容宽度测量 */
+} TextMeasureKeyRec, *TextMeasureKey;
+
+/** 文本尺寸的测量结果 */
+typedef struct TextMeasureRec_ {
+	LCUI_BOOL is_valid;
+	TextMeasureKeyRec key;
+	float width, height;
+} TextMeasureRec, *TextMeasure;
+
 typedef struct LCUI_TextViewRec_ {
 	wchar_t *content;
+	wchar_t *layer_text;		/**< 已设置到文本图层中的文本 */
+	unsigned content_version;	/**< 文本内容的版本号，内容变化时递增 */
+	unsigned style_version;		/**< 排版样式的版本号，样式变化时递增 */
 	LCUI_BOOL trimming;
 	LCUI_Widget widget;
 	LCUI_TextLayer layer;
@@ -73,6 +95,15 @@ typedef struct LCUI_TextViewRec_ {
 			int align;
 		};
 	} tasks[TASK_TOTAL];
+	/**
+	 * 最近几次的测量结果
+	 * 布局时会以相同的条件多次计算部件尺寸，而每次测量都需要对文本做完整的
+	 * 排版，缓存这些结果可以避免重复排版。
+	 */
+	struct {
+		TextMeasureRec items[TEXT_MEASURE_CACHE_SIZE];
+		int next;
+	} measures;
 } LCUI_TextViewRec, *LCUI_TextView;
 
 static struct LCUI_TextViewModule {
@@ -141,6 +172,9 @@ static void TextView_OnParseText(LCUI_Widget w, const char *text)
 static void TextView_SetTaskForLineHeight(LCUI_Widget w, int height)
 {
 	LCUI_TextView txt = GetData(w);
+	if (txt->layer->line_height != height) {
+		++txt->style_version;
+	}
 	TextLayer_SetLineHeight(txt->layer, height);
 	txt->tasks[TASK_UPDATE].is_valid = TRUE;
 }
@@ -242,6 +276,69 @@ static void TextView_OnResize(LCUI_Widget w, LCUI_WidgetEvent e, void *arg)
 	TextLayer_ClearInvalidRect(txt->layer);
 }
 
+/** 判断两个文本样式的排版结果是否相同 */
+static LCUI_BOOL TextView_IsSameLayoutStyle(LCUI_TextStyle a, LCUI_TextStyle b)
+{
+	int i;
+
+	if (a->style != b->style || a->weight != b->weight ||
+	    a->pixel_size != b->pixel_size) {
+		return FALSE;
+	}
+	if (!a->font_ids || !b->font_ids) {
+		return a->font_ids == b->font_ids;
+	}
+	for (i = 0; a->font_ids[i] > 0 && b->font_ids[i] > 0; ++i) {
+		if (a->font_ids[i] != b->font_ids[i]) {
+			return FALSE;
+		}
+	}
+	return a->font_ids[i] <= 0 && b->font_ids[i] <= 0;
+}
+
+static LCUI_BOOL TextMeasureKey_Equal(TextMeasureKey a, TextMeasureKey b)
+{
+	return a->content_version == b->content_version &&
+	       a->style_version == b->style_version && a->scale == b->scale &&
+	       a->width == b->width && a->height == b->height &&
+	       a->fixed_width == b->fixed_width &&
+	       a->max_width == b->max_width && a->fit_content == b->fit_content;
+}
+
+static TextMeasure TextView_GetMeasure(LCUI_TextView txt, TextMeasureKey key)
+{
+	int i;
+
+	for (i = 0; i < TEXT_MEASURE_CACHE_SIZE; ++i) {
+		if (txt->measures.items[i].is_valid &&
+		    TextMeasureKey_Equal(&txt->measures.items[i].key, key)) {
+			return &txt->measures.items[i];
+		}
+	}
+	return NULL;
+}
+
+static void TextView_AddMeasure(LCUI_TextView txt, TextMeasureKey key,
+				float width, float height)
+{
+	TextMeasure m = &txt->measures.items[txt->measures.next];
+
+	txt->measures.next = (txt->measures.next + 1) % TEXT_MEASURE_CACHE_SIZE;
+	m->is_valid = TRUE;
+	m->key = *key;
+	m->width = width;
+	m->height = height;
+}
+
+static void TextView_ClearMeasures(LCUI_TextView txt)
+{
+	int i;
+
+	for (i = 0; i < TEXT_MEASURE_CACHE_SIZE; ++i) {
+		txt->measures.items[i].is_valid = FALSE;
+	}
+}
+
 /** 初始化 TextView 部件数据 */
 static void TextView_OnInit(LCUI_Widget w)
 {
@@ -253,6 +350,11 @@ static void TextView_OnInit(LCUI_Widget w)
 	}
 	txt->widget = w;
 	txt->content = NULL;
+	txt->layer_text = NULL;
+	txt->content_version = 0;
+	txt->style_version = 0;
+	txt->measures.next = 0;
+	TextView_ClearMeasures(txt);
 	/* 默认清除首尾空白符 */
 	txt->trimming = TRUE;
 	/* 初始化文本图层 */
@@ -290,24 +392,52 @@ static void TextView_OnDestroy(LCUI_Widget w)
 	TextLayer_Destroy(txt->layer);
 	TextView_ClearTasks(w);
 	free(txt->content);
+	free(txt->layer_text);
 }
 
 static void TextView_AutoSize(LCUI_Widget w, float *width, float *height)
 {
 	float max_width;
 	int fixed_w, fixed_h;
+	TextMeasure m;
+	TextMeasureKeyRec key;
 	LCUI_TextView txt = GetData(w);
 	float scale = LCUIMetrics_GetScale();
 
 	TextView_UpdateLayerSize(w);
 	fixed_w = txt->layer->fixed_width;
 	fixed_h = txt->layer->fixed_height;
-	if (Widget_HasFitContentWidth(w) || !Widget_HasStaticWidthParent(w)) {
+	key.content_version = txt->content_version;
+	key.style_version = txt->style_version;
+	key.scale = scale;
+	key.width = *width;
+	key.height = *height;
+	key.fixed_width = fixed_w;
+	key.max_width = txt->layer->max_width;
+	key.fit_content =
+	    Widget_HasFitContentWidth(w) || !Widget_HasStaticWidthParent(w);
+	/* 只记录实际参与排版的宽度，以免部件尺寸的变化让缓存失效 */
+	if (key.fit_content) {
+		key.fixed_width = (int)(*width * scale);
+		if (Widget_HasParentDependentWidth(w)) {
+			max_width = scale * Widget_ComputeMaxContentWidth(w);
+			key.max_width = (int)max_width;
+		}
+	} else if (*width > 0) {
+		key.fixed_width = (int)(*width * scale);
+		key.max_width = 0;
+	}
+	m = TextView_GetMeasure(txt, &key);
+	if (m) {
+		*width = m->width;
+		*height = m->height;
+		return;
+	}
+	if (key.fit_content) {
 		/* 解除固定宽高设置，以计算最大宽高 */
 		TextLayer_SetFixedSize(txt->layer, (int)(*width * scale), 0);
 		if (Widget_HasParentDependentWidth(w)) {
-			max_width = scale * Widget_ComputeMaxContentWidth(w);
-			TextLayer_SetMaxSize(txt->layer, (int)max_width, 0);
+			TextLayer_SetMaxSize(txt->layer, key.max_width, 0);
 		}
 		TextLayer_Update(txt->layer, NULL);
 		if (*width <= 0) {
@@ -316,6 +446,7 @@ static void TextView_AutoSize(LCUI_Widget w, float *width, float *height)
 		if (*height <= 0) {
 			*height = TextLayer_GetHeight(txt->layer) / scale;
 		}
+		TextView_AddMeasure(txt, &key, *width, *height);
 		/* 还原固定宽高设置 */
 		TextLayer_SetFixedSize(txt->layer, fixed_w, fixed_h);
 		TextLayer_Update(txt->layer, NULL);
@@ -330,6 +461,7 @@ static void TextView_AutoSize(LCUI_Widget w, float *width, float *height)
 	TextLayer_SetFixedSize(txt->layer, (int)(*width * scale), 0);
 	TextLayer_Update(txt->layer, NULL);
 	*height = TextLayer_GetHeight(txt->layer) / scale;
+	TextView_AddMeasure(txt, &key, *width, *height);
 }
 
 static void TextView_OnRefresh(LCUI_Widget w)
@@ -354,26 +486,42 @@ static void TextView_OnTask(LCUI_Widget w)
 	if (txt->tasks[i].is_valid) {
 		txt->tasks[i].is_valid = FALSE;
 		TextLayer_SetTextW(txt->layer, txt->tasks[i].text, NULL);
+		/* 内容没变的话，之前的测量结果仍然有效 */
+		if (!txt->layer_text ||
+		    wcscmp(txt->layer_text, txt->tasks[i].text) != 0) {
+			++txt->content_version;
+		}
 		txt->tasks[TASK_UPDATE].is_valid = TRUE;
 		txt->tasks[TASK_UPDATE_SIZE].is_valid = TRUE;
-		free(txt->tasks[i].text);
+		free(txt->layer_text);
+		txt->layer_text = txt->tasks[i].text;
 		txt->tasks[i].text = NULL;
 	}
 	i = TASK_SET_AUTOWRAP;
 	if (txt->tasks[i].is_valid) {
 		txt->tasks[i].is_valid = FALSE;
+		if (!txt->layer->enable_autowrap != !txt->tasks[i].enable) {
+			++txt->style_version;
+		}
 		TextLayer_SetAutoWrap(txt->layer, txt->tasks[i].enable);
 		txt->tasks[TASK_UPDATE].is_valid = TRUE;
 	}
 	i = TASK_SET_WORD_BREAK;
 	if (txt->tasks[i].is_valid) {
 		txt->tasks[i].is_valid = FALSE;
+		if (txt->layer->word_break != txt->tasks[i].mode) {
+			++txt->style_version;
+		}
 		TextLayer_SetWordBreak(txt->layer, txt->tasks[i].mode);
 		txt->tasks[TASK_UPDATE].is_valid = TRUE;
 	}
 	i = TASK_SET_TEXT_STYLE;
 	if (txt->tasks[i].is_valid) {
 		txt->tasks[i].is_valid = FALSE;
+		if (!TextView_IsSameLayoutStyle(&txt->layer->text_default_style,
+					    &txt->tasks[i].style)) {
+			++txt->style_version;
+		}
 		TextLayer_SetTextStyle(txt->layer, &txt->tasks[i].style);
 		TextStyle_Destroy(&txt->tasks[i].style);
 		txt->tasks[TASK_UPDATE].is_valid = TRUE;
@@ -387,6 +535,9 @@ static void TextView_OnTask(LCUI_Widget w)
 	i = TASK_SET_MULITILINE;
 	if (txt->tasks[i].is_valid) {
 		txt->tasks[i].is_valid = FALSE;
+		if (!txt->layer->enable_mulitiline != !txt->tasks[i].enable) {
+			++txt->style_version;
+		}
 		TextLayer_SetMultiline(txt->layer, txt->tasks[i].enable);
 		txt->tasks[TASK_UPDATE].is_valid = TRUE;
 	}
@@ -418,7 +569,10 @@ static void TextView_OnTask(LCUI_Widget w)
 	if (Widget_HasParentDependentWidth(w) ||
 	    Widget_HasAutoStyle(w, key_width) ||
 	    Widget_HasAutoStyle(w, key_height)) {
-		Widget_AddTask(w->parent, LCUI_WTASK_RESIZE);
+		Widget_InvalidateContentSize(w);
+		if (!Widget_IsRelayoutBoundary(w->parent)) {
+			Widget_AddTask(w->parent, LCUI_WTASK_RESIZE);
+		}
 	}
 }
 
@@ -500,6 +654,20 @@ int TextView_SetText(LCUI_Widget w, const char *utf8_text)
 	return ret;
 }
 
+size_t TextView_GetTextW(LCUI_Widget w, size_t start, size_t max_len,
+			 wchar_t *buf)
+{
+	size_t i, len;
+	LCUI_TextView txt = GetData(w);
+
+	len = txt->content ? wcslen(txt->content) : 0;
+	for (i = 0; start + i < len && i < max_len; ++i) {
+		buf[i] = txt->content[start + i];
+	}
+	buf[i] = 0;
+	return i;
+}
+
 void TextView_SetLineHeight(LCUI_Widget w, int height)
 {
 	Widget_SetFontStyle(w, key_line_height, (float)height, px);
@@ -541,6 +709,7 @@ size_t LCUIWidget_RefreshTextView(void)
 	for (LinkedList_Each(node, &self.list)) {
 		txt = node->data;
 		if (txt->widget->state != LCUI_WSTATE_DELETED) {
+			TextView_ClearMeasures(txt);
 			Widget_UpdateStyle(txt->widget, TRUE);
 		}
 		count += 1;
@@ -548,6 +717,23 @@ size_t LCUIWidget_RefreshTextView(void)
 	return count;
 }
 
+static void OnFontBitmapsReady(LCUI_Event e, void *arg)
+{
+	LCUI_TextView txt;
+	LinkedListNode *node;
+
+	for (LinkedList_Each(node, &self.list)) {
+		txt = node->data;
+		if (txt->widget->state == LCUI_WSTATE_DELETED) {
+			continue;
+		}
+		if (TextLayer_ReloadPendingBitmaps(txt->layer)) {
+			txt->tasks[TASK_UPDATE].is_valid = TRUE;
+			Widget_AddTask(txt->widget, LCUI_WTASK_USER);
+		}
+	}
+}
+
 void LCUIWidget_AddTextView(void)
 {
 	LCUI_CSSPropertyParserRec parser = { 0, "word-break",
@@ -565,6 +751,8 @@ void LCUIWidget_AddTextView(void)
 	self.prototype->runtask = TextView_OnTask;
 	LCUI_AddCSSPropertyParser(&parser);
 	LinkedList_Init(&self.list);
+	LCUIFont_BindEvent(LCUI_FONT_EVENT_BITMAPS_READY, OnFontBitmapsReady,
+			   NULL, NULL);
 }
 
 void LCUIWidget_FreeTextView(void)
@@ -39,6 +39,11 @@
 
 #define ComputeActual LCUIMetrics_ComputeActual
 
+/* 缩放后的背景图超过这个像素数量时不缓存，改为每次只缩放需要绘制的部分 */
+#define SCALED_IMAGE_MAX_PIXELS (4096 * 4096)
+/* Graph_Create() 不能创建宽或高超过这个值的图像 */
+#define SCALED_IMAGE_MAX_SIDE 10000
+
 typedef struct ImageCacheRec_ {
 	char *path;
 	LCUI_Graph image;
@@ -50,13 +55,86 @@ typedef struct ImageRefRec_ {
 	ImageCache cache;
 } ImageRefRec, *ImageRef;
 
-struct LCUI_WidgetBackgroundModule {
+/** 缩放后的图像数据，绘制线程在使用期间会持有引用，以免被重新缩放时释放 */
+typedef struct ScaledImageDataRec_ {
+	unsigned refs;
+	LCUI_Graph image;
+} ScaledImageDataRec, *ScaledImageData;
+
+/**
+ * 缩放后的背景图，以源图像的版本号、引用区域和缩放后的尺寸作为缓存的键
+ * 像素数据的地址可能会被新的图像重用，所以不能用来判断是否是同一张图
+ */
+typedef struct ScaledImageRec_ {
+	LCUI_Widget widget;
+	unsigned source_generation;	/**< 源图像的版本号 */
+	int source_x, source_y;
+	int source_width, source_height;
+	ScaledImageData data;
+} ScaledImageRec, *ScaledImage;
+
+static struct LCUI_WidgetBackgroundModule {
 	LCUI_BOOL active;
 	DictType dtype;
 	Dict *images;
 	RBTree refs;
+	RBTree scaled_images;	/**< 各个部件的缩放后的背景图 */
+	unsigned generation;	/**< 最近一次设置的背景图的版本号 */
+	LCUI_Mutex mutex;	/**< 背景图在多个线程中绘制，缓存需要加锁访问 */
 } self;
 
+static int OnCompareScaledImage(void *data, const void *keydata)
+{
+	ScaledImage scaled = data;
+	if (scaled->widget == keydata) {
+		return 0;
+	}
+	if ((void *)scaled->widget > keydata) {
+		return 1;
+	}
+	return -1;
+}
+
+/** 释放对缩放后的图像数据的引用，需要在持有 self.mutex 时调用 */
+static void ScaledImageData_Release(ScaledImageData data)
+{
+	if (--data->refs > 0) {
+		return;
+	}
+	Graph_Free(&data->image);
+	free(data);
+}
+
+static void OnDestroyScaledImage(void *data)
+{
+	ScaledImage scaled = data;
+	if (scaled->data) {
+		ScaledImageData_Release(scaled->data);
+	}
+	free(scaled);
+}
+
+static void ClearScaledImage(LCUI_Widget widget)
+{
+	if (!self.active) {
+		return;
+	}
+	LCUIMutex_Lock(&self.mutex);
+	RBTree_CustomErase(&self.scaled_images, widget);
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+/** 设置部件的背景图，并为它分配新的版本号 */
+static void SetBackgroundImage(LCUI_Widget widget, LCUI_Graph *image)
+{
+	LCUI_BackgroundStyle *bg = &widget->computed_style.background;
+
+	Graph_Quote(&bg->image, image, NULL);
+	LCUIMutex_Lock(&self.mutex);
+	bg->image_generation = ++self.generation;
+	LCUIMutex_Unlock(&self.mutex);
+}
+
 static void DestroyImageCache(ImageCache cache)
 {
 	LinkedListNode *node;
@@ -66,6 +144,7 @@ static void DestroyImageCache(ImageCache cache)
 		Widget_UnsetStyle(w, key_background_image);
 		Graph_Init(&w->computed_style.background.image);
 		LinkedList_DeleteNode(&cache->refs, node);
+		ClearScaledImage(w);
 	}
 	Graph_Free(&cache->image);
 	free(cache->path);
@@ -111,6 +190,7 @@ static void DeleteImageRef(LCUI_Widget widget)
 		Widget_UnsetStyle(w, key_background_image);
 		Graph_Init(&w->computed_style.background.image);
 		LinkedList_DeleteNode(&cache->refs, node);
+		ClearScaledImage(w);
 		break;
 	}
 	RBTree_CustomErase(&self.refs, widget);
@@ -139,7 +219,7 @@ static void ExecLoadImage(void *arg1, void *arg2)
 	} else {
 		DestroyImageCache(cache);
 	}
-	Graph_Quote(&w->computed_style.background.image, &cache->image, NULL);
+	SetBackgroundImage(w, &cache->image);
 	Widget_AddTask(w, LCUI_WTASK_BODY);
 }
 
@@ -155,6 +235,90 @@ static int OnCompareWidget(void *data, const void *keydata)
 	return -1;
 }
 
+/** 获取缩放后的背景图，需要在持有 self.mutex 时调用 */
+static ScaledImageData GetScaledImage(LCUI_Widget widget,
+				      const LCUI_Background *bg)
+{
+	ScaledImage scaled;
+	ScaledImageData data;
+	unsigned generation;
+
+	generation = widget->computed_style.background.image_generation;
+	scaled = RBTree_CustomGetData(&self.scaled_images, widget);
+	if (scaled && scaled->source_generation == generation &&
+	    scaled->source_x == bg->image->quote.left &&
+	    scaled->source_y == bg->image->quote.top &&
+	    scaled->source_width == (int)bg->image->width &&
+	    scaled->source_height == (int)bg->image->height &&
+	    scaled->data->image.width == (unsigned)bg->size.width &&
+	    scaled->data->image.height == (unsigned)bg->size.height) {
+		return scaled->data;
+	}
+	data = NEW(ScaledImageDataRec, 1);
+	if (!data) {
+		return NULL;
+	}
+	data->refs = 1;
+	Graph_Init(&data->image);
+	if (Graph_Zoom(bg->image, &data->image, FALSE, bg->size.width,
+		       bg->size.height) != 0) {
+		free(data);
+		RBTree_CustomErase(&self.scaled_images, widget);
+		return NULL;
+	}
+	if (scaled) {
+		/* 其它绘制线程可能还在使用旧的数据，由最后一个使用者释放 */
+		ScaledImageData_Release(scaled->data);
+	} else {
+		scaled = NEW(ScaledImageRec, 1);
+		scaled->widget = widget;
+		RBTree_CustomInsert(&self.scaled_images, widget, scaled);
+	}
+	scaled->source_generation = generation;
+	scaled->source_x = bg->image->quote.left;
+	scaled->source_y = bg->image->quote.top;
+	scaled->source_width = bg->image->width;
+	scaled->source_height = bg->image->height;
+	scaled->data = data;
+	return data;
+}
+
+/**
+ * 用缩放后的背景图绘制背景
+ * 缓存中没有的话，先将整张背景图缩放到目标尺寸并缓存，之后的绘制只需
+ * 要引用它，不必再对每个脏矩形重新缩放。查找和缩放时持有锁，绘制时只持
+ * 有图像数据的引用，以便多个绘制线程能同时绘制。
+ * @returns 绘制了背景则返回 TRUE，无法缓存时返回 FALSE
+ */
+static LCUI_BOOL PaintScaledImage(LCUI_Widget widget, LCUI_Background *bg,
+				  LCUI_Rect *box, LCUI_PaintContext paint)
+{
+	ScaledImageData data;
+
+	if (!self.active || !Graph_IsValid(bg->image) ||
+	    bg->size.width < 1 || bg->size.height < 1 ||
+	    bg->size.width > SCALED_IMAGE_MAX_SIDE ||
+	    bg->size.height > SCALED_IMAGE_MAX_SIDE ||
+	    bg->size.width * bg->size.height > SCALED_IMAGE_MAX_PIXELS) {
+		return FALSE;
+	}
+	LCUIMutex_Lock(&self.mutex);
+	data = GetScaledImage(widget, bg);
+	if (data) {
+		data->refs += 1;
+	}
+	LCUIMutex_Unlock(&self.mutex);
+	if (!data) {
+		return FALSE;
+	}
+	bg->image = &data->image;
+	Background_Paint(bg, box, paint);
+	LCUIMutex_Lock(&self.mutex);
+	ScaledImageData_Release(data);
+	LCUIMutex_Unlock(&self.mutex);
+	return TRUE;
+}
+
 static void AsyncLoadImage(LCUI_Widget widget, const char *path)
 {
 	ImageRef ref;
@@ -177,8 +341,7 @@ static void AsyncLoadImage(LCUI_Widget widget, const char *path)
 	cache = Dict_FetchValue(self.images, path);
 	if (cache) {
 		AddImageRef(widget, cache);
-		Graph_Quote(&widget->computed_style.background.image,
-			    &cache->image, NULL);
+		SetBackgroundImage(widget, &cache->image);
 		Widget_AddTask(widget, LCUI_WTASK_BODY);
 		return;
 	}
@@ -197,15 +360,22 @@ void LCUIWidget_InitImageLoader(void)
 	self.images = Dict_Create(&self.dtype, NULL);
 	RBTree_OnCompare(&self.refs, OnCompareWidget);
 	RBTree_OnDestroy(&self.refs, free);
+	RBTree_Init(&self.scaled_images);
+	RBTree_OnCompare(&self.scaled_images, OnCompareScaledImage);
+	RBTree_OnDestroy(&self.scaled_images, OnDestroyScaledImage);
+	self.generation = 0;
+	LCUIMutex_Init(&self.mutex);
 	self.active = TRUE;
 }
 
 void LCUIWidget_FreeImageLoader(void)
 {
+	self.active = FALSE;
 	Dict_Release(self.images);
 	RBTree_Destroy(&self.refs);
+	RBTree_Destroy(&self.scaled_images);
+	LCUIMutex_Destroy(&self.mutex);
 	self.images = NULL;
-	self.active = FALSE;
 }
 
 void Widget_InitBackground(LCUI_Widget w)
@@ -214,6 +384,7 @@ void Widget_InitBackground(LCUI_Widget w)
 	bg = &w->computed_style.background;
 	bg->color = RGB(255, 255, 255);
 	Graph_Init(&bg->image);
+	bg->image_generation = 0;
 	bg->size.using_value = TRUE;
 	bg->size.value = SV_AUTO;
 	bg->position.using_value = TRUE;
@@ -222,6 +393,7 @@ void Widget_InitBackground(LCUI_Widget w)
 
 void Widget_DestroyBackground(LCUI_Widget w)
 {
+	ClearScaledImage(w);
 	Widget_UnsetStyle(w, key_background_image);
 	Graph_Init(&w->computed_style.background.image);
 	if (Widget_CheckStyleType(w, key_background_image, string)) {
@@ -260,7 +432,11 @@ void Widget_UpdateBackground(LCUI_Widget widget)
 					Graph_Init(&bg->image);
 					break;
 				}
-				Graph_Quote(&bg->image, s->image, NULL);
+				/* 只更换了其它背景样式时，不必重新缩放背景图 */
+				if (!bg->image.quote.is_valid ||
+				    bg->image.quote.source != s->image) {
+					SetBackgroundImage(widget, s->image);
+				}
 				DeleteImageRef(widget);
 			default:
 				break;
@@ -473,9 +649,17 @@ void Widget_PaintBakcground(LCUI_Widget w, LCUI_PaintContext paint,
 			    LCUI_WidgetActualStyle style)
 {
 	LCUI_Rect box;
+	LCUI_Background bg = style->background;
+
 	box.x = style->padding_box.x - style->canvas_box.x;
 	box.y = style->padding_box.y - style->canvas_box.y;
 	box.width = style->padding_box.width;
 	box.height = style->padding_box.height;
-	Background_Paint(&style->background, &box, paint);
+	if (Graph_IsValid(bg.image) &&
+	    (bg.size.width != (int)bg.image->width ||
+	     bg.size.height != (int)bg.image->height) &&
+	    PaintScaledImage(w, &bg, &box, paint)) {
+		return;
+	}
+	Background_Paint(&bg, &box, paint);
 }
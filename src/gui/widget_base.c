@@ -35,12 +35,17 @@
 #include <assert.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
 #include <LCUI/gui/widget.h>
 #include <LCUI/gui/metrics.h>
 
 static struct LCUI_WidgetModule {
-	LCUI_Widget root; /**< 根级部件 */
-	LinkedList trash; /**< 待删除的部件列表 */
+	LCUI_Widget root;  /**< 根级部件 */
+	LinkedList trash;  /**< 待删除的部件列表 */
+	LCUI_BOOL active;  /**< 内存池是否可用 */
+	LCUI_Mutex mutex;  /**< 内存池的互斥锁 */
+	slab_t *widgets;   /**< 部件对象的分配器 */
+	slab_pool_t *pool; /**< 部件附属数据的内存池 */
 } LCUIWidget;
 
 static inline float ToBorderBoxWidth(LCUI_Widget w, float content_width)
@@ -71,6 +76,47 @@ static inline float ToContentBoxHeight(LCUI_Widget w, float height)
 	       w->computed_style.border.bottom.width;
 }
 
+void *LCUIWidget_AllocMemory(size_t size)
+{
+	void *ptr;
+
+	if (!LCUIWidget.active) {
+		ptr = slab_pool_alloc(NULL, size);
+	} else {
+		LCUIMutex_Lock(&LCUIWidget.mutex);
+		ptr = slab_pool_alloc(LCUIWidget.pool, size);
+		LCUIMutex_Unlock(&LCUIWidget.mutex);
+	}
+	if (ptr) {
+		memset(ptr, 0, size);
+	}
+	return ptr;
+}
+
+void LCUIWidget_FreeMemory(void *ptr)
+{
+	if (!LCUIWidget.active) {
+		slab_free(ptr);
+		return;
+	}
+	LCUIMutex_Lock(&LCUIWidget.mutex);
+	slab_free(ptr);
+	LCUIMutex_Unlock(&LCUIWidget.mutex);
+}
+
+static LCUI_Widget LCUIWidget_Alloc(void)
+{
+	LCUI_Widget w;
+
+	if (!LCUIWidget.active) {
+		return slab_pool_alloc(NULL, sizeof(LCUI_WidgetRec));
+	}
+	LCUIMutex_Lock(&LCUIWidget.mutex);
+	w = slab_alloc(LCUIWidget.widgets);
+	LCUIMutex_Unlock(&LCUIWidget.mutex);
+	return w;
+}
+
 LCUI_Widget LCUIWidget_GetRoot(void)
 {
 	return LCUIWidget.root;
@@ -107,7 +153,7 @@ static void Widget_Init(LCUI_Widget widget)
 {
 	ZEROSET(widget, LCUI_Widget);
 	widget->state = LCUI_WSTATE_CREATED;
-	widget->style = StyleSheet();
+	Widget_InitStyleSheets(widget);
 	widget->computed_style.opacity = 1.0;
 	widget->computed_style.visible = TRUE;
 	widget->computed_style.focusable = FALSE;
@@ -134,7 +180,7 @@ static void Widget_Init(LCUI_Widget widget)
 
 LCUI_Widget LCUIWidget_NewWithPrototype(LCUI_WidgetPrototypeC proto)
 {
-	LCUI_Widget widget = malloc(sizeof(LCUI_WidgetRec));
+	LCUI_Widget widget = LCUIWidget_Alloc();
 
 	Widget_Init(widget);
 	widget->proto = proto;
@@ -146,7 +192,7 @@ LCUI_Widget LCUIWidget_NewWithPrototype(LCUI_WidgetPrototypeC proto)
 
 LCUI_Widget LCUIWidget_New(const char *type)
 {
-	LCUI_Widget widget = malloc(sizeof(LCUI_WidgetRec));
+	LCUI_Widget widget = LCUIWidget_Alloc();
 
 	Widget_Init(widget);
 	if (type) {
@@ -171,6 +217,7 @@ void Widget_ExecDestroy(LCUI_Widget w)
 	Widget_DestroyBackground(w);
 	Widget_DestroyEventTrigger(w);
 	Widget_DestroyChildren(w);
+	Widget_DestroyHitIndex(w);
 	Widget_ClearPrototype(w);
 	if (w->title) {
 		free(w->title);
@@ -182,7 +229,7 @@ void Widget_ExecDestroy(LCUI_Widget w)
 	Widget_DestroyClasses(w);
 	Widget_DestroyStatus(w);
 	Widget_SetRules(w, NULL);
-	free(w);
+	LCUIWidget_FreeMemory(w);
 }
 
 void Widget_Destroy(LCUI_Widget w)
@@ -200,16 +247,6 @@ void Widget_Destroy(LCUI_Widget w)
 		return;
 	}
 	if (w->parent) {
-		LCUI_Widget child;
-		LinkedListNode *node;
-
-		/* Update the index of the siblings behind it */
-		node = w->node.next;
-		while (node) {
-			child = node->data;
-			child->index -= 1;
-			node = node->next;
-		}
 		if (w->computed_style.position != SV_ABSOLUTE) {
 			Widget_UpdateLayout(w->parent);
 		}
@@ -244,6 +281,8 @@ void Widget_Empty(LCUI_Widget w)
 		child->parent = NULL;
 	}
 	LinkedList_ClearData(&w->children_show, NULL);
+	Widget_InvalidateHitIndex(w);
+	Widget_InvalidateContentSize(w);
 	LinkedList_Concat(&LCUIWidget.trash, &w->children);
 	Widget_InvalidateArea(w, NULL, SV_GRAPH_BOX);
 	Widget_UpdateStyle(w, TRUE);
@@ -524,6 +563,7 @@ void Widget_AddState(LCUI_Widget w, LCUI_WidgetState state)
 			e.cancel_bubble = TRUE;
 			Widget_TriggerEvent(w, &e, NULL);
 			w->state = LCUI_WSTATE_NORMAL;
+			Widget_UpdateShowOrder(w);
 		}
 	}
 }
@@ -609,6 +649,7 @@ void Widget_UpdateDisplay(LCUI_Widget w)
 		return;
 	}
 	if (w->parent && w->computed_style.position != SV_ABSOLUTE) {
+		Widget_InvalidateContentSize(w->parent);
 		Widget_UpdateLayout(w->parent);
 	}
 	Widget_UpdateVisibility(w);
@@ -646,43 +687,103 @@ void Widget_UpdateZIndex(LCUI_Widget w)
 	Widget_AddTask(w, LCUI_WTASK_ZINDEX);
 }
 
+/** 比较两个部件的堆叠顺序，返回值大于 0 时表示 a 在 b 的上面 */
+static int Widget_CompareShowOrder(LCUI_Widget a, LCUI_Widget b)
+{
+	LCUI_WidgetStyle *sa = &a->computed_style;
+	LCUI_WidgetStyle *sb = &b->computed_style;
+
+	if (sa->z_index != sb->z_index) {
+		return sa->z_index > sb->z_index ? 1 : -1;
+	}
+	if (sa->position != sb->position) {
+		return sa->position > sb->position ? 1 : -1;
+	}
+	if (a->index != b->index) {
+		return a->index > b->index ? 1 : -1;
+	}
+	return 0;
+}
+
+static int CompareShowOrder(const void *a, const void *b)
+{
+	return Widget_CompareShowOrder(*(LCUI_Widget *)b, *(LCUI_Widget *)a);
+}
+
 void Widget_SortChildrenShow(LCUI_Widget w)
 {
-	LCUI_Widget child, target;
-	LCUI_WidgetStyle *s, *ts;
-	LinkedListNode *node, *target_node;
-	LinkedList *list;
+	size_t i, n = 0;
+	size_t length = w->children_show.length;
+	LCUI_Widget child, *children;
 
-	list = &w->children_show;
-	LinkedList_ClearData(list, NULL);
-	for (LinkedList_Each(node, &w->children)) {
-		child = node->data;
-		s = &child->computed_style;
-		if (child->state < LCUI_WSTATE_READY) {
-			continue;
+	children = malloc(sizeof(LCUI_Widget) * (w->children.length + 1));
+	if (!children) {
+		return;
+	}
+	for (i = 0; i < w->children.length; ++i) {
+		child = w->children_array[i];
+		if (child->state >= LCUI_WSTATE_READY) {
+			children[n++] = child;
 		}
-		for (LinkedList_Each(target_node, list)) {
-			target = target_node->data;
-			ts = &target->computed_style;
-			if (s->z_index == ts->z_index) {
-				if (s->position == ts->position) {
-					if (child->index < target->index) {
-						continue;
-					}
-				} else if (s->position < ts->position) {
-					continue;
-				}
-			} else if (s->z_index < ts->z_index) {
-				continue;
-			}
-			LinkedList_Link(list, target_node->prev,
-					&child->node_show);
-			break;
+	}
+	qsort(children, n, sizeof(LCUI_Widget), CompareShowOrder);
+	LinkedList_ClearData(&w->children_show, NULL);
+	for (i = 0; i < n; ++i) {
+		LinkedList_AppendNode(&w->children_show, &children[i]->node_show);
+	}
+	free(children);
+	Widget_InvalidateHitIndex(w);
+	if (w->children_show.length != length) {
+		Widget_InvalidateContentSize(w);
+	}
+}
+
+void Widget_UpdateShowOrder(LCUI_Widget w)
+{
+	LinkedList *list;
+	LinkedListNode *node, *target;
+
+	if (!w->parent) {
+		return;
+	}
+	list = &w->parent->children_show;
+	node = &w->node_show;
+	/* 如果部件已在显示列表中，且与相邻部件的先后顺序仍然正确，则无需移动 */
+	if (node->prev) {
+		if ((node->prev == &list->head ||
+		     Widget_CompareShowOrder(node->prev->data, w) > 0) &&
+		    (!node->next ||
+		     Widget_CompareShowOrder(node->next->data, w) < 0)) {
+			return;
 		}
-		if (!target_node) {
-			LinkedList_AppendNode(list, &child->node_show);
+		LinkedList_Unlink(list, node);
+	} else if (w->state < LCUI_WSTATE_READY) {
+		return;
+	} else {
+		Widget_InvalidateContentSize(w->parent);
+	}
+	Widget_InvalidateHitIndex(w->parent);
+	/* 显示列表由顶到底排列，先检查两端，常见的追加操作只需常数时间 */
+	target = list->head.next;
+	if (!target) {
+		LinkedList_AppendNode(list, node);
+		return;
+	}
+	if (Widget_CompareShowOrder(w, target->data) > 0) {
+		LinkedList_Link(list, &list->head, node);
+		return;
+	}
+	if (Widget_CompareShowOrder(w, list->tail.prev->data) < 0) {
+		LinkedList_AppendNode(list, node);
+		return;
+	}
+	for (; target; target = target->next) {
+		if (Widget_CompareShowOrder(w, target->data) > 0) {
+			LinkedList_Link(list, target->prev, node);
+			return;
 		}
 	}
+	LinkedList_AppendNode(list, node);
 }
 
 void Widget_ExecUpdateZIndex(LCUI_Widget w)
@@ -705,6 +806,7 @@ void Widget_ExecUpdateZIndex(LCUI_Widget w)
 		}
 	}
 	w->computed_style.z_index = z_index;
+	Widget_UpdateShowOrder(w);
 	if (w->computed_style.position != SV_STATIC) {
 		Widget_AddTask(w, LCUI_WTASK_REFRESH);
 	}
@@ -727,9 +829,9 @@ void Widget_ClearComputedSize(LCUI_Widget w)
 
 static void Widget_UpdateChildrenSize(LCUI_Widget w)
 {
-	LinkedListNode *node;
-	for (LinkedList_Each(node, &w->children)) {
-		LCUI_Widget child = node->data;
+	size_t i;
+	for (i = 0; i < w->children.length; ++i) {
+		LCUI_Widget child = w->children_array[i];
 		LCUI_StyleSheet s = child->style;
 		if (Widget_HasFillAvailableWidth(child)) {
 			Widget_AddTask(child, LCUI_WTASK_RESIZE);
@@ -757,6 +859,7 @@ static void Widget_UpdateChildrenSize(LCUI_Widget w)
 void Widget_UpdatePosition(LCUI_Widget w)
 {
 	LCUI_RectF rect;
+	LCUI_WidgetBoxModelRec old_box = w->box;
 	int position = ComputeStyleOption(w, key_position, SV_STATIC);
 	int valign = ComputeStyleOption(w, key_vertical_align, SV_TOP);
 	w->computed_style.vertical_align = valign;
@@ -766,6 +869,8 @@ void Widget_UpdatePosition(LCUI_Widget w)
 	w->computed_style.bottom = ComputeYMetric(w, key_bottom);
 	if (w->parent && w->computed_style.position != position) {
 		w->computed_style.position = position;
+		Widget_UpdateShowOrder(w);
+		Widget_InvalidateContentSize(w->parent);
 		Widget_UpdateLayout(w->parent);
 		Widget_ClearComputedSize(w);
 		Widget_UpdateChildrenSize(w);
@@ -855,6 +960,10 @@ void Widget_UpdatePosition(LCUI_Widget w)
 	w->box.canvas.x -= Widget_GetBoxShadowOffsetX(w);
 	w->box.canvas.y -= Widget_GetBoxShadowOffsetY(w);
 	if (w->parent) {
+		Widget_InvalidateHitIndex(w->parent);
+		if (memcmp(&old_box, &w->box, sizeof(old_box)) != 0) {
+			Widget_InvalidateContentSize(w->parent);
+		}
 		/* 标记移动前后的区域 */
 		Widget_InvalidateArea(w, NULL, SV_GRAPH_BOX);
 		Widget_InvalidateArea(w->parent, &rect, SV_PADDING_BOX);
@@ -872,6 +981,13 @@ static void Widget_UpdateCanvasBox(LCUI_Widget w)
 	rg->height = Widget_GetCanvasHeight(w);
 }
 
+/** 部件的尺寸是否会影响父部件的内容尺寸 */
+static LCUI_BOOL Widget_HasStaticSize(LCUI_Widget w)
+{
+	return w->computed_style.display != SV_NONE &&
+	       w->computed_style.position != SV_ABSOLUTE;
+}
+
 static LCUI_BOOL Widget_ComputeStaticSize(LCUI_Widget w, float *width,
 					  float *height)
 {
@@ -879,7 +995,7 @@ static LCUI_BOOL Widget_ComputeStaticSize(LCUI_Widget w, float *width,
 	LCUI_WidgetStyle *style = &w->computed_style;
 
 	/* If it is non-static layout */
-	if (style->display == SV_NONE || style->position == SV_ABSOLUTE) {
+	if (!Widget_HasStaticSize(w)) {
 		return FALSE;
 	}
 	if (Widget_HasParentDependentWidth(w)) {
@@ -981,6 +1097,25 @@ LCUI_BOOL Widget_HasFitContentWidth(LCUI_Widget w)
 	return FALSE;
 }
 
+LCUI_BOOL Widget_IsRelayoutBoundary(LCUI_Widget w)
+{
+	return !Widget_HasAutoStyle(w, key_width) &&
+	       !Widget_HasAutoStyle(w, key_height) &&
+	       !Widget_HasParentDependentWidth(w);
+}
+
+void Widget_InvalidateContentSize(LCUI_Widget w)
+{
+	/* 父部件计算内容尺寸时不会检查子部件的缓存，所以父部件的缓存有效不代表子
+	 * 部件的缓存也有效，这里需要一直向上标记，不能遇到已失效的部件就停下 */
+	for (; w; w = w->parent) {
+		w->content_size.valid = FALSE;
+		if (Widget_IsRelayoutBoundary(w)) {
+			break;
+		}
+	}
+}
+
 /** 根据当前部件的内外间距，获取调整后宽度 */
 static float Widget_GetAdjustedWidth(LCUI_Widget w, float width)
 {
@@ -1070,6 +1205,7 @@ static void Widget_SetSize(LCUI_Widget w, float width, float height)
 {
 	LCUI_RectF *box, *pbox;
 	LCUI_BorderStyle *bbox;
+	LCUI_WidgetBoxModelRec old_box = w->box;
 
 	w->width = width;
 	w->height = height;
@@ -1109,6 +1245,42 @@ static void Widget_SetSize(LCUI_Widget w, float width, float height)
 	w->box.outer.width += w->margin.left + w->margin.right;
 	w->box.outer.height += w->margin.top + w->margin.bottom;
 	Widget_UpdateCanvasBox(w);
+	if (w->parent) {
+		Widget_InvalidateHitIndex(w->parent);
+		if (memcmp(&old_box, &w->box, sizeof(old_box)) != 0) {
+			Widget_InvalidateContentSize(w->parent);
+		}
+	}
+}
+
+static void Widget_GetContentSizeKey(LCUI_Widget w, float width, float height,
+				     LCUI_WidgetContentSizeKeyRec *key)
+{
+	LCUI_WidgetStyle *style = &w->computed_style;
+
+	memset(key, 0, sizeof(LCUI_WidgetContentSizeKeyRec));
+	key->width = width;
+	key->height = height;
+	key->min_width = style->min_width;
+	key->max_width = style->max_width;
+	key->min_height = style->min_height;
+	key->max_height = style->max_height;
+	key->padding = w->padding;
+	key->border_top = style->border.top.width;
+	key->border_right = style->border.right.width;
+	key->border_bottom = style->border.bottom.width;
+	key->border_left = style->border.left.width;
+	key->box_sizing = style->box_sizing;
+}
+
+/**
+ * 部件的内容尺寸是否可以缓存
+ * 自定义的尺寸计算函数依赖的数据（如文本内容）变化时不一定会通知缓存失效，所以
+ * 只缓存使用默认尺寸计算方式的部件。
+ */
+static LCUI_BOOL Widget_CanCacheContentSize(LCUI_Widget w)
+{
+	return !Widget_HasCustomResizer(w);
 }
 
 void Widget_ComputeContentSize(LCUI_Widget w, float *width, float *height)
@@ -1117,8 +1289,21 @@ void Widget_ComputeContentSize(LCUI_Widget w, float *width, float *height)
 	float static_width = 0, static_height = 0;
 	float content_width = width ? *width : 0;
 	float content_height = height ? *height : 0;
+	LCUI_BOOL cacheable;
+	LCUI_WidgetContentSizeKeyRec key;
 
 	Widget_ComputeLimitSize(w);
+	cacheable = Widget_CanCacheContentSize(w);
+	if (cacheable) {
+		Widget_GetContentSizeKey(w, content_width, content_height,
+					 &key);
+		if (w->content_size.valid &&
+		    memcmp(&w->content_size.key, &key, sizeof(key)) == 0) {
+			content_width = w->content_size.width;
+			content_height = w->content_size.height;
+			goto output;
+		}
+	}
 	Widget_ComputeStaticContentSize(w, &static_width, &static_height);
 	if (w->proto && w->proto->autosize) {
 		w->proto->autosize(w, &content_width, &content_height);
@@ -1148,6 +1333,14 @@ void Widget_ComputeContentSize(LCUI_Widget w, float *width, float *height)
 
 done:
 	content_height = max(content_height, static_height);
+	if (cacheable) {
+		w->content_size.key = key;
+		w->content_size.width = content_width;
+		w->content_size.height = content_height;
+		w->content_size.valid = TRUE;
+	}
+
+output:
 	if (width && *width <= 0) {
 		*width = content_width;
 	}
@@ -1286,13 +1479,11 @@ void Widget_UpdateMargin(LCUI_Widget w)
 			}
 		}
 	}
-	if (w->parent) {
-		if (Widget_HasAutoStyle(w->parent, key_width) ||
-		    Widget_HasAutoStyle(w->parent, key_height)) {
+	if (w->parent && Widget_HasStaticSize(w)) {
+		if (!Widget_IsRelayoutBoundary(w->parent)) {
 			Widget_AddTask(w->parent, LCUI_WTASK_RESIZE);
 		}
-		if (w->computed_style.display != SV_NONE &&
-		    w->computed_style.position == SV_STATIC) {
+		if (w->computed_style.position == SV_STATIC) {
 			Widget_UpdateLayout(w->parent);
 		}
 	}
@@ -1378,13 +1569,12 @@ void Widget_UpdateSize(LCUI_Widget w)
 		/* If its width depends on the parent, there is no need to
 		 * repeatedly update the parent size and layout.
 		 * See Widget_ComputeStaticSize() for more details. */
-		if (!Widget_HasParentDependentWidth(w)) {
-			if (Widget_HasAutoStyle(w->parent, key_width) ||
-			    Widget_HasAutoStyle(w->parent, key_height)) {
+		if (!Widget_HasParentDependentWidth(w) &&
+		    Widget_HasStaticSize(w)) {
+			if (!Widget_IsRelayoutBoundary(w->parent)) {
 				Widget_AddTask(w->parent, LCUI_WTASK_RESIZE);
 			}
-			if (w->computed_style.display != SV_NONE &&
-			    w->computed_style.position == SV_STATIC) {
+			if (w->computed_style.position == SV_STATIC) {
 				Widget_UpdateLayout(w->parent);
 			}
 		}
@@ -1465,6 +1655,12 @@ float Widget_ComputeMaxContentWidth(LCUI_Widget w)
 
 void LCUIWidget_InitBase(void)
 {
+	if (!LCUIWidget.active) {
+		LCUIMutex_Init(&LCUIWidget.mutex);
+		LCUIWidget.widgets = slab_create(sizeof(LCUI_WidgetRec));
+		LCUIWidget.pool = slab_pool_create();
+		LCUIWidget.active = TRUE;
+	}
 	LinkedList_Init(&LCUIWidget.trash);
 	LCUIWidget.root = LCUIWidget_New("root");
 	Widget_SetTitleW(LCUIWidget.root, L"LCUI Display");
@@ -1478,4 +1674,18 @@ void LCUIWidget_FreeRoot(void)
 void LCUIWidget_FreeBase(void)
 {
 	LCUIWidget.root = NULL;
+	if (!LCUIWidget.active) {
+		return;
+	}
+	/* 还有部件没被销毁时保留内存池，让它们以后还能正常释放 */
+	if (slab_count(LCUIWidget.widgets) > 0 ||
+	    slab_pool_count(LCUIWidget.pool) > 0) {
+		return;
+	}
+	slab_destroy(LCUIWidget.widgets);
+	slab_pool_destroy(LCUIWidget.pool);
+	LCUIMutex_Destroy(&LCUIWidget.mutex);
+	LCUIWidget.widgets = NULL;
+	LCUIWidget.pool = NULL;
+	LCUIWidget.active = FALSE;
 }
@@ -169,7 +169,7 @@ static void DestroyWidgetEventHandler(void *arg)
 		handler->destroy_data(handler->data);
 	}
 	handler->data = NULL;
-	free(handler);
+	LCUIWidget_FreeMemory(handler);
 }
 
 static int GetEventId(const char *event_name)
@@ -436,12 +436,14 @@ int Widget_BindEventById(LCUI_Widget widget, int event_id,
 			 void (*destroy_data)(void *))
 {
 	WidgetEventHandler handler;
-	handler = NEW(WidgetEventHandlerRec, 1);
+	handler = LCUIWidget_AllocMemory(sizeof(WidgetEventHandlerRec));
 	handler->func = func;
 	handler->data = data;
 	handler->destroy_data = destroy_data;
 	if (!widget->trigger) {
-		widget->trigger = EventTrigger();
+		widget->trigger =
+		    LCUIWidget_AllocMemory(sizeof(LCUI_EventTriggerRec));
+		EventTrigger_Init(widget->trigger);
 	}
 	return EventTrigger_Bind(widget->trigger, event_id,
 				 (LCUI_EventFunc)WidgetEventTranslator, handler,
@@ -700,13 +702,12 @@ static LCUI_Widget Widget_GetEventTarget(LCUI_Widget widget, float x, float y,
 
 	LCUI_Widget child;
 	LCUI_Widget target = NULL;
-	LinkedListNode *node;
+	LCUI_WidgetHitIteratorRec iter;
 
-	for (LinkedList_Each(node, &widget->children_show)) {
-		child = node->data;
+	child = Widget_GetFirstChildAt(widget, x, y, &iter);
+	for (; child; child = Widget_GetNextChildAt(&iter)) {
 		if (!child->computed_style.visible ||
-		    child->state != LCUI_WSTATE_NORMAL ||
-		    !LCUIRect_HasPoint(&child->box.border, x, y)) {
+		    child->state != LCUI_WSTATE_NORMAL) {
 			continue;
 		}
 		pointer_events = child->computed_style.pointer_events;
@@ -1243,7 +1244,8 @@ void Widget_DestroyEventTrigger(LCUI_Widget w)
 	Widget_StopEventPropagation(w);
 	LCUIWidget_ClearEventTarget(w);
 	if (w->trigger) {
-		EventTrigger_Destroy(w->trigger);
+		EventTrigger_Clear(w->trigger);
+		LCUIWidget_FreeMemory(w->trigger);
 		w->trigger = NULL;
 	}
 }
@@ -174,13 +174,13 @@ static void LCUILayout_End(LCUI_LayoutContext ctx)
 
 void Widget_ExecUpdateLayout(LCUI_Widget w)
 {
-	LinkedListNode *node;
+	size_t i;
 	LCUI_LayoutContext ctx;
 	LCUI_WidgetEventRec ev = { 0 };
 
 	ctx = LCUILayout_Begin(w);
-	for (LinkedList_Each(node, &w->children)) {
-		ctx->current = node->data;
+	for (i = 0; i < w->children.length; ++i) {
+		ctx->current = w->children_array[i];
 		if (ctx->current->computed_style.position != SV_STATIC &&
 		    ctx->current->computed_style.position != SV_RELATIVE) {
 			Widget_AddState(ctx->current, LCUI_WSTATE_LAYOUTED);
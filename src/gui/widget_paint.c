@@ -35,6 +35,7 @@
 #include <LCUI/LCUI.h>
 #include <LCUI/gui/widget.h>
 #include <LCUI/display.h>
+#include <LCUI/draw/boxshadow.h>
 
 //#define DEBUG_FRAME_RENDER
 #define ComputeActualPX(VAL) LCUIMetrics_ComputeActual(VAL, LCUI_STYPE_PX)
@@ -266,6 +267,8 @@ void LCUIWidget_InitRenderer(void)
 	RBTree_OnCompare(&self.groups, OnCompareGroup);
 	RBTree_OnDestroy(&self.groups, OnDestroyGroup);
 	LinkedList_Init(&self.rects);
+	BoxShadow_InitCache();
+	Border_InitCache();
 	self.active = TRUE;
 }
 
@@ -274,6 +277,8 @@ void LCUIWidget_FreeRenderer(void)
 	self.active = FALSE;
 	RectList_Clear(&self.rects);
 	RBTree_Destroy(&self.groups);
+	BoxShadow_FreeCache();
+	Border_FreeCache();
 }
 
 /** 当前部件的绘制函数 */
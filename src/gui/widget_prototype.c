@@ -164,6 +164,12 @@ LCUI_BOOL Widget_CheckPrototype(LCUI_Widget w, LCUI_WidgetPrototypeC proto)
 	return FALSE;
 }
 
+LCUI_BOOL Widget_HasCustomResizer(LCUI_Widget w)
+{
+	return w->proto && w->proto->autosize &&
+	       w->proto->autosize != Widget_DefaultResizer;
+}
+
 void *Widget_GetData(LCUI_Widget widget, LCUI_WidgetPrototype proto)
 {
 	uint_t i;
@@ -188,7 +194,7 @@ void *Widget_AddData(LCUI_Widget widget, LCUI_WidgetPrototype proto,
 	if (!list) {
 		return NULL;
 	}
-	data = malloc(data_size);
+	data = LCUIWidget_AllocMemory(data_size);
 	list[widget->data.length].data = data;
 	list[widget->data.length].proto = proto;
 	widget->data.list = list;
@@ -203,7 +209,8 @@ void Widget_ClearPrototype(LCUI_Widget widget)
 	}
 	while (widget->data.length > 0) {
 		widget->data.length -= 1;
-		free(widget->data.list[widget->data.length].data);
+		LCUIWidget_FreeMemory(
+		    widget->data.list[widget->data.length].data);
 	}
 	if (widget->data.list) {
 		free(widget->data.list);
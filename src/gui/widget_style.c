@@ -298,13 +298,23 @@ void Widget_ExecUpdateStyle(LCUI_Widget w, LCUI_BOOL is_update_all)
 	}
 }
 
+void Widget_InitStyleSheets(LCUI_Widget w)
+{
+	w->style = LCUIWidget_AllocMemory(sizeof(LCUI_StyleSheetRec));
+	w->style->length = LCUI_GetStyleTotal();
+	w->style->sheet = NEW(LCUI_StyleRec, w->style->length + 1);
+}
+
 void Widget_DestroyStyleSheets(LCUI_Widget w)
 {
 	w->inherited_style = NULL;
 	if (w->custom_style) {
 		StyleList_Delete(w->custom_style);
 	}
-	StyleSheet_Delete(w->style);
+	StyleSheet_Clear(w->style);
+	free(w->style->sheet);
+	LCUIWidget_FreeMemory(w->style);
+	w->style = NULL;
 }
 
 void LCUIWidget_InitStyle(void)
@@ -418,9 +418,26 @@ static size_t Widget_UpdateChildren(LCUI_Widget w, LCUI_WidgetTaskContext ctx)
 	return total;
 }
 
-size_t Widget_UpdateWithContext(LCUI_Widget w, LCUI_WidgetTaskContext ctx)
+static void Widget_RunTasks(LCUI_Widget w, int first, int last)
 {
 	int i;
+	LCUI_BOOL *states = w->task.states;
+
+	for (i = first; i < last; ++i) {
+		if (states[i]) {
+			states[i] = FALSE;
+			if (self.handlers[i]) {
+				self.handlers[i](w);
+			}
+		} else {
+			states[i] = FALSE;
+		}
+	}
+}
+
+size_t Widget_UpdateWithContext(LCUI_Widget w, LCUI_WidgetTaskContext ctx)
+{
+	int64_t time;
 	size_t count = 0;
 	LCUI_BOOL *states;
 	LCUI_WidgetTaskContext self_ctx;
@@ -448,21 +465,23 @@ size_t Widget_UpdateWithContext(LCUI_Widget w, LCUI_WidgetTaskContext ctx)
 			}
 			self_ctx->profile->update_count += 1;
 		}
-		for (i = 0; i < LCUI_WTASK_USER; ++i) {
-			if (states[i]) {
-				states[i] = FALSE;
-				if (self.handlers[i]) {
-					self.handlers[i](w);
-				}
-			} else {
-				states[i] = FALSE;
-			}
+		if (self_ctx->profile) {
+			/* 单独统计样式计算和布局相关任务的耗时 */
+			time = LCUI_GetTimeUs();
+			Widget_RunTasks(w, 0, LCUI_WTASK_TITLE);
+			self_ctx->profile->style_time += LCUI_GetTimeUs() - time;
+			Widget_RunTasks(w, LCUI_WTASK_TITLE, LCUI_WTASK_LAYOUT);
+			time = LCUI_GetTimeUs();
+			Widget_RunTasks(w, LCUI_WTASK_LAYOUT, LCUI_WTASK_ZINDEX);
+			self_ctx->profile->layout_time += LCUI_GetTimeUs() - time;
+			Widget_RunTasks(w, LCUI_WTASK_ZINDEX, LCUI_WTASK_USER);
+		} else {
+			Widget_RunTasks(w, 0, LCUI_WTASK_USER);
 		}
 		Widget_AddState(w, LCUI_WSTATE_UPDATED);
 		count += 1;
 	}
 	count += Widget_UpdateChildren(w, self_ctx);
-	Widget_SortChildrenShow(w);
 	Widget_EndUpdate(self_ctx);
 	return count;
 }
@@ -28,6 +28,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <math.h>
+#include <errno.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -36,6 +38,30 @@
 #include <LCUI/LCUI.h>
 #include <LCUI/gui/widget.h>
 
+#define CHILDREN_ARRAY_MIN_CAPACITY 8
+
+/** 确保子部件数组至少能容纳 n 个子部件 */
+static int Widget_ReserveChildren(LCUI_Widget w, size_t n)
+{
+	size_t capacity;
+	LCUI_Widget *children;
+
+	if (n <= w->children_capacity) {
+		return 0;
+	}
+	capacity = max(w->children_capacity * 2, CHILDREN_ARRAY_MIN_CAPACITY);
+	if (capacity < n) {
+		capacity = n;
+	}
+	children = realloc(w->children_array, capacity * sizeof(LCUI_Widget));
+	if (!children) {
+		return -ENOMEM;
+	}
+	w->children_array = children;
+	w->children_capacity = capacity;
+	return 0;
+}
+
 int Widget_Append(LCUI_Widget parent, LCUI_Widget widget)
 {
 	LCUI_WidgetEventRec ev = { 0 };
@@ -46,10 +72,14 @@ int Widget_Append(LCUI_Widget parent, LCUI_Widget widget)
 	if (parent == widget) {
 		return -2;
 	}
+	if (Widget_ReserveChildren(parent, parent->children.length + 1) != 0) {
+		return -ENOMEM;
+	}
 	Widget_Unlink(widget);
 	widget->parent = parent;
 	widget->state = LCUI_WSTATE_CREATED;
 	widget->index = parent->children.length;
+	parent->children_array[widget->index] = widget;
 	LinkedList_AppendNode(&parent->children, &widget->node);
 	ev.cancel_bubble = TRUE;
 	ev.type = LCUI_WEVENT_LINK;
@@ -75,6 +105,9 @@ int Widget_Prepend(LCUI_Widget parent, LCUI_Widget widget)
 	if (parent == widget) {
 		return -2;
 	}
+	if (Widget_ReserveChildren(parent, parent->children.length + 1) != 0) {
+		return -ENOMEM;
+	}
 	child = widget->parent;
 	Widget_Unlink(widget);
 	widget->index = 0;
@@ -82,6 +115,9 @@ int Widget_Prepend(LCUI_Widget parent, LCUI_Widget widget)
 	widget->state = LCUI_WSTATE_CREATED;
 	node = &widget->node;
 	LinkedList_InsertNode(&parent->children, 0, node);
+	memmove(parent->children_array + 1, parent->children_array,
+		sizeof(LCUI_Widget) * (parent->children.length - 1));
+	parent->children_array[0] = widget;
 	/** 修改它后面的部件的 index 值 */
 	node = node->next;
 	while (node) {
@@ -102,7 +138,7 @@ int Widget_Prepend(LCUI_Widget parent, LCUI_Widget widget)
 
 int Widget_Unwrap(LCUI_Widget widget)
 {
-	size_t len;
+	size_t i, len;
 	LCUI_Widget child;
 	LinkedList *children;
 	LinkedListNode *target, *node, *prev;
@@ -112,6 +148,10 @@ int Widget_Unwrap(LCUI_Widget widget)
 	}
 	children = &widget->parent->children;
 	len = widget->children.length;
+	if (Widget_ReserveChildren(widget->parent, children->length + len) !=
+	    0) {
+		return -ENOMEM;
+	}
 	if (len > 0) {
 		node = LinkedList_GetNode(&widget->children, 0);
 		Widget_RemoveStatus(node->data, "first-child");
@@ -127,6 +167,10 @@ int Widget_Unwrap(LCUI_Widget widget)
 		prev = node->prev;
 		child = node->data;
 		LinkedList_Unlink(&widget->children, node);
+		if (child->node_show.prev) {
+			LinkedList_Unlink(&widget->children_show,
+					  &child->node_show);
+		}
 		child->parent = widget->parent;
 		LinkedList_Link(children, target, node);
 		Widget_AddTaskForChildren(child, LCUI_WTASK_REFRESH_STYLE);
@@ -141,6 +185,14 @@ int Widget_Unwrap(LCUI_Widget widget)
 		node = LinkedList_GetNodeAtTail(children, 0);
 		Widget_AddStatus(node->data, "last-child");
 	}
+	/* 子部件的序号和堆叠顺序都已改变，需要重新计算 */
+	i = 0;
+	for (LinkedList_Each(node, children)) {
+		child = node->data;
+		widget->parent->children_array[i] = child;
+		child->index = i++;
+	}
+	Widget_SortChildrenShow(widget->parent);
 	Widget_Destroy(widget);
 	return 0;
 }
@@ -180,8 +232,19 @@ int Widget_Unlink(LCUI_Widget w)
 	ev.cancel_bubble = TRUE;
 	ev.type = LCUI_WEVENT_UNLINK;
 	Widget_TriggerEvent(w, &ev, NULL);
+	/* 销毁全部子部件时链表已被清空，子部件数组无需再调整 */
+	if (w->index < w->parent->children.length) {
+		memmove(w->parent->children_array + w->index,
+			w->parent->children_array + w->index + 1,
+			sizeof(LCUI_Widget) *
+			    (w->parent->children.length - w->index - 1));
+	}
 	LinkedList_Unlink(&w->parent->children, node);
-	LinkedList_Unlink(&w->parent->children_show, &w->node_show);
+	if (w->node_show.prev) {
+		LinkedList_Unlink(&w->parent->children_show, &w->node_show);
+	}
+	Widget_InvalidateHitIndex(w->parent);
+	Widget_InvalidateContentSize(w->parent);
 	Widget_PostSurfaceEvent(w, LCUI_WEVENT_UNLINK, TRUE);
 	Widget_UpdateLayout(w->parent);
 	w->parent = NULL;
@@ -208,9 +271,8 @@ LCUI_Widget Widget_GetNext(LCUI_Widget w)
 
 LCUI_Widget Widget_GetChild(LCUI_Widget w, size_t index)
 {
-	LinkedListNode *node = LinkedList_GetNode(&w->children, index);
-	if (node) {
-		return node->data;
+	if (index < w->children.length) {
+		return w->children_array[index];
 	}
 	return NULL;
 }
@@ -225,7 +287,11 @@ void Widget_DestroyChildren(LCUI_Widget w)
 	/* 先释放显示列表，后销毁部件列表，因为部件在这两个链表中的节点是和它共用
 	 * 一块内存空间的，销毁部件列表会把部件释放掉，所以把这个操作放在后面 */
 	LinkedList_ClearData(&w->children_show, NULL);
+	Widget_InvalidateHitIndex(w);
 	LinkedList_ClearData(&w->children, Widget_OnDestroy);
+	free(w->children_array);
+	w->children_array = NULL;
+	w->children_capacity = 0;
 }
 
 static void _LCUIWidget_PrintTree(LCUI_Widget w, int depth, const char *prefix)
@@ -303,12 +369,274 @@ size_t Widget_Each(LCUI_Widget w, void (*callback)(LCUI_Widget, void *),
 	return count;
 }
 
+/* clang-format off */
+
+/** 子部件数量达到该值时才为其建立命中测试索引 */
+#define HIT_INDEX_MIN_CHILDREN	32
+/** 网格的行数和列数上限 */
+#define HIT_INDEX_MAX_CELLS	256
+/** 平均每个子部件占用的格子数超过该值时放弃使用索引 */
+#define HIT_INDEX_MAX_SPAN	8
+
+/**
+ * 子部件命中测试索引
+ * 将子部件的边框盒所在区域划分成均匀的网格，每个格子按堆叠顺序记录与它相交的
+ * 子部件，命中测试时只需要检查坐标所在格子中的子部件。格子的子部件列表连续存放
+ * 在 items 中，第 i 个格子的列表为 items[offsets[i]] 至 items[offsets[i + 1]]。
+ */
+typedef struct LCUI_WidgetHitIndexRec_ {
+	LCUI_BOOL dirty;	/**< 是否需要重建 */
+	LCUI_BOOL usable;	/**< 是否可用，子部件重叠过多时改用线性查找 */
+	float x, y;		/**< 网格的左上角坐标 */
+	float cell_width;
+	float cell_height;
+	int cols, rows;
+	size_t *offsets;
+	size_t offsets_size;
+	LCUI_Widget *items;
+	size_t items_size;
+} LCUI_WidgetHitIndexRec;
+
+/* clang-format on */
+
+static int HitIndex_GetCol(LCUI_WidgetHitIndex index, float x)
+{
+	int col = (int)((x - index->x) / index->cell_width);
+	return col < 0 ? 0 : (col >= index->cols ? index->cols - 1 : col);
+}
+
+static int HitIndex_GetRow(LCUI_WidgetHitIndex index, float y)
+{
+	int row = (int)((y - index->y) / index->cell_height);
+	return row < 0 ? 0 : (row >= index->rows ? index->rows - 1 : row);
+}
+
+/**
+ * 获取子部件所占的格子范围
+ * 超出网格的部分会被归入边缘的格子，查询时坐标也会以同样的方式归入边缘格子，所以
+ * 不会漏掉子部件。
+ */
+static LCUI_BOOL HitIndex_GetSpan(LCUI_WidgetHitIndex index, LCUI_Widget child,
+				  int *col1, int *row1, int *col2, int *row2)
+{
+	LCUI_RectF *rect = &child->box.border;
+
+	if (rect->width <= 0 || rect->height <= 0) {
+		return FALSE;
+	}
+	*col1 = HitIndex_GetCol(index, rect->x);
+	*row1 = HitIndex_GetRow(index, rect->y);
+	*col2 = HitIndex_GetCol(index, rect->x + rect->width);
+	*row2 = HitIndex_GetRow(index, rect->y + rect->height);
+	return TRUE;
+}
+
+static int HitIndex_Reserve(LCUI_WidgetHitIndex index, size_t n_offsets,
+			    size_t n_items)
+{
+	void *p;
+
+	if (n_offsets > index->offsets_size) {
+		p = realloc(index->offsets, n_offsets * sizeof(size_t));
+		if (!p) {
+			return -ENOMEM;
+		}
+		index->offsets = p;
+		index->offsets_size = n_offsets;
+	}
+	if (n_items > index->items_size) {
+		p = realloc(index->items, n_items * sizeof(LCUI_Widget));
+		if (!p) {
+			return -ENOMEM;
+		}
+		index->items = p;
+		index->items_size = n_items;
+	}
+	return 0;
+}
+
+static void HitIndex_Build(LCUI_WidgetHitIndex index, LCUI_Widget w)
+{
+	int col, row, col1, row1, col2, row2;
+	size_t i, n = 0, count = 0, cells;
+	float x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+	LCUI_Widget child;
+	LCUI_RectF *rect;
+	LinkedListNode *node;
+
+	index->dirty = FALSE;
+	index->usable = FALSE;
+	for (LinkedList_Each(node, &w->children_show)) {
+		child = node->data;
+		rect = &child->box.border;
+		if (rect->width <= 0 || rect->height <= 0) {
+			continue;
+		}
+		if (n == 0 || rect->x < x1) {
+			x1 = rect->x;
+		}
+		if (n == 0 || rect->y < y1) {
+			y1 = rect->y;
+		}
+		if (n == 0 || rect->x + rect->width > x2) {
+			x2 = rect->x + rect->width;
+		}
+		if (n == 0 || rect->y + rect->height > y2) {
+			y2 = rect->y + rect->height;
+		}
+		++n;
+	}
+	/* 让格子的数量与子部件数量相当，格子的形状尽量接近正方形 */
+	index->x = x1;
+	index->y = y1;
+	index->cols = 1;
+	index->rows = 1;
+	if (n > 0 && x2 > x1 && y2 > y1) {
+		index->cols = (int)(sqrt(n * (x2 - x1) / (y2 - y1)) + 0.5);
+		index->cols = max(1, min(index->cols, HIT_INDEX_MAX_CELLS));
+		index->rows = (int)((n + index->cols - 1) / index->cols);
+		index->rows = max(1, min(index->rows, HIT_INDEX_MAX_CELLS));
+	}
+	index->cell_width = max((x2 - x1) / index->cols, 1.0f);
+	index->cell_height = max((y2 - y1) / index->rows, 1.0f);
+	cells = (size_t)index->cols * index->rows;
+	if (HitIndex_Reserve(index, cells + 2, 0) != 0) {
+		return;
+	}
+	memset(index->offsets, 0, (cells + 2) * sizeof(size_t));
+	/* 先统计每个格子中的子部件数量，第 i 个格子的数量记在 offsets[i + 2] */
+	for (LinkedList_Each(node, &w->children_show)) {
+		if (!HitIndex_GetSpan(index, node->data, &col1, &row1, &col2,
+				      &row2)) {
+			continue;
+		}
+		count += (size_t)(col2 - col1 + 1) * (row2 - row1 + 1);
+		for (row = row1; row <= row2; ++row) {
+			for (col = col1; col <= col2; ++col) {
+				index->offsets[row * index->cols + col + 2]++;
+			}
+		}
+	}
+	if (count > n * HIT_INDEX_MAX_SPAN + cells) {
+		return;
+	}
+	if (HitIndex_Reserve(index, 0, count) != 0) {
+		return;
+	}
+	for (i = 2; i <= cells + 1; ++i) {
+		index->offsets[i] += index->offsets[i - 1];
+	}
+	/*
+	 * 累加后 offsets[i + 1] 是第 i 个格子的起始位置，按堆叠顺序填充时将它用作写
+	 * 入位置，填充完后它就变成了第 i 个格子的结束位置，即第 i + 1 个格子的起始
+	 * 位置
+	 */
+	for (LinkedList_Each(node, &w->children_show)) {
+		child = node->data;
+		if (!HitIndex_GetSpan(index, child, &col1, &row1, &col2,
+				      &row2)) {
+			continue;
+		}
+		for (row = row1; row <= row2; ++row) {
+			for (col = col1; col <= col2; ++col) {
+				i = row * index->cols + col;
+				index->items[index->offsets[i + 1]++] = child;
+			}
+		}
+	}
+	index->usable = TRUE;
+}
+
+void Widget_InvalidateHitIndex(LCUI_Widget w)
+{
+	if (w->hit_index) {
+		w->hit_index->dirty = TRUE;
+	}
+}
+
+void Widget_DestroyHitIndex(LCUI_Widget w)
+{
+	if (!w->hit_index) {
+		return;
+	}
+	free(w->hit_index->offsets);
+	free(w->hit_index->items);
+	LCUIWidget_FreeMemory(w->hit_index);
+	w->hit_index = NULL;
+}
+
+static LCUI_WidgetHitIndex Widget_GetHitIndex(LCUI_Widget w)
+{
+	if (w->children_show.length < HIT_INDEX_MIN_CHILDREN) {
+		return NULL;
+	}
+	if (!w->hit_index) {
+		w->hit_index = LCUIWidget_AllocMemory(
+		    sizeof(LCUI_WidgetHitIndexRec));
+		if (!w->hit_index) {
+			return NULL;
+		}
+		w->hit_index->dirty = TRUE;
+	}
+	if (w->hit_index->dirty) {
+		HitIndex_Build(w->hit_index, w);
+	}
+	return w->hit_index->usable ? w->hit_index : NULL;
+}
+
+LCUI_Widget Widget_GetNextChildAt(LCUI_WidgetHitIterator iter)
+{
+	LCUI_Widget child;
+
+	if (iter->items) {
+		while (iter->i < iter->length) {
+			child = iter->items[iter->i++];
+			if (LCUIRect_HasPoint(&child->box.border, iter->x,
+					      iter->y)) {
+				return child;
+			}
+		}
+		return NULL;
+	}
+	while (iter->node) {
+		child = iter->node->data;
+		iter->node = iter->node->next;
+		if (LCUIRect_HasPoint(&child->box.border, iter->x, iter->y)) {
+			return child;
+		}
+	}
+	return NULL;
+}
+
+LCUI_Widget Widget_GetFirstChildAt(LCUI_Widget w, float x, float y,
+				   LCUI_WidgetHitIterator iter)
+{
+	size_t cell;
+	LCUI_WidgetHitIndex index = Widget_GetHitIndex(w);
+
+	iter->x = x;
+	iter->y = y;
+	iter->node = NULL;
+	iter->items = NULL;
+	iter->length = 0;
+	iter->i = 0;
+	if (index) {
+		cell = (size_t)HitIndex_GetRow(index, y) * index->cols +
+		       HitIndex_GetCol(index, x);
+		iter->items = index->items + index->offsets[cell];
+		iter->length = index->offsets[cell + 1] - index->offsets[cell];
+	} else {
+		iter->node = LinkedList_GetNode(&w->children_show, 0);
+	}
+	return Widget_GetNextChildAt(iter);
+}
+
 LCUI_Widget Widget_At(LCUI_Widget widget, int ix, int iy)
 {
 	float x, y;
 	LCUI_BOOL is_hit;
-	LinkedListNode *node;
 	LCUI_Widget target = widget, c = NULL;
+	LCUI_WidgetHitIteratorRec iter;
 
 	if (!widget) {
 		return NULL;
@@ -317,18 +645,16 @@ LCUI_Widget Widget_At(LCUI_Widget widget, int ix, int iy)
 	y = 1.0f * iy;
 	do {
 		is_hit = FALSE;
-		for (LinkedList_Each(node, &target->children_show)) {
-			c = node->data;
+		c = Widget_GetFirstChildAt(target, x, y, &iter);
+		for (; c; c = Widget_GetNextChildAt(&iter)) {
 			if (!c->computed_style.visible) {
 				continue;
 			}
-			if (LCUIRect_HasPoint(&c->box.border, x, y)) {
-				target = c;
-				x -= c->box.padding.x;
-				y -= c->box.padding.y;
-				is_hit = TRUE;
-				break;
-			}
+			target = c;
+			x -= c->box.padding.x;
+			y -= c->box.padding.y;
+			is_hit = TRUE;
+			break;
 		}
 	} while (is_hit);
 	return target == widget ? NULL : target;
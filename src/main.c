@@ -135,6 +135,8 @@ static void LCUIProfile_Print(LCUI_Profile profile)
 		Logger_Debug("events.count: %zu\nevents.time: %ldms\n",
 			     frame->events_count, frame->events_time);
 		Logger_Debug("widget_tasks.time: %ldms\n"
+			     "widget_tasks.style_time: %ldus\n"
+			     "widget_tasks.layout_time: %ldus\n"
 			     "widget_tasks.update_count: %u\n"
 			     "widget_tasks.refresh_count: %u\n"
 			     "widget_tasks.layout_count: %u\n"
@@ -142,6 +144,8 @@ static void LCUIProfile_Print(LCUI_Profile profile)
 			     "widget_tasks.destroy_count: %u\n"
 			     "widget_tasks.destroy_time: %ldms\n",
 			     frame->widget_tasks.time,
+			     (long)frame->widget_tasks.style_time,
+			     (long)frame->widget_tasks.layout_time,
 			     frame->widget_tasks.update_count,
 			     frame->widget_tasks.refresh_count,
 			     frame->widget_tasks.layout_count,
@@ -182,6 +186,8 @@ static void LCUIProfile_EndFrame(LCUI_Profile profile)
 
 void LCUI_RunFrameWithProfile(LCUI_FrameProfile profile)
 {
+	int64_t t;
+
 	profile->timers_time = clock();
 	profile->timers_count = LCUI_ProcessTimers();
 	profile->timers_time = clock() - profile->timers_time;
@@ -190,23 +196,30 @@ void LCUI_RunFrameWithProfile(LCUI_FrameProfile profile)
 	profile->events_count = LCUI_ProcessEvents();
 	profile->events_time = clock() - profile->events_time;
 
+	LCUIFont_ProcessBitmapRequests();
 	LCUICursor_Update();
 	LCUIWidget_UpdateWithProfile(&profile->widget_tasks);
 
+	/* clock() 计的是进程的 CPU 时间，会包含各个绘制线程的耗时 */
+	t = LCUI_GetTimeUs();
 	profile->render_time = clock();
 	LCUIDisplay_Update();
 	profile->render_count = LCUIDisplay_Render();
 	profile->render_time = clock() - profile->render_time;
+	profile->render_wall_time = LCUI_GetTimeUs() - t;
 
+	t = LCUI_GetTimeUs();
 	profile->present_time = clock();
 	LCUIDisplay_Present();
 	profile->present_time = clock() - profile->present_time;
+	profile->present_wall_time = LCUI_GetTimeUs() - t;
 }
 
 void LCUI_RunFrame(void)
 {
 	LCUI_ProcessTimers();
 	LCUI_ProcessEvents();
+	LCUIFont_ProcessBitmapRequests();
 	LCUICursor_Update();
 	LCUIWidget_Update();
 	LCUIDisplay_Update();
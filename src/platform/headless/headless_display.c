@@ -0,0 +1,326 @@
+﻿/*
+ * headless_display.c -- In-memory display driver, no real screen needed
+ *
+ * Copyright (c) 2018, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LCUI_SURFACE_C
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/display.h>
+#include <LCUI/painter.h>
+#include <LCUI/image.h>
+
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+
+typedef struct LCUI_SurfaceRec_ {
+	int x, y;
+	int width, height;
+	LCUI_BOOL visible;
+	LCUI_Graph canvas;   /**< 帧缓存，所有内容都直接绘制在这里 */
+	LinkedListNode node; /**< 在表面列表中的结点 */
+} LCUI_SurfaceRec;
+
+static struct LCUI_HeadlessDisplay {
+	LCUI_BOOL active;
+	LinkedList surfaces;
+	size_t frame_count; /**< 已呈现的帧数 */
+	LCUI_BOOL presented; /**< 当前帧是否有 surface 呈现了内容 */
+	LCUI_EventTrigger trigger;
+} headless;
+
+static void HeadlessSurface_Destroy(LCUI_Surface surface)
+{
+	LinkedList_Unlink(&headless.surfaces, &surface->node);
+	Graph_Free(&surface->canvas);
+	free(surface);
+}
+
+static LCUI_Surface HeadlessSurface_New(void)
+{
+	LCUI_Surface surface;
+
+	surface = NEW(LCUI_SurfaceRec, 1);
+	surface->node.data = surface;
+	Graph_Init(&surface->canvas);
+	surface->canvas.color_type = LCUI_COLOR_TYPE_ARGB;
+	LinkedList_AppendNode(&headless.surfaces, &surface->node);
+	return surface;
+}
+
+static LCUI_BOOL HeadlessSurface_IsReady(LCUI_Surface surface)
+{
+	return TRUE;
+}
+
+static void HeadlessSurface_Move(LCUI_Surface surface, int x, int y)
+{
+	surface->x = x;
+	surface->y = y;
+}
+
+static void HeadlessSurface_Resize(LCUI_Surface surface, int width, int height)
+{
+	if (width == surface->width && height == surface->height) {
+		return;
+	}
+	surface->width = width;
+	surface->height = height;
+	if (width > 0 && height > 0) {
+		Graph_Create(&surface->canvas, width, height);
+	} else {
+		Graph_Free(&surface->canvas);
+	}
+}
+
+static void HeadlessSurface_Show(LCUI_Surface surface)
+{
+	surface->visible = TRUE;
+}
+
+static void HeadlessSurface_Hide(LCUI_Surface surface)
+{
+	surface->visible = FALSE;
+}
+
+static void HeadlessSurface_Update(LCUI_Surface surface)
+{
+}
+
+static void HeadlessSurface_Present(LCUI_Surface surface)
+{
+	/* 一帧内可能会呈现多个 surface，帧数在每帧结束后统一计算 */
+	headless.presented = TRUE;
+}
+
+static LCUI_PaintContext HeadlessSurface_BeginPaint(LCUI_Surface surface,
+						    LCUI_Rect *rect)
+{
+	LCUI_Rect actual_rect = *rect;
+	LCUI_PaintContext paint;
+
+	LCUIRect_ValidateArea(&actual_rect, surface->width, surface->height);
+	if (actual_rect.width < 1 || actual_rect.height < 1) {
+		return NULL;
+	}
+	/* Dirty rectangles do not overlap, so that they can be painted in
+	 * parallel without locking the canvas */
+	paint = LCUIPainter_Begin(&surface->canvas, &actual_rect);
+	return paint;
+}
+
+static void HeadlessSurface_EndPaint(LCUI_Surface surface,
+				     LCUI_PaintContext paint)
+{
+	LCUIPainter_End(paint);
+}
+
+static void HeadlessSurface_SetCaptionW(LCUI_Surface surface,
+					const wchar_t *wstr)
+{
+}
+
+static void HeadlessSurface_SetRenderMode(LCUI_Surface surface, int mode)
+{
+}
+
+static void HeadlessSurface_SetOpacity(LCUI_Surface surface, float opacity)
+{
+}
+
+static void *HeadlessSurface_GetHandle(LCUI_Surface surface)
+{
+	return surface;
+}
+
+static int HeadlessSurface_GetWidth(LCUI_Surface surface)
+{
+	return surface->width;
+}
+
+static int HeadlessSurface_GetHeight(LCUI_Surface surface)
+{
+	return surface->height;
+}
+
+static int HeadlessDisplay_GetWidth(void)
+{
+	return SCREEN_WIDTH;
+}
+
+static int HeadlessDisplay_GetHeight(void)
+{
+	return SCREEN_HEIGHT;
+}
+
+static int HeadlessDisplay_BindEvent(int event_id, LCUI_EventFunc func,
+				     void *data, void (*destroy_data)(void *))
+{
+	return EventTrigger_Bind(headless.trigger, event_id, func, data,
+				 destroy_data);
+}
+
+static void OnDestroySurface(void *data)
+{
+	LCUI_Surface surface = data;
+
+	Graph_Free(&surface->canvas);
+	free(surface);
+}
+
+static LCUI_Surface HeadlessDisplay_GetSurface(LCUI_Surface surface)
+{
+	if (surface) {
+		return surface;
+	}
+	surface = LCUIDisplay_GetSurfaceOwner(LCUIWidget_GetRoot());
+	if (surface) {
+		return surface;
+	}
+	return LinkedList_Get(&headless.surfaces, 0);
+}
+
+LCUI_Graph *LCUIHeadlessDisplay_GetCanvas(LCUI_Surface surface)
+{
+	if (!headless.active) {
+		return NULL;
+	}
+	surface = HeadlessDisplay_GetSurface(surface);
+	if (!surface) {
+		return NULL;
+	}
+	return &surface->canvas;
+}
+
+size_t LCUIHeadlessDisplay_StepFrames(int frames)
+{
+	size_t count = headless.frame_count;
+
+	for (; frames > 0; --frames) {
+		headless.presented = FALSE;
+		LCUI_RunFrame();
+		if (headless.presented) {
+			headless.frame_count += 1;
+		}
+	}
+	return headless.frame_count - count;
+}
+
+int LCUIHeadlessDisplay_WritePNG(LCUI_Surface surface, const char *filename)
+{
+	LCUI_Graph *canvas = LCUIHeadlessDisplay_GetCanvas(surface);
+
+	if (!canvas || !Graph_IsValid(canvas)) {
+		return -1;
+	}
+	return LCUI_WritePNGFile(filename, canvas);
+}
+
+uint32_t LCUIHeadlessDisplay_GetChecksum(LCUI_Surface surface,
+					 const LCUI_Rect *rect)
+{
+	unsigned x, y;
+	uint32_t hash = 2166136261u;
+	const LCUI_ARGB *px;
+	LCUI_Graph quote;
+	LCUI_Graph *canvas = LCUIHeadlessDisplay_GetCanvas(surface);
+
+	if (!canvas || !Graph_IsValid(canvas)) {
+		return 0;
+	}
+	Graph_Init(&quote);
+	if (Graph_QuoteReadOnly(&quote, canvas, rect) != 0) {
+		return 0;
+	}
+	/* FNV-1a over the pixels in row order, stable across platforms */
+	for (y = 0; y < quote.height; ++y) {
+		px = Graph_GetPixelPointer(canvas, quote.quote.left,
+					   quote.quote.top + y);
+		for (x = 0; x < quote.width; ++x, ++px) {
+			hash = (hash ^ px->b) * 16777619u;
+			hash = (hash ^ px->g) * 16777619u;
+			hash = (hash ^ px->r) * 16777619u;
+			hash = (hash ^ px->a) * 16777619u;
+		}
+	}
+	return hash;
+}
+
+LCUI_DisplayDriver LCUI_CreateHeadlessDisplayDriver(void)
+{
+	LCUI_DisplayDriver driver;
+
+	if (headless.active) {
+		return NULL;
+	}
+	driver = NEW(LCUI_DisplayDriverRec, 1);
+	if (!driver) {
+		return NULL;
+	}
+	strcpy(driver->name, "headless");
+	driver->getWidth = HeadlessDisplay_GetWidth;
+	driver->getHeight = HeadlessDisplay_GetHeight;
+	driver->create = HeadlessSurface_New;
+	driver->destroy = HeadlessSurface_Destroy;
+	driver->close = HeadlessSurface_Destroy;
+	driver->isReady = HeadlessSurface_IsReady;
+	driver->show = HeadlessSurface_Show;
+	driver->hide = HeadlessSurface_Hide;
+	driver->move = HeadlessSurface_Move;
+	driver->resize = HeadlessSurface_Resize;
+	driver->update = HeadlessSurface_Update;
+	driver->present = HeadlessSurface_Present;
+	driver->setCaptionW = HeadlessSurface_SetCaptionW;
+	driver->setRenderMode = HeadlessSurface_SetRenderMode;
+	driver->setOpacity = HeadlessSurface_SetOpacity;
+	driver->getHandle = HeadlessSurface_GetHandle;
+	driver->getSurfaceWidth = HeadlessSurface_GetWidth;
+	driver->getSurfaceHeight = HeadlessSurface_GetHeight;
+	driver->beginPaint = HeadlessSurface_BeginPaint;
+	driver->endPaint = HeadlessSurface_EndPaint;
+	driver->bindEvent = HeadlessDisplay_BindEvent;
+	LinkedList_Init(&headless.surfaces);
+	headless.trigger = EventTrigger();
+	headless.frame_count = 0;
+	headless.presented = FALSE;
+	headless.active = TRUE;
+	return driver;
+}
+
+void LCUI_DestroyHeadlessDisplayDriver(LCUI_DisplayDriver driver)
+{
+	headless.active = FALSE;
+	LinkedList_ClearData(&headless.surfaces, OnDestroySurface);
+	EventTrigger_Destroy(headless.trigger);
+	headless.trigger = NULL;
+	free(driver);
+}
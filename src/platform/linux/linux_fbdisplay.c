@@ -53,8 +53,21 @@
 #define MIN_WIDTH 320
 #define MIN_HEIGHT 240
 
+/** 行在这一帧中有变化 */
+#define FB_DAMAGE_CURRENT 1
+
+/** 行在上一帧中有变化 */
+#define FB_DAMAGE_PREVIOUS 2
+
 enum SurfaceTaskType { TASK_RESIZE, TASK_DELETE, TASK_TOTAL_NUM };
 
+/**
+ * 帧缓冲的缓冲模式
+ * 画面都先写到内存中的影子缓冲里。双缓冲模式下，有变化的行被复制到后台页，
+ * 然后平移显示区域来切换页；影子缓冲模式下，有变化的行直接复制到显存中。
+ */
+enum FrameBufferMode { FB_MODE_SHADOW, FB_MODE_PAGE_FLIP };
+
 typedef struct LCUI_SurfaceTaskRec_ {
 	LCUI_BOOL is_valid;
 	struct {
@@ -85,9 +98,21 @@ static struct LCUI_DisplayModule {
 		unsigned char *mem;
 		size_t mem_len;
 
+		enum FrameBufferMode mode;
+		unsigned front;		/**< 当前显示的页 */
+		size_t page_size;	/**< 每页画面占用的字节数 */
+		LCUI_BOOL vsync;	/**< 是否支持等待垂直同步 */
+		unsigned char *damage;	/**< 每一行的变化标记 */
+
+		/** 将 ARGB 像素行转换为设备的像素格式 */
+		LCUI_PixelRowConverter convert;
+		unsigned bytes_per_pixel;
+
 		struct fb_var_screeninfo var_info;
+		struct fb_var_screeninfo orig_var_info;
 		struct fb_fix_screeninfo fix_info;
 		struct fb_cmap cmap;
+		__u16 cmap_buf[256 * 3];
 	} fb;
 
 	unsigned width;
@@ -101,6 +126,16 @@ static struct LCUI_DisplayModule {
 	LCUI_EventTrigger trigger;
 } display;
 
+static LCUI_FrameBufferIoctl fb_ioctl;
+
+static int FBDevice_Ioctl(unsigned long request, void *arg)
+{
+	if (fb_ioctl) {
+		return fb_ioctl(display.fb.dev_fd, request, arg);
+	}
+	return ioctl(display.fb.dev_fd, request, arg);
+}
+
 static void FBSurface_OnResize(LCUI_Surface s, int width, int height)
 {
 	s->width = width;
@@ -197,7 +232,6 @@ static LCUI_PaintContext FBSurface_BeginPaint(LCUI_Surface surface,
 	actual_rect.x -= surface->rect.x;
 	actual_rect.y -= surface->rect.y;
 	paint = LCUIPainter_Begin(&surface->canvas, &actual_rect);
-	Graph_FillRect(&paint->canvas, RGB(255, 255, 255), NULL, TRUE);
 	RectList_Add(&surface->rects, rect);
 	return paint;
 }
@@ -207,118 +241,131 @@ static void FBSurface_EndPaint(LCUI_Surface surface, LCUI_PaintContext paint)
 	LCUIPainter_End(paint);
 }
 
-static void FBDisplay_SyncRect16(LCUI_Graph *canvas, int x, int y)
-{
-	uint32_t iy, ix;
-	LCUI_Rect rect;
-	LCUI_ARGB *pixel, *pixel_row;
-	unsigned char *dst, *dst_row;
-
-	Graph_GetValidRect(canvas, &rect);
-	pixel_row = canvas->argb + rect.y * canvas->width + rect.x;
-	dst_row = display.fb.mem + y * display.canvas.bytes_per_row + x * 2;
-	for (iy = 0; iy < rect.width; ++iy) {
-		dst = dst_row;
-		pixel = pixel_row;
-		for (ix = 0; ix < rect.width; ++ix) {
-			dst[0] = (pixel->r & 0xF8) | (pixel->b >> 5);
-			dst[1] = ((pixel->g & 0x1C) << 3) | (pixel->b >> 3);
-		}
-		pixel_row += canvas->width;
-		dst_row += display.canvas.bytes_per_row;
-	}
-}
-
-static void FBDisplay_SyncRect8(LCUI_Graph *canvas, int x, int y)
-{
-	uint32_t ix, iy;
-	LCUI_Rect rect;
-	LCUI_ARGB *pixel, *pixel_row;
-	unsigned char *dst, *dst_row;
-	unsigned int r, g, b, i;
-	struct fb_cmap cmap;
-	__u16 cmap_buf[256 * 3] = { 0 };
-
-	cmap.start = 0;
-	cmap.len = 255;
-	cmap.transp = 0;
-	cmap.red = cmap_buf;
-	cmap.green = cmap_buf + 256;
-	cmap.blue = cmap_buf + 512;
-
-	Graph_GetValidRect(canvas, &rect);
-	pixel_row = canvas->argb + rect.y * canvas->width + rect.x;
-	dst_row = display.fb.mem + y * display.canvas.bytes_per_row + x;
-	for (iy = 0; iy < rect.height; ++iy) {
-		dst = dst_row;
-		pixel = pixel_row;
-		for (ix = 0; ix < rect.width; ++ix, ++dst) {
-			r = pixel->r * 0.92;
-			g = pixel->g * 0.92;
-			b = pixel->b * 0.92;
-
-			i = ((r & 0xc0)) + ((g & 0xf0) >> 2) +
-			    ((b & 0xc0) >> 6);
-
-			cmap.red[i] = r * 256;
-			cmap.green[i] = g * 256;
-			cmap.blue[i] = b * 256;
-			*dst = (((r & 0xc0)) + ((g & 0xf0) >> 2) +
-				((b & 0xc0) >> 6));
-		}
-		pixel_row += canvas->width;
-		dst_row += display.canvas.bytes_per_row;
-	}
-	ioctl(display.fb.dev_fd, FBIOPUTCMAP, &cmap);
-}
-
-static void FBDisplay_SyncRect24(LCUI_Graph *canvas, int x, int y)
-{
-	Graph_Replace(&display.canvas, canvas, x, y);
-}
-
-#include <LCUI/image.h>
-
-static void FBDisplay_SyncRect32(LCUI_Graph *canvas, int x, int y)
-{
-	Graph_Replace(&display.canvas, canvas, x, y);
-}
-
 static void FBDisplay_SyncRect(LCUI_Surface surface, LCUI_Rect *rect)
 {
-	int x, y;
+	int x, y, iy;
 	LCUI_Graph canvas;
 	LCUI_Rect actual_rect;
+	LCUI_ARGB *src;
+	unsigned char *dst;
+
+	if (!display.fb.convert) {
+		return;
+	}
 	/* Get actual write rectangle */
 	actual_rect.x = rect->x + surface->x;
 	actual_rect.y = rect->y + surface->y;
 	actual_rect.width = rect->width;
 	actual_rect.height = rect->height;
 	LCUIRect_ValidateArea(&actual_rect, display.width, display.height);
+	if (actual_rect.width <= 0 || actual_rect.height <= 0) {
+		return;
+	}
 	/* Convert this rectangle to surface canvas related rectangle */
 	x = actual_rect.x;
 	y = actual_rect.y;
 	actual_rect.x -= surface->x;
 	actual_rect.y -= surface->y;
 	Graph_Init(&canvas);
-	/* Use this rectangle as a canvas rectangle to write pixels */
 	Graph_Quote(&canvas, &surface->canvas, &actual_rect);
+	Graph_GetValidRect(&canvas, &actual_rect);
+	memset(display.fb.damage + y, FB_DAMAGE_CURRENT, actual_rect.height);
 	/* Write pixels to the framebuffer by pixel format */
-	switch (display.fb.var_info.bits_per_pixel) {
-	case 32:
-		FBDisplay_SyncRect32(&canvas, x, y);
-		break;
-	case 24:
-		FBDisplay_SyncRect24(&canvas, x, y);
-		break;
-	case 16:
-		FBDisplay_SyncRect16(&canvas, x, y);
-		break;
-	case 8:
-		FBDisplay_SyncRect8(&canvas, x, y);
-		break;
-	default:
-		break;
+	src = surface->canvas.argb + actual_rect.y * surface->canvas.width +
+	      actual_rect.x;
+	dst = display.canvas.bytes + y * display.canvas.bytes_per_row +
+	      x * display.fb.bytes_per_pixel;
+	for (iy = 0; iy < actual_rect.height; ++iy) {
+		display.fb.convert(dst, src, actual_rect.width, x, y + iy);
+		src += surface->canvas.width;
+		dst += display.canvas.bytes_per_row;
+	}
+}
+
+static unsigned char *FBDisplay_GetPage(unsigned page)
+{
+	return display.fb.mem + page * display.fb.page_size;
+}
+
+static void FBDisplay_WaitVSync(void)
+{
+#ifdef FBIO_WAITFORVSYNC
+	__u32 crtc = 0;
+
+	if (display.fb.vsync &&
+	    FBDevice_Ioctl(FBIO_WAITFORVSYNC, &crtc) != 0) {
+		display.fb.vsync = FALSE;
+	}
+#endif
+}
+
+/** 将带有指定标记的行从影子缓冲复制到显存，连续的行一次复制 */
+static void FBDisplay_CopyRows(unsigned char *dst, unsigned char mask)
+{
+	size_t offset;
+	unsigned y, start;
+	size_t row_size = display.canvas.bytes_per_row;
+
+	for (y = 0; y < display.height;) {
+		if (!(display.fb.damage[y] & mask)) {
+			++y;
+			continue;
+		}
+		for (start = y; y < display.height; ++y) {
+			if (!(display.fb.damage[y] & mask)) {
+				break;
+			}
+		}
+		offset = start * row_size;
+		memcpy(dst + offset, display.canvas.bytes + offset,
+		       (y - start) * row_size);
+	}
+}
+
+/**
+ * 切换到后台页
+ * 后台页上的画面停留在两帧之前，所以上一帧和这一帧中有变化的行都需要复制
+ */
+static void FBDisplay_Flip(void)
+{
+	unsigned back = !display.fb.front;
+	struct fb_var_screeninfo var = display.fb.var_info;
+
+	FBDisplay_CopyRows(FBDisplay_GetPage(back),
+			   FB_DAMAGE_CURRENT | FB_DAMAGE_PREVIOUS);
+	var.xoffset = 0;
+	var.yoffset = back * var.yres;
+	if (FBDevice_Ioctl(FBIOPAN_DISPLAY, &var) != 0) {
+		Logger_Warning("[display] framebuffer panning failed, "
+			       "fall back to shadow buffer\n");
+		display.fb.mode = FB_MODE_SHADOW;
+		memset(display.fb.damage, FB_DAMAGE_CURRENT, display.height);
+		FBDisplay_CopyRows(FBDisplay_GetPage(display.fb.front),
+				   FB_DAMAGE_CURRENT);
+		return;
+	}
+	display.fb.var_info.yoffset = var.yoffset;
+	display.fb.front = back;
+	FBDisplay_WaitVSync();
+}
+
+static void FBDisplay_Flush(void)
+{
+	unsigned y;
+
+	if (display.fb.mode == FB_MODE_PAGE_FLIP) {
+		FBDisplay_Flip();
+	} else {
+		FBDisplay_WaitVSync();
+		FBDisplay_CopyRows(FBDisplay_GetPage(display.fb.front),
+				   FB_DAMAGE_CURRENT);
+	}
+	for (y = 0; y < display.height; ++y) {
+		if (display.fb.damage[y] & FB_DAMAGE_CURRENT) {
+			display.fb.damage[y] = FB_DAMAGE_PREVIOUS;
+		} else {
+			display.fb.damage[y] = 0;
+		}
 	}
 }
 
@@ -326,10 +373,15 @@ static void FBSurface_Present(LCUI_Surface surface)
 {
 	LinkedListNode *node;
 	LCUIMutex_Lock(&surface->mutex);
+	if (surface->rects.length < 1) {
+		LCUIMutex_Unlock(&surface->mutex);
+		return;
+	}
 	for (LinkedList_Each(node, &surface->rects)) {
 		FBDisplay_SyncRect(surface, node->data);
 	}
 	LinkedList_Clear(&surface->rects, free);
+	FBDisplay_Flush();
 	LCUIMutex_Unlock(&surface->mutex);
 }
 
@@ -439,13 +491,86 @@ static void FBDisplay_PrintInfo(void)
 	    display.fb.var_info.transp.offset);
 }
 
+/**
+ * 选择缓冲模式
+ * 如果显存能容纳两页画面并且设备支持平移显示区域，则使用双缓冲，否则使用
+ * 影子缓冲。
+ */
+static void FBDisplay_InitBuffers(void)
+{
+#ifdef FBIO_WAITFORVSYNC
+	__u32 crtc = 0;
+#endif
+	struct fb_var_screeninfo var = display.fb.var_info;
+	size_t page_size =
+	    display.fb.fix_info.line_length * display.fb.var_info.yres;
+
+	display.fb.mode = FB_MODE_SHADOW;
+	display.fb.front = 0;
+	display.fb.vsync = FALSE;
+	if (display.fb.fix_info.ypanstep > 0 &&
+	    display.fb.fix_info.smem_len >= page_size * 2) {
+		var.yres_virtual = var.yres * 2;
+		var.xoffset = 0;
+		var.yoffset = 0;
+		if (FBDevice_Ioctl(FBIOPUT_VSCREENINFO, &var) == 0 &&
+		    FBDevice_Ioctl(FBIOGET_VSCREENINFO, &var) == 0 &&
+		    FBDevice_Ioctl(FBIOGET_FSCREENINFO,
+				   &display.fb.fix_info) == 0 &&
+		    var.yres_virtual >= var.yres * 2) {
+			display.fb.var_info = var;
+			display.fb.mode = FB_MODE_PAGE_FLIP;
+		}
+	}
+	display.fb.page_size =
+	    display.fb.fix_info.line_length * display.fb.var_info.yres;
+#ifdef FBIO_WAITFORVSYNC
+	display.fb.vsync = FBDevice_Ioctl(FBIO_WAITFORVSYNC, &crtc) == 0;
+#endif
+	Logger_Debug("[display] framebuffer mode: %s, vsync: %s\n",
+		     display.fb.mode == FB_MODE_PAGE_FLIP ? "page flip"
+							  : "shadow buffer",
+		     display.fb.vsync ? "yes" : "no");
+}
+
+/** 设置 INDEX8 格式的调色板，原来的调色板会在释放驱动时恢复 */
+static void FBDisplay_InitPalette(void)
+{
+	unsigned i;
+	LCUI_Color color;
+	struct fb_cmap cmap;
+	__u16 cmap_buf[256 * 3];
+
+	display.fb.cmap.start = 0;
+	display.fb.cmap.len = 256;
+	display.fb.cmap.red = display.fb.cmap_buf;
+	display.fb.cmap.green = display.fb.cmap_buf + 256;
+	display.fb.cmap.blue = display.fb.cmap_buf + 512;
+	display.fb.cmap.transp = NULL;
+	FBDevice_Ioctl(FBIOGETCMAP, &display.fb.cmap);
+	cmap = display.fb.cmap;
+	cmap.red = cmap_buf;
+	cmap.green = cmap_buf + 256;
+	cmap.blue = cmap_buf + 512;
+	for (i = 0; i < 256; ++i) {
+		color = LCUI_GetIndex8Color((uchar_t)i);
+		cmap.red[i] = color.r * 257;
+		cmap.green[i] = color.g * 257;
+		cmap.blue[i] = color.b * 257;
+	}
+	FBDevice_Ioctl(FBIOPUTCMAP, &cmap);
+}
+
 static void FBDisplay_InitCanvas(void)
 {
+	int flags = 0;
+
 	display.canvas.width = display.width;
 	display.canvas.height = display.height;
-	display.canvas.bytes = display.fb.mem;
+	display.canvas.bytes = calloc(display.fb.page_size, 1);
 	display.canvas.bytes_per_row = display.fb.fix_info.line_length;
-	display.canvas.mem_size = display.fb.mem_len;
+	display.canvas.mem_size = display.fb.page_size;
+	display.fb.damage = calloc(display.height, 1);
 	switch (display.fb.var_info.bits_per_pixel) {
 	case 32:
 		display.canvas.color_type = LCUI_COLOR_TYPE_ARGB8888;
@@ -453,12 +578,27 @@ static void FBDisplay_InitCanvas(void)
 	case 24:
 		display.canvas.color_type = LCUI_COLOR_TYPE_RGB888;
 		break;
+	case 16:
+		display.canvas.color_type = LCUI_COLOR_TYPE_RGB565;
+		break;
 	case 8:
-		ioctl(display.fb.dev_fd, FBIOGETCMAP, &display.fb.cmap);
-	default:
+		display.canvas.color_type = LCUI_COLOR_TYPE_INDEX8;
+		FBDisplay_InitPalette();
 		break;
+	default:
+		Logger_Warning("[display] unsupported pixel format: %u bpp\n",
+			       display.fb.var_info.bits_per_pixel);
+		display.fb.convert = NULL;
+		memset(display.fb.mem, 0, display.fb.mem_len);
+		return;
+	}
+	if (getenv("LCUI_FRAMEBUFFER_DITHER")) {
+		flags |= LCUI_PIXEL_CONVERT_DITHER;
 	}
-	memset(display.canvas.bytes, 0, display.canvas.mem_size);
+	display.fb.bytes_per_pixel = display.fb.var_info.bits_per_pixel / 8;
+	display.fb.convert =
+	    LCUI_GetPixelRowConverter(display.canvas.color_type, flags);
+	memset(display.fb.mem, 0, display.fb.mem_len);
 }
 
 static void FBDisplay_InitSurface(void)
@@ -485,15 +625,22 @@ static int FBDisplay_Init(void)
 		Logger_Error("[display] open framebuffer device failed");
 		return -1;
 	}
-	ioctl(display.fb.dev_fd, FBIOGET_VSCREENINFO, &display.fb.var_info);
-	ioctl(display.fb.dev_fd, FBIOGET_FSCREENINFO, &display.fb.fix_info);
+	if (FBDevice_Ioctl(FBIOGET_VSCREENINFO, &display.fb.var_info) != 0 ||
+	    FBDevice_Ioctl(FBIOGET_FSCREENINFO, &display.fb.fix_info) != 0) {
+		Logger_Error("[display] get framebuffer screen info failed");
+		close(display.fb.dev_fd);
+		return -1;
+	}
+	display.fb.orig_var_info = display.fb.var_info;
 	display.width = display.fb.var_info.xres;
 	display.height = display.fb.var_info.yres;
+	FBDisplay_InitBuffers();
 	display.fb.mem_len = display.fb.fix_info.smem_len;
 	display.fb.mem = mmap(NULL, display.fb.mem_len, PROT_READ | PROT_WRITE,
 			      MAP_SHARED, display.fb.dev_fd, 0);
 	if ((void *)-1 == display.fb.mem) {
 		Logger_Error("[display] framebuffer mmap failed");
+		close(display.fb.dev_fd);
 		return -1;
 	}
 	FBDisplay_PrintInfo();
@@ -540,11 +687,21 @@ void LCUI_DestroyLinuxFBDisplayDriver(LCUI_DisplayDriver driver)
 	}
 	switch (display.fb.var_info.bits_per_pixel) {
 	case 8:
-		ioctl(display.fb.dev_fd, FBIOPUTCMAP, &display.fb.cmap);
+		FBDevice_Ioctl(FBIOPUTCMAP, &display.fb.cmap);
 	default:
 		Graph_Free(&display.surface.canvas);
 		break;
 	}
+	/* Restore the virtual resolution and show the first page again */
+	if (display.fb.var_info.yres_virtual !=
+		display.fb.orig_var_info.yres_virtual ||
+	    display.fb.var_info.yoffset != display.fb.orig_var_info.yoffset) {
+		FBDevice_Ioctl(FBIOPUT_VSCREENINFO, &display.fb.orig_var_info);
+	}
+	free(display.canvas.bytes);
+	free(display.fb.damage);
+	display.canvas.bytes = NULL;
+	display.fb.damage = NULL;
 	EventTrigger_Destroy(display.trigger);
 	close(display.fb.dev_fd);
 	free(driver);
@@ -553,4 +710,9 @@ void LCUI_DestroyLinuxFBDisplayDriver(LCUI_DisplayDriver driver)
 	display.active = FALSE;
 }
 
+void LCUI_SetLinuxFBDeviceIoctl(LCUI_FrameBufferIoctl func)
+{
+	fb_ioctl = func;
+}
+
 #endif
@@ -242,7 +242,6 @@ static LCUI_PaintContext UWPSurface_BeginPaint(LCUI_Surface surface,
 	LCUIRect_ValidateArea(&paint->rect, UWPDisplay_GetWidth(),
 			      UWPDisplay_GetHeight());
 	Graph_Quote(&paint->canvas, &display.frame, &paint->rect);
-	Graph_FillRect(&paint->canvas, RGB(255, 255, 255), NULL, TRUE);
 	return paint;
 }
 
@@ -0,0 +1,616 @@
+﻿/*
+ * resample.c -- Separable image resampling
+ *
+ * Copyright (c) 2018, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The resampler works in two passes: every needed source row is first
+ * filtered horizontally into a temporary buffer, then every output row is
+ * filtered vertically from that buffer. Filter weights are computed once per
+ * output column and per output row and stored as 14-bit fixed point numbers,
+ * so that the inner loops only do integer multiply-adds and can be mapped
+ * directly onto SSE2 (pmaddwd) and AVX2 instructions.
+ */
+
+#include "config.h"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/types.h>
+#include <LCUI/util.h>
+#include <LCUI/graph.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLE_WITH_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RESAMPLE_WITH_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define WEIGHT_BITS 14
+#define WEIGHT_ONE (1 << WEIGHT_BITS)
+#define WEIGHT_ROUND (1 << (WEIGHT_BITS - 1))
+
+/** Images smaller than this are not worth splitting into row bands */
+#define PARALLEL_MIN_PIXELS (128 * 128)
+
+typedef struct ResampleFilterRec_ {
+	double support;
+	double (*func)(double);
+} ResampleFilterRec, *ResampleFilter;
+
+/** Filter weight table for one axis */
+typedef struct ResampleTableRec_ {
+	int size;         /**< number of output pixels */
+	int taps;         /**< max number of source pixels per output pixel */
+	int *bounds;      /**< (first source pixel, count) pairs */
+	short *weights;   /**< size * taps fixed point weights */
+	LCUI_BOOL is_identity;
+} ResampleTableRec, *ResampleTable;
+
+typedef void (*ResampleRowFunc)(uchar_t *, const uchar_t *, size_t,
+				const short *, int, int);
+
+static double BoxFilter(double x)
+{
+	if (x > -0.5 && x <= 0.5) {
+		return 1.0;
+	}
+	return 0.0;
+}
+
+static double TriangleFilter(double x)
+{
+	if (x < 0.0) {
+		x = -x;
+	}
+	if (x < 1.0) {
+		return 1.0 - x;
+	}
+	return 0.0;
+}
+
+static double Sinc(double x)
+{
+	if (x == 0.0) {
+		return 1.0;
+	}
+	x *= M_PI;
+	return sin(x) / x;
+}
+
+static double Lanczos3Filter(double x)
+{
+	if (x > -3.0 && x < 3.0) {
+		return Sinc(x) * Sinc(x / 3.0);
+	}
+	return 0.0;
+}
+
+static ResampleFilterRec resample_filters[] = {
+	{ 0.0, NULL },
+	{ 1.0, TriangleFilter },
+	{ 0.5, BoxFilter },
+	{ 3.0, Lanczos3Filter }
+};
+
+static void ResampleTable_Destroy(ResampleTable table)
+{
+	free(table->bounds);
+	free(table->weights);
+	table->bounds = NULL;
+	table->weights = NULL;
+}
+
+static int ResampleTable_Init(ResampleTable table, ResampleFilter filter,
+			      int src_size, int dst_size, double scale)
+{
+	int i, k, start, end, count, sum, max_k;
+	double center, support, filter_scale, total;
+	double *values;
+	short *weights;
+
+	filter_scale = scale < 1.0 ? 1.0 : scale;
+	support = filter->support * filter_scale;
+	table->size = dst_size;
+	table->taps = (int)ceil(support) * 2 + 1;
+	table->is_identity = src_size == dst_size && scale == 1.0;
+	table->bounds = malloc(sizeof(int) * 2 * dst_size);
+	table->weights = malloc(sizeof(short) * table->taps * dst_size);
+	values = malloc(sizeof(double) * table->taps);
+	if (!table->bounds || !table->weights || !values) {
+		ResampleTable_Destroy(table);
+		free(values);
+		return -ENOMEM;
+	}
+	for (i = 0; i < dst_size; ++i) {
+		center = (i + 0.5) * scale;
+		start = (int)(center - support + 0.5);
+		end = (int)(center + support + 0.5);
+		start = max(start, 0);
+		end = min(end, src_size);
+		count = min(end - start, table->taps);
+		weights = table->weights + i * table->taps;
+		for (total = 0, k = 0; k < count; ++k) {
+			values[k] = filter->func((start + k - center + 0.5) /
+						 filter_scale);
+			total += values[k];
+		}
+		if (count <= 0 || total == 0.0) {
+			table->bounds[i * 2] = max(0, min(start, src_size - 1));
+			table->bounds[i * 2 + 1] = 1;
+			weights[0] = WEIGHT_ONE;
+			continue;
+		}
+		/* Quantize the normalized weights and give the rounding
+		 * error to the heaviest tap, so that a flat area stays flat */
+		for (sum = 0, max_k = 0, k = 0; k < count; ++k) {
+			weights[k] =
+			    (short)floor(values[k] / total * WEIGHT_ONE + 0.5);
+			sum += weights[k];
+			if (weights[k] > weights[max_k]) {
+				max_k = k;
+			}
+		}
+		weights[max_k] += (short)(WEIGHT_ONE - sum);
+		table->bounds[i * 2] = start;
+		table->bounds[i * 2 + 1] = count;
+	}
+	free(values);
+	return 0;
+}
+
+INLINE uchar_t ClampWeightedSum(int sum)
+{
+	sum >>= WEIGHT_BITS;
+	if (sum < 0) {
+		return 0;
+	}
+	if (sum > 255) {
+		return 255;
+	}
+	return (uchar_t)sum;
+}
+
+/*---------------------------- Scalar kernels -----------------------------*/
+
+static void ResampleRowHorizontal(uchar_t *dst, const uchar_t *src,
+				  ResampleTable table, int channels)
+{
+	int x, k, c, start, count;
+	int sum[4];
+	const short *weights;
+	const uchar_t *px;
+
+	for (x = 0; x < table->size; ++x) {
+		start = table->bounds[x * 2];
+		count = table->bounds[x * 2 + 1];
+		weights = table->weights + x * table->taps;
+		px = src + start * channels;
+		sum[0] = sum[1] = sum[2] = sum[3] = WEIGHT_ROUND;
+		for (k = 0; k < count; ++k) {
+			for (c = 0; c < channels; ++c) {
+				sum[c] += *px++ * weights[k];
+			}
+		}
+		for (c = 0; c < channels; ++c) {
+			*dst++ = ClampWeightedSum(sum[c]);
+		}
+	}
+}
+
+static void ResampleRowVertical(uchar_t *dst, const uchar_t *src,
+				size_t stride, const short *weights, int count,
+				int row_size)
+{
+	int i, k, sum;
+	const uchar_t *px;
+
+	for (i = 0; i < row_size; ++i) {
+		px = src + i;
+		sum = WEIGHT_ROUND;
+		for (k = 0; k < count; ++k) {
+			sum += *px * weights[k];
+			px += stride;
+		}
+		dst[i] = ClampWeightedSum(sum);
+	}
+}
+
+/*----------------------------- SIMD kernels ------------------------------*/
+
+#ifdef RESAMPLE_WITH_SSE2
+
+INLINE int PackWeights(short w0, short w1)
+{
+	return (int)((unsigned)(unsigned short)w0 |
+		     ((unsigned)(unsigned short)w1 << 16));
+}
+
+static void ResampleRowHorizontalARGB_SSE2(uchar_t *dst, const uchar_t *src,
+					   ResampleTable table)
+{
+	int x, k, start, count, value;
+	const short *weights;
+	const uchar_t *px;
+	__m128i zero = _mm_setzero_si128();
+	__m128i sum, pixels, w;
+
+	for (x = 0; x < table->size; ++x) {
+		start = table->bounds[x * 2];
+		count = table->bounds[x * 2 + 1];
+		weights = table->weights + x * table->taps;
+		px = src + start * 4;
+		sum = _mm_set1_epi32(WEIGHT_ROUND);
+		for (k = 0; k + 1 < count; k += 2, px += 8) {
+			/* [p0.b p0.g p0.r p0.a p1.b p1.g p1.r p1.a] =>
+			 * [p0.b p1.b p0.g p1.g p0.r p1.r p0.a p1.a] */
+			pixels = _mm_loadl_epi64((const __m128i *)px);
+			pixels = _mm_unpacklo_epi8(pixels, zero);
+			pixels = _mm_unpacklo_epi16(pixels,
+						    _mm_srli_si128(pixels, 8));
+			w = _mm_set1_epi32(
+			    PackWeights(weights[k], weights[k + 1]));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(pixels, w));
+		}
+		if (k < count) {
+			memcpy(&value, px, 4);
+			pixels = _mm_cvtsi32_si128(value);
+			pixels = _mm_unpacklo_epi8(pixels, zero);
+			pixels = _mm_unpacklo_epi16(pixels, zero);
+			w = _mm_set1_epi32(PackWeights(weights[k], 0));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(pixels, w));
+		}
+		sum = _mm_srai_epi32(sum, WEIGHT_BITS);
+		sum = _mm_packs_epi32(sum, sum);
+		sum = _mm_packus_epi16(sum, sum);
+		value = _mm_cvtsi128_si32(sum);
+		memcpy(dst, &value, 4);
+		dst += 4;
+	}
+}
+
+static void ResampleRowVertical_SSE2(uchar_t *dst, const uchar_t *src,
+				     size_t stride, const short *weights,
+				     int count, int row_size)
+{
+	int i, k;
+	const uchar_t *px;
+	__m128i zero = _mm_setzero_si128();
+	__m128i sum0, sum1, sum2, sum3, row0, row1, lo, hi, w;
+
+	for (i = 0; i + 16 <= row_size; i += 16) {
+		px = src + i;
+		sum0 = sum1 = sum2 = sum3 = _mm_set1_epi32(WEIGHT_ROUND);
+		for (k = 0; k < count; k += 2, px += stride * 2) {
+			row0 = _mm_loadu_si128((const __m128i *)px);
+			if (k + 1 < count) {
+				row1 = _mm_loadu_si128(
+				    (const __m128i *)(px + stride));
+				w = _mm_set1_epi32(
+				    PackWeights(weights[k], weights[k + 1]));
+			} else {
+				row1 = zero;
+				w = _mm_set1_epi32(PackWeights(weights[k], 0));
+			}
+			lo = _mm_unpacklo_epi8(row0, row1);
+			hi = _mm_unpackhi_epi8(row0, row1);
+			sum0 = _mm_add_epi32(
+			    sum0,
+			    _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+			sum1 = _mm_add_epi32(
+			    sum1,
+			    _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+			sum2 = _mm_add_epi32(
+			    sum2,
+			    _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+			sum3 = _mm_add_epi32(
+			    sum3,
+			    _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+		}
+		sum0 = _mm_packs_epi32(_mm_srai_epi32(sum0, WEIGHT_BITS),
+				       _mm_srai_epi32(sum1, WEIGHT_BITS));
+		sum2 = _mm_packs_epi32(_mm_srai_epi32(sum2, WEIGHT_BITS),
+				       _mm_srai_epi32(sum3, WEIGHT_BITS));
+		_mm_storeu_si128((__m128i *)(dst + i),
+				 _mm_packus_epi16(sum0, sum2));
+	}
+	if (i < row_size) {
+		ResampleRowVertical(dst + i, src + i, stride, weights, count,
+				    row_size - i);
+	}
+}
+
+#endif /* RESAMPLE_WITH_SSE2 */
+
+#ifdef RESAMPLE_WITH_AVX2
+
+__attribute__((target("avx2"))) static void ResampleRowVertical_AVX2(
+    uchar_t *dst, const uchar_t *src, size_t stride, const short *weights,
+    int count, int row_size)
+{
+	int i, k;
+	const uchar_t *px;
+	__m256i zero = _mm256_setzero_si256();
+	__m256i sum0, sum1, sum2, sum3, row0, row1, lo, hi, w;
+
+	/* The unpack and pack instructions work within 128-bit lanes, so
+	 * the byte order is restored by the final pack without a permute */
+	for (i = 0; i + 32 <= row_size; i += 32) {
+		px = src + i;
+		sum0 = sum1 = sum2 = sum3 = _mm256_set1_epi32(WEIGHT_ROUND);
+		for (k = 0; k < count; k += 2, px += stride * 2) {
+			row0 = _mm256_loadu_si256((const __m256i *)px);
+			if (k + 1 < count) {
+				row1 = _mm256_loadu_si256(
+				    (const __m256i *)(px + stride));
+				w = _mm256_set1_epi32(
+				    PackWeights(weights[k], weights[k + 1]));
+			} else {
+				row1 = zero;
+				w = _mm256_set1_epi32(
+				    PackWeights(weights[k], 0));
+			}
+			lo = _mm256_unpacklo_epi8(row0, row1);
+			hi = _mm256_unpackhi_epi8(row0, row1);
+			sum0 = _mm256_add_epi32(
+			    sum0, _mm256_madd_epi16(
+				      _mm256_unpacklo_epi8(lo, zero), w));
+			sum1 = _mm256_add_epi32(
+			    sum1, _mm256_madd_epi16(
+				      _mm256_unpackhi_epi8(lo, zero), w));
+			sum2 = _mm256_add_epi32(
+			    sum2, _mm256_madd_epi16(
+				      _mm256_unpacklo_epi8(hi, zero), w));
+			sum3 = _mm256_add_epi32(
+			    sum3, _mm256_madd_epi16(
+				      _mm256_unpackhi_epi8(hi, zero), w));
+		}
+		sum0 = _mm256_packs_epi32(_mm256_srai_epi32(sum0, WEIGHT_BITS),
+					  _mm256_srai_epi32(sum1, WEIGHT_BITS));
+		sum2 = _mm256_packs_epi32(_mm256_srai_epi32(sum2, WEIGHT_BITS),
+					  _mm256_srai_epi32(sum3, WEIGHT_BITS));
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    _mm256_packus_epi16(sum0, sum2));
+	}
+	if (i < row_size) {
+		ResampleRowVertical_SSE2(dst + i, src + i, stride, weights,
+					 count, row_size - i);
+	}
+}
+
+#endif /* RESAMPLE_WITH_AVX2 */
+
+static ResampleRowFunc GetVerticalKernel(void)
+{
+#ifdef RESAMPLE_WITH_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return ResampleRowVertical_AVX2;
+	}
+#endif
+#ifdef RESAMPLE_WITH_SSE2
+	return ResampleRowVertical_SSE2;
+#else
+	return ResampleRowVertical;
+#endif
+}
+
+static void ResampleRow(uchar_t *dst, const uchar_t *src, ResampleTable table,
+			int channels)
+{
+	if (table->is_identity) {
+		memcpy(dst, src, table->size * channels);
+		return;
+	}
+#ifdef RESAMPLE_WITH_SSE2
+	if (channels == 4) {
+		ResampleRowHorizontalARGB_SSE2(dst, src, table);
+		return;
+	}
+#endif
+	ResampleRowHorizontal(dst, src, table, channels);
+}
+
+/*------------------------------- Resamplers -------------------------------*/
+
+static int Graph_ResampleNearest(const LCUI_Graph *graph, LCUI_Rect rect,
+				 LCUI_Graph *buff, double scale_x,
+				 double scale_y)
+{
+	int x, y, src_y;
+	int *offsets;
+	const uchar_t *row;
+	uchar_t *px;
+	int width = buff->width;
+	int height = buff->height;
+	unsigned bpp = graph->bytes_per_pixel;
+
+	offsets = malloc(sizeof(int) * width);
+	if (!offsets) {
+		return -ENOMEM;
+	}
+	for (x = 0; x < width; ++x) {
+		offsets[x] = min((int)(x * scale_x), rect.width - 1);
+	}
+#ifdef USE_OPENMP
+#pragma omp parallel for if (width * height > PARALLEL_MIN_PIXELS) \
+	private(x, src_y, row, px) schedule(static)
+#endif
+	for (y = 0; y < height; ++y) {
+		src_y = min((int)(y * scale_y), rect.height - 1);
+		row = graph->bytes + (src_y + rect.y) * graph->bytes_per_row +
+		      rect.x * bpp;
+		px = buff->bytes + y * buff->bytes_per_row;
+		if (bpp == 4) {
+			const LCUI_ARGB *src = (const LCUI_ARGB *)row;
+			LCUI_ARGB *dst = (LCUI_ARGB *)px;
+			for (x = 0; x < width; ++x) {
+				dst[x] = src[offsets[x]];
+			}
+			continue;
+		}
+		for (x = 0; x < width; ++x) {
+			const uchar_t *src = row + offsets[x] * bpp;
+			*px++ = *src++;
+			*px++ = *src++;
+			*px++ = *src;
+		}
+	}
+	free(offsets);
+	return 0;
+}
+
+static int Graph_ResampleSeparable(const LCUI_Graph *graph, LCUI_Rect rect,
+				   LCUI_Graph *buff, ResampleFilter filter,
+				   double scale_x, double scale_y)
+{
+	int y, row_start, row_end, rows, row_size;
+	size_t stride;
+	uchar_t *tmp = NULL;
+	const uchar_t *src;
+	ResampleTableRec xtable, ytable;
+	ResampleRowFunc vertical_kernel = GetVerticalKernel();
+	int channels = graph->bytes_per_pixel;
+
+	if (ResampleTable_Init(&xtable, filter, rect.width, buff->width,
+			       scale_x) != 0) {
+		return -ENOMEM;
+	}
+	if (ResampleTable_Init(&ytable, filter, rect.height, buff->height,
+			       scale_y) != 0) {
+		ResampleTable_Destroy(&xtable);
+		return -ENOMEM;
+	}
+	/* Only the source rows covered by the vertical filter are needed */
+	row_start = ytable.bounds[0];
+	row_end = ytable.bounds[(buff->height - 1) * 2] +
+		  ytable.bounds[(buff->height - 1) * 2 + 1];
+	rows = row_end - row_start;
+	row_size = buff->width * channels;
+	src = graph->bytes + rect.y * graph->bytes_per_row + rect.x * channels;
+	if (xtable.is_identity) {
+		stride = graph->bytes_per_row;
+		src += row_start * stride;
+	} else {
+		stride = row_size;
+		tmp = malloc(stride * rows);
+		if (!tmp) {
+			ResampleTable_Destroy(&xtable);
+			ResampleTable_Destroy(&ytable);
+			return -ENOMEM;
+		}
+#ifdef USE_OPENMP
+#pragma omp parallel for if (row_size * rows > PARALLEL_MIN_PIXELS * 4) \
+	schedule(static)
+#endif
+		for (y = 0; y < rows; ++y) {
+			ResampleRow(tmp + y * stride,
+				    src + (y + row_start) * graph->bytes_per_row,
+				    &xtable, channels);
+		}
+		src = tmp;
+	}
+#ifdef USE_OPENMP
+#pragma omp parallel for if (row_size * buff->height > \
+			     PARALLEL_MIN_PIXELS * 4) schedule(static)
+#endif
+	for (y = 0; y < (int)buff->height; ++y) {
+		vertical_kernel(buff->bytes + y * buff->bytes_per_row,
+				src + (ytable.bounds[y * 2] - row_start) * stride,
+				stride, ytable.weights + y * ytable.taps,
+				ytable.bounds[y * 2 + 1], row_size);
+	}
+	free(tmp);
+	ResampleTable_Destroy(&xtable);
+	ResampleTable_Destroy(&ytable);
+	return 0;
+}
+
+int Graph_Resample(const LCUI_Graph *graph, LCUI_Graph *buff,
+		   LCUI_GraphResampleFilter filter, LCUI_BOOL keep_scale,
+		   int width, int height)
+{
+	LCUI_Rect rect;
+	double scale_x = 0.0, scale_y = 0.0;
+
+	if (!Graph_IsValid(graph) || (width <= 0 && height <= 0)) {
+		return -1;
+	}
+	/* 获取引用的有效区域，以及指向引用的对象的指针 */
+	Graph_GetValidRect(graph, &rect);
+	graph = Graph_GetQuote(graph);
+	if (width > 0) {
+		scale_x = 1.0 * rect.width / width;
+	}
+	if (height > 0) {
+		scale_y = 1.0 * rect.height / height;
+	}
+	if (width <= 0) {
+		scale_x = scale_y;
+		width = (int)(0.5 + 1.0 * graph->width / scale_x);
+	}
+	if (height <= 0) {
+		scale_y = scale_x;
+		height = (int)(0.5 + 1.0 * graph->height / scale_y);
+	}
+	/* 如果保持宽高比 */
+	if (keep_scale) {
+		if (scale_x < scale_y) {
+			scale_y = scale_x;
+		} else {
+			scale_x = scale_y;
+		}
+	}
+	buff->color_type = graph->color_type;
+	if (Graph_Create(buff, width, height) < 0) {
+		return -2;
+	}
+	/* Filtering is only implemented for 8-bit RGB and ARGB pixels */
+	if (filter == LCUI_RESAMPLE_NEAREST ||
+	    (graph->color_type != LCUI_COLOR_TYPE_RGB &&
+	     graph->color_type != LCUI_COLOR_TYPE_ARGB)) {
+		return Graph_ResampleNearest(graph, rect, buff, scale_x,
+					     scale_y);
+	}
+	return Graph_ResampleSeparable(graph, rect, buff,
+				       &resample_filters[filter], scale_x,
+				       scale_y);
+}
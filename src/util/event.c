@@ -97,20 +97,30 @@ static void EventTrigger_RemoveHandler(LCUI_EventTrigger trigger,
 	}
 }
 
-LCUI_EventTrigger EventTrigger(void)
+void EventTrigger_Init(LCUI_EventTrigger trigger)
 {
-	LCUI_EventTrigger trigger = NEW(LCUI_EventTriggerRec, 1);
 	trigger->handler_base_id = 1;
 	RBTree_Init(&trigger->handlers);
 	RBTree_Init(&trigger->events);
 	RBTree_OnDestroy(&trigger->events, DestroyEventRecord);
-	return trigger;
 }
 
-void EventTrigger_Destroy(LCUI_EventTrigger trigger)
+void EventTrigger_Clear(LCUI_EventTrigger trigger)
 {
 	RBTree_Destroy(&trigger->events);
 	RBTree_Destroy(&trigger->handlers);
+}
+
+LCUI_EventTrigger EventTrigger(void)
+{
+	LCUI_EventTrigger trigger = NEW(LCUI_EventTriggerRec, 1);
+	EventTrigger_Init(trigger);
+	return trigger;
+}
+
+void EventTrigger_Destroy(LCUI_EventTrigger trigger)
+{
+	EventTrigger_Clear(trigger);
 	free(trigger);
 }
 
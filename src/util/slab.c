@@ -0,0 +1,285 @@
+﻿/*
+ * slab.c -- slab allocator for small objects
+ *
+ * Copyright (c) 2019, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/util/linkedlist.h>
+#include <LCUI/util/slab.h>
+
+/* 每一页的目标大小，对象较大时至少容纳 SLAB_MIN_OBJECTS 个对象 */
+#define SLAB_PAGE_SIZE 16384
+#define SLAB_MIN_OBJECTS 8
+
+/* 内存池的分级：16、24、32、48 …… 4096，每两级大小翻倍 */
+#define SLAB_POOL_MIN_SIZE 16
+#define SLAB_POOL_CLASSES 17
+
+typedef struct slab_page slab_page_t;
+
+/** 对象的头部，记录对象所在的页，空闲时用于链接下一个空闲对象 */
+typedef union slab_header {
+	slab_page_t *page;
+	union slab_header *next;
+	double align;
+} slab_header_t;
+
+struct slab_page {
+	slab_t *slab;
+	LinkedListNode node;         /**< 在 slab 的页列表中的节点 */
+	LinkedListNode partial_node; /**< 在有空闲对象的页列表中的节点 */
+	size_t used;                 /**< 正在使用的对象数量 */
+	size_t initialized;          /**< 已经分配过的对象数量 */
+	slab_header_t *free;         /**< 空闲对象链表 */
+	char *objects;
+};
+
+struct slab {
+	size_t object_size; /**< 对象占用的空间，包括头部 */
+	size_t capacity;    /**< 每一页的对象数量 */
+	size_t count;       /**< 正在使用的对象数量 */
+	LinkedList pages;
+	LinkedList partial_pages;
+	slab_page_t *empty_page; /**< 保留的空页，避免反复申请和释放同一页 */
+};
+
+struct slab_pool {
+	size_t sizes[SLAB_POOL_CLASSES];
+	slab_t *slabs[SLAB_POOL_CLASSES];
+};
+
+slab_t *slab_create(size_t object_size)
+{
+	slab_t *slab;
+	const size_t align = sizeof(slab_header_t);
+
+	slab = malloc(sizeof(slab_t));
+	if (!slab) {
+		return NULL;
+	}
+	object_size = (object_size + align - 1) / align * align;
+	slab->object_size = object_size + sizeof(slab_header_t);
+	slab->capacity = SLAB_PAGE_SIZE / slab->object_size;
+	if (slab->capacity < SLAB_MIN_OBJECTS) {
+		slab->capacity = SLAB_MIN_OBJECTS;
+	}
+	slab->count = 0;
+	slab->empty_page = NULL;
+	LinkedList_Init(&slab->pages);
+	LinkedList_Init(&slab->partial_pages);
+	return slab;
+}
+
+static slab_page_t *slab_page_create(slab_t *slab)
+{
+	slab_page_t *page;
+	const size_t align = sizeof(slab_header_t);
+	const size_t header_size =
+	    (sizeof(slab_page_t) + align - 1) / align * align;
+
+	page = malloc(header_size + slab->object_size * slab->capacity);
+	if (!page) {
+		return NULL;
+	}
+	page->slab = slab;
+	page->used = 0;
+	page->initialized = 0;
+	page->free = NULL;
+	page->objects = (char *)page + header_size;
+	page->node.data = page;
+	page->partial_node.data = page;
+	LinkedList_AppendNode(&slab->pages, &page->node);
+	LinkedList_AppendNode(&slab->partial_pages, &page->partial_node);
+	return page;
+}
+
+static void slab_page_destroy(slab_page_t *page)
+{
+	slab_t *slab = page->slab;
+
+	if (page->used < slab->capacity) {
+		LinkedList_Unlink(&slab->partial_pages, &page->partial_node);
+	}
+	LinkedList_Unlink(&slab->pages, &page->node);
+	free(page);
+}
+
+void *slab_alloc(slab_t *slab)
+{
+	slab_page_t *page;
+	slab_header_t *header;
+
+	if (slab->partial_pages.length > 0) {
+		page = slab->partial_pages.head.next->data;
+	} else {
+		page = slab_page_create(slab);
+		if (!page) {
+			return NULL;
+		}
+	}
+	if (page->free) {
+		header = page->free;
+		page->free = header->next;
+	} else {
+		header = (slab_header_t *)(page->objects +
+					   slab->object_size * page->initialized);
+		page->initialized += 1;
+	}
+	if (page == slab->empty_page) {
+		slab->empty_page = NULL;
+	}
+	page->used += 1;
+	if (page->used == slab->capacity) {
+		LinkedList_Unlink(&slab->partial_pages, &page->partial_node);
+	}
+	slab->count += 1;
+	header->page = page;
+	return header + 1;
+}
+
+void slab_free(void *ptr)
+{
+	slab_t *slab;
+	slab_page_t *page;
+	slab_header_t *header;
+
+	if (!ptr) {
+		return;
+	}
+	header = (slab_header_t *)ptr - 1;
+	page = header->page;
+	if (!page) {
+		free(header);
+		return;
+	}
+	slab = page->slab;
+	if (page->used == slab->capacity) {
+		LinkedList_AppendNode(&slab->partial_pages, &page->partial_node);
+	}
+	header->next = page->free;
+	page->free = header;
+	page->used -= 1;
+	slab->count -= 1;
+	if (page->used > 0) {
+		return;
+	}
+	/* 只保留一个空页，其余的还给系统 */
+	if (slab->empty_page) {
+		slab_page_destroy(page);
+	} else {
+		slab->empty_page = page;
+	}
+}
+
+size_t slab_count(slab_t *slab)
+{
+	return slab->count;
+}
+
+void slab_destroy(slab_t *slab)
+{
+	LinkedListNode *node, *next;
+
+	for (node = slab->pages.head.next; node; node = next) {
+		next = node->next;
+		free(node->data);
+	}
+	free(slab);
+}
+
+slab_pool_t *slab_pool_create(void)
+{
+	int i;
+	size_t size;
+	slab_pool_t *pool;
+
+	pool = malloc(sizeof(slab_pool_t));
+	if (!pool) {
+		return NULL;
+	}
+	for (i = 0; i < SLAB_POOL_CLASSES; ++i) {
+		size = SLAB_POOL_MIN_SIZE << (i / 2);
+		pool->sizes[i] = i % 2 ? size + size / 2 : size;
+		pool->slabs[i] = NULL;
+	}
+	return pool;
+}
+
+void *slab_pool_alloc(slab_pool_t *pool, size_t size)
+{
+	int i;
+	slab_header_t *header;
+
+	if (pool) {
+		for (i = 0; i < SLAB_POOL_CLASSES; ++i) {
+			if (size > pool->sizes[i]) {
+				continue;
+			}
+			if (!pool->slabs[i]) {
+				pool->slabs[i] = slab_create(pool->sizes[i]);
+				if (!pool->slabs[i]) {
+					return NULL;
+				}
+			}
+			return slab_alloc(pool->slabs[i]);
+		}
+	}
+	header = malloc(sizeof(slab_header_t) + size);
+	if (!header) {
+		return NULL;
+	}
+	header->page = NULL;
+	return header + 1;
+}
+
+size_t slab_pool_count(slab_pool_t *pool)
+{
+	int i;
+	size_t count = 0;
+
+	for (i = 0; i < SLAB_POOL_CLASSES; ++i) {
+		if (pool->slabs[i]) {
+			count += pool->slabs[i]->count;
+		}
+	}
+	return count;
+}
+
+void slab_pool_destroy(slab_pool_t *pool)
+{
+	int i;
+
+	for (i = 0; i < SLAB_POOL_CLASSES; ++i) {
+		if (pool->slabs[i]) {
+			slab_destroy(pool->slabs[i]);
+		}
+	}
+	free(pool);
+}
@@ -23,6 +23,11 @@ int main(void)
 	ret += test_widget_inline_block_layout();
 	ret += test_widget_event();
 	ret += test_widget_opacity();
+	ret += test_border_paint();
+	ret += test_linux_fbdisplay();
+	ret += test_pixel_convert();
+	ret += test_slab();
+	ret += test_headless_display();
 	ret += test_widget_rect();
 	ret += test_textview_resize();
 	ret += test_textedit();
@@ -44,6 +44,11 @@ int test_widget_layout(void);
 int test_widget_flex_layout(void);
 int test_widget_inline_block_layout(void);
 int test_widget_rect(void);
+int test_headless_display(void);
+int test_border_paint(void);
+int test_linux_fbdisplay(void);
+int test_pixel_convert(void);
+int test_slab(void);
 int test_widget_opacity(void);
 int test_widget_event(void);
 int test_textview_resize(void);
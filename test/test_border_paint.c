@@ -0,0 +1,168 @@
+﻿#include <stdio.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/draw/border.h>
+#include "test.h"
+
+#define BOX_WIDTH 100
+#define BOX_HEIGHT 80
+#define TILE_SIZE 16
+
+static void InitBorder(LCUI_Border *border, int width, int radius)
+{
+	border->top.width = width;
+	border->right.width = width;
+	border->bottom.width = width;
+	border->left.width = width;
+	border->top.style = SV_SOLID;
+	border->right.style = SV_SOLID;
+	border->bottom.style = SV_SOLID;
+	border->left.style = SV_SOLID;
+	border->top.color = RGB(255, 0, 0);
+	border->right.color = RGB(0, 255, 0);
+	border->bottom.color = RGB(0, 0, 255);
+	border->left.color = RGB(0, 0, 0);
+	border->top_left_radius = radius;
+	border->top_right_radius = radius;
+	border->bottom_left_radius = radius;
+	border->bottom_right_radius = radius;
+}
+
+static void CreateCanvas(LCUI_Graph *canvas)
+{
+	Graph_Init(canvas);
+	canvas->color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create(canvas, BOX_WIDTH, BOX_HEIGHT);
+	Graph_FillRect(canvas, RGB(255, 255, 255), NULL, TRUE);
+}
+
+/** 按小块分别绘制，像界面渲染那样 */
+static void PaintBorder(const LCUI_Border *border, LCUI_Graph *canvas,
+			int tile_size, LCUI_BOOL crop)
+{
+	LCUI_Rect box = { 0, 0, BOX_WIDTH, BOX_HEIGHT };
+	LCUI_PaintContextRec paint;
+
+	paint.with_alpha = TRUE;
+	for (paint.rect.y = 0; paint.rect.y < box.height;
+	     paint.rect.y += tile_size) {
+		for (paint.rect.x = 0; paint.rect.x < box.width;
+		     paint.rect.x += tile_size) {
+			paint.rect.width = tile_size;
+			paint.rect.height = tile_size;
+			LCUIRect_ValidateArea(&paint.rect, box.width,
+					      box.height);
+			Graph_Quote(&paint.canvas, canvas, &paint.rect);
+			if (crop) {
+				Border_CropContent(border, &box, &paint);
+			} else {
+				Border_Paint(border, &box, &paint);
+			}
+		}
+	}
+}
+
+static uchar_t GetAlpha(LCUI_Graph *canvas, int x, int y)
+{
+	return Graph_GetPixelPointer(canvas, x, y)->a;
+}
+
+/** 检查四个圆角的透明度是否对称 */
+static LCUI_BOOL CheckSymmetry(LCUI_Graph *canvas, int size)
+{
+	int x, y;
+	int right = BOX_WIDTH - 1;
+	int bottom = BOX_HEIGHT - 1;
+	uchar_t a;
+
+	for (y = 0; y < size; ++y) {
+		for (x = 0; x < size; ++x) {
+			a = GetAlpha(canvas, x, y);
+			if (a != GetAlpha(canvas, right - x, y) ||
+			    a != GetAlpha(canvas, x, bottom - y) ||
+			    a != GetAlpha(canvas, right - x, bottom - y)) {
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+/** 检查圆弧上是否有半透明的像素 */
+static LCUI_BOOL CheckAntiAliasing(LCUI_Graph *canvas, int radius)
+{
+	int i;
+	uchar_t a;
+
+	for (i = 0; i < radius; ++i) {
+		a = GetAlpha(canvas, i, i);
+		if (a > 0 && a < 255) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static LCUI_BOOL CheckColor(LCUI_Graph *canvas, int x, int y,
+			    LCUI_Color color)
+{
+	return Graph_GetPixelPointer(canvas, x, y)->value == color.value;
+}
+
+static LCUI_BOOL IsSameCanvas(LCUI_Graph *a, LCUI_Graph *b)
+{
+	return memcmp(a->bytes, b->bytes, a->mem_size) == 0;
+}
+
+int test_border_paint(void)
+{
+	int ret = 0;
+	LCUI_Border border;
+	LCUI_Graph canvas, tiled, cached, cropped;
+
+	InitBorder(&border, 4, 20);
+	CreateCanvas(&canvas);
+	CreateCanvas(&tiled);
+	CreateCanvas(&cached);
+	CreateCanvas(&cropped);
+
+	PaintBorder(&border, &canvas, BOX_WIDTH, FALSE);
+	CHECK(GetAlpha(&canvas, 0, 0) == 0);
+	CHECK(CheckColor(&canvas, BOX_WIDTH / 2, 1, border.top.color));
+	CHECK(CheckColor(&canvas, 1, BOX_HEIGHT / 2, border.left.color));
+	CHECK(CheckColor(&canvas, BOX_WIDTH - 2, BOX_HEIGHT / 2,
+			 border.right.color));
+	CHECK(CheckColor(&canvas, BOX_WIDTH / 2, BOX_HEIGHT - 2,
+			 border.bottom.color));
+	CHECK(CheckColor(&canvas, BOX_WIDTH / 2, BOX_HEIGHT / 2,
+			 RGB(255, 255, 255)));
+	CHECK(CheckAntiAliasing(&canvas, 20));
+	CHECK(CheckSymmetry(&canvas, 20));
+
+	PaintBorder(&border, &tiled, TILE_SIZE, FALSE);
+	CHECK_WITH_TEXT("tiled painting is the same as full painting",
+			IsSameCanvas(&canvas, &tiled));
+
+	Border_InitCache();
+	PaintBorder(&border, &cached, TILE_SIZE, FALSE);
+	CHECK_WITH_TEXT("cached masks give the same result",
+			IsSameCanvas(&canvas, &cached));
+
+	PaintBorder(&border, &cropped, TILE_SIZE, TRUE);
+	CHECK_WITH_TEXT("content corner is cropped",
+			GetAlpha(&cropped, 4, 4) == 0);
+	CHECK_WITH_TEXT("border area is not cropped",
+			GetAlpha(&cropped, 0, 0) == 255);
+	CHECK(GetAlpha(&cropped, BOX_WIDTH / 2, BOX_HEIGHT / 2) == 255);
+	CHECK(CheckAntiAliasing(&cropped, 20));
+	CHECK(CheckSymmetry(&cropped, 20));
+	Border_FreeCache();
+
+	Graph_Free(&canvas);
+	Graph_Free(&tiled);
+	Graph_Free(&cached);
+	Graph_Free(&cropped);
+	return ret;
+}
@@ -0,0 +1,122 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/draw/boxshadow.h>
+
+#define TILE_SIZE 64
+#define REPEAT_TIMES 200
+
+typedef struct BenchCaseRec_ {
+	const char *name;
+	int width, height;
+	int x, y, blur, spread, radius;
+	unsigned char alpha, r, g, b;
+} BenchCaseRec;
+
+static BenchCaseRec cases[] = {
+	{ "card", 320, 200, 0, 2, 8, 0, 4, 64, 0, 0, 0 },
+	{ "dialog", 480, 320, 0, 8, 32, 4, 6, 96, 0, 0, 0 },
+	{ "button", 96, 32, 0, 1, 3, 0, 2, 80, 0, 0, 0 },
+	{ "tooltip", 160, 40, 2, 2, 12, -2, 0, 128, 30, 30, 30 },
+	{ "round", 100, 100, 0, 0, 16, 0, 50, 160, 33, 150, 243 },
+	{ "sharp", 200, 120, 4, 4, 0, 6, 0, 255, 0, 0, 0 },
+	{ "floating", 360, 240, 0, 24, 64, 0, 16, 90, 0, 0, 0 },
+	{ "tiny", 8, 6, 0, 0, 10, 0, 3, 100, 0, 0, 0 }
+};
+
+/** 像界面渲染那样，按小块分别绘制阴影 */
+static void PaintShadow(const LCUI_BoxShadow *shadow, const LCUI_Rect *box,
+			int width, int height, LCUI_Graph *canvas)
+{
+	LCUI_PaintContextRec paint;
+
+	paint.with_alpha = TRUE;
+	for (paint.rect.y = 0; paint.rect.y < box->height;
+	     paint.rect.y += TILE_SIZE) {
+		for (paint.rect.x = 0; paint.rect.x < box->width;
+		     paint.rect.x += TILE_SIZE) {
+			paint.rect.width = TILE_SIZE;
+			paint.rect.height = TILE_SIZE;
+			LCUIRect_ValidateArea(&paint.rect, box->width,
+					      box->height);
+			Graph_Quote(&paint.canvas, canvas, &paint.rect);
+			BoxShadow_Paint(shadow, box, width, height, &paint);
+		}
+	}
+}
+
+static int64_t RunPaint(const LCUI_BoxShadow *shadow, const LCUI_Rect *box,
+			const BenchCaseRec *bench, LCUI_Graph *canvas)
+{
+	int i;
+	int64_t t;
+
+	t = LCUI_GetTime();
+	for (i = 0; i < REPEAT_TIMES; ++i) {
+		Graph_FillRect(canvas, ARGB(0, 0, 0, 0), NULL, FALSE);
+		PaintShadow(shadow, box, bench->width, bench->height, canvas);
+	}
+	return LCUI_GetTimeDelta(t);
+}
+
+static int RunCase(const BenchCaseRec *bench)
+{
+	int ret = 0;
+	int64_t t_ref, t_new;
+	char s_ref[32], s_new[32];
+	LCUI_Rect box, content = { 0, 0, 0, 0 };
+	LCUI_Graph g_ref, g_new;
+	LCUI_BoxShadow shadow;
+
+	memset(&shadow, 0, sizeof(shadow));
+	shadow.x = bench->x;
+	shadow.y = bench->y;
+	shadow.blur = bench->blur;
+	shadow.spread = bench->spread;
+	shadow.color = ARGB(bench->alpha, bench->r, bench->g, bench->b);
+	shadow.top_left_radius = bench->radius;
+	shadow.top_right_radius = bench->radius;
+	shadow.bottom_left_radius = bench->radius;
+	shadow.bottom_right_radius = bench->radius;
+	content.width = bench->width;
+	content.height = bench->height;
+	BoxShadow_GetCanvasRect(&shadow, &content, &box);
+	box.x = box.y = 0;
+	Graph_Init(&g_ref);
+	Graph_Init(&g_new);
+	g_ref.color_type = LCUI_COLOR_TYPE_ARGB;
+	g_new.color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create(&g_ref, box.width, box.height);
+	Graph_Create(&g_new, box.width, box.height);
+
+	t_ref = RunPaint(&shadow, &box, bench, &g_ref);
+	BoxShadow_InitCache();
+	t_new = RunPaint(&shadow, &box, bench, &g_new);
+	BoxShadow_FreeCache();
+	if (memcmp(g_ref.bytes, g_new.bytes, g_ref.mem_size) != 0) {
+		ret = -1;
+	}
+	sprintf(s_ref, "%.2fms", 1.0 * t_ref / REPEAT_TIMES);
+	sprintf(s_new, "%.2fms", 1.0 * t_new / REPEAT_TIMES);
+	Logger_Info("%-10s%-12s%-12s%s\n", bench->name, s_ref, s_new,
+		    ret == 0 ? "yes" : "no (mismatch!)");
+	Graph_Free(&g_ref);
+	Graph_Free(&g_new);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int ret = 0;
+	size_t i;
+
+	Logger_Info("%-10s%-12s%-12s%s\n", "shadow", "direct", "cached",
+		    "identical");
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		ret += RunCase(&cases[i]);
+	}
+	return ret;
+}
@@ -0,0 +1,155 @@
+﻿/*
+ * test_builder_bench.c -- Load large generated layouts with the UI builder
+ *
+ * Usage: test_builder_bench [items] [xml|binary]
+ *
+ * A layout with the given number of list items (50000 by default, each item
+ * is a widget with a text view inside, grouped by 50) is written
+ * to a temporary file, then loaded once with LCUIBuilder_LoadFile(), or
+ * compiled with LCUIBuilder_CompileFile() and loaded once with
+ * LCUIBuilder_LoadBinaryFile(). The load time and the growth of the peak
+ * resident set size are printed, so run it in a fresh process for each size
+ * and format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/display.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/builder.h>
+
+#ifdef LCUI_BUILD_IN_LINUX
+#include <sys/resource.h>
+#endif
+
+#define DEFAULT_ITEMS 50000
+#define GROUP_SIZE 50
+#define LAYOUT_FILE "test_builder_bench.xml"
+#define BINARY_FILE "test_builder_bench.bin"
+
+static double GetTimeMs(void)
+{
+#ifdef LCUI_BUILD_IN_LINUX
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#else
+	return (double)LCUI_GetTime();
+#endif
+}
+
+/** 获取进程的峰值常驻内存，单位为 KB */
+static long GetPeakRSS(void)
+{
+#ifdef LCUI_BUILD_IN_LINUX
+	struct rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+#else
+	return 0;
+#endif
+}
+
+/** 生成布局文件，每组包含一个标题和若干个带有 id、class 和属性的列表项 */
+static long WriteLayout(const char *path, int items)
+{
+	int i;
+	long size;
+	FILE *fp;
+
+	fp = fopen(path, "w");
+	if (!fp) {
+		return -1;
+	}
+	fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+		    "<lcui-app>\n  <ui>\n");
+	for (i = 0; i < items; ++i) {
+		if (i % GROUP_SIZE == 0) {
+			if (i > 0) {
+				fprintf(fp, "    </w>\n");
+			}
+			fprintf(fp, "    <w class=\"group\">\n");
+			fprintf(fp, "      <textview class=\"group-title\">"
+				    "Group %d</textview>\n",
+				i / GROUP_SIZE);
+			continue;
+		}
+		fprintf(fp,
+			"      <w id=\"item-%d\" class=\"item item-%d\" "
+			"data-index=\"%d\">\n"
+			"        <textview class=\"item-text\">Item %d"
+			"</textview>\n"
+			"      </w>\n",
+			i, i % 4, i, i);
+	}
+	if (items > 0) {
+		fprintf(fp, "    </w>\n");
+	}
+	fprintf(fp, "  </ui>\n</lcui-app>\n");
+	size = ftell(fp);
+	fclose(fp);
+	return size;
+}
+
+int main(int argc, char **argv)
+{
+	int items = DEFAULT_ITEMS;
+	long file_size, rss;
+	double t;
+	LCUI_BOOL binary = FALSE;
+	LCUI_Widget pack;
+	FILE *fp;
+
+	if (argc > 1) {
+		items = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		binary = strcmp(argv[2], "binary") == 0;
+	}
+	file_size = WriteLayout(LAYOUT_FILE, items);
+	if (file_size < 0) {
+		Logger_Error("cannot write %s\n", LAYOUT_FILE);
+		return -1;
+	}
+	LCUI_InitBase();
+	LCUI_InitApp(NULL);
+	LCUI_InitDisplay(LCUI_CreateHeadlessDisplayDriver());
+	LCUI_Init();
+	if (binary) {
+		if (LCUIBuilder_CompileFile(LAYOUT_FILE, BINARY_FILE) != 0) {
+			Logger_Error("cannot compile %s\n", LAYOUT_FILE);
+			remove(LAYOUT_FILE);
+			LCUI_Destroy();
+			return -1;
+		}
+		fp = fopen(BINARY_FILE, "rb");
+		fseek(fp, 0, SEEK_END);
+		file_size = ftell(fp);
+		fclose(fp);
+	}
+	rss = GetPeakRSS();
+	t = GetTimeMs();
+	if (binary) {
+		pack = LCUIBuilder_LoadBinaryFile(BINARY_FILE);
+	} else {
+		pack = LCUIBuilder_LoadFile(LAYOUT_FILE);
+	}
+	t = GetTimeMs() - t;
+	rss = GetPeakRSS() - rss;
+	Logger_Info("%d items, %ld KB of %s\n", items, file_size / 1024,
+		    binary ? "binary" : "xml");
+	Logger_Info("load: %.2fms, peak rss growth: %ld KB\n", t, rss);
+	if (pack) {
+		Widget_Destroy(pack);
+	}
+	remove(LAYOUT_FILE);
+	remove(BINARY_FILE);
+	LCUI_Destroy();
+	return pack ? 0 : -1;
+}
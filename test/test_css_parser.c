@@ -1,11 +1,70 @@
 ﻿#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/display.h>
+#include <LCUI/util/dirent.h>
 #include <LCUI/gui/builder.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/css_parser.h>
 #include "test.h"
 
-int test_css_parser( void )
+#define CACHE_DIR "."
+
+/** 处理缓存目录中的样式缓存文件，truncate 为 TRUE 时截断文件，否则删除文件 */
+static int each_cache_file( LCUI_BOOL truncate )
+{
+	int count = 0;
+	char name[256], *data;
+	wchar_t *wname;
+	size_t i, len, size;
+	FILE *fp;
+	LCUI_Dir dir;
+	LCUI_DirEntry *entry;
+
+	if( LCUI_OpenDirW( L"" CACHE_DIR, &dir ) != 0 ) {
+		return 0;
+	}
+	while( (entry = LCUI_ReadDirW( &dir )) ) {
+		wname = LCUI_GetFileNameW( entry );
+		len = wcslen( wname );
+		if( len < 5 || len >= 256 ||
+		    wcscmp( wname + len - 5, L".lcss" ) != 0 ) {
+			continue;
+		}
+		/* 缓存文件名只包含 ASCII 字符 */
+		for( i = 0; i <= len; ++i ) {
+			name[i] = (char)wname[i];
+		}
+		count += 1;
+		if( !truncate ) {
+			remove( name );
+			continue;
+		}
+		fp = fopen( name, "rb" );
+		if( !fp ) {
+			continue;
+		}
+		fseek( fp, 0, SEEK_END );
+		size = ftell( fp );
+		fseek( fp, 0, SEEK_SET );
+		data = malloc( size );
+		size = fread( data, 1, size, fp );
+		fclose( fp );
+		fp = fopen( name, "wb" );
+		if( fp ) {
+			fwrite( data, 1, size - 1, fp );
+			fclose( fp );
+		}
+		free( data );
+	}
+	LCUI_CloseDir( &dir );
+	return count;
+}
+
+static int check_css_parser( void )
 {
 	int ret = 0;
 	LCUI_Widget root, box, btn, text;
@@ -43,3 +102,100 @@ int test_css_parser( void )
 	LCUI_Destroy();
 	return ret;
 }
+
+static int check_css_tokenizer( void )
+{
+	int ret = 0;
+	size_t len;
+	char *css;
+	LCUI_Widget w;
+	const char *head =
+		"/* rules { a: b; } are ignored in comments */\n"
+		"textview.tokenizer-a,\n\t#tokenizer-test /* a, b */ {\n"
+		"  width : 20px ;\n"
+		"  height: 30px; /* height: 40px; */\n"
+		"  display: inline-block }\n"
+		"#tokenizer-test{min-width:10px; /* c */ max-width:50px}\n"
+		"/*/ not closed yet */"
+		"#tokenizer-test{margin-left:";
+	const char *tail = "4px}";
+
+	/* 属性值的长度超过解析器的初始缓存大小 */
+	len = strlen( head ) + strlen( tail );
+	css = malloc( len + 1024 + 1 );
+	strcpy( css, head );
+	memset( css + strlen( head ), ' ', 1024 );
+	strcpy( css + strlen( head ) + 1024, tail );
+	LCUI_Init();
+	w = LCUIWidget_New( "textview" );
+	Widget_SetId( w, "tokenizer-test" );
+	Widget_Append( LCUIWidget_GetRoot(), w );
+	LCUI_LoadCSSString( css, NULL );
+	Widget_UpdateStyle( w, TRUE );
+	Widget_Update( w );
+	CHECK( w->style->sheet[key_width].val_px == 20 );
+	CHECK( w->style->sheet[key_height].val_px == 30 );
+	/* 属性名前面的注释需要被跳过 */
+	CHECK( w->style->sheet[key_display].is_valid &&
+	       w->style->sheet[key_display].val_style == SV_INLINE_BLOCK );
+	CHECK( w->style->sheet[key_max_width].is_valid &&
+	       w->style->sheet[key_max_width].val_px == 50 );
+	CHECK( w->style->sheet[key_margin_left].val_px == 4 );
+	LCUI_Destroy();
+	free( css );
+	return ret;
+}
+
+static int check_style_names( void )
+{
+	int i, ret = 0;
+	int keys[100];
+	char name[32];
+
+	LCUI_Init();
+	CHECK( strcmp( LCUI_GetStyleName( key_width ), "width" ) == 0 );
+	CHECK( strcmp( LCUI_GetStyleValueName( SV_ABSOLUTE ),
+		       "absolute" ) == 0 );
+	/* 添加足够多的属性名称，让名称表扩容 */
+	for( i = 0; i < 100; ++i ) {
+		sprintf( name, "test-property-%d", i );
+		keys[i] = LCUI_AddCSSPropertyName( name );
+	}
+	for( i = 0; i < 100; ++i ) {
+		sprintf( name, "test-property-%d", i );
+		if( !LCUI_GetStyleName( keys[i] ) ||
+		    strcmp( LCUI_GetStyleName( keys[i] ), name ) != 0 ) {
+			break;
+		}
+	}
+	CHECK_WITH_TEXT( "check added property names", i == 100 );
+	CHECK( LCUI_SetStyleName( keys[0], "test-renamed" ) == 0 );
+	CHECK( strcmp( LCUI_GetStyleName( keys[0] ), "test-renamed" ) == 0 );
+	CHECK( LCUI_SetStyleName( -1, "test-unknown" ) != 0 );
+	CHECK( LCUI_GetStyleName( -1 ) == NULL );
+	CHECK( LCUI_AddStyleValue( SV_ABSOLUTE, "test-value" ) != 0 );
+	LCUI_Destroy();
+	return ret;
+}
+
+int test_css_parser( void )
+{
+	int ret = 0;
+
+	ret += check_style_names();
+	ret += check_css_tokenizer();
+	each_cache_file( FALSE );
+	ret += check_css_parser();
+	LCUI_SetCSSCacheDir( CACHE_DIR );
+	TEST_LOG( "parse css and write cache\n" );
+	ret += check_css_parser();
+	CHECK_WITH_TEXT( "check cache files are written",
+			 each_cache_file( TRUE ) > 0 );
+	TEST_LOG( "load css from corrupted cache\n" );
+	ret += check_css_parser();
+	TEST_LOG( "load css from cache\n" );
+	ret += check_css_parser();
+	LCUI_SetCSSCacheDir( NULL );
+	each_cache_file( FALSE );
+	return ret;
+}
@@ -0,0 +1,112 @@
+/*
+ * test_css_parser_bench.c -- Parse a large generated stylesheet
+ *
+ * Usage: test_css_parser_bench [rules] [rounds]
+ *
+ * A stylesheet with the given number of rules (20000 by default, about 9 MB)
+ * is generated in memory, each rule has a comment, a few selectors and a
+ * dozen declarations. The stylesheet is loaded with LCUI_LoadCSSString()
+ * into a fresh style library several times (5 rounds by default), and the
+ * best time and the throughput are printed. The time also covers parsing
+ * the property values and adding the style sheets to the library.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/css_parser.h>
+
+#define DEFAULT_RULES 20000
+#define DEFAULT_ROUNDS 5
+
+static double GetTimeMs(void)
+{
+#ifdef LCUI_BUILD_IN_LINUX
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#else
+	return (double)LCUI_GetTime();
+#endif
+}
+
+static char *CreateStyleSheet(int rules, size_t *length)
+{
+	int i;
+	size_t len = 0, size;
+	char *css;
+
+	size = (size_t)rules * 512 + 1;
+	css = malloc(size);
+	if (!css) {
+		return NULL;
+	}
+	for (i = 0; i < rules; ++i) {
+		len += snprintf(
+		    css + len, size - len,
+		    "/* rule %d: generated for the parser benchmark */\n"
+		    ".theme-%d .list-item:hover > textview.item-text,\n"
+		    "#item-%d .item-text, .item-%d {\n"
+		    "  width: %dpx;\n"
+		    "  height: 24px;\n"
+		    "  display: inline-block;\n"
+		    "  position: relative;\n"
+		    "  margin: 4px 8px 4px 8px;\n"
+		    "  padding: 2px 6px;\n"
+		    "  color: #%06x;\n"
+		    "  background-color: rgba(%d, 120, 200, 0.5);\n"
+		    "  border: 1px solid #ddd;\n"
+		    "  font-size: 14px;\n"
+		    "  font-family: \"Segoe UI\", \"Noto Sans\";\n"
+		    "  box-shadow: 0 1px 2px rgba(0, 0, 0, 0.2);\n"
+		    "}\n",
+		    i, i % 8, i, i, 100 + i % 200, (i * 2654435761u) & 0xffffff,
+		    i % 256);
+	}
+	*length = len;
+	return css;
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+	int rules = DEFAULT_RULES;
+	int rounds = DEFAULT_ROUNDS;
+	size_t len;
+	double t, best = -1;
+	char *css;
+
+	if (argc > 1) {
+		rules = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		rounds = atoi(argv[2]);
+	}
+	css = CreateStyleSheet(rules, &len);
+	if (!css) {
+		return -1;
+	}
+	LCUI_InitBase();
+	for (i = 0; i < rounds; ++i) {
+		LCUI_InitCSSLibrary();
+		LCUI_InitCSSParser();
+		t = GetTimeMs();
+		LCUI_LoadCSSString(css, NULL);
+		t = GetTimeMs() - t;
+		if (best < 0 || t < best) {
+			best = t;
+		}
+		LCUI_FreeCSSParser();
+		LCUI_FreeCSSLibrary();
+	}
+	Logger_Info("%d rules, %.2f MB of css\n", rules, len / 1048576.0);
+	Logger_Info("parse: %.2fms, %.2f MB/s\n", best,
+		    len / 1048576.0 / (best / 1000.0));
+	free(css);
+	return 0;
+}
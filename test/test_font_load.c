@@ -1,10 +1,14 @@
-﻿#include <LCUI_Build.h>
+﻿#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
 #include <LCUI/font.h>
 #include <LCUI/gui/css_library.h>
 #include <LCUI/gui/css_parser.h>
 #include "test.h"
 
+#define FONT_INDEX_FILE "test_font_load.index"
 #define GetSegoeUIFont(S, W) LCUIFont_GetId( "Segoe UI", S, W )
 #define GetArialFont(S, W) LCUIFont_GetId( "Arial", S, W )
 
@@ -130,6 +134,149 @@ int test_arial_font_load( void )
 	return ret;
 }
 
+static void set_font_index_file( const char *path )
+{
+#ifdef LCUI_BUILD_IN_WIN32
+	char str[256];
+	snprintf( str, sizeof( str ), "LCUI_FONT_INDEX_FILE=%s", path ? path : "" );
+	_putenv( str );
+#else
+	if( path ) {
+		setenv( "LCUI_FONT_INDEX_FILE", path, 1 );
+	} else {
+		unsetenv( "LCUI_FONT_INDEX_FILE" );
+	}
+#endif
+}
+
+static int test_font_index( void )
+{
+	FILE *fp;
+	int i, ret = 0, id;
+	LCUI_FontBitmap bmp;
+
+	remove( FONT_INDEX_FILE );
+	set_font_index_file( FONT_INDEX_FILE );
+	/* 第一次载入时生成字体索引，第二次载入时直接使用索引 */
+	for( i = 0; i < 2; ++i ) {
+		LCUI_InitFontLibrary();
+		CHECK( LCUIFont_LoadFile( "test_font_load.ttf" ) == 0 );
+		CHECK( (id = LCUIFont_GetId( "icomoon", 0, 0 )) > 0 );
+		/* 字体在首次渲染字形时才会被真正打开 */
+		FontBitmap_Init( &bmp );
+		CHECK( LCUIFont_RenderBitmap( &bmp, '0', id, 16 ) == 0 );
+		CHECK( bmp.width > 0 && bmp.rows > 0 );
+		FontBitmap_Free( &bmp );
+		LCUI_FreeFontLibrary();
+		fp = fopen( FONT_INDEX_FILE, "r" );
+		CHECK_WITH_TEXT( "check font index file exists", fp != NULL );
+		if( fp ) {
+			fclose( fp );
+		}
+	}
+	set_font_index_file( NULL );
+	remove( FONT_INDEX_FILE );
+	return ret;
+}
+
+static int test_font_async_render( void )
+{
+	int ret = 0, id;
+	const LCUI_FontBitmap *bmp;
+
+	LCUI_InitFontLibrary();
+	CHECK( LCUIFont_LoadFile( "test_font_load.ttf" ) == 0 );
+	CHECK( (id = LCUIFont_GetId( "icomoon", 0, 0 )) > 0 );
+	/* 预先渲染的字形位图在渲染完后加入缓存 */
+	CHECK( LCUIFont_PrefetchBitmaps( L"0 0", id, 16 ) == 1 );
+	CHECK( LCUIFont_WaitBitmapRequests() == 1 );
+	CHECK( LCUIFont_GetBitmap( '0', id, 16, &bmp ) == 0 );
+	CHECK( bmp && bmp->width > 0 && bmp->rows > 0 );
+	/* 启用异步渲染后，未缓存的字形先用占位位图代替 */
+	LCUIFont_EnableAsyncRender( TRUE );
+	CHECK( LCUIFont_RequestBitmap( '0', id, 16, &bmp ) == 0 );
+	CHECK( LCUIFont_RequestBitmap( '0', id, 20, &bmp ) == 1 );
+	CHECK( bmp && bmp->advance.x == 10 && bmp->width == 0 );
+	CHECK( LCUIFont_RequestBitmap( 0x4E2D, id, 20, &bmp ) == 1 );
+	CHECK( bmp && bmp->advance.x == 20 );
+	CHECK( LCUIFont_WaitBitmapRequests() == 2 );
+	CHECK( LCUIFont_RequestBitmap( '0', id, 20, &bmp ) == 0 );
+	CHECK( bmp && bmp->width > 0 && bmp->rows > 0 );
+	/* 字体中没有的字符不会被反复渲染 */
+	CHECK( LCUIFont_RequestBitmap( 0x4E2D, id, 20, &bmp ) == -1 );
+	/* 替换字体后，之前失败的请求会被清除 */
+	CHECK( LCUIFont_LoadFile( "test_font_load.ttf" ) == 0 );
+	CHECK( LCUIFont_GetId( "icomoon", 0, 0 ) == id );
+	CHECK( LCUIFont_RequestBitmap( 0x4E2D, id, 20, &bmp ) == 1 );
+	CHECK( LCUIFont_WaitBitmapRequests() == 1 );
+	CHECK( LCUIFont_RequestBitmap( 0x4E2D, id, 20, &bmp ) == -1 );
+	LCUIFont_EnableAsyncRender( FALSE );
+	LCUI_FreeFontLibrary();
+	return ret;
+}
+
+static int test_font_metrics( void )
+{
+	int ret = 0, id;
+	LCUI_Graph canvas;
+	LCUI_TextLayer layer;
+	LCUI_TextStyleRec style;
+	LCUI_Rect area = { 0, 0, 64, 32 };
+	LCUI_Pos pos = { 0, 0 };
+	const LCUI_FontMetrics *metrics, *space;
+	const LCUI_FontBitmap *bmp;
+
+	LCUI_InitFontLibrary();
+	CHECK( LCUIFont_LoadFile( "test_font_load.ttf" ) == 0 );
+	CHECK( (id = LCUIFont_GetId( "icomoon", 0, 0 )) > 0 );
+	/* 获取度量数据不会渲染字形位图 */
+	LCUIFont_EnableAsyncRender( TRUE );
+	CHECK( LCUIFont_GetMetrics( '0', id, 24, &metrics ) == 0 );
+	CHECK( metrics && metrics->advance.x > 0 );
+	CHECK( LCUIFont_RequestBitmap( '0', id, 24, &bmp ) == 1 );
+	CHECK( LCUIFont_WaitBitmapRequests() == 1 );
+	CHECK( LCUIFont_GetBitmap( '0', id, 24, &bmp ) == 0 );
+	CHECK( bmp && bmp->advance.x == metrics->advance.x );
+	CHECK( bmp && bmp->left == metrics->left && bmp->top == metrics->top );
+	CHECK( LCUIFont_GetMetrics( 0x4E2D, id, 24, &metrics ) == -1 );
+
+	/* 文本图层按度量数据排版，在绘制时才渲染字形位图 */
+	layer = TextLayer_New();
+	TextStyle_Init( &style );
+	TextStyle_SetFont( &style, "icomoon" );
+	style.pixel_size = 20;
+	style.has_pixel_size = TRUE;
+	TextLayer_SetTextStyle( layer, &style );
+	TextLayer_SetTextW( layer, L"00", NULL );
+	TextLayer_Update( layer, NULL );
+	LCUIFont_GetMetrics( '0', id, 20, &metrics );
+	CHECK( TextLayer_GetWidth( layer ) == metrics->advance.x * 2 );
+	CHECK( LCUIFont_RequestBitmap( '0', id, 20, &bmp ) == 1 );
+	Graph_Init( &canvas );
+	canvas.color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create( &canvas, area.width, area.height );
+	TextLayer_RenderTo( layer, area, pos, &canvas );
+	CHECK( layer->bitmaps_pending );
+	CHECK( LCUIFont_WaitBitmapRequests() == 1 );
+	CHECK( TextLayer_ReloadPendingBitmaps( layer ) );
+	TextLayer_RenderTo( layer, area, pos, &canvas );
+	CHECK( !layer->bitmaps_pending );
+	CHECK( layer->text_rows.rows[0]->string[0].bitmap != NULL );
+	/* 空格没有字形位图，但它的跨距也计入文本宽度 */
+	TextLayer_SetTextW( layer, L"0 0", NULL );
+	TextLayer_Update( layer, NULL );
+	CHECK( LCUIFont_GetMetrics( ' ', id, 20, &space ) == 0 );
+	CHECK( space->advance.x > 0 );
+	CHECK( TextLayer_GetWidth( layer ) ==
+	       metrics->advance.x * 2 + space->advance.x );
+	Graph_Free( &canvas );
+	TextStyle_Destroy( &style );
+	TextLayer_Destroy( layer );
+	LCUIFont_EnableAsyncRender( FALSE );
+	LCUI_FreeFontLibrary();
+	return ret;
+}
+
 int test_font_load( void )
 {
 	int ret = 0;
@@ -142,6 +289,9 @@ int test_font_load( void )
 	ret += test_arial_font_load();
 #endif
 	LCUI_FreeFontLibrary();
+	ret += test_font_index();
+	ret += test_font_async_render();
+	ret += test_font_metrics();
 
 	LCUI_InitFontLibrary();
 	LCUI_InitCSSLibrary();
@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/font.h>
+
+#define CANVAS_WIDTH 1280
+#define CANVAS_HEIGHT 720
+#define REPEAT_TIMES 10
+
+/** The integer kernel may differ from the floating point one by rounding */
+#define MAX_CHANNEL_ERROR 1
+
+typedef struct GlyphSizeRec_ {
+	int width, rows;
+} GlyphSizeRec;
+
+static GlyphSizeRec glyph_sizes[] = { { 6, 11 }, { 9, 16 }, { 17, 24 },
+				      { 33, 40 } };
+
+/** The path used before the integer kernel, kept here as the reference */
+static void MixGlyphByOverPixel(LCUI_Graph *graph, LCUI_Pos pos,
+				const LCUI_FontBitmap *bmp, LCUI_Color color)
+{
+	int x, y;
+	LCUI_Color c;
+	LCUI_ARGB *px;
+	const uchar_t *byte_ptr = bmp->buffer;
+
+	for (y = 0; y < bmp->rows; ++y) {
+		px = graph->argb + (pos.y + y) * graph->width + pos.x;
+		for (x = 0; x < bmp->width; ++x, ++byte_ptr, ++px) {
+			c = color;
+			c.alpha = (uchar_t)(*byte_ptr * color.alpha / 255.0);
+			LCUI_OverPixel(px, &c);
+		}
+	}
+}
+
+/**
+ * Fill the bitmap with a coverage mask that looks like an anti-aliased
+ * glyph: mostly empty, a solid core and some partially covered edges.
+ */
+static void CreateGlyph(LCUI_FontBitmap *bmp, int width, int rows)
+{
+	int x, y, d;
+	uchar_t *p;
+
+	FontBitmap_Init(bmp);
+	FontBitmap_Create(bmp, width, rows);
+	for (p = bmp->buffer, y = 0; y < rows; ++y) {
+		for (x = 0; x < width; ++x, ++p) {
+			d = abs(2 * x - width) + abs(y - rows / 2);
+			if (d < width / 2) {
+				*p = 255;
+			} else if (d < width) {
+				*p = (uchar_t)(255 * (width - d) / (width / 2));
+			} else {
+				*p = 0;
+			}
+		}
+	}
+}
+
+static void FillCanvas(LCUI_Graph *graph, uchar_t alpha)
+{
+	int x, y;
+	LCUI_ARGB *px = graph->argb;
+
+	for (y = 0; y < (int)graph->height; ++y) {
+		for (x = 0; x < (int)graph->width; ++x, ++px) {
+			px->r = (uchar_t)(x * 255 / graph->width);
+			px->g = (uchar_t)(y * 255 / graph->height);
+			px->b = (uchar_t)((x + y) & 0xff);
+			px->a = alpha ? alpha : (uchar_t)((x * 7 + y) & 0xff);
+		}
+	}
+}
+
+static void DrawText(LCUI_Graph *graph, const LCUI_FontBitmap *bmp,
+		     LCUI_Color color, LCUI_BOOL reference)
+{
+	LCUI_Pos pos;
+
+	for (pos.y = 0; pos.y + bmp->rows <= (int)graph->height;
+	     pos.y += bmp->rows) {
+		for (pos.x = 0; pos.x + bmp->width <= (int)graph->width;
+		     pos.x += bmp->width) {
+			if (reference) {
+				MixGlyphByOverPixel(graph, pos, bmp, color);
+			} else {
+				FontBitmap_Mix(graph, pos, bmp, color);
+			}
+		}
+	}
+}
+
+static int CompareCanvas(const LCUI_Graph *a, const LCUI_Graph *b)
+{
+	size_t i, n = a->width * a->height;
+	int d, max_error = 0;
+
+	for (i = 0; i < n; ++i) {
+		/* The color of a fully transparent pixel does not matter */
+		if (a->argb[i].a == 0 && b->argb[i].a == 0) {
+			continue;
+		}
+		d = abs(a->argb[i].r - b->argb[i].r);
+		max_error = max(max_error, d);
+		d = abs(a->argb[i].g - b->argb[i].g);
+		max_error = max(max_error, d);
+		d = abs(a->argb[i].b - b->argb[i].b);
+		max_error = max(max_error, d);
+		d = abs(a->argb[i].a - b->argb[i].a);
+		max_error = max(max_error, d);
+	}
+	return max_error;
+}
+
+int main(int argc, char **argv)
+{
+	int ret = 0, error;
+	size_t i, j, k;
+	int64_t t_ref, t_new;
+	char s_size[32], s_ref[32], s_new[32], s_error[32];
+	LCUI_Color colors[] = { RGB(0, 0, 0), ARGB(200, 33, 150, 243) };
+	uchar_t backgrounds[] = { 255, 0 };
+	const char *background_names[] = { "opaque", "mixed" };
+	LCUI_FontBitmap bmp;
+	LCUI_Graph g_ref, g_new;
+
+	Graph_Init(&g_ref);
+	Graph_Init(&g_new);
+	g_ref.color_type = LCUI_COLOR_TYPE_ARGB;
+	g_new.color_type = LCUI_COLOR_TYPE_ARGB;
+	if (Graph_Create(&g_ref, CANVAS_WIDTH, CANVAS_HEIGHT) != 0 ||
+	    Graph_Create(&g_new, CANVAS_WIDTH, CANVAS_HEIGHT) != 0) {
+		return -2;
+	}
+	Logger_Info("%-10s%-12s%-8s%-14s%-14s%s\n", "glyph", "background",
+		    "color", "OverPixel", "FontBitmap", "max error");
+	for (i = 0; i < sizeof(glyph_sizes) / sizeof(glyph_sizes[0]); ++i) {
+		CreateGlyph(&bmp, glyph_sizes[i].width, glyph_sizes[i].rows);
+		sprintf(s_size, "%dx%d", bmp.width, bmp.rows);
+		for (j = 0; j < 4; ++j) {
+			FillCanvas(&g_ref, backgrounds[j / 2]);
+			FillCanvas(&g_new, backgrounds[j / 2]);
+			DrawText(&g_ref, &bmp, colors[j % 2], TRUE);
+			DrawText(&g_new, &bmp, colors[j % 2], FALSE);
+			error = CompareCanvas(&g_ref, &g_new);
+			t_ref = LCUI_GetTime();
+			for (k = 0; k < REPEAT_TIMES; ++k) {
+				DrawText(&g_ref, &bmp, colors[j % 2], TRUE);
+			}
+			t_ref = LCUI_GetTimeDelta(t_ref);
+			t_new = LCUI_GetTime();
+			for (k = 0; k < REPEAT_TIMES; ++k) {
+				DrawText(&g_new, &bmp, colors[j % 2], FALSE);
+			}
+			t_new = LCUI_GetTimeDelta(t_new);
+			sprintf(s_ref, "%.2fms", 1.0 * t_ref / REPEAT_TIMES);
+			sprintf(s_new, "%.2fms", 1.0 * t_new / REPEAT_TIMES);
+			sprintf(s_error, "%d", error);
+			if (error > MAX_CHANNEL_ERROR) {
+				strcat(s_error, " (too high!)");
+				ret -= 1;
+			}
+			Logger_Info("%-10s%-12s%-8s%-14s%-14s%s\n", s_size,
+				    background_names[j / 2],
+				    j % 2 ? "alpha" : "solid", s_ref, s_new,
+				    s_error);
+		}
+		FontBitmap_Free(&bmp);
+	}
+	Graph_Free(&g_ref);
+	Graph_Free(&g_new);
+	return ret;
+}
@@ -0,0 +1,587 @@
+﻿/*
+ * test_frame_bench.c -- End-to-end frame benchmark driven by XML/CSS scenes
+ *
+ * Each scene is written out as an XML file, loaded with LCUIBuilder_LoadFile()
+ * and styled by test_frame_bench.css, then driven through scripted mutations
+ * on the headless display driver. The per-phase frame times, allocation
+ * counts and RSS growth are written as JSON to the file given as the first
+ * argument, or to stdout.
+ *
+ * Frames are run by LCUI_RunFrameWithProfile(), and all phases are measured
+ * with the same monotonic wall clock. "style" covers the style refresh tasks
+ * of the widgets, "layout" covers the layout, resize and position tasks,
+ * "render" and "present" cover the display steps, and "frame" covers the
+ * scripted mutation and the whole frame.
+ *
+ * "rss_growth_kb" is the largest increase of the resident set size over
+ * the value before the scene was loaded, sampled after every frame.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/timer.h>
+#include <LCUI/display.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/builder.h>
+#include <LCUI/gui/css_parser.h>
+#include <LCUI/gui/widget/textview.h>
+#include <LCUI/gui/widget/scrollbar.h>
+
+#ifdef LCUI_BUILD_IN_LINUX
+#include <unistd.h>
+#endif
+
+#define CSS_FILE "test_frame_bench.css"
+#define XML_FILE "test_frame_bench.tmp.xml"
+
+#define SCREEN_WIDTH 1280
+#define SCREEN_HEIGHT 720
+#define SCENE_FRAMES 120
+#define WARMUP_MAX_FRAMES 300
+
+#define LIST_ITEMS 10000
+#define NESTED_CHAINS 32
+/* Leave room for the ancestors, selectors are limited to MAX_SELECTOR_DEPTH */
+#define NESTED_DEPTH (MAX_SELECTOR_DEPTH - 8)
+#define SHADOW_CARDS 300
+#define TEXT_LINES 1000
+#define OVERLAY_LAYERS 6
+#define FLEX_ROWS 60
+#define FLEX_ITEMS 16
+
+enum BenchPhase {
+	PHASE_STYLE,
+	PHASE_LAYOUT,
+	PHASE_RENDER,
+	PHASE_PRESENT,
+	PHASE_FRAME,
+	PHASE_TOTAL_NUM
+};
+
+static const char *phase_names[PHASE_TOTAL_NUM] = { "style", "layout", "render",
+						    "present", "frame" };
+
+typedef struct BenchSceneRec_ {
+	const char *name;
+	void (*build)(FILE *);
+	void (*update)(int);
+} BenchSceneRec, *BenchScene;
+
+typedef struct BenchResultRec_ {
+	size_t widgets;
+	size_t frames;
+	size_t warmup_frames;
+	size_t build_allocations;
+	size_t allocations;
+	long rss_growth_kb;
+	double times[PHASE_TOTAL_NUM][SCENE_FRAMES];
+} BenchResultRec, *BenchResult;
+
+/*
+ * Allocation counting
+ *
+ * On glibc the allocator entry points can be interposed by the executable,
+ * which also catches the allocations made inside libLCUI.
+ */
+
+#if defined(__GLIBC__) && !defined(BENCH_NO_ALLOC_HOOKS)
+
+#define HAVE_ALLOC_HOOKS
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static volatile size_t alloc_count;
+
+void *malloc(size_t size)
+{
+	__sync_fetch_and_add(&alloc_count, 1);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	__sync_fetch_and_add(&alloc_count, 1);
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	__sync_fetch_and_add(&alloc_count, 1);
+	return __libc_realloc(ptr, size);
+}
+
+static size_t GetAllocCount(void)
+{
+	return __sync_fetch_and_add(&alloc_count, 0);
+}
+
+#else
+
+static size_t GetAllocCount(void)
+{
+	return 0;
+}
+
+#endif
+
+/* The current resident set size, ru_maxrss only has the peak of the process */
+static long GetRSS(void)
+{
+#ifdef LCUI_BUILD_IN_LINUX
+	long pages = -1;
+	FILE *fp = fopen("/proc/self/statm", "r");
+
+	if (fp) {
+		if (fscanf(fp, "%*s %ld", &pages) != 1) {
+			pages = -1;
+		}
+		fclose(fp);
+	}
+	if (pages >= 0) {
+		return pages * (sysconf(_SC_PAGESIZE) / 1024);
+	}
+#endif
+	return -1;
+}
+
+/* The same monotonic clock is used by the widget task profile */
+static double GetTimeMs(void)
+{
+	return LCUI_GetTimeUs() / 1000.0;
+}
+
+static void LogToStderr(const char *str)
+{
+	fputs(str, stderr);
+}
+
+static LCUI_Widget GetChild(const char *id, size_t index)
+{
+	LCUI_Widget w = LCUIWidget_GetById(id);
+
+	return w ? Widget_GetChild(w, index) : NULL;
+}
+
+static void ToggleClass(LCUI_Widget w, const char *class_name)
+{
+	if (!w) {
+		return;
+	}
+	if (Widget_HasClass(w, class_name)) {
+		Widget_RemoveClass(w, class_name);
+	} else {
+		Widget_AddClass(w, class_name);
+	}
+}
+
+static void WriteCards(FILE *fp, int n)
+{
+	int i;
+
+	for (i = 0; i < n; ++i) {
+		fprintf(fp, "<w class=\"card\" />\n");
+	}
+}
+
+/* list: 10k items in a scrolled container */
+
+static void BuildListScene(FILE *fp)
+{
+	int i;
+
+	fprintf(fp, "<w id=\"list\" class=\"list\">\n"
+		    "<w id=\"list-content\" class=\"list-content\">\n");
+	for (i = 0; i < LIST_ITEMS; ++i) {
+		fprintf(fp,
+			"<w class=\"list-item\"><w type=\"textview\" "
+			"class=\"list-item-text\">Item #%d</w></w>\n",
+			i);
+	}
+	fprintf(fp, "</w>\n<w id=\"list-scrollbar\" type=\"scrollbar\" "
+		    "target=\"list-content\" />\n</w>\n");
+}
+
+static void UpdateListScene(int frame)
+{
+	LCUI_Widget scrollbar = LCUIWidget_GetById("list-scrollbar");
+
+	ScrollBar_SetPosition(scrollbar, frame * 48);
+	ToggleClass(GetChild("list-content", (frame * 37) % LIST_ITEMS),
+		    "active");
+}
+
+/* nested: deep chains of wrappers */
+
+static void BuildNestedScene(FILE *fp)
+{
+	int i, j;
+
+	fprintf(fp, "<w id=\"nested\" class=\"nested\">\n");
+	for (i = 0; i < NESTED_CHAINS; ++i) {
+		for (j = 0; j < NESTED_DEPTH; ++j) {
+			fprintf(fp, "<w class=\"nested-box\">");
+		}
+		fprintf(fp, "<w type=\"textview\">Chain #%d</w>", i);
+		for (j = 0; j < NESTED_DEPTH; ++j) {
+			fprintf(fp, "</w>");
+		}
+		fprintf(fp, "\n");
+	}
+	fprintf(fp, "</w>\n");
+}
+
+static void UpdateNestedScene(int frame)
+{
+	ToggleClass(LCUIWidget_GetById("nested"), "wide");
+}
+
+/* shadows: cards with box-shadow and border-radius */
+
+static void BuildShadowScene(FILE *fp)
+{
+	fprintf(fp, "<w id=\"cards\">\n");
+	WriteCards(fp, SHADOW_CARDS);
+	fprintf(fp, "</w>\n");
+}
+
+static void UpdateShadowScene(int frame)
+{
+	ToggleClass(GetChild("cards", (frame * 7) % SHADOW_CARDS), "raised");
+}
+
+/* text: a large textview */
+
+static char *CreateText(int version)
+{
+	int i;
+	size_t len = 0, size = TEXT_LINES * 96;
+	char *text = malloc(size);
+
+	if (!text) {
+		return NULL;
+	}
+	for (i = 0; i < TEXT_LINES; ++i) {
+		len += snprintf(text + len, size - len,
+				"%04d: The quick brown fox jumps over the "
+				"lazy dog, revision %d.\n",
+				i, i % 50 == 0 ? version : 0);
+	}
+	return text;
+}
+
+static void BuildTextScene(FILE *fp)
+{
+	char *text = CreateText(0);
+
+	fprintf(fp,
+		"<w id=\"text-box\" class=\"text-box\">\n"
+		"<w id=\"text-content\" type=\"textview\" "
+		"class=\"text-content\">%s</w>\n"
+		"<w id=\"text-scrollbar\" type=\"scrollbar\" "
+		"target=\"text-content\" />\n</w>\n",
+		text ? text : "");
+	free(text);
+}
+
+static void UpdateTextScene(int frame)
+{
+	char *text;
+
+	ScrollBar_SetPosition(LCUIWidget_GetById("text-scrollbar"),
+			      frame * 20);
+	if (frame % 8 != 0) {
+		return;
+	}
+	text = CreateText(frame);
+	if (text) {
+		TextView_SetText(LCUIWidget_GetById("text-content"), text);
+		free(text);
+	}
+}
+
+/* overlays: stacked translucent layers on top of some content */
+
+static void BuildOverlayScene(FILE *fp)
+{
+	int i;
+
+	fprintf(fp, "<w id=\"overlays\">\n");
+	WriteCards(fp, SHADOW_CARDS / 4);
+	for (i = 0; i < OVERLAY_LAYERS; ++i) {
+		fprintf(fp, "<w class=\"overlay\"><w class=\"overlay-panel\">"
+			    "<w type=\"textview\">Overlay</w></w></w>\n");
+	}
+	fprintf(fp, "</w>\n");
+}
+
+static void UpdateOverlayScene(int frame)
+{
+	int i = SHADOW_CARDS / 4 + frame % OVERLAY_LAYERS;
+
+	ToggleClass(GetChild("overlays", i), "dimmed");
+}
+
+/* flex: rows of flexible items, with display resizes */
+
+static void BuildFlexScene(FILE *fp)
+{
+	int i, j;
+
+	fprintf(fp, "<w id=\"rows\">\n");
+	for (i = 0; i < FLEX_ROWS; ++i) {
+		fprintf(fp, "<w class=\"flex-row\">");
+		for (j = 0; j < FLEX_ITEMS; ++j) {
+			fprintf(fp, "<w class=\"flex-item\" />");
+		}
+		fprintf(fp, "</w>\n");
+	}
+	fprintf(fp, "</w>\n");
+}
+
+static void UpdateFlexScene(int frame)
+{
+	ToggleClass(GetChild("rows", frame % FLEX_ROWS), "compact");
+	if (frame % 10 == 0) {
+		if (frame % 20 == 0) {
+			LCUIDisplay_SetSize(SCREEN_WIDTH * 4 / 5, SCREEN_HEIGHT);
+		} else {
+			LCUIDisplay_SetSize(SCREEN_WIDTH, SCREEN_HEIGHT);
+		}
+	}
+}
+
+static BenchSceneRec scenes[] = {
+	{ "list", BuildListScene, UpdateListScene },
+	{ "nested", BuildNestedScene, UpdateNestedScene },
+	{ "shadows", BuildShadowScene, UpdateShadowScene },
+	{ "text", BuildTextScene, UpdateTextScene },
+	{ "overlays", BuildOverlayScene, UpdateOverlayScene },
+	{ "flex", BuildFlexScene, UpdateFlexScene }
+};
+
+static size_t CountWidgets(LCUI_Widget w)
+{
+	size_t count = 1;
+	LinkedListNode *node;
+
+	for (LinkedList_Each(node, &w->children)) {
+		count += CountWidgets(node->data);
+	}
+	return count;
+}
+
+static int LoadScene(BenchScene scene)
+{
+	FILE *fp;
+	LCUI_Widget pack;
+
+	fp = fopen(XML_FILE, "w");
+	if (!fp) {
+		return -1;
+	}
+	fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+		    "<lcui-app>\n<ui>\n<w class=\"scene\">\n");
+	scene->build(fp);
+	fprintf(fp, "</w>\n</ui>\n</lcui-app>\n");
+	fclose(fp);
+	pack = LCUIBuilder_LoadFile(XML_FILE);
+	remove(XML_FILE);
+	if (!pack) {
+		return -2;
+	}
+	Widget_Append(LCUIWidget_GetRoot(), pack);
+	Widget_Unwrap(pack);
+	return 0;
+}
+
+/* Run a frame and take the wall-clock time of each phase from its profile */
+static void RunFrame(LCUI_FrameProfile profile, double *times)
+{
+	memset(profile, 0, sizeof(LCUI_FrameProfileRec));
+	LCUI_RunFrameWithProfile(profile);
+	times[PHASE_STYLE] = profile->widget_tasks.style_time / 1000.0;
+	times[PHASE_LAYOUT] = profile->widget_tasks.layout_time / 1000.0;
+	times[PHASE_RENDER] = profile->render_wall_time / 1000.0;
+	times[PHASE_PRESENT] = profile->present_wall_time / 1000.0;
+}
+
+static void UpdateRSSGrowth(BenchResult result, long base_rss)
+{
+	long rss = GetRSS();
+
+	if (base_rss >= 0 && rss - base_rss > result->rss_growth_kb) {
+		result->rss_growth_kb = rss - base_rss;
+	}
+}
+
+static int RunScene(BenchScene scene, BenchResult result)
+{
+	int i, j;
+	double t, times[PHASE_TOTAL_NUM];
+	size_t allocs;
+	long base_rss;
+	LCUI_FrameProfileRec profile;
+
+	memset(result, 0, sizeof(BenchResultRec));
+	LCUIDisplay_SetSize(SCREEN_WIDTH, SCREEN_HEIGHT);
+	base_rss = GetRSS();
+	result->rss_growth_kb = base_rss >= 0 ? 0 : -1;
+	allocs = GetAllocCount();
+	if (LoadScene(scene) != 0) {
+		return -1;
+	}
+	UpdateRSSGrowth(result, base_rss);
+	/* Let the progressive widget update settle before measuring */
+	for (i = 0; i < WARMUP_MAX_FRAMES; ++i) {
+		RunFrame(&profile, times);
+		UpdateRSSGrowth(result, base_rss);
+		if (profile.widget_tasks.update_count == 0 &&
+		    profile.render_count == 0) {
+			break;
+		}
+	}
+	result->warmup_frames = i;
+	result->build_allocations = GetAllocCount() - allocs;
+	result->widgets = CountWidgets(LCUIWidget_GetRoot()) - 1;
+	allocs = GetAllocCount();
+	for (i = 0; i < SCENE_FRAMES; ++i) {
+		t = GetTimeMs();
+		scene->update(i);
+		RunFrame(&profile, times);
+		times[PHASE_FRAME] = GetTimeMs() - t;
+		UpdateRSSGrowth(result, base_rss);
+		for (j = 0; j < PHASE_TOTAL_NUM; ++j) {
+			result->times[j][i] = times[j];
+		}
+	}
+	result->frames = SCENE_FRAMES;
+	result->allocations = GetAllocCount() - allocs;
+	Widget_Empty(LCUIWidget_GetRoot());
+	RunFrame(&profile, times);
+	return 0;
+}
+
+static int CompareDouble(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static double GetPercentile(const double *sorted, size_t n, int percent)
+{
+	size_t i = (n * percent + 99) / 100;
+
+	return sorted[i > 0 ? i - 1 : 0];
+}
+
+static void WritePhase(FILE *fp, const char *name, double *times, size_t n)
+{
+	qsort(times, n, sizeof(double), CompareDouble);
+	fprintf(fp,
+		"        \"%s\": { \"p50\": %.3f, \"p90\": %.3f, "
+		"\"p99\": %.3f, \"max\": %.3f }",
+		name, GetPercentile(times, n, 50), GetPercentile(times, n, 90),
+		GetPercentile(times, n, 99), times[n - 1]);
+}
+
+static void WriteResult(FILE *fp, BenchScene scene, BenchResult result)
+{
+	int i;
+
+	fprintf(fp,
+		"    {\n"
+		"      \"name\": \"%s\",\n"
+		"      \"widgets\": %zu,\n"
+		"      \"warmup_frames\": %zu,\n"
+		"      \"frames\": %zu,\n"
+		"      \"time_ms\": {\n",
+		scene->name, result->widgets, result->warmup_frames,
+		result->frames);
+	for (i = 0; i < PHASE_TOTAL_NUM; ++i) {
+		WritePhase(fp, phase_names[i], result->times[i],
+			   result->frames);
+		fprintf(fp, i + 1 < PHASE_TOTAL_NUM ? ",\n" : "\n");
+	}
+	fprintf(fp,
+		"      },\n"
+		"      \"build_allocations\": %zu,\n"
+		"      \"allocations\": %zu,\n"
+		"      \"allocations_per_frame\": %.1f,\n"
+		"      \"rss_growth_kb\": %ld\n"
+		"    }",
+		result->build_allocations, result->allocations,
+		1.0 * result->allocations / result->frames,
+		result->rss_growth_kb);
+}
+
+int main(int argc, char **argv)
+{
+	int ret = 0;
+	size_t i, n = sizeof(scenes) / sizeof(scenes[0]);
+	FILE *fp = stdout;
+	BenchResult results;
+
+	results = calloc(n, sizeof(BenchResultRec));
+	if (!results) {
+		return -ENOMEM;
+	}
+	if (argc > 1) {
+		fp = fopen(argv[1], "w");
+		if (!fp) {
+			fprintf(stderr, "cannot open %s\n", argv[1]);
+			free(results);
+			return -1;
+		}
+	} else {
+		/* Keep stdout clean for the JSON output */
+		Logger_SetHandler(LogToStderr);
+	}
+	LCUI_InitBase();
+	LCUI_InitApp(NULL);
+	LCUI_InitDisplay(LCUI_CreateHeadlessDisplayDriver());
+	LCUI_Init();
+	LCUIMetrics_SetScale(1.0f);
+	if (LCUI_LoadCSSFile(CSS_FILE) != 0) {
+		fprintf(stderr, "cannot load %s\n", CSS_FILE);
+		ret = -1;
+	}
+	for (i = 0; ret == 0 && i < n; ++i) {
+		if (RunScene(&scenes[i], &results[i]) != 0) {
+			fprintf(stderr, "cannot load scene: %s\n",
+				scenes[i].name);
+			ret = -1;
+		}
+	}
+	if (ret == 0) {
+		fprintf(fp,
+			"{\n  \"version\": \"%s\",\n"
+			"  \"screen\": { \"width\": %d, \"height\": %d },\n"
+			"  \"alloc_hooks\": %s,\n  \"scenes\": [\n",
+			LCUI_GetVersion(), SCREEN_WIDTH, SCREEN_HEIGHT,
+#ifdef HAVE_ALLOC_HOOKS
+			"true"
+#else
+			"false"
+#endif
+		);
+		for (i = 0; i < n; ++i) {
+			WriteResult(fp, &scenes[i], &results[i]);
+			fprintf(fp, i + 1 < n ? ",\n" : "\n");
+		}
+		fprintf(fp, "  ]\n}\n");
+	}
+	if (fp != stdout) {
+		fclose(fp);
+	}
+	free(results);
+	LCUI_Destroy();
+	return ret;
+}
@@ -0,0 +1,308 @@
+﻿#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/cursor.h>
+#include <LCUI/display.h>
+#include <LCUI/image.h>
+#include <LCUI/surface.h>
+#include <LCUI/gui/widget.h>
+#include "test.h"
+
+#define SCREEN_WIDTH 400
+#define SCREEN_HEIGHT 300
+#define BLOCK_SIZE 100
+#define PNG_FILE "test_headless_display.png"
+
+static LCUI_Widget create_block(float x, float y, LCUI_Color color)
+{
+	LCUI_Widget w = LCUIWidget_New(NULL);
+
+	Widget_Resize(w, BLOCK_SIZE, BLOCK_SIZE);
+	Widget_SetPosition(w, SV_ABSOLUTE);
+	Widget_Move(w, x, y);
+	Widget_SetStyle(w, key_background_color, color, color);
+	Widget_Append(LCUIWidget_GetRoot(), w);
+	return w;
+}
+
+static int check_color(LCUI_Graph *canvas, int x, int y, LCUI_Color expected)
+{
+	LCUI_Color color;
+
+	Graph_GetPixel(canvas, x, y, color);
+	return color.r == expected.r && color.g == expected.g &&
+	       color.b == expected.b;
+}
+
+static int check_png_file(void)
+{
+	int ret;
+	LCUI_Graph img;
+	LCUI_Graph *canvas = LCUIHeadlessDisplay_GetCanvas(NULL);
+
+	Graph_Init(&img);
+	if (LCUIHeadlessDisplay_WritePNG(NULL, PNG_FILE) != 0) {
+		return 0;
+	}
+	ret = LCUI_ReadImageFile(PNG_FILE, &img) == 0 &&
+	      img.width == canvas->width && img.height == canvas->height;
+	remove(PNG_FILE);
+	Graph_Free(&img);
+	return ret;
+}
+
+/** 检查缩放后的背景图是否与直接缩放的结果一致 */
+static int check_background(LCUI_Widget w, const LCUI_Graph *image)
+{
+	int x, y;
+	LCUI_Graph zoomed;
+	LCUI_Color expected, actual;
+	LCUI_Graph *canvas = LCUIHeadlessDisplay_GetCanvas(NULL);
+
+	Graph_Init(&zoomed);
+	Graph_Zoom(image, &zoomed, FALSE, (int)w->width, (int)w->height);
+	for (y = 0; y < (int)w->height; y += 7) {
+		for (x = 0; x < (int)w->width; x += 7) {
+			Graph_GetPixel(&zoomed, x, y, expected);
+			Graph_GetPixel(canvas, (int)w->x + x, (int)w->y + y,
+				       actual);
+			if (expected.value != actual.value) {
+				Graph_Free(&zoomed);
+				return 0;
+			}
+		}
+	}
+	Graph_Free(&zoomed);
+	return 1;
+}
+
+/** 移动游标时只需恢复和保存游标下的内容，不必重绘部件 */
+static int test_cursor_save_under(LCUI_Widget block)
+{
+	int ret = 0;
+	size_t count;
+	uint32_t checksum;
+	LCUI_Pos pos = { 220, 40 };
+	LCUI_Rect rect = { 220, 40, 12, 19 };
+	LCUI_Color red = RGB(255, 0, 0);
+	LCUI_Graph *canvas = LCUIHeadlessDisplay_GetCanvas(NULL);
+
+	LCUICursor_Hide();
+	LCUIHeadlessDisplay_StepFrames(1);
+	checksum = LCUIHeadlessDisplay_GetChecksum(NULL, &rect);
+	LCUICursor_SetPos(pos);
+	LCUICursor_Show();
+	LCUIHeadlessDisplay_StepFrames(1);
+	CHECK_WITH_TEXT("draw the cursor",
+			checksum != LCUIHeadlessDisplay_GetChecksum(NULL, &rect));
+
+	pos.x += 30;
+	LCUICursor_SetPos(pos);
+	LCUICursor_Update();
+	LCUIDisplay_Update();
+	count = LCUIDisplay_Render();
+	LCUIDisplay_Present();
+	CHECK_WITH_TEXT("moving the cursor does not repaint widgets",
+			count == 1);
+	CHECK_WITH_TEXT("restore the content under the cursor",
+			checksum == LCUIHeadlessDisplay_GetChecksum(NULL, &rect));
+
+	/* 重绘游标下的部件后，保存的内容也应该更新 */
+	Widget_SetStyle(block, key_background_color, red, color);
+	Widget_UpdateStyle(block, FALSE);
+	LCUIHeadlessDisplay_StepFrames(2);
+	LCUICursor_Hide();
+	LCUIHeadlessDisplay_StepFrames(1);
+	CHECK(check_color(canvas, pos.x + 2, pos.y + 5, red));
+	checksum = LCUIHeadlessDisplay_GetChecksum(NULL, NULL);
+	Widget_InvalidateArea(LCUIWidget_GetRoot(), NULL, SV_BORDER_BOX);
+	LCUIHeadlessDisplay_StepFrames(1);
+	CHECK_WITH_TEXT("no cursor trails are left",
+			checksum == LCUIHeadlessDisplay_GetChecksum(NULL, NULL));
+	return ret;
+}
+
+static void create_gradient_image(LCUI_Graph *image, int shift)
+{
+	int x, y;
+
+	Graph_Init(image);
+	image->color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create(image, 16, 16);
+	for (y = 0; y < 16; ++y) {
+		for (x = 0; x < 16; ++x) {
+			Graph_SetPixel(image, x, y,
+				       ARGB(255, x * 16, y * 16, shift));
+		}
+	}
+}
+
+static int test_background_cache(void)
+{
+	int ret = 0;
+	unsigned generation;
+	uint32_t checksum;
+	LCUI_Graph image, image2;
+	LCUI_Color white = RGB(255, 255, 255);
+	LCUI_Widget w = LCUIWidget_New(NULL);
+
+	create_gradient_image(&image, 128);
+	create_gradient_image(&image2, 32);
+	Widget_Resize(w, 128, 128);
+	Widget_SetPosition(w, SV_ABSOLUTE);
+	Widget_Move(w, 200, 160);
+	Widget_SetStyle(w, key_background_image, &image, image);
+	Widget_SetStyle(w, key_background_size, SV_COVER, style);
+	Widget_Append(LCUIWidget_GetRoot(), w);
+	LCUIHeadlessDisplay_StepFrames(2);
+	CHECK(check_background(w, &image));
+
+	/* 重绘时使用缓存的背景图，结果应该不变 */
+	checksum = LCUIHeadlessDisplay_GetChecksum(NULL, NULL);
+	Widget_InvalidateArea(w, NULL, SV_BORDER_BOX);
+	LCUIHeadlessDisplay_StepFrames(1);
+	CHECK(checksum == LCUIHeadlessDisplay_GetChecksum(NULL, NULL));
+
+	/* 尺寸变化后需要重新缩放 */
+	Widget_Resize(w, 96, 96);
+	LCUIHeadlessDisplay_StepFrames(2);
+	CHECK(check_background(w, &image));
+
+	/* 只修改背景色时，背景图的版本号不变，缓存的背景图仍然可用 */
+	generation = w->computed_style.background.image_generation;
+	Widget_SetStyle(w, key_background_color, white, color);
+	Widget_UpdateStyle(w, FALSE);
+	LCUIHeadlessDisplay_StepFrames(2);
+	CHECK(generation == w->computed_style.background.image_generation);
+	CHECK(check_background(w, &image));
+
+	/* 更换背景图后需要重新缩放 */
+	Widget_SetStyle(w, key_background_image, &image2, image);
+	Widget_UpdateStyle(w, FALSE);
+	LCUIHeadlessDisplay_StepFrames(2);
+	CHECK(generation != w->computed_style.background.image_generation);
+	CHECK(check_background(w, &image2));
+
+	Widget_Destroy(w);
+	LCUIHeadlessDisplay_StepFrames(1);
+	Graph_Free(&image);
+	Graph_Free(&image2);
+	return ret;
+}
+
+/** 太高的背景图无法整张缩放，只缩放需要绘制的部分 */
+static int test_tall_background(void)
+{
+	int ret = 0;
+	LCUI_Graph image;
+	LCUI_Color color = ARGB(255, 0, 0, 128);
+	LCUI_Widget w = LCUIWidget_New(NULL);
+	LCUI_Graph *canvas = LCUIHeadlessDisplay_GetCanvas(NULL);
+
+	Graph_Init(&image);
+	image.color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create(&image, 80, 1500);
+	Graph_FillRect(&image, color, NULL, TRUE);
+	Widget_Resize(w, 800, 15000);
+	Widget_SetPosition(w, SV_ABSOLUTE);
+	Widget_Move(w, 0, 0);
+	Widget_SetStyle(w, key_background_image, &image, image);
+	Widget_SetStyle(w, key_background_size_width, 800, px);
+	Widget_SetStyle(w, key_background_size_height, 15000, px);
+	Widget_Append(LCUIWidget_GetRoot(), w);
+	LCUIHeadlessDisplay_StepFrames(2);
+	CHECK_WITH_TEXT("paint a background taller than a graph can be",
+			check_color(canvas, 0, 0, color) &&
+			    check_color(canvas, 300, 250, color));
+	Widget_Destroy(w);
+	LCUIHeadlessDisplay_StepFrames(1);
+	Graph_Free(&image);
+	return ret;
+}
+
+static void present_surfaces(LCUI_Widget w, LCUI_WidgetEvent e, void *arg)
+{
+	LCUI_Surface *surfaces = e->data;
+
+	Surface_Present(surfaces[0]);
+	Surface_Present(surfaces[1]);
+}
+
+static int test_frame_count(void)
+{
+	int ret = 0;
+	LCUI_Widget w;
+	LCUI_Surface surfaces[2];
+
+	/* 一帧内呈现了多个 surface 时仍然只计为一帧 */
+	surfaces[0] = Surface_New();
+	surfaces[1] = Surface_New();
+	w = LCUIWidget_New(NULL);
+	Widget_BindEvent(w, "ready", present_surfaces, surfaces, NULL);
+	Widget_Append(LCUIWidget_GetRoot(), w);
+	CHECK_WITH_TEXT("count frames instead of surface presents",
+			LCUIHeadlessDisplay_StepFrames(1) == 1);
+	Widget_Destroy(w);
+	LCUIHeadlessDisplay_StepFrames(1);
+	Surface_Destroy(surfaces[0]);
+	Surface_Destroy(surfaces[1]);
+	return ret;
+}
+
+int test_headless_display(void)
+{
+	int ret = 0;
+	uint32_t checksum;
+	LCUI_Rect rect_a = { 20, 20, BLOCK_SIZE, BLOCK_SIZE };
+	LCUI_Rect rect_b = { 200, 20, BLOCK_SIZE, BLOCK_SIZE };
+	LCUI_Color red = RGB(255, 0, 0);
+	LCUI_Color blue = RGB(0, 0, 255);
+	LCUI_Color white = RGB(255, 255, 255);
+	LCUI_Widget block;
+	LCUI_Graph *canvas;
+
+	LCUI_InitBase();
+	LCUI_InitApp(NULL);
+	LCUI_InitDisplay(LCUI_CreateHeadlessDisplayDriver());
+	LCUI_Init();
+	LCUIMetrics_SetScale(1.0f);
+	LCUIDisplay_SetSize(SCREEN_WIDTH, SCREEN_HEIGHT);
+	create_block(20, 20, red);
+	block = create_block(200, 20, red);
+
+	CHECK(LCUIHeadlessDisplay_StepFrames(2) > 0);
+	canvas = LCUIHeadlessDisplay_GetCanvas(NULL);
+	CHECK(canvas != NULL);
+	if (!canvas) {
+		LCUI_Destroy();
+		return ret;
+	}
+	CHECK(canvas->width == SCREEN_WIDTH && canvas->height == SCREEN_HEIGHT);
+	CHECK(check_color(canvas, 50, 50, red));
+	CHECK(check_color(canvas, 150, 200, white));
+	CHECK(LCUIHeadlessDisplay_GetChecksum(NULL, &rect_a) ==
+	      LCUIHeadlessDisplay_GetChecksum(NULL, &rect_b));
+
+	checksum = LCUIHeadlessDisplay_GetChecksum(NULL, NULL);
+	LCUIHeadlessDisplay_StepFrames(2);
+	CHECK_WITH_TEXT("checksum is stable without changes",
+			checksum == LCUIHeadlessDisplay_GetChecksum(NULL, NULL));
+
+	Widget_SetStyle(block, key_background_color, blue, color);
+	Widget_UpdateStyle(block, FALSE);
+	LCUIHeadlessDisplay_StepFrames(2);
+	CHECK(check_color(canvas, 250, 50, blue));
+	CHECK_WITH_TEXT("checksum changes after repainting",
+			checksum != LCUIHeadlessDisplay_GetChecksum(NULL, NULL));
+	CHECK(LCUIHeadlessDisplay_GetChecksum(NULL, &rect_a) !=
+	      LCUIHeadlessDisplay_GetChecksum(NULL, &rect_b));
+	CHECK(check_png_file());
+	ret += test_cursor_save_under(block);
+	ret += test_background_cache();
+	ret += test_tall_background();
+	ret += test_frame_count();
+
+	LCUI_Destroy();
+	return ret;
+}
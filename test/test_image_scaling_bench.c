@@ -1,50 +1,163 @@
+#include <math.h>
 #include <stdlib.h>
-#include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
-#include <LCUI/timer.h>
-#include <LCUI/display.h>
-#include <LCUI/gui/widget.h>
-#include <LCUI/gui/builder.h>
 #include <LCUI/graph.h>
-#include <LCUI/image.h>
+
+#define SOURCE_WIDTH 960
+#define SOURCE_HEIGHT 540
+#define REPEAT_TIMES 5
+#define SUPERSAMPLING 2
+
+/** Filtered methods must stay above this quality on the test pattern */
+#define MIN_FILTERED_PSNR 30.0
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct ScalingMethodRec_ {
+	const char *name;
+	LCUI_GraphResampleFilter filter;
+} ScalingMethodRec;
+
+static ScalingMethodRec methods[] = {
+	{ "nearest", LCUI_RESAMPLE_NEAREST },
+	{ "bilinear", LCUI_RESAMPLE_BILINEAR },
+	{ "box", LCUI_RESAMPLE_BOX },
+	{ "lanczos3", LCUI_RESAMPLE_LANCZOS3 }
+};
+
+/**
+ * A smooth test pattern defined on continuous source coordinates, so that the
+ * reference image of any size can be computed directly from it instead of
+ * from another resampled image.
+ */
+static double Pattern(int channel, double x, double y)
+{
+	switch (channel) {
+	case 0:
+		return 127.5 + 127.5 * sin(2 * M_PI * x / 97.0) *
+				   cos(2 * M_PI * y / 61.0);
+	case 1:
+		return 127.5 + 127.5 * sin(2 * M_PI * (x + y) / 131.0);
+	default:
+		break;
+	}
+	return 255.0 * x / SOURCE_WIDTH;
+}
+
+static uchar_t PatternPixel(int channel, double x, double y, double scale_x,
+			    double scale_y)
+{
+	int i, j;
+	double sum = 0;
+
+	/* Average the pattern over the footprint of the pixel */
+	for (i = 0; i < SUPERSAMPLING; ++i) {
+		for (j = 0; j < SUPERSAMPLING; ++j) {
+			sum += Pattern(
+			    channel,
+			    (x + (j + 0.5) / SUPERSAMPLING) * scale_x,
+			    (y + (i + 0.5) / SUPERSAMPLING) * scale_y);
+		}
+	}
+	sum /= SUPERSAMPLING * SUPERSAMPLING;
+	return (uchar_t)(sum + 0.5);
+}
+
+static int CreatePatternImage(LCUI_Graph *graph, int width, int height)
+{
+	int x, y;
+	LCUI_ARGB *px;
+	double scale_x = 1.0 * SOURCE_WIDTH / width;
+	double scale_y = 1.0 * SOURCE_HEIGHT / height;
+
+	Graph_Init(graph);
+	graph->color_type = LCUI_COLOR_TYPE_ARGB;
+	if (Graph_Create(graph, width, height) != 0) {
+		return -1;
+	}
+	px = graph->argb;
+	for (y = 0; y < height; ++y) {
+		for (x = 0; x < width; ++x, ++px) {
+			px->r = PatternPixel(0, x, y, scale_x, scale_y);
+			px->g = PatternPixel(1, x, y, scale_x, scale_y);
+			px->b = PatternPixel(2, x, y, scale_x, scale_y);
+			px->a = 255;
+		}
+	}
+	return 0;
+}
+
+static double ComputePSNR(const LCUI_Graph *a, const LCUI_Graph *b)
+{
+	size_t i, n;
+	double d, mse = 0;
+
+	n = a->width * a->height;
+	for (i = 0; i < n; ++i) {
+		d = a->argb[i].r - b->argb[i].r;
+		mse += d * d;
+		d = a->argb[i].g - b->argb[i].g;
+		mse += d * d;
+		d = a->argb[i].b - b->argb[i].b;
+		mse += d * d;
+	}
+	mse /= n * 3.0;
+	if (mse == 0) {
+		return 99.0;
+	}
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
 
 int main(int argc, char **argv)
 {
-	int i;
-	int64_t t0, t1, t2;
-	int resx[] = { 480, 960, 1280, 1366, 1920, 2560, 3840 }, resy;
-	char s_res[32], s_t0[32], s_t1[32];
+	int ret = 0;
+	size_t i, j, k;
+	int64_t t;
+	int resx[] = { 240, 480, 800, 960, 1280, 1366, 1920, 2560, 3840 }, resy;
+	char s_res[32], s_time[32], s_psnr[32];
+	double psnr;
 
-	LCUI_Graph g_src, g_dst;
-	LCUI_Color t_color;
+	LCUI_Graph g_src, g_dst, g_ref;
 
-	Graph_Init(&g_src);
-	g_src.color_type = LCUI_COLOR_TYPE_ARGB;
-	if (Graph_Create(&g_src, 960, 540) < 0) {
+	if (CreatePatternImage(&g_src, SOURCE_WIDTH, SOURCE_HEIGHT) != 0) {
 		return -2;
 	}
-	t_color.value = 0xffaa5500;
-	Graph_FillRect(&g_src, t_color, NULL, false);
-	Logger_Info("%-20s%-20s%s\n", "image size\\method", "Graph_Zoom()",
-		    "Graph_ZoomBilinear()");
-	for (i = 0; i < sizeof(resx) / sizeof(int); i++) {
+	Logger_Info("%-14s%-12s%-14s%s\n", "image size", "method", "time",
+		    "PSNR");
+	for (i = 0; i < sizeof(resx) / sizeof(int); ++i) {
 		resy = resx[i] * 9 / 16;
-		t0 = LCUI_GetTime();
-		Graph_Init(&g_dst);
-		Graph_Zoom(&g_src, &g_dst, false, resx[i], resy);
-		Graph_Free(&g_dst);
-		t1 = LCUI_GetTime();
-		Graph_Init(&g_dst);
-		Graph_ZoomBilinear(&g_src, &g_dst, false, resx[i], resy);
-		Graph_Free(&g_dst);
-		t2 = LCUI_GetTime();
 		sprintf(s_res, "%dx%d", resx[i], resy);
-		sprintf(s_t0, "%ldms", t1 - t0);
-		sprintf(s_t1, "%ldms", t2 - t1);
-		Logger_Info("%-20s%-20s%-20s\n", s_res, s_t0, s_t1);
+		if (CreatePatternImage(&g_ref, resx[i], resy) != 0) {
+			return -2;
+		}
+		for (j = 0; j < sizeof(methods) / sizeof(methods[0]); ++j) {
+			Graph_Init(&g_dst);
+			t = LCUI_GetTime();
+			for (k = 0; k < REPEAT_TIMES; ++k) {
+				Graph_Resample(&g_src, &g_dst,
+					       methods[j].filter, FALSE,
+					       resx[i], resy);
+			}
+			t = LCUI_GetTimeDelta(t);
+			psnr = ComputePSNR(&g_ref, &g_dst);
+			sprintf(s_time, "%.1fms", 1.0 * t / REPEAT_TIMES);
+			sprintf(s_psnr, "%.2fdB", psnr);
+			if (methods[j].filter != LCUI_RESAMPLE_NEAREST &&
+			    psnr < MIN_FILTERED_PSNR) {
+				strcat(s_psnr, " (too low!)");
+				ret -= 1;
+			}
+			Logger_Info("%-14s%-12s%-14s%s\n", s_res,
+				    methods[j].name, s_time, s_psnr);
+			Graph_Free(&g_dst);
+		}
+		Graph_Free(&g_ref);
 	}
 	Graph_Free(&g_src);
-	return 0;
+	return ret;
 }
@@ -0,0 +1,216 @@
+﻿#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/config.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/display.h>
+#include <LCUI/platform.h>
+#include "test.h"
+
+#if defined(LCUI_BUILD_IN_LINUX) && defined(LCUI_VIDEO_DRIVER_FRAMEBUFFER)
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fb.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include LCUI_DISPLAY_H
+
+#define SCREEN_WIDTH 320
+#define SCREEN_HEIGHT 240
+
+/** 用普通文件模拟的帧缓冲设备 */
+static struct FakeFrameBuffer {
+	char path[64];
+	LCUI_BOOL can_pan;
+	int bytes_per_pixel;
+	int pan_count;
+	int vsync_count;
+	unsigned char *mem;
+	size_t mem_len;
+	struct fb_var_screeninfo var_info;
+	struct fb_fix_screeninfo fix_info;
+} fake;
+
+static int FakeFB_Ioctl(int fd, unsigned long request, void *arg)
+{
+	struct fb_var_screeninfo *var = arg;
+
+	switch (request) {
+	case FBIOGET_VSCREENINFO:
+		*var = fake.var_info;
+		return 0;
+	case FBIOGET_FSCREENINFO:
+		*(struct fb_fix_screeninfo *)arg = fake.fix_info;
+		return 0;
+	case FBIOPUT_VSCREENINFO:
+		if (var->yres_virtual * fake.fix_info.line_length >
+		    fake.fix_info.smem_len) {
+			break;
+		}
+		fake.var_info = *var;
+		return 0;
+	case FBIOPAN_DISPLAY:
+		if (!fake.can_pan ||
+		    var->yoffset + var->yres > fake.var_info.yres_virtual) {
+			break;
+		}
+		fake.var_info.yoffset = var->yoffset;
+		fake.pan_count += 1;
+		return 0;
+	case FBIO_WAITFORVSYNC:
+		fake.vsync_count += 1;
+		return 0;
+	default:
+		break;
+	}
+	errno = EINVAL;
+	return -1;
+}
+
+static int FakeFB_Open(LCUI_BOOL can_pan, int bytes_per_pixel)
+{
+	int fd;
+
+	memset(&fake, 0, sizeof(fake));
+	strcpy(fake.path, "/tmp/lcui-test-fb-XXXXXX");
+	fd = mkstemp(fake.path);
+	if (fd == -1) {
+		return -1;
+	}
+	fake.can_pan = can_pan;
+	fake.bytes_per_pixel = bytes_per_pixel;
+	fake.var_info.xres = SCREEN_WIDTH;
+	fake.var_info.yres = SCREEN_HEIGHT;
+	fake.var_info.xres_virtual = SCREEN_WIDTH;
+	fake.var_info.yres_virtual = SCREEN_HEIGHT;
+	fake.var_info.bits_per_pixel = bytes_per_pixel * 8;
+	fake.fix_info.line_length = SCREEN_WIDTH * bytes_per_pixel;
+	fake.fix_info.ypanstep = can_pan ? 1 : 0;
+	fake.fix_info.smem_len = fake.fix_info.line_length * SCREEN_HEIGHT * 2;
+	fake.mem_len = fake.fix_info.smem_len;
+	if (ftruncate(fd, fake.mem_len) != 0) {
+		close(fd);
+		return -1;
+	}
+	fake.mem = mmap(NULL, fake.mem_len, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (fake.mem == MAP_FAILED) {
+		return -1;
+	}
+	setenv("LCUI_FRAMEBUFFER_DEVICE", fake.path, 1);
+	LCUI_SetLinuxFBDeviceIoctl(FakeFB_Ioctl);
+	return 0;
+}
+
+static void FakeFB_Close(void)
+{
+	munmap(fake.mem, fake.mem_len);
+	remove(fake.path);
+	unsetenv("LCUI_FRAMEBUFFER_DEVICE");
+	LCUI_SetLinuxFBDeviceIoctl(NULL);
+}
+
+/** 检查当前显示的页上的像素颜色 */
+static LCUI_BOOL FakeFB_CheckColor(int x, int y, LCUI_Color color)
+{
+	unsigned value;
+	unsigned char *p = fake.mem;
+
+	p += (fake.var_info.yoffset + y) * fake.fix_info.line_length;
+	p += x * fake.bytes_per_pixel;
+	if (fake.bytes_per_pixel == 2) {
+		value = ((color.r >> 3) << 11) | ((color.g >> 2) << 5) |
+			(color.b >> 3);
+		return p[0] == (value & 0xff) && p[1] == (value >> 8);
+	}
+	return p[0] == color.b && p[1] == color.g && p[2] == color.r;
+}
+
+static void FillRect(LCUI_DisplayDriver driver, LCUI_Surface surface,
+		     LCUI_Rect rect, LCUI_Color color)
+{
+	LCUI_PaintContext paint;
+
+	paint = driver->beginPaint(surface, &rect);
+	Graph_FillRect(&paint->canvas, color, NULL, TRUE);
+	driver->endPaint(surface, paint);
+}
+
+static int test_fb_buffering(LCUI_BOOL can_pan, int bytes_per_pixel)
+{
+	int ret = 0;
+	int pan_count;
+	LCUI_Rect rect_a = { 10, 10, 40, 30 };
+	LCUI_Rect rect_b = { 100, 120, 60, 50 };
+	LCUI_Color red = RGB(255, 0, 0);
+	LCUI_Color blue = RGB(0, 0, 255);
+	LCUI_Color black = RGB(0, 0, 0);
+	LCUI_DisplayDriver driver;
+	LCUI_Surface surface;
+
+	if (FakeFB_Open(can_pan, bytes_per_pixel) != 0) {
+		CHECK_WITH_TEXT("create fake framebuffer device", FALSE);
+		return ret;
+	}
+	driver = LCUI_CreateLinuxFBDisplayDriver();
+	CHECK(driver != NULL);
+	if (!driver) {
+		FakeFB_Close();
+		return ret;
+	}
+	surface = driver->create();
+	driver->resize(surface, SCREEN_WIDTH, SCREEN_HEIGHT);
+	driver->update(surface);
+
+	FillRect(driver, surface, rect_a, red);
+	driver->present(surface);
+	CHECK(FakeFB_CheckColor(20, 20, red));
+	CHECK(FakeFB_CheckColor(120, 140, black));
+
+	/* The page shown now must also have the previous frame */
+	FillRect(driver, surface, rect_b, blue);
+	driver->present(surface);
+	CHECK(FakeFB_CheckColor(20, 20, red));
+	CHECK(FakeFB_CheckColor(120, 140, blue));
+	CHECK(FakeFB_CheckColor(200, 200, black));
+	if (can_pan) {
+		CHECK_WITH_TEXT("flip pages by panning", fake.pan_count == 2);
+		CHECK_WITH_TEXT("wait for vsync", fake.vsync_count > 0);
+	} else {
+		CHECK_WITH_TEXT("write to the shadow buffer",
+				fake.pan_count == 0 && fake.var_info.yoffset == 0);
+	}
+
+	pan_count = fake.pan_count;
+	driver->present(surface);
+	CHECK_WITH_TEXT("nothing to present without changes",
+			fake.pan_count == pan_count);
+
+	LCUI_DestroyLinuxFBDisplayDriver(driver);
+	CHECK_WITH_TEXT("restore the screen info",
+			fake.var_info.yoffset == 0 &&
+			    fake.var_info.yres_virtual == SCREEN_HEIGHT);
+	FakeFB_Close();
+	return ret;
+}
+
+int test_linux_fbdisplay(void)
+{
+	int ret = 0;
+
+	ret += test_fb_buffering(TRUE, 4);
+	ret += test_fb_buffering(FALSE, 4);
+	ret += test_fb_buffering(TRUE, 2);
+	return ret;
+}
+
+#else
+
+int test_linux_fbdisplay(void)
+{
+	return 0;
+}
+
+#endif
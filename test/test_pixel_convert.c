@@ -0,0 +1,151 @@
+﻿#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include "test.h"
+
+#define MAX_WIDTH 67
+#define GUARD_BYTE 0xaa
+
+static const uchar_t dither_matrix[4][4] = { { 0, 8, 2, 10 },
+					     { 12, 4, 14, 6 },
+					     { 3, 11, 1, 9 },
+					     { 15, 7, 13, 5 } };
+
+typedef struct ConverterCaseRec_ {
+	const char *name;
+	int color_type;
+	int flags;
+	int bytes_per_pixel;
+} ConverterCaseRec;
+
+static ConverterCaseRec cases[] = {
+	{ "ARGB8888", LCUI_COLOR_TYPE_ARGB8888, 0, 4 },
+	{ "RGB888", LCUI_COLOR_TYPE_RGB888, 0, 3 },
+	{ "RGB565", LCUI_COLOR_TYPE_RGB565, 0, 2 },
+	{ "RGB565 dither", LCUI_COLOR_TYPE_RGB565, LCUI_PIXEL_CONVERT_DITHER,
+	  2 },
+	{ "INDEX8", LCUI_COLOR_TYPE_INDEX8, 0, 1 }
+};
+
+/** 逐个像素转换，作为参考结果 */
+static void ConvertRow(const ConverterCaseRec *c, uchar_t *dst,
+		       const LCUI_ARGB *src, int width, int x, int y)
+{
+	int i, d;
+	unsigned r, g, b, value;
+
+	for (i = 0; i < width; ++i) {
+		r = src[i].r;
+		g = src[i].g;
+		b = src[i].b;
+		switch (c->color_type) {
+		case LCUI_COLOR_TYPE_ARGB8888:
+			memcpy(dst, &src[i], 4);
+			break;
+		case LCUI_COLOR_TYPE_RGB888:
+			dst[0] = (uchar_t)b;
+			dst[1] = (uchar_t)g;
+			dst[2] = (uchar_t)r;
+			break;
+		case LCUI_COLOR_TYPE_RGB565:
+			if (c->flags & LCUI_PIXEL_CONVERT_DITHER) {
+				d = dither_matrix[y & 3][(x + i) & 3];
+				r = min(255, r + d / 2);
+				g = min(255, g + d / 4);
+				b = min(255, b + d / 2);
+			}
+			value = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+			dst[0] = (uchar_t)(value & 0xff);
+			dst[1] = (uchar_t)(value >> 8);
+			break;
+		case LCUI_COLOR_TYPE_INDEX8:
+			dst[0] = (uchar_t)((r & 0xc0) | ((g & 0xf0) >> 2) |
+					   (b >> 6));
+			break;
+		default:
+			break;
+		}
+		dst += c->bytes_per_pixel;
+	}
+}
+
+/** 检查所有宽度和起始坐标下的结果都与参考结果一致，并且没有越界写入 */
+static LCUI_BOOL CheckConverter(const ConverterCaseRec *c,
+				const LCUI_ARGB *src)
+{
+	int width, x, y;
+	size_t size = (MAX_WIDTH + 1) * 4;
+	uchar_t expected[(MAX_WIDTH + 1) * 4];
+	uchar_t actual[(MAX_WIDTH + 1) * 4];
+	LCUI_PixelRowConverter convert;
+
+	convert = LCUI_GetPixelRowConverter(c->color_type, c->flags);
+	if (!convert) {
+		return FALSE;
+	}
+	for (width = 0; width <= MAX_WIDTH; ++width) {
+		for (y = 0; y < 4; ++y) {
+			for (x = 0; x < 4; ++x) {
+				memset(expected, GUARD_BYTE, size);
+				memset(actual, GUARD_BYTE, size);
+				ConvertRow(c, expected, src + x, width, x, y);
+				convert(actual, src + x, width, x, y);
+				if (memcmp(expected, actual, size) != 0) {
+					TEST_LOG("%s: mismatch at width %d, "
+						 "x %d, y %d\n",
+						 c->name, width, x, y);
+					return FALSE;
+				}
+			}
+		}
+	}
+	return TRUE;
+}
+
+static LCUI_BOOL CheckPalette(void)
+{
+	int i;
+	uchar_t index;
+	LCUI_Color color;
+	LCUI_PixelRowConverter convert;
+
+	convert = LCUI_GetPixelRowConverter(LCUI_COLOR_TYPE_INDEX8, 0);
+	for (i = 0; i < 256; ++i) {
+		color = LCUI_GetIndex8Color((uchar_t)i);
+		convert(&index, &color, 1, 0, 0);
+		if (index != i) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+int test_pixel_convert(void)
+{
+	int ret = 0;
+	size_t i;
+	LCUI_ARGB src[MAX_WIDTH + 4];
+	uchar_t *bytes = (uchar_t *)src;
+
+	/* 包含各分量的边界值，其余使用随机值 */
+	srand(42);
+	for (i = 0; i < sizeof(src); ++i) {
+		bytes[i] = (uchar_t)(rand() & 0xff);
+	}
+	src[0] = ARGB(255, 255, 255, 255);
+	src[1] = ARGB(0, 0, 0, 0);
+	src[2] = ARGB(128, 250, 252, 249);
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		CHECK_WITH_TEXT(cases[i].name, CheckConverter(&cases[i], src));
+	}
+	CHECK_WITH_TEXT("palette colors map back to their index",
+			CheckPalette());
+	CHECK(LCUI_GetPixelRowConverter(LCUI_COLOR_TYPE_RGB888,
+					LCUI_PIXEL_CONVERT_DITHER) ==
+	      LCUI_GetPixelRowConverter(LCUI_COLOR_TYPE_RGB888, 0));
+	CHECK(LCUI_GetPixelRowConverter(LCUI_COLOR_TYPE_GRAY8, 0) == NULL);
+	return ret;
+}
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/util/slab.h>
+#include "test.h"
+
+#define OBJECT_COUNT 1000
+
+static LCUI_BOOL CheckObjects(char **objects, size_t count, size_t size)
+{
+	size_t i, j;
+
+	for (i = 0; i < count; ++i) {
+		if ((size_t)objects[i] % sizeof(void *) != 0) {
+			return FALSE;
+		}
+		for (j = 0; j < size; ++j) {
+			if (objects[i][j] != (char)i) {
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+static int test_slab_objects(void)
+{
+	int ret = 0;
+	size_t i;
+	slab_t *slab;
+	char *obj;
+	char *objects[OBJECT_COUNT];
+
+	CHECK(slab = slab_create(20));
+	for (i = 0; i < OBJECT_COUNT; ++i) {
+		objects[i] = slab_alloc(slab);
+		memset(objects[i], (char)i, 20);
+	}
+	CHECK(slab_count(slab) == OBJECT_COUNT);
+	CHECK_WITH_TEXT("objects do not overlap",
+			CheckObjects(objects, OBJECT_COUNT, 20));
+	for (i = 0; i < OBJECT_COUNT; i += 2) {
+		slab_free(objects[i]);
+	}
+	CHECK(slab_count(slab) == OBJECT_COUNT / 2);
+	obj = slab_alloc(slab);
+	for (i = 0; i < OBJECT_COUNT; i += 2) {
+		if (objects[i] == obj) {
+			break;
+		}
+	}
+	CHECK_WITH_TEXT("reuse freed objects", i < OBJECT_COUNT);
+	slab_free(obj);
+	for (i = 1; i < OBJECT_COUNT; i += 2) {
+		slab_free(objects[i]);
+	}
+	CHECK(slab_count(slab) == 0);
+	slab_destroy(slab);
+	return ret;
+}
+
+static int test_slab_pool(void)
+{
+	int ret = 0;
+	size_t i, size;
+	char *objects[OBJECT_COUNT];
+	slab_pool_t *pool;
+
+	CHECK(pool = slab_pool_create());
+	for (i = 0; i < OBJECT_COUNT; ++i) {
+		size = i * 7 % 5000 + 1;
+		objects[i] = slab_pool_alloc(pool, size);
+		memset(objects[i], (char)i, size);
+	}
+	for (i = 0; i < OBJECT_COUNT; ++i) {
+		size = i * 7 % 5000 + 1;
+		if ((size_t)objects[i] % sizeof(void *) != 0 ||
+		    objects[i][0] != (char)i || objects[i][size - 1] != (char)i) {
+			break;
+		}
+	}
+	CHECK_WITH_TEXT("objects of all sizes are usable", i == OBJECT_COUNT);
+	CHECK_WITH_TEXT("large objects are not counted",
+			slab_pool_count(pool) < OBJECT_COUNT);
+	for (i = 0; i < OBJECT_COUNT; ++i) {
+		slab_free(objects[i]);
+	}
+	CHECK(slab_pool_count(pool) == 0);
+	slab_pool_destroy(pool);
+	CHECK(objects[0] = slab_pool_alloc(NULL, 64));
+	slab_free(objects[0]);
+	return ret;
+}
+
+int test_slab(void)
+{
+	int ret = 0;
+
+	ret += test_slab_objects();
+	ret += test_slab_pool();
+	return ret;
+}
@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/font.h>
+
+#define TEXT_LENGTH 100000
+#define LINE_LENGTH 120
+#define EDIT_TIMES 1000
+#define RENDER_WIDTH 800
+#define RENDER_HEIGHT 600
+#define RENDER_TIMES 100
+
+typedef struct BenchCaseRec_ {
+	const char *name;
+	LCUI_BOOL multiline;
+} BenchCaseRec;
+
+static BenchCaseRec cases[] = { { "wrapped", TRUE }, { "single-row", FALSE } };
+
+static wchar_t *CreateDocument(LCUI_BOOL multiline)
+{
+	int i;
+	const wchar_t *words = L"lorem ipsum dolor sit amet consectetur ";
+	size_t n = wcslen(words);
+	wchar_t *text = malloc(sizeof(wchar_t) * (TEXT_LENGTH + 1));
+
+	for (i = 0; i < TEXT_LENGTH; ++i) {
+		if (multiline && i % LINE_LENGTH == LINE_LENGTH - 1) {
+			text[i] = '\n';
+		} else {
+			text[i] = words[i % n];
+		}
+	}
+	text[TEXT_LENGTH] = 0;
+	return text;
+}
+
+/** Line breaks are stored as row ends, not as characters */
+static size_t CountChars(const wchar_t *text, wchar_t ch)
+{
+	size_t count;
+
+	for (count = 0; *text; ++text) {
+		if (ch ? *text == ch : *text != '\n') {
+			++count;
+		}
+	}
+	return count;
+}
+
+static void LogTime(const char *name, const char *step, int64_t t)
+{
+	char str[32];
+
+	sprintf(str, "%.2fms", 1.0 * t);
+	Logger_Info("%-12s%-12s%s\n", name, step, str);
+}
+
+static int RunCase(const BenchCaseRec *bench)
+{
+	int i, ret = 0;
+	int64_t t;
+	size_t len, expected_len;
+	wchar_t *text, *buff;
+	LCUI_Graph canvas;
+	LCUI_TextStyleRec style;
+	LCUI_Rect area = { 0, 0, RENDER_WIDTH, RENDER_HEIGHT };
+	LCUI_Pos pos = { 0, 0 };
+	LCUI_TextLayer layer = TextLayer_New();
+
+	TextStyle_Init(&style);
+	style.pixel_size = 14;
+	style.has_pixel_size = TRUE;
+	TextLayer_SetTextStyle(layer, &style);
+	TextLayer_SetMultiline(layer, bench->multiline);
+	TextLayer_SetAutoWrap(layer, bench->multiline);
+	TextLayer_SetMaxSize(layer, RENDER_WIDTH, 0);
+	TextLayer_Update(layer, NULL);
+	text = CreateDocument(bench->multiline);
+
+	t = LCUI_GetTime();
+	TextLayer_SetTextW(layer, text, NULL);
+	LogTime(bench->name, "set text", LCUI_GetTimeDelta(t));
+
+	t = LCUI_GetTime();
+	TextLayer_Update(layer, NULL);
+	TextLayer_ClearInvalidRect(layer);
+	LogTime(bench->name, "typeset", LCUI_GetTimeDelta(t));
+
+	/* Type characters one by one in the middle of the document */
+	t = LCUI_GetTime();
+	TextLayer_SetCaretPos(layer, TextLayer_GetRowTotal(layer) / 2,
+			      LINE_LENGTH / 2);
+	for (i = 0; i < EDIT_TIMES; ++i) {
+		TextLayer_InsertTextW(layer, L"x", NULL);
+	}
+	TextLayer_Update(layer, NULL);
+	TextLayer_ClearInvalidRect(layer);
+	LogTime(bench->name, "insert", LCUI_GetTimeDelta(t));
+
+	Graph_Init(&canvas);
+	canvas.color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create(&canvas, RENDER_WIDTH, RENDER_HEIGHT);
+	t = LCUI_GetTime();
+	for (i = 0; i < RENDER_TIMES; ++i) {
+		Graph_FillRect(&canvas, RGB(255, 255, 255), NULL, TRUE);
+		TextLayer_RenderTo(layer, area, pos, &canvas);
+	}
+	LogTime(bench->name, "render", LCUI_GetTimeDelta(t));
+	Graph_Free(&canvas);
+
+	expected_len = CountChars(text, 0) + EDIT_TIMES;
+	buff = malloc(sizeof(wchar_t) * (expected_len + 1));
+	t = LCUI_GetTime();
+	len = TextLayer_GetTextW(layer, 0, expected_len, buff);
+	LogTime(bench->name, "get text", LCUI_GetTimeDelta(t));
+	if (len != expected_len || CountChars(buff, 'x') != EDIT_TIMES) {
+		Logger_Info("%-12s%-12s%s\n", bench->name, "(error)",
+			    "text content mismatch");
+		ret = -1;
+	}
+	free(buff);
+	free(text);
+	TextStyle_Destroy(&style);
+	TextLayer_Destroy(layer);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int ret = 0;
+	size_t i;
+
+	LCUI_InitFontLibrary();
+	Logger_Info("%-12s%-12s%s\n", "document", "step", "time");
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		ret += RunCase(&cases[i]);
+	}
+	LCUI_FreeFontLibrary();
+	return ret;
+}
@@ -11,6 +11,7 @@
 static struct {
 	LCUI_Widget block;
 	LCUI_Widget inline_block;
+	float short_content_width;
 } self;
 
 static const char *css = CodeToString(
@@ -38,6 +39,10 @@ static const char *css = CodeToString(
 	content: "this is long long long long long long long text";
 }
 
+.large-font {
+	font-size: 28px;
+}
+
 );
 
 /* clang-format on */
@@ -103,6 +108,7 @@ static int check_textview_set_short_content_css(void)
 	CHECK(self.block->height < 45.0f);
 	CHECK(self.inline_block->width < 70.0f);
 	CHECK(self.inline_block->height < 45.0f);
+	self.short_content_width = self.inline_block->width;
 
 	return ret;
 }
@@ -128,6 +134,33 @@ static int check_textview_set_long_content_css(void)
 	return ret;
 }
 
+static void test_textview_restore_short_content_css(void *arg)
+{
+	Widget_RemoveClass(self.inline_block, "long-content");
+	Widget_AddClass(self.inline_block, "short-content");
+}
+
+static int check_textview_measure_cache(void)
+{
+	int ret = 0;
+
+	LCUIWidget_Update();
+	CHECK(self.inline_block->width == self.short_content_width);
+
+	/* 字体大小变化后不能再使用之前的测量结果 */
+	Widget_AddClass(self.inline_block, "large-font");
+	LCUIWidget_Update();
+	CHECK(self.inline_block->width > self.short_content_width);
+	CHECK(self.inline_block->height > 45.0f);
+
+	/* 还原字体大小后，尺寸也应该还原 */
+	Widget_RemoveClass(self.inline_block, "large-font");
+	LCUIWidget_Update();
+	CHECK(self.inline_block->width == self.short_content_width);
+	CHECK(self.inline_block->height < 45.0f);
+	return ret;
+}
+
 int test_textview_resize(void)
 {
 	int ret = 0;
@@ -142,6 +175,8 @@ int test_textview_resize(void)
 	ret += check_textview_set_short_content_css();
 	test_textview_set_long_content_css(NULL);
 	ret += check_textview_set_long_content_css();
+	test_textview_restore_short_content_css(NULL);
+	ret += check_textview_measure_cache();
 
 	LCUI_Destroy();
 	return ret;
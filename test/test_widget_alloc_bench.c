@@ -0,0 +1,172 @@
+﻿/*
+ * test_widget_alloc_bench.c -- Create and destroy large widget trees
+ *
+ * Each round builds a detached tree of 10k widgets, optionally with classes,
+ * event handlers and text views, then destroys it. The best create and
+ * destroy times of all rounds and the number of heap allocations per widget
+ * are printed for each case.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/display.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/widget/textview.h>
+
+#define TREE_WIDGETS 10000
+#define ROUNDS 20
+
+typedef struct BenchCaseRec_ {
+	const char *name;
+	int group_size; /**< 每组的子部件数量，为 0 时所有部件都在同一层 */
+	LCUI_BOOL with_extras;
+} BenchCaseRec;
+
+static BenchCaseRec cases[] = { { "flat", 0, FALSE },
+				{ "groups", 100, FALSE },
+				{ "groups+extras", 100, TRUE } };
+
+#if defined(__GLIBC__) && !defined(BENCH_NO_ALLOC_HOOKS)
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static volatile size_t alloc_count;
+
+void *malloc(size_t size)
+{
+	__sync_fetch_and_add(&alloc_count, 1);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	__sync_fetch_and_add(&alloc_count, 1);
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	__sync_fetch_and_add(&alloc_count, 1);
+	return __libc_realloc(ptr, size);
+}
+
+static size_t GetAllocCount(void)
+{
+	return __sync_fetch_and_add(&alloc_count, 0);
+}
+
+#else
+
+static size_t GetAllocCount(void)
+{
+	return 0;
+}
+
+#endif
+
+static double GetTimeMs(void)
+{
+#ifdef LCUI_BUILD_IN_LINUX
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#else
+	return (double)LCUI_GetTime();
+#endif
+}
+
+static void OnClick(LCUI_Widget w, LCUI_WidgetEvent e, void *arg)
+{
+}
+
+static LCUI_Widget CreateItem(const BenchCaseRec *bench, int i)
+{
+	LCUI_Widget w;
+
+	if (bench->with_extras && i % 4 == 0) {
+		w = LCUIWidget_New("textview");
+		TextView_SetText(w, "item");
+	} else {
+		w = LCUIWidget_New(NULL);
+	}
+	if (bench->with_extras) {
+		Widget_AddClass(w, "item");
+		Widget_BindEvent(w, "click", OnClick, NULL, NULL);
+	}
+	return w;
+}
+
+static LCUI_Widget CreateTree(const BenchCaseRec *bench)
+{
+	int i;
+	LCUI_Widget root, parent, w;
+
+	root = LCUIWidget_New(NULL);
+	parent = root;
+	for (i = 0; i < TREE_WIDGETS; ++i) {
+		if (bench->group_size > 0 && i % bench->group_size == 0) {
+			parent = LCUIWidget_New(NULL);
+			Widget_Append(root, parent);
+		}
+		w = CreateItem(bench, i);
+		Widget_Append(parent, w);
+	}
+	return root;
+}
+
+static void RunCase(const BenchCaseRec *bench)
+{
+	int i;
+	double t;
+	size_t count;
+	double create_time = -1, destroy_time = -1;
+	char s_create[32], s_destroy[32], s_allocs[32];
+	LCUI_Widget root;
+
+	count = GetAllocCount();
+	for (i = 0; i < ROUNDS; ++i) {
+		t = GetTimeMs();
+		root = CreateTree(bench);
+		t = GetTimeMs() - t;
+		if (create_time < 0 || t < create_time) {
+			create_time = t;
+		}
+		t = GetTimeMs();
+		Widget_Destroy(root);
+		t = GetTimeMs() - t;
+		if (destroy_time < 0 || t < destroy_time) {
+			destroy_time = t;
+		}
+	}
+	count = GetAllocCount() - count;
+	sprintf(s_create, "%.2fms", create_time);
+	sprintf(s_destroy, "%.2fms", destroy_time);
+	sprintf(s_allocs, "%.2f", 1.0 * count / ROUNDS / TREE_WIDGETS);
+	Logger_Info("%-16s%-12s%-12s%s\n", bench->name, s_create, s_destroy,
+		    s_allocs);
+}
+
+int main(int argc, char **argv)
+{
+	size_t i;
+
+	LCUI_InitBase();
+	LCUI_InitApp(NULL);
+	LCUI_InitDisplay(LCUI_CreateHeadlessDisplayDriver());
+	LCUI_Init();
+	Logger_Info("%d widgets per tree, %d rounds\n", TREE_WIDGETS, ROUNDS);
+	Logger_Info("%-16s%-12s%-12s%s\n", "case", "create", "destroy",
+		    "allocs/widget");
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		RunCase(&cases[i]);
+	}
+	LCUI_Destroy();
+	return 0;
+}
@@ -105,7 +105,208 @@ int test_widget_mouse_event(void)
 	return ret;
 }
 
+/** 按堆叠顺序逐个检查子部件，用于和命中测试索引的结果做对比 */
+static LCUI_Widget find_child_at(LCUI_Widget w, float x, float y)
+{
+	LCUI_Widget child;
+	LinkedListNode *node;
+
+	for (LinkedList_Each(node, &w->children_show)) {
+		child = node->data;
+		if (child->computed_style.visible &&
+		    LCUIRect_HasPoint(&child->box.border, x, y)) {
+			return child;
+		}
+	}
+	return NULL;
+}
+
+int test_widget_hit_index(void)
+{
+	int i, x, y, ret = 0;
+	int mismatches = 0;
+	LCUI_Widget container, cover;
+	LCUI_Widget items[400];
+
+	LCUI_Init();
+	container = LCUIWidget_New(NULL);
+	Widget_Resize(container, 400, 400);
+	Widget_Append(LCUIWidget_GetRoot(), container);
+	for (i = 0; i < 400; ++i) {
+		items[i] = LCUIWidget_New(NULL);
+		Widget_SetStyle(items[i], key_position, SV_ABSOLUTE, style);
+		Widget_Move(items[i], (i % 20) * 20.f, (i / 20) * 20.f);
+		Widget_Resize(items[i], 20, 20);
+		Widget_Append(container, items[i]);
+	}
+	cover = LCUIWidget_New(NULL);
+	Widget_SetStyle(cover, key_position, SV_ABSOLUTE, style);
+	Widget_SetStyle(cover, key_z_index, 10, int);
+	Widget_Move(cover, 100, 100);
+	Widget_Resize(cover, 50, 50);
+	Widget_Append(container, cover);
+	LCUIWidget_Update();
+
+	CHECK_WITH_TEXT("Widget_At(5, 5) == items[0]",
+			Widget_At(container, 5, 5) == items[0]);
+	CHECK_WITH_TEXT("Widget_At(110, 110) == cover",
+			Widget_At(container, 110, 110) == cover);
+	CHECK_WITH_TEXT("Widget_At(399, 399) == items[399]",
+			Widget_At(container, 399, 399) == items[399]);
+	CHECK_WITH_TEXT("Widget_At(400, 400) == NULL",
+			Widget_At(container, 400, 400) == NULL);
+	for (y = -7; y < 420; y += 7) {
+		for (x = -7; x < 420; x += 7) {
+			if (Widget_At(container, x, y) !=
+			    find_child_at(container, 1.f * x, 1.f * y)) {
+				++mismatches;
+			}
+		}
+	}
+	CHECK_WITH_TEXT("check hit test results of the whole container",
+			mismatches == 0);
+
+	Widget_Move(cover, 0, 0);
+	LCUIWidget_Update();
+	CHECK_WITH_TEXT("move cover: Widget_At(5, 5) == cover",
+			Widget_At(container, 5, 5) == cover);
+	CHECK_WITH_TEXT("move cover: Widget_At(110, 110) == items[105]",
+			Widget_At(container, 110, 110) == items[105]);
+
+	Widget_Move(items[399], 500, 500);
+	LCUIWidget_Update();
+	CHECK_WITH_TEXT("move items[399]: Widget_At(510, 510) == items[399]",
+			Widget_At(container, 510, 510) == items[399]);
+	CHECK_WITH_TEXT("move items[399]: Widget_At(390, 390) == NULL",
+			Widget_At(container, 390, 390) == NULL);
+
+	Widget_Destroy(cover);
+	LCUIWidget_Update();
+	CHECK_WITH_TEXT("destroy cover: Widget_At(5, 5) == items[0]",
+			Widget_At(container, 5, 5) == items[0]);
+
+	LCUI_Destroy();
+	return ret;
+}
+
+/**
+ * 检查子部件的序号是否连续、能否按序号取到子部件，以及显示列表是否按堆叠顺序
+ * 由顶到底排列
+ */
+static LCUI_BOOL check_children_order(LCUI_Widget w)
+{
+	size_t i = 0;
+	LCUI_Widget a, b;
+	LCUI_WidgetStyle *sa, *sb;
+	LinkedListNode *node;
+
+	for (LinkedList_Each(node, &w->children)) {
+		a = node->data;
+		if (a->index != i++ || Widget_GetChild(w, a->index) != a) {
+			return FALSE;
+		}
+	}
+	if (Widget_GetChild(w, i)) {
+		return FALSE;
+	}
+	if (w->children_show.length != w->children.length) {
+		return FALSE;
+	}
+	for (LinkedList_Each(node, &w->children_show)) {
+		if (!node->next) {
+			break;
+		}
+		a = node->data;
+		b = node->next->data;
+		sa = &a->computed_style;
+		sb = &b->computed_style;
+		if (sa->z_index != sb->z_index) {
+			if (sa->z_index < sb->z_index) {
+				return FALSE;
+			}
+		} else if (sa->position != sb->position) {
+			if (sa->position < sb->position) {
+				return FALSE;
+			}
+		} else if (a->index < b->index) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+int test_widget_show_order(void)
+{
+	int i, ret = 0;
+	LCUI_Widget container, wrapper, w;
+	LCUI_Widget items[100];
+
+	LCUI_Init();
+	container = LCUIWidget_New(NULL);
+	Widget_Append(LCUIWidget_GetRoot(), container);
+	for (i = 0; i < 100; ++i) {
+		items[i] = LCUIWidget_New(NULL);
+		if (i % 7 == 0) {
+			Widget_SetStyle(items[i], key_position, SV_RELATIVE,
+					style);
+		}
+		if (i % 11 == 0) {
+			Widget_SetStyle(items[i], key_z_index, i % 3, int);
+		}
+		Widget_Append(container, items[i]);
+	}
+	LCUIWidget_Update();
+	CHECK_WITH_TEXT("check show order of appended children",
+			check_children_order(container));
+
+	for (i = 0; i < 100; i += 9) {
+		Widget_SetStyle(items[i], key_z_index, 5 - i % 4, int);
+		Widget_UpdateStyle(items[i], FALSE);
+	}
+	for (i = 3; i < 100; i += 13) {
+		Widget_SetStyle(items[i], key_position, SV_ABSOLUTE, style);
+		Widget_UpdateStyle(items[i], FALSE);
+	}
+	LCUIWidget_Update();
+	CHECK_WITH_TEXT("check show order after changing z-index and position",
+			check_children_order(container));
+
+	for (i = 1; i < 100; i += 10) {
+		Widget_Destroy(items[i]);
+	}
+	w = LCUIWidget_New(NULL);
+	Widget_Prepend(container, w);
+	LCUIWidget_Update();
+	CHECK_WITH_TEXT("check show order after destroying and prepending",
+			check_children_order(container));
+
+	wrapper = LCUIWidget_New(NULL);
+	for (i = 0; i < 5; ++i) {
+		w = LCUIWidget_New(NULL);
+		Widget_SetStyle(w, key_z_index, i, int);
+		Widget_Append(wrapper, w);
+	}
+	Widget_Append(container, wrapper);
+	LCUIWidget_Update();
+	Widget_Unwrap(wrapper);
+	LCUIWidget_Update();
+	CHECK_WITH_TEXT("check show order after unwrapping",
+			check_children_order(container));
+
+	Widget_Empty(container);
+	for (i = 0; i < 3; ++i) {
+		Widget_Append(container, LCUIWidget_New(NULL));
+	}
+	LCUIWidget_Update();
+	CHECK_WITH_TEXT("check children order after emptying",
+			check_children_order(container));
+
+	LCUI_Destroy();
+	return ret;
+}
+
 int test_widget_event(void)
 {
-	return test_widget_mouse_event();
+	return test_widget_mouse_event() + test_widget_hit_index() +
+	       test_widget_show_order();
 }
@@ -123,6 +123,43 @@ static int check_change_visible(void)
 	return ret;
 }
 
+static int check_relayout_boundary(void)
+{
+	int ret = 0;
+	float width;
+	LCUI_Widget fitbox, child, panel;
+
+	fitbox = LCUIWidget_New(NULL);
+	child = LCUIWidget_New(NULL);
+	panel = LCUIWidget_New(NULL);
+	Widget_SetStyle(fitbox, key_position, SV_ABSOLUTE, style);
+	Widget_SetStyle(child, key_width, 100, px);
+	Widget_SetStyle(child, key_height, 20, px);
+	Widget_SetStyle(panel, key_width, 300, px);
+	Widget_SetStyle(panel, key_height, 300, px);
+	Widget_Append(fitbox, child);
+	Widget_Append(LCUIWidget_GetRoot(), fitbox);
+	Widget_Append(LCUIWidget_GetRoot(), panel);
+	LCUIWidget_Update();
+	CHECK(!Widget_IsRelayoutBoundary(fitbox));
+	CHECK(Widget_IsRelayoutBoundary(panel));
+	width = fitbox->width;
+	CHECK(width == 100);
+	/* 子部件的尺寸变化需要让祖先部件缓存的内容尺寸失效 */
+	Widget_SetStyle(child, key_width, 200, px);
+	Widget_UpdateStyle(child, FALSE);
+	LCUIWidget_Update();
+	CHECK(fitbox->width == 200);
+	Widget_SetStyle(child, key_width, 100, px);
+	Widget_UpdateStyle(child, FALSE);
+	LCUIWidget_Update();
+	CHECK(fitbox->width == width);
+	Widget_Destroy(fitbox);
+	Widget_Destroy(panel);
+	LCUIWidget_Update();
+	return ret;
+}
+
 static int check_layout(void)
 {
 	int ret = 0;
@@ -136,6 +173,7 @@ static int check_layout(void)
 	ret += check_overflow_box();
 	ret += check_offset_box();
 	ret += check_change_visible();
+	ret += check_relayout_boundary();
 	return ret;
 }
 
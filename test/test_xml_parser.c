@@ -1,10 +1,16 @@
-﻿#include <LCUI_Build.h>
+﻿#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/display.h>
 #include <LCUI/gui/widget.h>
+#include <LCUI/gui/widget/textview.h>
 #include <LCUI/gui/builder.h>
 #include "test.h"
 
+#define TEXT_MAX_LEN 256
+
 static int check_widget_attribute(void)
 {
 	int ret = 0;
@@ -39,6 +45,178 @@ static int check_widget_loaded_from_nested_xml(void)
 	return ret;
 }
 
+static int check_load_string(void)
+{
+	int ret = 0;
+	LCUI_Widget pack, w;
+	const char *xml = "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"
+			  "<lcui-app>"
+			  "<resource type=\"text/css\">"
+			  "#test-string-1 { width: 123px; }"
+			  "</resource>"
+			  "<ui>"
+			  "<unknown><w id=\"test-string-skipped\" /></unknown>"
+			  "<w id=\"box\"><textview id=\"test-string-1\">"
+			  "Hello</textview></w>"
+			  "</ui>"
+			  "</lcui-app>";
+	const char *bad_root = "<app><ui><w /></ui></app>";
+	const char *bad_xml = "<lcui-app><ui><w id=\"box\"></ui></lcui-app>";
+
+	pack = LCUIBuilder_LoadString(xml, (int)strlen(xml));
+	CHECK_WITH_TEXT("load ui from string", pack);
+	if (!pack) {
+		return ret;
+	}
+	w = Widget_GetChild(pack, 0);
+	CHECK(w && Widget_GetChild(w, 0));
+	w = w ? Widget_GetChild(w, 0) : NULL;
+	CHECK_WITH_TEXT("check widget created from prototype element",
+			w && strcmp(w->type, "textview") == 0);
+	CHECK_WITH_TEXT("check unknown element is skipped",
+			pack->children.length == 1);
+	Widget_Destroy(pack);
+	CHECK_WITH_TEXT("check error root node name",
+			!LCUIBuilder_LoadString(bad_root,
+						(int)strlen(bad_root)));
+	CHECK_WITH_TEXT("check malformed xml",
+			!LCUIBuilder_LoadString(bad_xml, (int)strlen(bad_xml)));
+	return ret;
+}
+
+/** 检查部件 a 的类是否都在部件 b 中 */
+static LCUI_BOOL contains_classes(LCUI_Widget a, LCUI_Widget b)
+{
+	int i;
+
+	for (i = 0; a->classes && a->classes[i]; ++i) {
+		if (!Widget_HasClass(b, a->classes[i])) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** 检查部件 a 的属性是否都在部件 b 中，且值相同 */
+static LCUI_BOOL contains_attributes(LCUI_Widget a, LCUI_Widget b)
+{
+	DictEntry *entry;
+	DictIterator *iter;
+	LCUI_WidgetAttribute attr;
+	const char *value_a, *value_b;
+	LCUI_BOOL equal = TRUE;
+
+	if (!a->attributes) {
+		return TRUE;
+	}
+	iter = Dict_GetIterator(a->attributes);
+	while (equal && (entry = Dict_Next(iter))) {
+		attr = DictEntry_GetVal(entry);
+		value_a = Widget_GetAttribute(a, attr->name);
+		value_b = Widget_GetAttribute(b, attr->name);
+		if (!value_a || !value_b) {
+			equal = value_a == value_b;
+		} else {
+			equal = strcmp(value_a, value_b) == 0;
+		}
+	}
+	Dict_ReleaseIterator(iter);
+	return equal;
+}
+
+static LCUI_BOOL compare_widget_text(LCUI_Widget a, LCUI_Widget b)
+{
+	wchar_t text_a[TEXT_MAX_LEN], text_b[TEXT_MAX_LEN];
+
+	if (!a->type || strcmp(a->type, "textview") != 0) {
+		return TRUE;
+	}
+	TextView_GetTextW(a, 0, TEXT_MAX_LEN - 1, text_a);
+	TextView_GetTextW(b, 0, TEXT_MAX_LEN - 1, text_b);
+	return wcscmp(text_a, text_b) == 0;
+}
+
+/** 比较两个部件树的结构、属性和文本内容是否一致 */
+static LCUI_BOOL compare_widget_tree(LCUI_Widget a, LCUI_Widget b)
+{
+	LinkedListNode *na, *nb;
+
+	if (strcmp(a->type ? a->type : "", b->type ? b->type : "") != 0 ||
+	    strcmp(a->id ? a->id : "", b->id ? b->id : "") != 0 ||
+	    a->disabled != b->disabled ||
+	    a->children.length != b->children.length) {
+		return FALSE;
+	}
+	if (!contains_classes(a, b) || !contains_classes(b, a) ||
+	    !contains_attributes(a, b) || !contains_attributes(b, a) ||
+	    !compare_widget_text(a, b)) {
+		return FALSE;
+	}
+	na = a->children.head.next;
+	nb = b->children.head.next;
+	for (; na && nb; na = na->next, nb = nb->next) {
+		if (!compare_widget_tree(na->data, nb->data)) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** 编译界面文件，并检查从编译结果载入的部件树是否与原文件的一致 */
+static int check_compiled_ui(const char *xml_file, const char *file)
+{
+	int ret = 0;
+	LCUI_Widget pack, binary_pack;
+
+	CHECK(LCUIBuilder_CompileFile(xml_file, file) == 0);
+	pack = LCUIBuilder_LoadFile(xml_file);
+	binary_pack = LCUIBuilder_LoadBinaryFile(file);
+	CHECK_WITH_TEXT("load ui from binary file", binary_pack);
+	if (pack && binary_pack) {
+		CHECK_WITH_TEXT("check binary ui is the same as xml ui",
+				compare_widget_tree(pack, binary_pack));
+	}
+	if (pack) {
+		Widget_Destroy(pack);
+	}
+	if (binary_pack) {
+		Widget_Destroy(binary_pack);
+	}
+	return ret;
+}
+
+static int check_load_binary(void)
+{
+	int ret = 0;
+	size_t size;
+	char *data;
+	FILE *fp;
+	const char *file = "test_xml_parser.bin";
+
+	ret += check_compiled_ui("test_xml_parser.binary.xml", file);
+	ret += check_compiled_ui("test_xml_parser.xml", file);
+	fp = fopen(file, "rb");
+	CHECK(fp != NULL);
+	if (!fp) {
+		return ret;
+	}
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	data = malloc(size);
+	CHECK(fread(data, 1, size, fp) == size);
+	fclose(fp);
+	remove(file);
+	CHECK_WITH_TEXT("check truncated binary data",
+			!LCUIBuilder_LoadBinary(data, size - 1));
+	data[0] = 'X';
+	CHECK_WITH_TEXT("check bad magic", !LCUIBuilder_LoadBinary(data, size));
+	free(data);
+	CHECK_WITH_TEXT("check compiling a file without <ui>",
+			LCUIBuilder_CompileFile("test_css_parser.css", file) != 0);
+	return ret;
+}
+
 int test_xml_parser(void)
 {
 	int ret = 0;
@@ -59,6 +237,8 @@ int test_xml_parser(void)
 	LCUIWidget_Update();
 	ret += check_widget_attribute();
 	ret += check_widget_loaded_from_nested_xml();
+	ret += check_load_string();
+	ret += check_load_binary();
 	LCUI_Destroy();
 	return ret;
 }